@@ -0,0 +1,232 @@
+/**
+ * \file   band-edge-model.cpp
+ * \brief  Band-edge parameters for a heterostructure alloy system
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "band-edge-model.h"
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#include "constants.h"
+#include "file-io.h"
+#include "material.h"
+#include "mesh.h"
+
+namespace QWWAD
+{
+using namespace constants;
+
+/**
+ * \brief Resolve the band-edge parameters for an alloy system
+ *
+ * \param[in] mat Material library entry for the alloy system
+ */
+BandEdgeModel::BandEdgeModel(const Material &mat) :
+    _n_alloy(static_cast<unsigned int>(mat.get_property_value("alloy-components"))),
+    _Eg(mat, "bandgap"),
+    _eps_dc(mat, "eps_dc"),
+    _Eg0(0.0)
+{
+    if(_n_alloy < 1 or _n_alloy > 2)
+    {
+        std::ostringstream oss;
+        oss << "Alloy system " << mat.get_name() << " has " << _n_alloy
+            << " alloy components. Only 1 or 2 are supported.";
+        throw std::domain_error(oss.str());
+    }
+
+    _Eg0 = evaluate(_Eg, arma::zeros(1), arma::zeros(1))(0);
+
+    for(const char p : {'e', 'h', 'l'})
+    {
+        const Glib::ustring mass_name   = Glib::ustring("effective-mass-") + p;
+        const Glib::ustring offset_name = Glib::ustring("band-offset-fraction-") + p;
+
+        if(mat.has_property(mass_name))
+        {
+            const bool has_offset = mat.has_property(offset_name);
+            const double offset   = has_offset ? MaterialPropertyHandle(mat, offset_name).get_val() : 0.0;
+
+            _particles.push_back({p, MaterialPropertyHandle(mat, mass_name), offset, has_offset});
+        }
+    }
+}
+
+/**
+ * \returns The IDs of all particles supported by the model
+ */
+auto BandEdgeModel::get_particles() const -> std::string
+{
+    std::string particles;
+
+    for(const auto &particle : _particles) {
+        particles.push_back(particle.p);
+    }
+
+    return particles;
+}
+
+/**
+ * \param[in] p Particle ID
+ *
+ * \returns The parameters for the given particle
+ */
+auto BandEdgeModel::find_particle(const char p) const -> const ParticleModel &
+{
+    for(const auto &particle : _particles)
+    {
+        if(particle.p == p) {
+            return particle;
+        }
+    }
+
+    std::ostringstream oss;
+    oss << "Data not defined for particle " << p;
+    throw std::domain_error(oss.str());
+}
+
+/**
+ * \param[in] p Particle ID
+ *
+ * \returns True if the band-edge potential is defined for the particle
+ */
+auto BandEdgeModel::has_potential(const char p) const -> bool
+{
+    return find_particle(p).has_potential;
+}
+
+/**
+ * \brief Evaluate a property over a set of points
+ *
+ * \param[in] prop The property
+ * \param[in] x    First alloy variable at each point
+ * \param[in] y    Second alloy variable at each point (ignored for ternary alloys)
+ *
+ * \returns The value of the property at each point
+ */
+auto BandEdgeModel::evaluate(const MaterialPropertyHandle &prop,
+                             const arma::vec              &x,
+                             const arma::vec              &y) const -> arma::vec
+{
+    return (_n_alloy > 1) ? prop.get_val(x, y) : prop.get_val(x);
+}
+
+/**
+ * \brief Find the band-edge parameters for all particles at a set of points
+ *
+ * \param[in] x Alloy variables at each point (one column per variable)
+ *
+ * \returns The band-edge parameters at each point
+ */
+auto BandEdgeModel::get_profiles(const arma::mat &x) const -> BandEdgeProfiles
+{
+    if(x.n_cols < _n_alloy)
+    {
+        std::ostringstream oss;
+        oss << "Got " << x.n_cols << " alloy components but " << _n_alloy << " are needed";
+        throw std::length_error(oss.str());
+    }
+
+    const arma::vec x0 = x.col(0);
+    const arma::vec y0 = (_n_alloy > 1) ? arma::vec(x.col(1)) : arma::vec();
+
+    BandEdgeProfiles prof;
+    const arma::vec Eg_eV = evaluate(_Eg, x0, y0);
+    prof.Eg     = Eg_eV*e;
+    prof.alpha  = 1.0/prof.Eg;
+    prof.eps_dc = evaluate(_eps_dc, x0, y0)*eps0;
+
+    // Total band discontinuity [J]
+    const arma::vec dV = (Eg_eV - _Eg0)*e;
+
+    for(const auto &particle : _particles)
+    {
+        prof.m[particle.p] = evaluate(particle.m, x0, y0)*me;
+        prof.V[particle.p] = particle.has_potential ? arma::vec(particle.offset_fraction*dV)
+                                                    : arma::vec(arma::zeros(x.n_rows));
+    }
+
+    return prof;
+}
+
+/**
+ * \brief Find the band-edge parameters for all particles in a mesh
+ *
+ * \param[in] mesh The heterostructure mesh
+ *
+ * \returns The band-edge parameters at each cell in the mesh
+ *
+ * \details The model is evaluated once per layer and then copied to each cell
+ */
+auto BandEdgeModel::get_profiles(const Mesh &mesh) const -> BandEdgeProfiles
+{
+    const auto x_layers = mesh.get_x_layers();
+    arma::mat x(x_layers.size(), mesh.get_n_alloy());
+
+    for(unsigned int iL = 0; iL < x_layers.size(); ++iL)
+    {
+        for(unsigned int ialloy = 0; ialloy < mesh.get_n_alloy(); ++ialloy) {
+            x(iL, ialloy) = x_layers[iL][ialloy];
+        }
+    }
+
+    const auto layer_prof = get_profiles(x);
+    const auto index      = mesh.get_layer_index();
+
+    BandEdgeProfiles prof;
+    prof.Eg     = layer_prof.Eg.elem(index);
+    prof.alpha  = layer_prof.alpha.elem(index);
+    prof.eps_dc = layer_prof.eps_dc.elem(index);
+
+    for(const auto &particle : _particles)
+    {
+        prof.m[particle.p] = layer_prof.m.at(particle.p).elem(index);
+        prof.V[particle.p] = layer_prof.V.at(particle.p).elem(index);
+    }
+
+    return prof;
+}
+
+/**
+ * \brief Write the band-edge profiles for a particle to file
+ *
+ * \param[in] z                 Position of each point [m]
+ * \param[in] prof              Band-edge parameters at each point
+ * \param[in] p                 Particle ID
+ * \param[in] potential_file    Name of file for the band-edge potential
+ * \param[in] permittivity_file Name of file for the low-frequency permittivity
+ * \param[in] m_const           Effective mass to use at every point [kg], or zero
+ *                              to use the mass profile
+ *
+ * \details The bandgap, effective mass and nonparabolicity are written to Eg.r,
+ *          m.r, m_perp.r and alpha.r.  The reference potentials, v0.r and v1.r,
+ *          are removed, since they belong to any previous structure.
+ */
+void write_band_edge_profiles(const arma::vec        &z,
+                              const BandEdgeProfiles &prof,
+                              const char              p,
+                              const std::string      &potential_file,
+                              const std::string      &permittivity_file,
+                              const double            m_const)
+{
+    remove("v0.r");
+    remove("v1.r");
+
+    arma::vec m = prof.m.at(p);
+
+    if(m_const > 0.0) {
+        m.fill(m_const);
+    }
+
+    write_table(potential_file, z, prof.V.at(p));
+    write_table("Eg.r", z, prof.Eg);
+    write_table(permittivity_file, z, prof.eps_dc);
+    write_table("m.r", z, m);
+    write_table("m_perp.r", z, m);
+    write_table("alpha.r", z, prof.alpha);
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
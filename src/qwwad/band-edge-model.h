@@ -0,0 +1,107 @@
+/**
+ * \file   band-edge-model.h
+ * \brief  Band-edge parameters for a heterostructure alloy system
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_BAND_EDGE_MODEL_H
+#define QWWAD_BAND_EDGE_MODEL_H
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif //HAVE_CONFIG_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <armadillo>
+
+#include "material-property-handle.h"
+
+namespace QWWAD
+{
+class Material;
+class Mesh;
+
+/**
+ * \brief Band-edge parameters at a set of points in a structure
+ */
+struct BandEdgeProfiles
+{
+    arma::vec Eg;     ///< Bandgap [J]
+    arma::vec alpha;  ///< Nonparabolicity parameter [1/J]
+    arma::vec eps_dc; ///< Low-frequency permittivity [F/m]
+
+    std::map<char, arma::vec> V; ///< Band-edge potential for each particle [J]
+    std::map<char, arma::vec> m; ///< Effective mass for each particle [kg]
+};
+
+/**
+ * \brief Band-edge model for an alloy system, read from the material library
+ *
+ * \details The alloy system is described by a material in the library with the
+ *          following properties, each of which may depend on one or two alloy
+ *          variables (as given by its \c alloy-components property):
+ *
+ *          - \c bandgap:                  bandgap [eV]
+ *          - \c band-offset-fraction-[p]: fraction of the change in bandgap that
+ *                                         appears in the band edge for particle p
+ *          - \c effective-mass-[p]:       effective mass for particle p [m0]
+ *          - \c eps_dc:                   low-frequency relative permittivity
+ *
+ *          where p is 'e', 'h' or 'l'.  A particle is supported if its effective
+ *          mass is defined.  If it has no band-offset fraction, its band edge is flat.
+ *
+ *          All properties are resolved once, on construction.  Profiles for all
+ *          particles are then found in a single vectorised evaluation.  For a Mesh,
+ *          the model is evaluated once per layer and the results are copied out to
+ *          every cell in the layer.  The model refers directly to the properties
+ *          in the Material, so the Material must outlive the model.
+ */
+class BandEdgeModel
+{
+public:
+    explicit BandEdgeModel(const Material &mat);
+
+    /// Get the number of alloy variables in the system
+    [[nodiscard]] inline auto get_n_alloy() const -> unsigned int {return _n_alloy;}
+
+    [[nodiscard]] auto get_particles() const -> std::string;
+    [[nodiscard]] auto has_potential(char p) const -> bool;
+
+    [[nodiscard]] auto get_profiles(const arma::mat &x) const -> BandEdgeProfiles;
+    [[nodiscard]] auto get_profiles(const Mesh &mesh) const -> BandEdgeProfiles;
+
+private:
+    /// Parameters for a single type of particle
+    struct ParticleModel
+    {
+        char                   p;               ///< Particle ID
+        MaterialPropertyHandle m;               ///< Effective mass [m0]
+        double                 offset_fraction; ///< Fraction of bandgap change in band edge
+        bool                   has_potential;   ///< True if the band-offset fraction is defined
+    };
+
+    unsigned int               _n_alloy;   ///< Number of alloy variables
+    MaterialPropertyHandle     _Eg;        ///< Bandgap [eV]
+    MaterialPropertyHandle     _eps_dc;    ///< Low-frequency relative permittivity
+    double                     _Eg0;       ///< Bandgap with all alloy variables zero [eV]
+    std::vector<ParticleModel> _particles; ///< Supported particles
+
+    [[nodiscard]] auto find_particle(char p) const -> const ParticleModel &;
+
+    [[nodiscard]] auto evaluate(const MaterialPropertyHandle &prop,
+                                const arma::vec              &x,
+                                const arma::vec              &y) const -> arma::vec;
+};
+
+void write_band_edge_profiles(const arma::vec        &z,
+                              const BandEdgeProfiles &prof,
+                              char                    p,
+                              const std::string      &potential_file,
+                              const std::string      &permittivity_file,
+                              double                  m_const = 0.0);
+} // namespace QWWAD
+#endif //QWWAD_BAND_EDGE_MODEL_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
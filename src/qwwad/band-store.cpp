@@ -0,0 +1,342 @@
+/**
+ * \file   band-store.cpp
+ * \brief  Binary store for plane-wave band-structure results
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "band-store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace QWWAD {
+namespace {
+/// Signature at the start of every store
+const char store_magic[8] = {'Q', 'W', 'W', 'A', 'D', 'P', 'W', '\0'};
+
+/// Version of the store format.  Increment this whenever the layout changes
+const uint32_t store_version = 1;
+
+/// Largest dimension that is accepted from a store
+const uint64_t max_dimension = 1ULL << 32;
+} // namespace
+
+/**
+ * \brief Open a store
+ *
+ * \param[in] filename Name of the store file
+ */
+BandStore::BandStore(const std::string &filename) :
+    _file(filename)
+{
+    char *bytes = _file.data();
+    const auto *header = reinterpret_cast<const Header *>(bytes);
+
+    if(_file.size() < sizeof(Header) ||
+       std::memcmp(header->magic, store_magic, sizeof(store_magic)) != 0)
+    {
+        std::ostringstream oss;
+        oss << filename << " is not a band store";
+        throw std::runtime_error(oss.str());
+    }
+
+    if(header->version != store_version)
+    {
+        std::ostringstream oss;
+        oss << filename << " uses band store format version " << header->version
+            << ". Expected version " << store_version;
+        throw std::runtime_error(oss.str());
+    }
+
+    // Check the size of each block without forming a product that could
+    // overflow for a damaged header
+    uint64_t E_size   = 0;
+    uint64_t ank_size = 0;
+
+    if(header->n_basis >= max_dimension || header->n_k >= max_dimension ||
+       header->n_bands >= max_dimension ||
+       !multiply_sizes({header->n_k, header->n_bands, sizeof(double)}, E_size) ||
+       E_size > _file.size() ||
+       !multiply_sizes({header->n_k, header->n_basis, header->n_bands, sizeof(std::complex<double>)}, ank_size) ||
+       get_ank_offset(header->n_k, header->n_bands) > _file.size() ||
+       _file.size() - get_ank_offset(header->n_k, header->n_bands) != ank_size)
+    {
+        std::ostringstream oss;
+        oss << filename << " is damaged: size does not match " << header->n_k << " wave vectors, "
+            << header->n_bands << " bands and " << header->n_basis << " coefficients";
+        throw std::runtime_error(oss.str());
+    }
+
+    // Each state has one coefficient per plane wave, or two with spin
+    if(header->n_basis != header->n_G && (header->n_basis % 2 != 0 || header->n_basis/2 != header->n_G))
+    {
+        std::ostringstream oss;
+        oss << filename << " is damaged: " << header->n_basis << " coefficients per state "
+            << "does not match " << header->n_G << " plane waves";
+        throw std::runtime_error(oss.str());
+    }
+
+    _n_basis  = header->n_basis;
+    _n_G      = header->n_G;
+    _n_k      = header->n_k;
+    _n_bands  = header->n_bands;
+    _band_min = header->band_min;
+
+    _k   = reinterpret_cast<double *>(bytes + sizeof(Header));
+    _E   = reinterpret_cast<double *>(bytes + get_E_offset(_n_k));
+    _ank = reinterpret_cast<std::complex<double> *>(bytes + get_ank_offset(_n_k, _n_bands));
+}
+
+/**
+ * \brief Find the location of the energy block
+ *
+ * \param[in] n_k Number of wave vectors
+ *
+ * \returns Offset of the first energy from the start of the file [bytes]
+ */
+auto BandStore::get_E_offset(const uint64_t n_k) -> size_t
+{
+    return sizeof(Header) + 3*n_k*sizeof(double);
+}
+
+/**
+ * \brief Find the location of the coefficient block
+ *
+ * \param[in] n_k     Number of wave vectors
+ * \param[in] n_bands Number of bands
+ *
+ * \returns Offset of the first coefficient from the start of the file [bytes]
+ *
+ * \details The block is aligned to the size of a complex number
+ */
+auto BandStore::get_ank_offset(const uint64_t n_k,
+                               const uint64_t n_bands) -> size_t
+{
+    constexpr size_t align = sizeof(std::complex<double>);
+    const size_t offset = get_E_offset(n_k) + n_k*n_bands*sizeof(double);
+    return (offset + align - 1)/align*align;
+}
+
+/**
+ * \brief Get the index of the first stored band
+ *
+ * \returns The band index, counting from zero
+ *
+ * \details Throws an exception if the store doesn't record absolute band
+ *          indices.  See has_band_index().
+ */
+auto BandStore::get_band_min() const -> size_t
+{
+    if(!has_band_index()) {
+        throw std::runtime_error("Band store holds the states closest to a reference energy, "
+                                 "and does not record which bands they are");
+    }
+
+    return _band_min;
+}
+
+/**
+ * \brief Get a wave vector
+ *
+ * \param[in] ik Index of wave vector
+ *
+ * \returns The wave vector [1/m]
+ */
+auto BandStore::get_k(const size_t ik) const -> arma::vec
+{
+    if(ik >= _n_k)
+    {
+        std::ostringstream oss;
+        oss << "Wave vector index " << ik << " out of range. Only " << _n_k << " are stored";
+        throw std::out_of_range(oss.str());
+    }
+
+    return arma::vec(_k + 3*ik, 3);
+}
+
+/**
+ * \brief Get the energy of every stored band
+ *
+ * \returns Energies [J], with one row per band and one column per wave vector.
+ *          The matrix uses the store's memory directly.
+ */
+auto BandStore::get_energies() const -> arma::mat
+{
+    return arma::mat(_E, _n_bands, _n_k, false, true);
+}
+
+/**
+ * \brief Get the coefficients of every stored band at a wave vector
+ *
+ * \param[in] ik Index of wave vector
+ *
+ * \returns Coefficients, with one band per column.
+ *          The matrix uses the store's memory directly.
+ */
+auto BandStore::get_coefficients(const size_t ik) const -> arma::cx_mat
+{
+    if(ik >= _n_k)
+    {
+        std::ostringstream oss;
+        oss << "Wave vector index " << ik << " out of range. Only " << _n_k << " are stored";
+        throw std::out_of_range(oss.str());
+    }
+
+    return arma::cx_mat(_ank + ik*_n_basis*_n_bands, _n_basis, _n_bands, false, true);
+}
+
+/**
+ * \brief Check whether a file is a band store
+ *
+ * \param[in] filename Name of the file
+ *
+ * \returns True if the file starts with the store signature
+ */
+auto BandStore::is_store(const std::string &filename) -> bool
+{
+    std::ifstream stream(filename, std::ios::binary);
+    char magic[sizeof(store_magic)] = {};
+    stream.read(magic, sizeof(magic));
+
+    return stream.gcount() == sizeof(magic) &&
+           std::memcmp(magic, store_magic, sizeof(magic)) == 0;
+}
+
+/**
+ * \brief Create a store, and reserve space for every wave vector
+ *
+ * \param[in] filename Name of the store file
+ * \param[in] n_basis  Number of coefficients for each state
+ * \param[in] n_G      Number of reciprocal lattice vectors
+ * \param[in] n_bands  Number of bands to store at each wave vector
+ * \param[in] band_min Index of the first stored band (counting from zero), or
+ *                     unknown_band if the absolute band indices are unknown
+ * \param[in] k        Wave vectors [1/m]
+ */
+BandStore::Writer::Writer(const std::string            &filename,
+                          const size_t                  n_basis,
+                          const size_t                  n_G,
+                          const size_t                  n_bands,
+                          const size_t                  band_min,
+                          const std::vector<arma::vec> &k) :
+    _filename(filename),
+    _tmp_filename(filename + ".tmp"),
+    _stream(_tmp_filename, std::ios::binary | std::ios::trunc),
+    _n_basis(n_basis),
+    _n_bands(n_bands),
+    _written(k.size(), false)
+{
+    if(!_stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << _tmp_filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    const uint64_t n_k = k.size();
+
+    Header header {};
+    std::memcpy(header.magic, store_magic, sizeof(store_magic));
+    header.version  = store_version;
+    header.n_basis  = n_basis;
+    header.n_G      = n_G;
+    header.n_k      = n_k;
+    header.n_bands  = n_bands;
+    header.band_min = band_min;
+
+    _stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for(const auto &k_point : k)
+    {
+        if(k_point.n_elem != 3) {
+            throw std::length_error("Wave vectors must have three components");
+        }
+
+        _stream.write(reinterpret_cast<const char *>(k_point.memptr()), 3*sizeof(double));
+    }
+
+    // Reserve the rest of the file
+    const size_t size = get_ank_offset(n_k, n_bands) + n_k*n_basis*n_bands*sizeof(std::complex<double>);
+
+    if(size > static_cast<size_t>(_stream.tellp()))
+    {
+        _stream.seekp(size - 1);
+        _stream.put('\0');
+    }
+}
+
+BandStore::Writer::~Writer()
+{
+    if(_stream.is_open())
+    {
+        _stream.close();
+        std::remove(_tmp_filename.c_str());
+    }
+}
+
+/**
+ * \brief Write the solutions at a wave vector
+ *
+ * \param[in] ik  Index of wave vector
+ * \param[in] E   Energy of each stored band [J]
+ * \param[in] ank Coefficients of each stored band, one per column
+ *
+ * \details This may be called from several threads at once
+ */
+void BandStore::Writer::write(const size_t        ik,
+                              const arma::vec    &E,
+                              const arma::cx_mat &ank)
+{
+    if(ik >= _written.size() || E.n_elem != _n_bands || ank.n_rows != _n_basis || ank.n_cols != _n_bands)
+    {
+        std::ostringstream oss;
+        oss << "Cannot store " << E.n_elem << " energies and a " << ank.n_rows << "x" << ank.n_cols
+            << " coefficient matrix at wave vector " << ik << " in a store with "
+            << _n_bands << " bands, " << _n_basis << " coefficients and "
+            << _written.size() << " wave vectors";
+        throw std::length_error(oss.str());
+    }
+
+    const auto n_k = _written.size();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _stream.seekp(get_E_offset(n_k) + ik*_n_bands*sizeof(double));
+    _stream.write(reinterpret_cast<const char *>(E.memptr()), _n_bands*sizeof(double));
+
+    _stream.seekp(get_ank_offset(n_k, _n_bands) + ik*_n_basis*_n_bands*sizeof(std::complex<double>));
+    _stream.write(reinterpret_cast<const char *>(ank.memptr()), ank.n_elem*sizeof(std::complex<double>));
+
+    _written[ik] = true;
+}
+
+/**
+ * \brief Finish writing, and move the store into place
+ */
+void BandStore::Writer::close()
+{
+    const auto missing = std::find(_written.begin(), _written.end(), false);
+
+    if(missing != _written.end())
+    {
+        std::ostringstream oss;
+        oss << "Wave vector " << std::distance(_written.begin(), missing)
+            << " was never written to " << _filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    _stream.close();
+
+    if(!_stream || std::rename(_tmp_filename.c_str(), _filename.c_str()) != 0)
+    {
+        std::remove(_tmp_filename.c_str());
+        std::ostringstream oss;
+        oss << "Could not write " << _filename;
+        throw std::runtime_error(oss.str());
+    }
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
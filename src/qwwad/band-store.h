@@ -0,0 +1,151 @@
+/**
+ * \file   band-store.h
+ * \brief  Binary store for plane-wave band-structure results
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_BAND_STORE_H
+#define QWWAD_BAND_STORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <armadillo>
+
+#include "file-io.h"
+
+namespace QWWAD {
+/**
+ * \brief Energies and plane-wave coefficients, a_nk(G), for a set of bands and wave vectors
+ *
+ * \details Large-basis pseudopotential calculations produce hundreds of
+ *          megabytes of coefficients, which are slow to write and parse as
+ *          text.  This store holds everything in a single binary file:
+ *
+ *          - A header with the basis size, the number of plane waves, the
+ *            number of stored bands and the index of the first stored band.
+ *          - The list of wave vectors [1/m].
+ *          - The energy of each band at each wave vector [J].
+ *          - The coefficients at each wave vector, as a column-major
+ *            (n_basis x n_bands) block.
+ *
+ *          The file is memory-mapped when it is opened, and the data is
+ *          returned as Armadillo objects that use the mapped memory
+ *          directly, so opening a store costs almost nothing.  The mapping
+ *          is private, so modifying these objects never changes the file.
+ *
+ *          With spin-orbit coupling, the basis holds all spin-up coefficients
+ *          followed by all spin-down coefficients, so n_basis = 2 n_G.
+ *
+ *          Folded-spectrum solvers find the states closest to a reference
+ *          energy, without knowing how many bands lie below them.  Their
+ *          results are stored with the first band index set to unknown_band.
+ */
+class BandStore {
+public:
+    /// Index of the first stored band, if the absolute band indices are unknown
+    static constexpr uint64_t unknown_band = UINT64_MAX;
+
+    explicit BandStore(const std::string &filename);
+
+    BandStore(const BandStore &)                     = delete;
+    auto operator=(const BandStore &) -> BandStore & = delete;
+
+    /// Get the number of coefficients for each state
+    [[nodiscard]] inline auto get_n_basis()  const -> size_t {return _n_basis;}
+
+    /// Get the number of reciprocal lattice vectors
+    [[nodiscard]] inline auto get_n_G()      const -> size_t {return _n_G;}
+
+    /// Get the number of wave vectors
+    [[nodiscard]] inline auto get_n_k()      const -> size_t {return _n_k;}
+
+    /// Get the number of stored bands
+    [[nodiscard]] inline auto get_n_bands()  const -> size_t {return _n_bands;}
+
+    /// Check whether the absolute index of each stored band is known
+    [[nodiscard]] inline auto has_band_index() const -> bool {return _band_min != unknown_band;}
+
+    [[nodiscard]] auto get_band_min() const -> size_t;
+
+    [[nodiscard]] auto get_k(size_t ik) const -> arma::vec;
+    [[nodiscard]] auto get_energies() const -> arma::mat;
+    [[nodiscard]] auto get_coefficients(size_t ik) const -> arma::cx_mat;
+
+    [[nodiscard]] static auto is_store(const std::string &filename) -> bool;
+
+    /**
+     * \brief Writes a store, one wave vector at a time
+     *
+     * \details Space for every wave vector is reserved when the writer is
+     *          created, so the wave vectors may be written in any order, and
+     *          from several threads at once.  The data goes to a temporary
+     *          file, which replaces the named file when close() is called.
+     *          If the writer is destroyed without being closed, the temporary
+     *          file is removed.
+     */
+    class Writer {
+    public:
+        Writer(const std::string            &filename,
+               size_t                        n_basis,
+               size_t                        n_G,
+               size_t                        n_bands,
+               size_t                        band_min,
+               const std::vector<arma::vec> &k);
+        ~Writer();
+
+        Writer(const Writer &)                     = delete;
+        auto operator=(const Writer &) -> Writer & = delete;
+
+        void write(size_t              ik,
+                   const arma::vec    &E,
+                   const arma::cx_mat &ank);
+
+        void close();
+
+    private:
+        std::string       _filename;     ///< Name of the final file
+        std::string       _tmp_filename; ///< Name of the file being written
+        std::ofstream     _stream;       ///< Output stream
+        std::mutex        _mutex;        ///< Lock for the output stream
+        size_t            _n_basis;      ///< Number of coefficients for each state
+        size_t            _n_bands;      ///< Number of bands for each wave vector
+        std::vector<bool> _written;      ///< Has each wave vector been written?
+    };
+
+private:
+    /// File header
+    struct Header {
+        char     magic[8];  ///< File signature
+        uint32_t version;   ///< Format version
+        uint32_t reserved;  ///< Padding (zero)
+        uint64_t n_basis;   ///< Number of coefficients for each state
+        uint64_t n_G;       ///< Number of reciprocal lattice vectors
+        uint64_t n_k;       ///< Number of wave vectors
+        uint64_t n_bands;   ///< Number of stored bands
+        uint64_t band_min;  ///< Index of first stored band (or unknown_band)
+    };
+
+    [[nodiscard]] static auto get_E_offset(uint64_t n_k) -> size_t;
+
+    [[nodiscard]] static auto get_ank_offset(uint64_t n_k,
+                                             uint64_t n_bands) -> size_t;
+
+    FileView _file; ///< Contents of the store file
+
+    size_t _n_basis  = 0; ///< Number of coefficients for each state
+    size_t _n_G      = 0; ///< Number of reciprocal lattice vectors
+    size_t _n_k      = 0; ///< Number of wave vectors
+    size_t _n_bands  = 0; ///< Number of stored bands
+    size_t _band_min = 0; ///< Index of first stored band (or unknown_band)
+
+    double               *_k   = nullptr; ///< Wave vectors [1/m]
+    double               *_E   = nullptr; ///< Energies [J]
+    std::complex<double> *_ank = nullptr; ///< Coefficients
+};
+} // namespace QWWAD
+#endif // QWWAD_BAND_STORE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,207 @@
+/**
+ * \file   band-tracker.cpp
+ * \brief  Band structure along a path in k-space, with bands tracked by continuity
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "band-tracker.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace QWWAD {
+/**
+ * \brief Set up a band tracker
+ *
+ * \param[in] solver      Function that finds the eigenstates at a wave vector
+ * \param[in] E_tol       Largest deviation of any band from a linear extrapolation
+ *                        of the previous step, before the step is bisected
+ * \param[in] max_depth   Largest number of times that each step can be bisected
+ * \param[in] min_overlap Smallest overlap between consecutive eigenvectors for a
+ *                        band to be considered as matched (0 to 1)
+ */
+BandTracker::BandTracker(Solver             solver,
+                         const double       E_tol,
+                         const unsigned int max_depth,
+                         const double       min_overlap) :
+    _solver(std::move(solver)),
+    _E_tol(E_tol),
+    _max_depth(max_depth),
+    _min_overlap(min_overlap),
+    _n_solves(0)
+{
+    if(E_tol <= 0) {
+        throw std::domain_error("Energy tolerance for band tracking must be positive");
+    }
+}
+
+/**
+ * \brief Find the bands along a path
+ *
+ * \param[in] vertices Wave vectors at the corners of the path
+ * \param[in] n_steps  Initial number of steps along each segment of the path
+ */
+void BandTracker::trace(const std::vector<arma::vec> &vertices,
+                        const unsigned int            n_steps)
+{
+    if(vertices.size() < 2 || n_steps == 0) {
+        throw std::domain_error("A k-path needs at least two vertices and one step per segment");
+    }
+
+    _k.clear();
+    _s.clear();
+    _E_points.clear();
+    _n_solves = 0;
+
+    // Start from scratch at the first vertex
+    PathPoint point;
+    point.k         = vertices.front();
+    point.s         = 0.0;
+    point.has_slope = false;
+    _solver(point.k, point.E, point.X);
+    ++_n_solves;
+
+    append(point);
+
+    for(unsigned int iseg = 1; iseg < vertices.size(); ++iseg)
+    {
+        // The bands are generally not smooth through a vertex
+        point.has_slope = false;
+
+        const arma::vec dk = vertices[iseg] - vertices[iseg-1];
+
+        for(unsigned int istep = 1; istep <= n_steps; ++istep) {
+            step(point, vertices[iseg-1] + dk*istep/n_steps, 0);
+        }
+    }
+
+    _E.set_size(_E_points.size(), point.E.n_elem);
+
+    for(unsigned int ik = 0; ik < _E_points.size(); ++ik) {
+        _E.row(ik) = _E_points[ik].t();
+    }
+
+    _E_points.clear();
+}
+
+/**
+ * \brief Advance from one point to the next, bisecting the step if needed
+ *
+ * \param[in,out] prev  The last point on the path.  This is replaced by the
+ *                      new point on return.
+ * \param[in]     k     Wave vector at the end of the step
+ * \param[in]     depth Number of times that the step has been bisected already
+ */
+void BandTracker::step(PathPoint          &prev,
+                       const arma::vec    &k,
+                       const unsigned int  depth)
+{
+    double overlap = 0.0;
+    auto next = solve(prev, k, overlap);
+
+    const double ds = next.s - prev.s;
+    bool refine = (overlap < _min_overlap);
+
+    if(prev.has_slope)
+    {
+        const arma::vec E_predicted = prev.E + prev.slope*ds;
+        refine = refine || (arma::abs(next.E - E_predicted).max() > _E_tol);
+    }
+
+    if(refine && depth < _max_depth)
+    {
+        const arma::vec k_mid = 0.5*(prev.k + k);
+        step(prev, k_mid, depth+1);
+        step(prev, k,     depth+1);
+        return;
+    }
+
+    next.slope     = (next.E - prev.E)/ds;
+    next.has_slope = true;
+
+    append(next);
+    prev = std::move(next);
+}
+
+/**
+ * \brief Find the eigenstates at a wave vector, in the same order as the previous point
+ *
+ * \param[in]  prev        The last point on the path
+ * \param[in]  k           Wave vector
+ * \param[out] min_overlap The smallest overlap between any band and its match
+ *
+ * \returns The solution at the new point
+ *
+ * \details Bands are matched in order of decreasing overlap, |<x_prev|x_new>|^2.
+ *          Degenerate states can mix freely, so the overlap of a band is
+ *          taken as its total overlap with all states within the energy
+ *          tolerance of its match.
+ */
+auto BandTracker::solve(const PathPoint &prev,
+                        const arma::vec &k,
+                        double          &min_overlap) -> PathPoint
+{
+    arma::vec    E;
+    arma::cx_mat X = prev.X; // Start from the previous solution
+    _solver(k, E, X);
+    ++_n_solves;
+
+    const auto n = prev.X.n_cols;
+
+    if(X.n_cols != n || E.n_elem != n || X.n_rows != prev.X.n_rows)
+    {
+        std::ostringstream oss;
+        oss << "Solver returned " << E.n_elem << " states at k = " << k.t()
+            << "but " << n << " states were found at the previous point";
+        throw std::runtime_error(oss.str());
+    }
+
+    arma::mat O = arma::square(arma::abs(prev.X.t() * X)); // Overlaps
+    const arma::mat O_all = O;
+
+    // Greedy assignment, taking the strongest remaining overlap each time
+    arma::uvec match(n); // Index of new state matched to each band
+
+    for(unsigned int i = 0; i < n; ++i)
+    {
+        const arma::uword i_max = O.index_max();
+        const arma::uword iband = i_max % n;
+        const arma::uword jnew  = i_max / n;
+
+        match(iband) = jnew;
+        O.row(iband).fill(-1.0);
+        O.col(jnew).fill(-1.0);
+    }
+
+    PathPoint next;
+    next.k         = k;
+    next.s         = prev.s + arma::norm(k - prev.k);
+    next.E         = E.elem(match);
+    next.X         = X.cols(match);
+    next.has_slope = false;
+
+    min_overlap = 1.0;
+
+    for(unsigned int iband = 0; iband < n; ++iband)
+    {
+        const arma::uvec partners = arma::find(arma::abs(E - next.E(iband)) < _E_tol);
+        const double overlap = arma::accu(O_all.submat(arma::uvec{iband}, partners));
+        min_overlap = std::min(min_overlap, overlap);
+    }
+
+    return next;
+}
+
+/**
+ * \brief Add a point to the output
+ */
+void BandTracker::append(const PathPoint &point)
+{
+    _k.push_back(point.k);
+    _s.push_back(point.s);
+    _E_points.push_back(point.E);
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
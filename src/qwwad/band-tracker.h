@@ -0,0 +1,103 @@
+/**
+ * \file   band-tracker.h
+ * \brief  Band structure along a path in k-space, with bands tracked by continuity
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_BAND_TRACKER_H
+#define QWWAD_BAND_TRACKER_H
+
+#include <functional>
+#include <vector>
+
+#include <armadillo>
+
+namespace QWWAD {
+/**
+ * \brief Find a set of bands along a piecewise-linear path in k-space
+ *
+ * \details Solving each k-point independently labels the bands in order of
+ *          energy, so the labels swap wherever two bands cross, and nothing
+ *          is learnt from the neighbouring k-points.  This class walks along
+ *          the path instead:
+ *
+ *          - The eigenvectors found at each k-point are passed to the solver
+ *            as the starting guess for the next one.  An iterative solver
+ *            then needs only a few iterations per point.
+ *          - Each new eigenvector is matched to the previous one that it
+ *            overlaps most, so a band keeps its label through a crossing.
+ *          - A step is bisected if any band deviates from a straight-line
+ *            extrapolation of the previous step by more than a tolerance, or
+ *            if any band cannot be matched clearly.  Points are therefore
+ *            concentrated where the bands curve sharply.
+ *
+ *          The eigenvectors must be expressed in the same basis at every
+ *          k-point (e.g., plane-wave coefficients for a fixed set of
+ *          reciprocal lattice vectors).
+ */
+class BandTracker {
+public:
+    /**
+     * \brief Function that finds the eigenstates at a wave vector
+     *
+     * \details The arguments are the wave vector, the eigenvalues (output) and
+     *          the eigenvectors, one per column (input: starting guess, which
+     *          is empty at the first point; output: solution).
+     */
+    using Solver = std::function<void(const arma::vec &, arma::vec &, arma::cx_mat &)>;
+
+    BandTracker(Solver       solver,
+                double       E_tol,
+                unsigned int max_depth   = 6,
+                double       min_overlap = 0.5);
+
+    void trace(const std::vector<arma::vec> &vertices,
+               unsigned int                  n_steps);
+
+    /// Get the wave vector at each point on the path
+    [[nodiscard]] inline auto get_k() const -> const std::vector<arma::vec> & {return _k;}
+
+    /// Get the distance of each point along the path
+    [[nodiscard]] inline auto get_path_length() const -> const std::vector<double> & {return _s;}
+
+    /// Get the energy of each band at each point, with a row per point
+    [[nodiscard]] inline auto get_energies() const -> const arma::mat & {return _E;}
+
+    /// Get the number of times that the solver was called
+    [[nodiscard]] inline auto get_n_solves() const -> unsigned int {return _n_solves;}
+
+private:
+    /// Solution at a single point on the path
+    struct PathPoint {
+        arma::vec    k;         ///< Wave vector
+        double       s;         ///< Distance along path
+        arma::vec    E;         ///< Energy of each band
+        arma::cx_mat X;         ///< Eigenvector of each band
+        arma::vec    slope;     ///< dE/ds over the previous step
+        bool         has_slope; ///< Is the slope known on this segment?
+    };
+
+    Solver       _solver;      ///< Eigenvalue solver
+    double       _E_tol;       ///< Largest deviation from linear extrapolation
+    unsigned int _max_depth;   ///< Largest number of bisections of each step
+    double       _min_overlap; ///< Smallest overlap for a reliable band match
+
+    std::vector<arma::vec> _k;        ///< Wave vector at each point
+    std::vector<double>    _s;        ///< Distance along path at each point
+    std::vector<arma::vec> _E_points; ///< Energies found so far in the current trace
+    arma::mat              _E;        ///< Energy of each band at each point
+    unsigned int           _n_solves; ///< Number of calls to the solver
+
+    void step(PathPoint       &prev,
+              const arma::vec &k,
+              unsigned int     depth);
+
+    [[nodiscard]] auto solve(const PathPoint &prev,
+                             const arma::vec &k,
+                             double          &min_overlap) -> PathPoint;
+
+    void append(const PathPoint &point);
+};
+} // namespace QWWAD
+#endif // QWWAD_BAND_TRACKER_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -77,6 +77,107 @@ auto DebyeModel::get_cp(const double T) const -> double
     return cp;
 }
 
+/**
+ * \brief Find the specific heat capacity using a closed-form expression
+ *
+ * \param[in] T Temperature [K]
+ *
+ * \details Differentiating the internal energy analytically gives
+ *          \f[
+ *            c_p = \frac{3 N_A k_B n}{M}\left[4D_3(y) - \frac{3y}{e^y - 1}\right]
+ *          \f]
+ *          where \f$y = T_D/T\f$ and \f$D_3\f$ is the third-order Debye function.
+ *          This needs just one evaluation of the Debye function, and avoids the
+ *          truncation error of numerical differentiation.
+ */
+auto DebyeModel::get_cp_exact(const double T) const -> double
+{
+    if(T <= 0)
+    {
+        std::ostringstream oss;
+        oss << "Cannot find specific heat capacity for T = " << T << " K." << std::endl;
+        throw std::runtime_error(oss.str());
+    }
+
+    const auto y   = _T_D/T;
+    const auto D_3 = gsl_sf_debye_3(y);
+
+    return get_cp_high_T() * (4.0*D_3 - 3.0*y/std::expm1(y));
+}
+
+/**
+ * \brief Build a look-up table of specific heat capacity
+ *
+ * \param[in] T_min Lowest temperature in table [K]
+ * \param[in] T_max Highest temperature in table [K]
+ * \param[in] nT    Number of samples in table
+ *
+ * \details The table is sampled uniformly in temperature, so that look-ups in
+ *          get_cp(const arma::vec &) need no searching.  Since the heat capacity
+ *          increases monotonically with temperature, linear interpolation
+ *          between the samples is also monotonic.
+ */
+void DebyeModel::tabulate_cp(const double T_min,
+                             const double T_max,
+                             const size_t nT)
+{
+    if(T_min <= 0 || T_max <= T_min)
+    {
+        std::ostringstream oss;
+        oss << "Invalid temperature range for heat capacity table: " << T_min << " K to "
+            << T_max << " K.";
+        throw std::domain_error(oss.str());
+    }
+
+    if(nT < 2) {
+        throw std::domain_error("Heat capacity table needs at least two samples");
+    }
+
+    _T_table_min = T_min;
+    _dT_table    = (T_max - T_min)/(nT - 1);
+    _cp_table.set_size(nT);
+
+    for(unsigned int iT = 0; iT < nT; ++iT) {
+        _cp_table(iT) = get_cp_exact(T_min + iT*_dT_table);
+    }
+}
+
+/**
+ * \brief Find the specific heat capacity at a set of temperatures
+ *
+ * \param[in] T Temperatures [K]
+ *
+ * \returns Specific heat capacity at each temperature [J/(kg.K)]
+ *
+ * \details If a table has been built using tabulate_cp(), it is used to
+ *          interpolate the heat capacity.  Temperatures outside the range of
+ *          the table (or all temperatures, if there is no table) are evaluated
+ *          exactly.
+ */
+auto DebyeModel::get_cp(const arma::vec &T) const -> arma::vec
+{
+    const auto nT    = T.size();
+    const auto n_tab = _cp_table.size();
+    arma::vec cp(nT);
+
+    for(unsigned int iT = 0; iT < nT; ++iT)
+    {
+        const auto u = (n_tab > 1) ? (T(iT) - _T_table_min)/_dT_table : -1.0;
+
+        if(u >= 0.0 && u < static_cast<double>(n_tab - 1))
+        {
+            const auto i    = static_cast<arma::uword>(u);
+            const auto frac = u - i;
+            cp(iT) = _cp_table(i) + frac*(_cp_table(i+1) - _cp_table(i));
+        }
+        else {
+            cp(iT) = get_cp_exact(T(iT));
+        }
+    }
+
+    return cp;
+}
+
 /**
  * \brief Get specific heat, using low-temperature approximation
  */
@@ -10,6 +10,7 @@
 #define QWWAD_DEBYE
 
 #include <cstddef>
+#include <armadillo>
 
 namespace QWWAD
 {
@@ -22,15 +23,25 @@ public:
 
     [[nodiscard]] auto get_internal_energy(double T) const -> double;
     [[nodiscard]] auto get_cp(double T) const -> double;
+    [[nodiscard]] auto get_cp(const arma::vec &T) const -> arma::vec;
+    [[nodiscard]] auto get_cp_exact(double T) const -> double;
     [[nodiscard]] auto get_cp_approx(double T) const -> double;
     [[nodiscard]] auto get_cp_low_T(double T) const -> double;
     [[nodiscard]] auto get_cp_high_T() const -> double;
 
+    void tabulate_cp(double T_min,
+                     double T_max,
+                     size_t nT = 4096);
+
 private:
     double _T_D;    ///< Debye temperature [K]
     double _M;      ///< Molar mass [kg/mol]
     size_t _natoms; ///< Number of atoms per molecular unit
 
+    double    _T_table_min = 0.0; ///< Lowest temperature in look-up table [K]
+    double    _dT_table    = 0.0; ///< Temperature spacing in look-up table [K]
+    arma::vec _cp_table;          ///< Tabulated specific heat capacity [J/(kg.K)]
+
     static auto find_U(double T, void *params) -> double;
 };
 } // namespace
@@ -0,0 +1,273 @@
+/**
+ * \file   eigenstate-archive.cpp
+ * \brief  Single-file binary store for a set of eigenstates
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "eigenstate-archive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "eigenstate.h"
+
+namespace QWWAD {
+namespace {
+/// Signature at the start of every archive
+const char archive_magic[8] = {'Q', 'W', 'W', 'A', 'D', 'W', 'F', '\0'};
+
+/// Version of the archive format.  Increment this whenever the layout changes
+const uint32_t archive_version = 1;
+
+/// Largest number of samples or states that is accepted from an archive
+const uint64_t max_dimension = 1ULL << 32;
+} // namespace
+
+/**
+ * \brief Open an archive
+ *
+ * \param[in] filename Name of the archive file
+ */
+EigenstateArchive::EigenstateArchive(const std::string &filename) :
+    _file(filename)
+{
+    char *bytes = _file.data();
+    const auto *header = reinterpret_cast<const Header *>(bytes);
+
+    if(_file.size() < sizeof(Header) ||
+       std::memcmp(header->magic, archive_magic, sizeof(archive_magic)) != 0)
+    {
+        std::ostringstream oss;
+        oss << filename << " is not an eigenstate archive";
+        throw std::runtime_error(oss.str());
+    }
+
+    if(header->version != archive_version)
+    {
+        std::ostringstream oss;
+        oss << filename << " uses archive format version " << header->version
+            << ". Expected version " << archive_version;
+        throw std::runtime_error(oss.str());
+    }
+
+    // Check the size of the wave-function block without forming a product
+    // that could overflow for a damaged header
+    uint64_t psi_size = 0;
+
+    if(header->nz >= max_dimension || header->nst >= max_dimension ||
+       !multiply_sizes({header->nz, header->nst, sizeof(std::complex<double>)}, psi_size) ||
+       get_psi_offset(header->nz, header->nst) > _file.size() ||
+       _file.size() - get_psi_offset(header->nz, header->nst) != psi_size)
+    {
+        std::ostringstream oss;
+        oss << filename << " is damaged: size does not match " << header->nz << " samples and "
+            << header->nst << " states";
+        throw std::runtime_error(oss.str());
+    }
+
+    _nz  = header->nz;
+    _nst = header->nst;
+
+    _metadata.particle   = static_cast<char>(header->particle);
+    _metadata.mass       = header->mass;
+    _metadata.solver     = std::string(header->solver, strnlen(header->solver, sizeof(header->solver)));
+    _metadata.input_hash = header->input_hash;
+
+    _z   = reinterpret_cast<double *>(bytes + sizeof(Header));
+    _E   = _z + _nz;
+    _psi = reinterpret_cast<std::complex<double> *>(bytes + get_psi_offset(_nz, _nst));
+}
+
+/**
+ * \brief Find the location of the wave function block
+ *
+ * \param[in] nz  Number of spatial samples
+ * \param[in] nst Number of states
+ *
+ * \returns Offset of the first wave function sample from the start of the file [bytes]
+ *
+ * \details The block is aligned to the size of a complex number
+ */
+auto EigenstateArchive::get_psi_offset(const uint64_t nz,
+                                       const uint64_t nst) -> size_t
+{
+    constexpr size_t align = sizeof(std::complex<double>);
+    const size_t offset = sizeof(Header) + (nz + nst)*sizeof(double);
+    return (offset + align - 1)/align*align;
+}
+
+/**
+ * \brief Get the spatial samples
+ *
+ * \returns Spatial samples [m].  The vector uses the archive's memory directly.
+ */
+auto EigenstateArchive::get_position_samples() const -> arma::vec
+{
+    return arma::vec(_z, _nz, false, true);
+}
+
+/**
+ * \brief Get the energy of every state
+ *
+ * \returns Energies, in the same units as the states that were written.
+ *          The vector uses the archive's memory directly.
+ */
+auto EigenstateArchive::get_energies() const -> arma::vec
+{
+    return arma::vec(_E, _nst, false, true);
+}
+
+/**
+ * \brief Get the wave functions of all states
+ *
+ * \returns Wave functions [m^{-0.5}], with one state per column.
+ *          The matrix uses the archive's memory directly.
+ */
+auto EigenstateArchive::get_wavefunctions() const -> arma::cx_mat
+{
+    return arma::cx_mat(_psi, _nz, _nst, false, true);
+}
+
+/**
+ * \brief Check whether a file is an eigenstate archive
+ *
+ * \param[in] filename Name of the file
+ *
+ * \returns True if the file starts with the archive signature
+ */
+auto EigenstateArchive::is_archive(const std::string &filename) -> bool
+{
+    std::ifstream stream(filename, std::ios::binary);
+    char magic[sizeof(archive_magic)] = {};
+    stream.read(magic, sizeof(magic));
+
+    return stream.gcount() == sizeof(magic) &&
+           std::memcmp(magic, archive_magic, sizeof(magic)) == 0;
+}
+
+/**
+ * \brief Write a set of states to an archive
+ *
+ * \param[in] filename Name of the archive file
+ * \param[in] states   The states.  These must all use the same spatial samples
+ * \param[in] metadata Description of the calculation
+ *
+ * \details The archive is written to a temporary file, which then replaces
+ *          any existing file so that readers never see a partial archive.
+ */
+void EigenstateArchive::write(const std::string             &filename,
+                              const std::vector<Eigenstate> &states,
+                              const Metadata                &metadata)
+{
+    const arma::vec z  = states.empty() ? arma::vec() : states[0].get_position_samples();
+    const uint64_t  nz = z.size();
+    const uint64_t nst = states.size();
+
+    Header header {};
+    std::memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.version    = archive_version;
+    header.particle   = static_cast<unsigned char>(metadata.particle);
+    header.nz         = nz;
+    header.nst        = nst;
+    header.mass       = metadata.mass;
+    header.input_hash = metadata.input_hash;
+
+    if(metadata.solver.size() >= sizeof(header.solver))
+    {
+        std::ostringstream oss;
+        oss << "Solver name '" << metadata.solver << "' is too long for an eigenstate archive";
+        throw std::length_error(oss.str());
+    }
+
+    std::memcpy(header.solver, metadata.solver.data(), metadata.solver.size());
+
+    arma::vec E(nst);
+
+    for(unsigned int ist = 0; ist < nst; ++ist)
+    {
+        if(states[ist].get_position_samples().size() != nz)
+        {
+            std::ostringstream oss;
+            oss << "State " << ist+1 << " has " << states[ist].get_position_samples().size()
+                << " samples. Expected " << nz;
+            throw std::length_error(oss.str());
+        }
+
+        E[ist] = states[ist].get_energy();
+    }
+
+    const auto tmp_filename = filename + ".tmp";
+    std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << tmp_filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(z.memptr()), nz*sizeof(double));
+    stream.write(reinterpret_cast<const char *>(E.memptr()), nst*sizeof(double));
+
+    const size_t padding = get_psi_offset(nz, nst) - sizeof(Header) - (nz + nst)*sizeof(double);
+    const char zeros[sizeof(std::complex<double>)] = {};
+    stream.write(zeros, padding);
+
+    for(const auto &state : states) {
+        const arma::cx_vec psi = state.get_wavefunction_samples();
+        stream.write(reinterpret_cast<const char *>(psi.memptr()), nz*sizeof(std::complex<double>));
+    }
+
+    stream.close();
+
+    if(!stream || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmp_filename.c_str());
+        std::ostringstream oss;
+        oss << "Could not write " << filename;
+        throw std::runtime_error(oss.str());
+    }
+}
+
+/**
+ * \brief Find a hash of the contents of a set of files
+ *
+ * \param[in] filenames Names of the files
+ *
+ * \returns FNV-1a hash of the files' contents, in order
+ *
+ * \details This is stored in an archive so that it can later be checked
+ *          against the inputs that are currently on disk.
+ */
+auto EigenstateArchive::hash_files(const std::vector<std::string> &filenames) -> uint64_t
+{
+    uint64_t hash = fnv1a_offset;
+    std::vector<char> buffer(1 << 16);
+
+    for(const auto &filename : filenames)
+    {
+        std::ifstream stream(filename, std::ios::binary);
+
+        if(!stream.is_open())
+        {
+            std::ostringstream oss;
+            oss << "Could not open " << filename;
+            throw std::runtime_error(oss.str());
+        }
+
+        while(stream)
+        {
+            stream.read(buffer.data(), buffer.size());
+
+            hash = fnv1a(buffer.data(), stream.gcount(), hash);
+        }
+    }
+
+    return hash;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,94 @@
+/**
+ * \file   eigenstate-archive.h
+ * \brief  Single-file binary store for a set of eigenstates
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_EIGENSTATE_ARCHIVE_H
+#define QWWAD_EIGENSTATE_ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <armadillo>
+
+#include "file-io.h"
+
+namespace QWWAD {
+class Eigenstate;
+
+/**
+ * \brief A set of eigenstates stored in a single binary file
+ *
+ * \details The text format writes one file per state, each repeating the
+ *          spatial grid, and every downstream program has to parse them all
+ *          again.  An archive stores the grid once, followed by all of the
+ *          energies and then the wave functions as a contiguous column-major
+ *          (nz x nst) block.  A few items of metadata describe how the states
+ *          were found.
+ *
+ *          The archive is memory-mapped when it is opened, and the data is
+ *          returned as Armadillo objects that use the mapped memory directly.
+ *          The mapping is private, so modifying these objects never changes
+ *          the file.
+ */
+class EigenstateArchive {
+public:
+    /// Description of the calculation that produced a set of states
+    struct Metadata {
+        char        particle   = 'e'; ///< Particle ID ('e', 'h' or 'l')
+        double      mass       = 0.0; ///< Constant effective mass [kg] (zero if spatially varying)
+        std::string solver;           ///< Name of the Schroedinger solver
+        uint64_t    input_hash = 0;   ///< Hash of the input data (see hash_files)
+    };
+
+    explicit EigenstateArchive(const std::string &filename);
+
+    EigenstateArchive(const EigenstateArchive &)                     = delete;
+    auto operator=(const EigenstateArchive &) -> EigenstateArchive & = delete;
+
+    [[nodiscard]] inline auto get_n_samples()  const -> size_t {return _nz;}
+    [[nodiscard]] inline auto get_n_states()   const -> size_t {return _nst;}
+    [[nodiscard]] inline auto get_metadata()   const -> const Metadata & {return _metadata;}
+
+    [[nodiscard]] auto get_position_samples() const -> arma::vec;
+    [[nodiscard]] auto get_energies()         const -> arma::vec;
+    [[nodiscard]] auto get_wavefunctions()    const -> arma::cx_mat;
+
+    [[nodiscard]] static auto is_archive(const std::string &filename) -> bool;
+
+    static void write(const std::string             &filename,
+                      const std::vector<Eigenstate> &states,
+                      const Metadata                &metadata);
+
+    [[nodiscard]] static auto hash_files(const std::vector<std::string> &filenames) -> uint64_t;
+
+private:
+    /// File header
+    struct Header {
+        char     magic[8];    ///< File signature
+        uint32_t version;     ///< Format version
+        uint32_t particle;    ///< Particle ID
+        uint64_t nz;          ///< Number of spatial samples
+        uint64_t nst;         ///< Number of states
+        double   mass;        ///< Constant effective mass [kg]
+        uint64_t input_hash;  ///< Hash of the input data
+        char     solver[32];  ///< Name of the Schroedinger solver (null terminated)
+    };
+
+    [[nodiscard]] static auto get_psi_offset(uint64_t nz,
+                                             uint64_t nst) -> size_t;
+
+    FileView _file; ///< Contents of the archive file
+
+    size_t   _nz  = 0;   ///< Number of spatial samples
+    size_t   _nst = 0;   ///< Number of states
+    Metadata _metadata;  ///< Description of the calculation
+
+    double               *_z   = nullptr; ///< Spatial samples [m]
+    double               *_E   = nullptr; ///< Energies
+    std::complex<double> *_psi = nullptr; ///< Wave functions [m^{-0.5}]
+};
+} // namespace QWWAD
+#endif // QWWAD_EIGENSTATE_ARCHIVE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -2,6 +2,7 @@
 #include <sstream>
 #include <utility>
 
+#include "eigenstate-archive.h"
 #include "maths-helpers.h"
 #include "file-io.h"
 
@@ -57,7 +58,9 @@ void Eigenstate::normalise()
  * 
  * \returns  A vector containing the eigenstates
  *
- * \details Reads in eigenstates from files into a vector
+ * \details Reads in eigenstates from files into a vector.  If the eigenvalue
+ *          file is an EigenstateArchive, all states are read from it instead
+ *          and the eigenvector filenames and first-column flag are unused.
  */
 auto
 Eigenstate::read_from_file(const std::string &Eigenval_name,
@@ -68,27 +71,32 @@ Eigenstate::read_from_file(const std::string &Eigenval_name,
 {
     std::vector<Eigenstate> states;
 
-    // Read eigenvalues into tempory memory
-    arma::vec E_temp;
+    if(EigenstateArchive::is_archive(Eigenval_name))
+    {
+        const EigenstateArchive archive(Eigenval_name);
 
-    if(ignore_first_column) {
-        arma::vec indices;
-        read_table(Eigenval_name.c_str(), indices, E_temp);
-    } else {
-        read_table(Eigenval_name.c_str(), E_temp);
-    }
+        if(archive.get_n_states() == 0) {
+            std::ostringstream oss;
+            oss << Eigenval_name << " contains no states.";
+            throw std::runtime_error(oss.str());
+        }
 
-    E_temp /= eigenvalue_scale;
+        // These use the archive's memory, so only the copy into each state is made
+        const auto z   = archive.get_position_samples();
+        const auto E   = archive.get_energies();
+        const auto psi = archive.get_wavefunctions();
 
-    // Set number of states
-    const size_t nst = E_temp.size();
+        for(unsigned int ist = 0; ist < archive.get_n_states(); ++ist) {
+            states.emplace_back(E[ist]/eigenvalue_scale, z, psi.col(ist));
+        }
 
-    if(nst==0) {
-        std::ostringstream oss;
-        oss << Eigenval_name << " appears to be empty. Is this the correct eigenvalue input file?.";
-        throw std::runtime_error(oss.str());
+        return states;
     }
 
+    // Read eigenvalues into tempory memory
+    const auto E_temp = read_energies_from_file(Eigenval_name, eigenvalue_scale, ignore_first_column);
+    const size_t nst = E_temp.size();
+
     // Read first eigenvector into tempory memory to get size of vectors
     arma::vec z_temp;
     arma::cx_vec psi_temp;
@@ -117,6 +125,46 @@ Eigenstate::read_from_file(const std::string &Eigenval_name,
     return states;
 }
         
+/**
+ * \brief Read the eigenvalues of a set of states from file
+ *
+ * \param[in] Eigenval_name       The name of the file which holds the eigenvalues
+ * \param[in] eigenvalue_scale    Value by which all eigenvalues will be divided upon
+ *                                read
+ * \param[in] ignore_first_column True if first column of eigenvalue file should be
+ *                                ignored
+ *
+ * \returns The eigenvalues
+ *
+ * \details This is for programs that only need the energies.  As with
+ *          read_from_file, an EigenstateArchive is detected by its signature,
+ *          in which case the first-column flag is unused.
+ */
+auto Eigenstate::read_energies_from_file(const std::string &Eigenval_name,
+                                         const double       eigenvalue_scale,
+                                         const bool         ignore_first_column) -> arma::vec
+{
+    arma::vec E;
+
+    if(EigenstateArchive::is_archive(Eigenval_name)) {
+        const EigenstateArchive archive(Eigenval_name);
+        E = archive.get_energies();
+    } else if(ignore_first_column) {
+        arma::vec indices;
+        read_table(Eigenval_name.c_str(), indices, E);
+    } else {
+        read_table(Eigenval_name.c_str(), E);
+    }
+
+    if(E.empty()) {
+        std::ostringstream oss;
+        oss << Eigenval_name << " appears to be empty. Is this the correct eigenvalue input file?.";
+        throw std::runtime_error(oss.str());
+    }
+
+    return E/eigenvalue_scale;
+}
+
 /** 
  * \brief Write a set of eigenstates to file
  *
@@ -44,6 +44,10 @@ public:
                                double             eigenvalue_scale    = 1.0,
                                bool               ignore_first_column = false) -> std::vector<Eigenstate>;
 
+    static auto read_energies_from_file(const std::string &Eigenval_name,
+                                        double             eigenvalue_scale    = 1.0,
+                                        bool               ignore_first_column = false) -> arma::vec;
+
     static void write_to_file(const std::string             &Eigenval_name,
                               const std::string             &Eigenvect_prefix,
                               const std::string             &Eigenvect_ext,
@@ -7,6 +7,7 @@
 #include "fermi.h"
 
 #include "constants.h"
+#include <cmath>
 #include <stdexcept>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_roots.h>
@@ -17,6 +18,159 @@ namespace QWWAD
 {
 using namespace constants;
 
+namespace
+{
+/**
+ * \brief Complete Fermi-Dirac integral of order 0, evaluated without overflow
+ *
+ * \param x Reduced Fermi energy
+ */
+inline auto fermi_dirac_0(const double x) -> double
+{
+    return (x > 0.0) ? x + std::log1p(std::exp(-x)) : std::log1p(std::exp(x));
+}
+
+/**
+ * \brief Complete Fermi-Dirac integral of order -1 (i.e., the logistic function)
+ *
+ * \param x Reduced Fermi energy
+ */
+inline auto fermi_dirac_m1(const double x) -> double
+{
+    return 1.0/(1.0 + std::exp(-x));
+}
+
+/**
+ * \brief Add the population of one subband, and its derivative w.r.t. the Fermi energy
+ *
+ * \param[in]     Esb    Energy of the subband minimum [J]
+ * \param[in]     E_F    Quasi-Fermi energy [J]
+ * \param[in]     m0     Band-edge effective mass [kg]
+ * \param[in]     Te     Temperature of electron distribution [K]
+ * \param[in]     alpha  Nonparabolicity [1/J]
+ * \param[in]     V      Energy of the band edge [J]
+ * \param[in,out] N      Running total of population [m^{-2}]
+ * \param[in,out] dN_dEF Running total of derivative of population [m^{-2}/J]
+ *
+ * \details Uses the same expressions as find_pop, along with the identities
+ *          dF_j/dx = F_{j-1}.  The order 0 and -1 integrals have closed forms.
+ */
+inline void add_pop_and_derivative(const double  Esb,
+                                   const double  E_F,
+                                   const double  m0,
+                                   const double  Te,
+                                   const double  alpha,
+                                   const double  V,
+                                   double       &N,
+                                   double       &dN_dEF)
+{
+    const double rho_p = m0/(pi*hBar*hBar);
+    const double kT    = kB*Te;
+    const double x     = (E_F - Esb)/kT;
+
+    // Population is negligible
+    if(x < -700) {
+        return;
+    }
+
+    const double F0  = fermi_dirac_0(x);
+    const double Fm1 = fermi_dirac_m1(x);
+
+    if(gsl_fcmp(alpha,0,1e-6) == 0)
+    {
+        N      += rho_p*kT*F0;
+        dN_dEF += rho_p*Fm1;
+    }
+    else
+    {
+        const double a = 1.0 + 2.0*alpha*(Esb-V);
+        N      += rho_p*kT*(a*F0 + 2.0*alpha*kT*gsl_sf_fermi_dirac_1(x));
+        dN_dEF += rho_p*(a*Fm1 + 2.0*alpha*kT*F0);
+    }
+}
+
+/**
+ * \brief Find the global Fermi energy for a set of subbands using a safeguarded Newton iteration
+ *
+ * \param[in] Esb   Subband minima [J]
+ * \param[in] m0    Band-edge effective mass [kg]
+ * \param[in] N     Total population [m^{-2}]
+ * \param[in] Te    Temperature of carrier distribution [K]
+ * \param[in] alpha Nonparabolicity [1/J]
+ * \param[in] V     Band-edge [J]
+ *
+ * \details The search range is the same as in the scalar find_fermi_global.  The
+ *          iteration starts from the Fermi energy for the lowest subband alone.
+ *          Each Newton step that would leave the current bracket is replaced by
+ *          a bisection, so the iteration always converges.
+ */
+auto find_fermi_global_newton(const arma::vec &Esb,
+                              const double     m0,
+                              const double     N,
+                              const double     Te,
+                              const double     alpha,
+                              const double     V) -> double
+{
+    const double kT  = kB*Te;
+    const double tol = 1e-8*e;
+
+    double E_lo = Esb.min() - 100.0*kT;
+    double E_hi = Esb.max() + 500.0*kT;
+
+    const auto pop_error = [&](const double E_F, double &dN_dEF) {
+        double N_total = 0.0;
+        dN_dEF = 0.0;
+
+        for(auto E : Esb) {
+            add_pop_and_derivative(E, E_F, m0, Te, alpha, V, N_total, dN_dEF);
+        }
+
+        return N_total - N;
+    };
+
+    double dN_dEF = 0.0;
+
+    if(pop_error(E_lo, dN_dEF) > 0.0 || pop_error(E_hi, dN_dEF) < 0.0) {
+        throw std::runtime_error("No quasi-Fermi energy in range.");
+    }
+
+    // Start from the Fermi energy for the lowest subband [QWWAD4, 2.85]
+    double E_F = Esb.min() + kT * log(std::expm1((N*pi*hBar*hBar)/(m0*kT)));
+
+    if(!(E_F > E_lo && E_F < E_hi)) {
+        E_F = 0.5*(E_lo + E_hi);
+    }
+
+    const unsigned int max_iter = 200;
+
+    for(unsigned int iter = 0; iter < max_iter; ++iter)
+    {
+        const auto f = pop_error(E_F, dN_dEF);
+
+        if(f < 0.0) {
+            E_lo = E_F;
+        } else {
+            E_hi = E_F;
+        }
+
+        auto E_F_new = E_F - f/dN_dEF;
+
+        // Bisect if the Newton step leaves the bracket
+        if(!(E_F_new > E_lo && E_F_new < E_hi)) {
+            E_F_new = 0.5*(E_lo + E_hi);
+        }
+
+        if(std::abs(E_F_new - E_F) < tol || E_hi - E_lo < tol) {
+            return E_F_new;
+        }
+
+        E_F = E_F_new;
+    }
+
+    throw std::runtime_error("Quasi-Fermi energy search did not converge.");
+}
+} // namespace
+
 /**
  * \brief Fermi occupation probability at specified kinetic energy
  *
@@ -31,6 +185,38 @@ auto f_FD(const double E_F, const double E, const double Te) -> double
     return 1.0/(exp((E-E_F)/(kB*Te)) + 1.0);
 }
 
+/**
+ * \brief Fermi occupation probability at a set of energies
+ *
+ * \param E_F Fermi energy [J]
+ * \param E   Energies of electron, on the same scale as the Fermi energy [J]
+ * \param Te  Temperature [K]
+ *
+ * \returns Fermi occupation number at each energy
+ */
+auto f_FD(const double E_F, const arma::vec &E, const double Te) -> arma::vec
+{
+    return 1.0/(arma::exp((E-E_F)/(kB*Te)) + 1.0);
+}
+
+/**
+ * \brief Fermi occupation probability at a single energy, for a set of distributions
+ *
+ * \param E_F Fermi energy for each distribution [J]
+ * \param E   Energy of electron, on the same scale as the Fermi energy [J]
+ * \param Te  Temperature of each distribution [K]
+ *
+ * \returns Fermi occupation number for each distribution
+ */
+auto f_FD(const arma::vec &E_F, const double E, const arma::vec &Te) -> arma::vec
+{
+    if(E_F.size() != Te.size()) {
+        throw std::length_error("Fermi energy and temperature arrays have different sizes");
+    }
+
+    return 1.0/(arma::exp((E-E_F)/(kB*Te)) + 1.0);
+}
+
 /**
  * \brief Fermi ionisation probability with degeneracy of 2
  *
@@ -93,6 +279,54 @@ auto find_pop(const double Esb,
     return N;
 }
 
+/**
+ * \brief Find total population of a subband for a set of Fermi energies and temperatures
+ *
+ * \param Esb   Energy of the subband minimum [J]
+ * \param E_F   Quasi-Fermi energy for each distribution [J]
+ * \param m0    Band-edge effective mass [kg]
+ * \param Te    Temperature of each distribution [K]
+ * \param alpha Nonparabolicity [1/J]
+ * \param V     Energy of the band edge [J]
+ *
+ * \returns Subband population for each distribution [m^{-2}]
+ *
+ * \details This is a convenience wrapper that evaluates each distribution in turn,
+ *          using the same kernel as the scalar find_pop.  It is not vectorised, but
+ *          it avoids the overhead of a separate call per point.  The order-0 Fermi
+ *          integral is evaluated in closed form, so only nonparabolic subbands need
+ *          any special-function evaluations.
+ */
+auto find_pop(const double     Esb,
+              const arma::vec &E_F,
+              const double     m0,
+              const arma::vec &Te,
+              const double     alpha,
+              const double     V) -> arma::vec
+{
+    if(E_F.size() != Te.size()) {
+        throw std::length_error("Fermi energy and temperature arrays have different sizes");
+    }
+
+    const auto n = E_F.size();
+    arma::vec N = arma::zeros(n);
+
+    for(arma::uword i = 0; i < n; ++i)
+    {
+        // In case of underflow, return the same tiny value as the scalar version
+        if(gsl_fcmp((E_F(i) - Esb)/(kB*Te(i)), -700, 1e-6) == -1)
+        {
+            N(i) = 1;
+            continue;
+        }
+
+        double dN_dEF = 0.0;
+        add_pop_and_derivative(Esb, E_F(i), m0, Te(i), alpha, V, N(i), dN_dEF);
+    }
+
+    return N;
+}
+
 /**
  * \brief Parameters used for checking the population
  */
@@ -335,5 +569,47 @@ auto find_fermi_global(const arma::vec &Esb,
 
     return E_F;
 }
+
+/** 
+ * \brief Find Fermi energies for a 2D system with many subbands, at a set of populations and temperatures
+ *
+ * \param Esb   Array of subband minima [J]
+ * \param m0    Mass of carriers at band edge [kg]
+ * \param N     Population density of system at each point [m^{-2}]
+ * \param Te    Temperature of carrier distribution at each point [K]
+ * \param alpha Nonparabolicity parameter [1/J]
+ * \param V     Band-edge [J]
+ *
+ * \returns The Fermi energy for the entire system at each point [J]
+ *
+ * \details This is a convenience wrapper that solves each point in turn; it is
+ *          not vectorised.  Each point is solved using a safeguarded Newton
+ *          iteration, which needs far fewer population evaluations than a
+ *          bracketing search.
+ */
+auto find_fermi_global(const arma::vec &Esb,
+                       const double     m0,
+                       const arma::vec &N,
+                       const arma::vec &Te,
+                       const double     alpha,
+                       const double     V) -> arma::vec
+{
+    if(N.size() != Te.size()) {
+        throw std::length_error("Population and temperature arrays have different sizes");
+    }
+
+    if(Esb.is_empty()) {
+        throw std::runtime_error("No subbands specified");
+    }
+
+    const auto n = N.size();
+    arma::vec E_F(n);
+
+    for(arma::uword i = 0; i < n; ++i) {
+        E_F(i) = find_fermi_global_newton(Esb, m0, N(i), Te(i), alpha, V);
+    }
+
+    return E_F;
+}
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -16,6 +16,14 @@ auto f_FD(double E_F,
           double Ek,
           double Te) -> double;
 
+auto f_FD(double           E_F,
+          const arma::vec &E,
+          double           Te) -> arma::vec;
+
+auto f_FD(const arma::vec &E_F,
+          double           E,
+          const arma::vec &Te) -> arma::vec;
+
 auto f_FD_ionised(double E_F,
                   double Ed,
                   double Te) -> double;
@@ -27,6 +35,13 @@ auto find_pop(double Esb,
               double alpha=0,
               double V=0) -> double;
 
+auto find_pop(double           Esb,
+              const arma::vec &E_F,
+              double           m0,
+              const arma::vec &Te,
+              double           alpha=0,
+              double           V=0) -> arma::vec;
+
 auto find_fermi(double Esb,
                 double m0,
                 double N,
@@ -47,6 +62,13 @@ auto find_fermi_global(const std::vector<Eigenstate> &states,
                        double                   Te,
                        double                   alpha=0,
                        double                   V=0) -> double;
+
+auto find_fermi_global(const arma::vec &Esb,
+                       double           m0,
+                       const arma::vec &N,
+                       const arma::vec &Te,
+                       double           alpha=0,
+                       double           V=0) -> arma::vec;
 } // namespace
 #endif
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
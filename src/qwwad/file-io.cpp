@@ -7,8 +7,134 @@
 
 #include "file-io.h"
 
+#include <limits>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 namespace QWWAD
 {
+FileView::FileView(const std::string &fname)
+{
+#ifndef _WIN32
+    const int fd = ::open(fname.c_str(), O_RDONLY);
+
+    if(fd >= 0)
+    {
+        struct stat st;
+
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0)
+        {
+            // A writable private mapping lets the caller modify the contents
+            // without affecting the file
+            void *map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+            if(map != MAP_FAILED)
+            {
+                _map  = map;
+                _data = static_cast<char *>(map);
+                _size = st.st_size;
+                close(fd);
+                return;
+            }
+        }
+
+        close(fd);
+    }
+#endif
+
+    // Fall back to reading the whole file into memory
+    std::ifstream stream(fname, std::ios::binary);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << fname;
+        throw std::runtime_error(oss.str());
+    }
+
+    std::ostringstream contents;
+    contents << stream.rdbuf();
+    const auto str = contents.str();
+
+    _buffer.resize((str.size() + sizeof(std::max_align_t) - 1)/sizeof(std::max_align_t));
+    _data = reinterpret_cast<char *>(_buffer.data());
+    _size = str.size();
+    std::copy(str.begin(), str.end(), _data);
+}
+
+FileView::~FileView()
+{
+#ifndef _WIN32
+    if(_map != nullptr) {
+        munmap(_map, _size);
+    }
+#endif
+}
+
+/**
+ * \brief Update an FNV-1a hash with a block of data
+ *
+ * \param[in] data Start of data block
+ * \param[in] size Size of data block [bytes]
+ * \param[in] hash Hash of all previous data
+ *
+ * \returns The updated hash
+ *
+ * \details This is a fast, non-cryptographic hash, which is used to check
+ *          whether the inputs to a binary file have changed.
+ */
+auto fnv1a(const char *data,
+           const size_t size,
+           uint64_t     hash) -> uint64_t
+{
+    const uint64_t fnv1a_prime = 1099511628211ULL;
+
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= fnv1a_prime;
+    }
+
+    return hash;
+}
+
+/**
+ * \brief Multiply a set of sizes, checking for overflow
+ *
+ * \param[in]  factors Sizes to multiply (e.g., array dimensions and element size)
+ * \param[out] product The product of all factors
+ *
+ * \returns False if the product does not fit in 64 bits
+ *
+ * \details Use this to find the size of a block in a binary file from the
+ *          dimensions in its header, which can't be trusted if it is damaged.
+ */
+auto multiply_sizes(const std::initializer_list<uint64_t>  factors,
+                    uint64_t                              &product) -> bool
+{
+    product = 1;
+
+    if(std::find(factors.begin(), factors.end(), 0) != factors.end())
+    {
+        product = 0;
+        return true;
+    }
+
+    for(const auto factor : factors)
+    {
+        if(product > std::numeric_limits<uint64_t>::max()/factor) {
+            return false;
+        }
+
+        product *= factor;
+    }
+
+    return true;
+}
 
 void parse_items(std::istream &stream)
 {
@@ -3,8 +3,10 @@
  * \brief  Functions for reading and writing data from standard input 
  * \author Alex Valavanis  <a.valavanis@leeds.ac.uk>
  * \author Jonathan Cooper <jdc.tas@gmail.com>
- * \todo   Use C++11 variadic templates to make this much cleaner and more generic!
- * \todo   Replace string tokenisation with C++ istringstream handling
+ *
+ * \details Tables are read by memory-mapping the whole file and converting
+ *          each item in place with std::from_chars, which avoids building a
+ *          stream or a temporary string for every line.
  */
 
 #ifndef QWWAD_FILE_IO_H
@@ -14,8 +16,15 @@
 # include "config.h"
 #endif
 
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <fstream>
 #include <sstream>
@@ -25,6 +34,246 @@
 
 namespace QWWAD
 {
+/**
+ * \brief View of the entire contents of a file
+ *
+ * \details The file is memory-mapped where possible, so that it can be parsed
+ *          without copying.  Otherwise (e.g., for an empty file or a pipe), it
+ *          is read into memory.
+ *
+ *          The mapping is private, so the contents may be modified in memory
+ *          without changing the file.  This lets the binary file formats
+ *          return Armadillo objects that use the contents directly.  In
+ *          either case, the contents are aligned suitably for any type.
+ */
+class FileView
+{
+public:
+    explicit FileView(const std::string &fname);
+    ~FileView();
+
+    FileView(const FileView &)                     = delete;
+    auto operator=(const FileView &) -> FileView & = delete;
+
+    /// Get a pointer to the start of the file contents
+    [[nodiscard]] inline auto data() const -> const char * {return _data;}
+
+    /// Get a modifiable pointer to the start of the file contents
+    [[nodiscard]] inline auto data() -> char * {return _data;}
+
+    /// Get the size of the file [bytes]
+    [[nodiscard]] inline auto size() const -> size_t {return _size;}
+
+private:
+    char                          *_data = nullptr; ///< Start of file contents
+    size_t                         _size = 0;       ///< Size of file contents [bytes]
+    void                          *_map  = nullptr; ///< Memory mapping (if used)
+    std::vector<std::max_align_t>  _buffer;         ///< Copy of file contents (if not mapped)
+};
+
+/// Offset basis for FNV-1a hashes
+constexpr uint64_t fnv1a_offset = 14695981039346656037ULL;
+
+auto fnv1a(const char *data,
+           size_t      size,
+           uint64_t    hash = fnv1a_offset) -> uint64_t;
+
+auto multiply_sizes(std::initializer_list<uint64_t>  factors,
+                    uint64_t                        &product) -> bool;
+
+namespace file_io_detail
+{
+/// Check whether a character separates items on a line
+inline auto is_separator(const char c) -> bool
+{
+    return c == ' ' or c == '\t' or c == '\r' or c == '\v' or c == '\f';
+}
+
+/**
+ * \brief Find the next item on a line
+ *
+ * \param[in,out] pos Current position on the line. On return, this points to the end of the item
+ * \param[in]     end End of the line
+ *
+ * \returns The start of the item, or nullptr if there are no more items on the line
+ */
+inline auto next_item(const char *&pos,
+                      const char  *end) -> const char *
+{
+    while(pos != end and is_separator(*pos)) {
+        ++pos;
+    }
+
+    if(pos == end) {
+        return nullptr;
+    }
+
+    const char *start = pos;
+
+    while(pos != end and !is_separator(*pos)) {
+        ++pos;
+    }
+
+    return start;
+}
+
+/**
+ * \brief Convert a single item of text to a value
+ *
+ * \param[in]  begin Start of the item
+ * \param[in]  end   End of the item
+ * \param[out] dest  The value
+ *
+ * \returns True if the conversion succeeded
+ *
+ * \details Numbers are converted using std::from_chars, and the whole item
+ *          must be a valid number.  Strings are copied directly.  Any other
+ *          type is read using its stream operator.
+ */
+template <class T>
+auto parse_item(const char *begin,
+                const char *end,
+                T          &dest) -> bool
+{
+    if constexpr (std::is_floating_point_v<T> or
+                  (std::is_integral_v<T> and !std::is_same_v<T, bool> and !std::is_same_v<T, char>))
+    {
+        // Unlike stream input, from_chars doesn't accept a leading '+'
+        if(begin != end and *begin == '+') {
+            ++begin;
+        }
+
+        const auto result = std::from_chars(begin, end, dest);
+
+        // Reject items with trailing characters, such as "1.5x"
+        if(result.ptr != end) {
+            return false;
+        }
+
+        // Let strtod handle underflow and overflow in the same way as stream input
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if(result.ec == std::errc::result_out_of_range)
+            {
+                dest = static_cast<T>(std::strtod(std::string(begin, end).c_str(), nullptr));
+                return true;
+            }
+        }
+
+        return result.ec == std::errc();
+    }
+    else if constexpr (std::is_same_v<T, std::string>)
+    {
+        dest.assign(begin, end);
+        return true;
+    }
+    else
+    {
+        std::istringstream stream(std::string(begin, end));
+        return static_cast<bool>(stream >> dest);
+    }
+}
+
+/**
+ * \brief Read the next item on a line into a column of data
+ *
+ * \param[in,out] pos    Current position on the line
+ * \param[in]     end    End of the line
+ * \param[out]    column Destination column
+ * \param[in]     iline  Index of the line within the column
+ *
+ * \returns True if the item was found and converted
+ */
+template <class Tcontainer>
+auto parse_column(const char   *&pos,
+                  const char    *end,
+                  Tcontainer    &column,
+                  const size_t   iline) -> bool
+{
+    const char *item = next_item(pos, end);
+    return item != nullptr and parse_item(item, pos, column[iline]);
+}
+
+/**
+ * \brief Find the end of a line
+ *
+ * \param[in] line Start of the line
+ * \param[in] end  End of the data
+ *
+ * \returns Pointer to the newline character, or the end of the data
+ */
+inline auto find_line_end(const char *line,
+                          const char *end) -> const char *
+{
+    const auto *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+    return (line_end != nullptr) ? line_end : end;
+}
+} // namespace file_io_detail
+
+/**
+ * \brief Read columns of data from a file
+ *
+ * \param[in]  fname   Filename from which to read data
+ * \param[out] columns Containers into which each column of data is written
+ *
+ * \details The file is scanned twice.  The first pass finds each line of data,
+ *          so that every column can be sized exactly once.  The second pass
+ *          converts the data, and is split between threads if OpenMP is enabled.
+ *          Blank lines are skipped and any items after the last column are ignored.
+ */
+template <class... Tcolumns>
+void read_columns(const std::string &fname,
+                  Tcolumns       &...columns)
+{
+    const FileView file(fname);
+    const char *begin = file.data();
+    const char *end   = begin + file.size();
+
+    // Find the start of every line that contains data
+    std::vector<const char *> lines;
+
+    for(const char *line = begin; line < end;)
+    {
+        const char *line_end = file_io_detail::find_line_end(line, end);
+        const char *pos      = line;
+
+        if(file_io_detail::next_item(pos, line_end) != nullptr) {
+            lines.push_back(line);
+        }
+
+        line = line_end + 1;
+    }
+
+    const size_t n_lines = lines.size();
+    (columns.resize(n_lines), ...);
+
+    // Index of the first line that couldn't be read
+    size_t ibad = n_lines;
+
+#pragma omp parallel for schedule(static)
+    for(size_t iline = 0; iline < n_lines; ++iline)
+    {
+        const char *line_end = file_io_detail::find_line_end(lines[iline], end);
+        const char *pos      = lines[iline];
+
+        if(!(file_io_detail::parse_column(pos, line_end, columns, iline) and ...))
+        {
+#pragma omp critical
+            ibad = std::min(ibad, iline);
+        }
+    }
+
+    if(ibad != n_lines)
+    {
+        const char *line_end = file_io_detail::find_line_end(lines[ibad], end);
+
+        std::ostringstream oss;
+        oss << "Error reading " << fname << std::endl
+            << "Data missing or invalid on line: '" << std::string(lines[ibad], line_end) << "'";
+        throw std::runtime_error(oss.str());
+    }
+}
+
 /**
  * Read an array of size n from a single line
  *
@@ -38,81 +287,67 @@ template <template<typename, typename...> class Tcontainer,
           class T>
 auto read_line_array(Tcontainer<T> &dest, const size_t n, std::istream& stream) -> int
 {
-    const std::streamsize nbytes = 100; // Initial size of buffer
-    int scan_result=1; // Flag to show whether scan was successful [1=error]
-
     if(!stream.good()) {
         throw std::runtime_error("Could not read stream");
     }
 
-    // Buffer for line data
-    auto * linebuffer = new char[nbytes+1];
+    std::string line; // Buffer for line data
 
-    if(stream.getline(linebuffer, nbytes) && linebuffer[0] != '\0')
-    {
-        unsigned short i=0; // Loop counter for data items
-
-        // Pointer to a token on the line
-        char* pch=strtok(linebuffer, "\t ");
+    if(!std::getline(stream, line) or line.empty()) {
+        return 1;
+    }
 
-        /* Loop over all expected items on the line and read them to
-         * array one by one */
-        for(i=0; i<n; i++) {
-            if(pch == nullptr) {
-                throw std::runtime_error("Data missing on at least one line");
-	    }
+    const char *pos = line.data();
+    const char *end = pos + line.size();
 
-            dest[i]=atof(pch); // Copy data to array
-            pch=strtok(nullptr, "\t "); // Read next data item
+    // Loop over all expected items on the line and read them to array one by one
+    for(size_t i = 0; i < n; ++i) {
+        if(!file_io_detail::parse_column(pos, end, dest, i)) {
+            throw std::runtime_error("Data missing on at least one line");
         }
-
-        scan_result=0;
     }
 
-    delete[] linebuffer;
-    return scan_result;
+    return 0;
 }
 
 /**
  * Read an array of unknown size from a single line
  *
- * \param[in]  stream - Stream from which to read data
+ * \param[out] dest   Destination array for input data
+ * \param[in]  stream Stream from which to read data
  */
 template <template<typename, typename...> class Tcontainer,
           class T>
 void read_line_array_u(Tcontainer<T>& dest, std::istream& stream)
 {
-    constexpr size_t INITIAL_BUFFER_SIZE=10000;
-    std::streamsize nbytes=INITIAL_BUFFER_SIZE;
-
-    std::vector<T> dest_tmp; // Temp storage for output data
-
     if(!stream) {
         throw std::runtime_error("Could not read stream");
     }
-    
-    // Buffer for line data
-    char* linebuffer = new char[nbytes+1];
+
+    std::string line; // Buffer for line data
 
     // Read line from stream into input buffer
-    if(!stream.getline(linebuffer, nbytes) or linebuffer[0] == '\0') {
-        delete[] linebuffer;
+    if(!std::getline(stream, line) or line.empty()) {
         throw std::runtime_error("Blank input line detected");
     }
 
-    // Get a pointer to first token on line
-    char* pch=strtok(linebuffer, "\t ");
+    // Count the items first, so that the output only needs sizing once
+    const char *end = line.data() + line.size();
+    const char *pos = line.data();
+    size_t n = 0;
 
-    while(pch != nullptr)
-    {
-        dest_tmp.push_back(atof(pch)); // Copy data to array
-        pch = strtok(nullptr, "\t "); // Try to read next data from line
-    } 
+    while(file_io_detail::next_item(pos, end) != nullptr) {
+        ++n;
+    }
 
-    delete[] linebuffer;
+    dest.resize(n);
+    pos = line.data();
 
-    dest.resize(dest_tmp.size());
-    std::copy(dest_tmp.begin(), dest_tmp.end(), &dest[0]);
+    for(size_t i = 0; i < n; ++i) {
+        if(!file_io_detail::parse_column(pos, end, dest, i)) {
+            throw std::runtime_error("Could not read item");
+        }
+    }
 }
 
 void parse_items(std::istream &stream);
@@ -181,7 +416,7 @@ auto read_line(std::istream &stream,
         catch(std::runtime_error &e)
         {
             std::ostringstream err_ss;
-            err_ss << "Data missing on line: '" << linebuffer << "'";
+            err_ss << "Data missing or invalid on line: '" << linebuffer << "'";
             throw std::runtime_error(err_ss.str());
         }
     }
@@ -200,32 +435,7 @@ template <class Tstring,
           class T>
 void read_table(const Tstring fname, Tcontainer<T>& x)
 {
-    std::ifstream stream(fname);
-
-    if(!stream.is_open())
-    {
-        std::ostringstream oss;
-        oss << "Could not open " << fname;
-        throw std::runtime_error(oss.str());
-    }
-
-    std::vector<T> x_temp;
-
-    while(!stream.eof())
-    {
-        T buffer = 0; // Buffer for input data
-
-        // If data is valid, stick it into temp vector
-        if(!read_line(stream, buffer)) {
-            x_temp.push_back(buffer);
-	}
-    }
-    
-    stream.close();	
-    
-    // Copy data into output array
-    x.resize(x_temp.size());
-    std::copy(x_temp.begin(), x_temp.end(), &x[0]);
+    read_columns(std::string(fname), x);
 }
 
 
@@ -281,9 +491,8 @@ void write_table(const Tstring        fname,
  *                        you don't know the number, just omit this parameter
  *                        or set it to zero.
  *
- * \todo At the moment, the n_expected value is just used for checking the
- *       size of the data.  It might be sensible to allow it to be used for
- *       sizing the output arrays.  Probably a bit more efficient.
+ * \details The value of n_expected is only used for checking the size of the
+ *          data, since the file is always scanned to size the output arrays.
  */
 template <class Tstring,
           template<typename, typename...> class Tcontainerx,
@@ -295,51 +504,9 @@ void read_table(const Tstring    fname,
                 Tcontainery<Ty> &y,
                 const size_t     n_expected = 0)
 {
-    std::ifstream stream(fname);
+    read_columns(std::string(fname), x, y);
 
-    if(!stream.is_open())
-    {
-        std::ostringstream oss;
-        oss << "Could not open " << fname;
-        throw std::runtime_error(oss.str());
-    }
-
-    std::vector<Tx> x_temp;
-    std::vector<Ty> y_temp;
-
-    while(!stream.eof()){
-        Tx buffer_x = 0; // Buffer for x input data
-        Ty buffer_y = 0; // Buffer for y input data
-
-        // If data is valid, stick it into temp vector
-        try
-        {
-            if(!read_line(stream, buffer_x, buffer_y))
-            {
-                x_temp.push_back(buffer_x);
-                y_temp.push_back(buffer_y);
-            }
-        }
-        catch (std::runtime_error &e)
-        {
-            std::ostringstream err_st;
-            err_st << "Error reading " << fname << std::endl
-                   << e.what();
-            throw std::runtime_error(err_st.str());
-        }
-    }
-
-    const size_t nx = x_temp.size();
-    const size_t ny = y_temp.size();
-    x.resize(nx);
-    y.resize(ny);
-
-    if(nx != ny)
-    {
-        std::ostringstream oss;
-        oss << "Columns in " << fname << " are different lengths.";
-        throw std::runtime_error(oss.str());
-    }
+    const size_t nx = x.size();
 
     if(n_expected != 0 and nx != n_expected)
     {
@@ -348,12 +515,6 @@ void read_table(const Tstring    fname,
             << " lines of data. Expected " << n_expected;
         throw std::runtime_error(oss.str());
     }
-
-    // Copy data into output array
-    std::copy(x_temp.begin(), x_temp.end(), &x[0]);
-    std::copy(y_temp.begin(), y_temp.end(), &y[0]);
-
-    stream.close();	
 }
 
 
@@ -434,54 +595,7 @@ void read_table(const char      *fname,
                 Tcontainery<Ty> &y,
                 Tcontainerz<Tz> &z)
 {
-    std::ifstream stream(fname);
-
-    if(!stream.is_open())
-    {
-        std::ostringstream oss;
-        oss << "Could not open " << fname;
-        throw std::runtime_error(oss.str());
-    }
-
-    std::vector<Tx> x_temp;
-    std::vector<Ty> y_temp;
-    std::vector<Tz> z_temp;
-
-    while(!stream.eof()){
-        Tx buffer_x = 0; // Buffer for x input data
-        Ty buffer_y = 0; // Buffer for y input data
-        Tz buffer_z = 0; // Buffer for z input data
-
-        // If data is valid, stick it into temp vector
-        if(!read_line(stream, buffer_x, buffer_y, buffer_z))
-        {
-            x_temp.push_back(buffer_x);
-            y_temp.push_back(buffer_y);
-            z_temp.push_back(buffer_z);
-        }
-    }
-
-    const size_t nx = x_temp.size();
-    const size_t ny = y_temp.size();
-    const size_t nz = z_temp.size();
-    x.resize(nx);
-    y.resize(ny);
-    z.resize(nz);
-
-    if(nx != ny or nx != nz or ny != nz)
-    {
-        std::ostringstream oss;
-        oss << "Columns in " << fname << " have different lengths: nx = " << nx
-            << ", ny = " << ny << ", nz = " << nz;
-        throw std::runtime_error(oss.str());
-    }
-
-    // Copy data into output container
-    std::copy(x_temp.begin(), x_temp.end(), &x[0]);
-    std::copy(y_temp.begin(), y_temp.end(), &y[0]);
-    std::copy(z_temp.begin(), z_temp.end(), &z[0]);
-
-    stream.close();	
+    read_columns(std::string(fname), x, y, z);
 }
 
 /**
@@ -513,60 +627,7 @@ void read_table(const Tstring                 fname,
                 Tcontainerz<Tz, TzParams...> &z,
                 Tcontaineru<Tu, TuParams...> &u)
 {
-    std::ifstream stream(fname);
-
-    if(!stream.is_open())
-    {
-        std::ostringstream oss;
-        oss << "Could not open " << fname;
-        throw std::runtime_error(oss.str());
-    }
-
-    std::vector<Tx> x_temp;
-    std::vector<Ty> y_temp;
-    std::vector<Tz> z_temp;
-    std::vector<Tu> u_temp;
-
-    while(!stream.eof()){
-        Tx buffer_x; // Buffer for x input data
-        Ty buffer_y; // Buffer for y input data
-        Tz buffer_z; // Buffer for z input data
-        Tu buffer_u; // Buffer for u input data
-
-        // If data is valid, stick it into temp vector
-        if(!read_line(stream, buffer_x, buffer_y, buffer_z, buffer_u))
-        {
-            x_temp.push_back(buffer_x);
-            y_temp.push_back(buffer_y);
-            z_temp.push_back(buffer_z);
-            u_temp.push_back(buffer_u);
-        }
-    }
-
-    const size_t nx = x_temp.size();
-    const size_t ny = y_temp.size();
-    const size_t nz = z_temp.size();
-    const size_t nu = u_temp.size();
-    x.resize(nx);
-    y.resize(ny);
-    z.resize(nz);
-    u.resize(nu);
-
-    if(nx != ny || nx != nz || ny != nz || nu != nz)
-    {
-        std::ostringstream oss;
-        oss << "Columns in " << fname << " have different lengths: nx = " << nx
-            << ", ny = " << ny << ", nz = " << nz << ", nu = " << nu;
-        throw std::runtime_error(oss.str());
-    }
-
-    // Copy data into output array
-    std::copy(x_temp.begin(), x_temp.end(), &x[0]);
-    std::copy(y_temp.begin(), y_temp.end(), &y[0]);
-    std::copy(z_temp.begin(), z_temp.end(), &z[0]);
-    std::copy(u_temp.begin(), u_temp.end(), &u[0]);
-
-    stream.close();
+    read_columns(std::string(fname), x, y, z, u);
 }
 
 /**
@@ -0,0 +1,132 @@
+/**
+ * \file   heat-equation.cpp
+ * \brief  Time-stepping for the one-dimensional heat equation
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "heat-equation.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "linear-algebra.h"
+
+namespace QWWAD
+{
+namespace
+{
+/**
+ * \brief Harmonic mean of thermal conductivity across an interface [W/m/K]
+ *
+ * \details This is Eq. 3.25 in Craig's thesis.  It is exact for an interface
+ *          that lies midway between two points of uniform material.
+ */
+inline auto interface_k(const double k1,
+                        const double k2) -> double
+{
+    return (2*k1*k2)/(k1+k2);
+}
+} // namespace
+
+/**
+ * \brief Find the temperature profile at the next time-step
+ *
+ * \param[in] dt     Time-step [s]
+ * \param[in] dy     Spatial step [m]
+ * \param[in] T_old  Temperature at each point at the start of the step [K]
+ * \param[in] k      Thermal conductivity at each point [W/m/K]
+ * \param[in] rho_cp Product of density and specific heat capacity at each point [J/(m^3.K)]
+ * \param[in] q_old  Power density at the start of the step [W/m^3]
+ * \param[in] q_new  Power density at the end of the step [W/m^3]
+ *
+ * \returns Temperature at each point at the end of the step [K]
+ *
+ * \details The Crank-Nicolson method is used.  The first point is held at
+ *          its initial temperature (Dirichlet boundary), and the last point
+ *          is insulated (Neumann boundary).  Each interface uses the harmonic
+ *          mean of the conductivities at the points on either side.
+ */
+auto heat_step_crank_nicolson(const double     dt,
+                              const double     dy,
+                              const arma::vec &T_old,
+                              const arma::vec &k,
+                              const arma::vec &rho_cp,
+                              const arma::vec &q_old,
+                              const arma::vec &q_new) -> arma::vec
+{
+    const auto ny = T_old.size();
+
+    if(k.size() != ny or rho_cp.size() != ny or q_old.size() != ny or q_new.size() != ny)
+    {
+        std::ostringstream oss;
+        oss << "Material and heating profiles must all have " << ny << " points";
+        throw std::length_error(oss.str());
+    }
+
+    if(ny < 3) {
+        throw std::length_error("At least three points are needed for the heat equation");
+    }
+
+    const auto dy_sq = dy*dy;
+
+    // Note that the bottom of the device is not calculated.  We leave it
+    // set to the heatsink temperature (Dirichlet boundary)
+    arma::vec LHS_diag      = arma::ones(ny);
+    arma::vec LHS_subdiag   = arma::zeros(ny-1);
+    arma::vec LHS_superdiag = arma::zeros(ny-1);
+
+    // Material parameter matrix for RHS of Crank-Nicolson solver
+    arma::vec B_diag      = arma::ones(ny);
+    arma::vec B_superdiag = arma::zeros(ny-1);
+    arma::vec B_subdiag   = arma::zeros(ny-1);
+
+    arma::vec q = arma::zeros(ny); // heating vector for RHS of Crank-Nicolson solver
+
+    for(unsigned int iy=1; iy<ny-1; iy++)
+    {
+        const auto kn = interface_k(k(iy), k(iy+1));
+        const auto ks = interface_k(k(iy), k(iy-1));
+        const auto r = dt/(2.0*rho_cp(iy));
+        const auto alpha = r*ks/dy_sq;
+        const auto gamma = r*kn/dy_sq;
+
+        B_subdiag(iy-1) = alpha;
+        B_superdiag(iy) = gamma;
+        B_diag(iy)      = 1.0 - (alpha+gamma);
+
+        LHS_subdiag(iy-1) = -alpha;
+        LHS_superdiag(iy) = -gamma;
+        LHS_diag(iy)      = 1.0 + (alpha+gamma);
+
+        q(iy) = r*(q_old(iy)+q_new(iy));
+    }
+
+    // At last point, use Neumann boundary, i.e. dT/dy=0, which gives
+    // T[n] = T[n-2] in the finite-difference approximation.  The flux
+    // still crosses the interface below the last point.
+    const auto kns = interface_k(k(ny-1), k(ny-2));
+    const auto r = dt/(2.0*rho_cp(ny-1));
+    const auto alpha_gamma = r*kns/dy_sq;
+    B_subdiag(ny-2) = 2.0*alpha_gamma;
+    B_diag(ny-1)    = 1.0 - 2.0*alpha_gamma;
+
+    LHS_subdiag(ny-2) = -2.0*alpha_gamma;
+    LHS_diag(ny-1) = 1.0 + 2.0*alpha_gamma;
+
+    q(ny-1) = r*(q_old(ny-1)+q_new(ny-1));
+
+    // Perform matrix multiplication to get the RHS vector of the
+    // Crank-Nicolson solver
+    const auto RHS = multiply_vec_tridiag(B_subdiag,
+                                          B_diag,
+                                          B_superdiag,
+                                          T_old,
+                                          q);
+
+    return solve_tridiag(LHS_subdiag,
+                         LHS_diag,
+                         LHS_superdiag,
+                         RHS);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,23 @@
+/**
+ * \file   heat-equation.h
+ * \brief  Time-stepping for the one-dimensional heat equation
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_HEAT_EQUATION_H
+#define QWWAD_HEAT_EQUATION_H
+
+#include <armadillo>
+
+namespace QWWAD
+{
+auto heat_step_crank_nicolson(double           dt,
+                              double           dy,
+                              const arma::vec &T_old,
+                              const arma::vec &k,
+                              const arma::vec &rho_cp,
+                              const arma::vec &q_old,
+                              const arma::vec &q_new) -> arma::vec;
+} // namespace
+#endif //QWWAD_HEAT_EQUATION_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,169 @@
+/**
+ * \file   interdiffusion.cpp
+ * \brief  Coupled interdiffusion of several species on a shared sublattice
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "interdiffusion.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include "linear-algebra.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Constructor
+ *
+ * \param[in] z  Spatial location of each point (uniformly spaced) [m]
+ * \param[in] c0 Initial fraction of each independent species (one column per species)
+ * \param[in] D  Diffusion matrix [m^2/s]
+ */
+Interdiffusion::Interdiffusion(const arma::vec &z,
+                               const arma::mat &c0,
+                               const arma::mat &D)
+{
+    const auto nz = z.size();
+    const auto ns = c0.n_cols;
+
+    if(nz < 2) {
+        throw std::length_error("At least two spatial points are needed for interdiffusion");
+    }
+
+    if(c0.n_rows != nz || D.n_rows != ns || D.n_cols != ns)
+    {
+        std::ostringstream oss;
+        oss << "Interdiffusion profile (" << c0.n_rows << " x " << c0.n_cols
+            << ") and diffusion matrix (" << D.n_rows << " x " << D.n_cols
+            << ") do not match the " << nz << " spatial points";
+        throw std::length_error(oss.str());
+    }
+
+    _dz = z(1) - z(0);
+
+    // Decouple the species into independent diffusion modes
+    arma::cx_vec lambda;
+    arma::cx_mat P;
+
+    if(!arma::eig_gen(lambda, P, D)) {
+        throw std::runtime_error("Could not diagonalise diffusion matrix");
+    }
+
+    if(arma::abs(arma::imag(lambda)).max() > 1e-12*arma::abs(lambda).max()) {
+        throw std::domain_error("Diffusion matrix has complex eigenvalues");
+    }
+
+    _lambda = arma::real(lambda);
+    _P      = arma::real(P);
+
+    if(_lambda.min() < 0) {
+        throw std::domain_error("Diffusion matrix must not have negative eigenvalues");
+    }
+
+    // Each row of c0 is transformed as c = P u
+    _u = c0 * arma::inv(_P).t();
+}
+
+/**
+ * \brief Take a number of equal time-steps
+ *
+ * \param[in] dt      Time-step [s]
+ * \param[in] theta   Implicitness of scheme (0.5 = Crank-Nicolson, 1 = backward Euler)
+ * \param[in] n_steps Number of steps to take
+ */
+void Interdiffusion::march(const double       dt,
+                           const double       theta,
+                           const unsigned int n_steps)
+{
+    const auto nz = _u.n_rows;
+
+    for(unsigned int is = 0; is < _lambda.size(); ++is)
+    {
+        const double r = _lambda(is)*dt/(_dz*_dz);
+
+        if(r == 0.0) {
+            continue;
+        }
+
+        // Implicit matrix, using flux-conservative form with closed ends
+        arma::vec A_diag = arma::ones(nz) + 2.0*theta*r;
+        A_diag(0)    -= theta*r;
+        A_diag(nz-1) -= theta*r;
+        const arma::vec A_sub = -theta*r*arma::ones(nz-1);
+
+        arma::vec D_fac;
+        arma::vec L_fac;
+        factorise_tridiag_LDL_T(A_diag, A_sub, D_fac, L_fac);
+
+        const double r_exp = (1.0-theta)*r;
+        arma::vec u = _u.col(is);
+        arma::vec rhs(nz);
+
+        for(unsigned int it = 0; it < n_steps; ++it)
+        {
+            rhs = u;
+
+            if(r_exp > 0.0)
+            {
+                for(unsigned int iz = 0; iz+1 < nz; ++iz)
+                {
+                    const double flux = r_exp*(u(iz+1) - u(iz));
+                    rhs(iz)   += flux;
+                    rhs(iz+1) -= flux;
+                }
+            }
+
+            u = solve_tridiag_LDL_T(D_fac, L_fac, rhs);
+        }
+
+        _u.col(is) = u;
+    }
+}
+
+/**
+ * \brief Continue the anneal up to a given time
+ *
+ * \param[in] t_end Time at which to stop [s]
+ */
+void Interdiffusion::advance(const double t_end)
+{
+    double t_remain = t_end - _t;
+
+    if(t_remain < 0)
+    {
+        std::ostringstream oss;
+        oss << "Cannot anneal backwards in time from " << _t << " s to " << t_end << " s";
+        throw std::domain_error(oss.str());
+    }
+
+    if(t_remain == 0) {
+        return;
+    }
+
+    auto n_steps = static_cast<unsigned int>(std::ceil(t_remain/_dt_max));
+    double dt = t_remain/n_steps;
+
+    // Damp the first step using backward Euler
+    if(!_started)
+    {
+        march(dt/4, 1.0, 4);
+        _started = true;
+        --n_steps;
+    }
+
+    march(dt, 0.5, n_steps);
+
+    _t = t_end;
+}
+
+/**
+ * \brief Get the current fraction of each independent species at each point
+ */
+auto Interdiffusion::get_profile() const -> arma::mat
+{
+    return _u * _P.t();
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,67 @@
+/**
+ * \file   interdiffusion.h
+ * \brief  Coupled interdiffusion of several species on a shared sublattice
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_INTERDIFFUSION_H
+#define QWWAD_INTERDIFFUSION_H
+
+#include <armadillo>
+
+namespace QWWAD
+{
+/**
+ * \brief Solver for coupled interdiffusion of several species
+ *
+ * \details The species share a sublattice, so their fractions at each point
+ *          sum to one.  Only the independent species are simulated, and the
+ *          remaining (host) species makes up the balance.  The fraction of
+ *          each independent species evolves as
+ *          \f[
+ *            \frac{\partial c_i}{\partial t} = \sum_j D_{ij}\frac{\partial^2 c_j}{\partial z^2},
+ *          \f]
+ *          where the diffusion matrix, \f$D_{ij}\f$ includes any cross-coupling
+ *          between species.  The system is closed, so no material flows
+ *          through the ends of the structure.
+ *
+ *          The diffusion matrix is diagonalised once, which decouples the
+ *          system into independent modes.  Each mode is then stepped using
+ *          the Crank-Nicolson method with a pre-factorised tridiagonal matrix.
+ *          The first step is split into four backward-Euler steps, which damps
+ *          the oscillations that Crank-Nicolson would otherwise produce at the
+ *          abrupt interfaces of an as-grown structure.
+ */
+class Interdiffusion
+{
+public:
+    Interdiffusion(const arma::vec &z,
+                   const arma::mat &c0,
+                   const arma::mat &D);
+
+    void advance(double t_end);
+
+    [[nodiscard]] auto get_profile() const -> arma::mat;
+
+    /// Get the time that has elapsed since the start of the anneal [s]
+    [[nodiscard]] inline auto get_time() const -> double {return _t;}
+
+    /// Set the largest time-step to use [s]
+    inline void set_max_step(const double dt_max) {_dt_max = dt_max;}
+
+private:
+    double    _dz;          ///< Spatial step [m]
+    arma::mat _P;           ///< Eigenvectors of diffusion matrix
+    arma::vec _lambda;      ///< Eigenvalues of diffusion matrix [m^2/s]
+    arma::mat _u;           ///< Amplitude of each mode at each point
+    double    _t      = 0;  ///< Time elapsed [s]
+    double    _dt_max = 1;  ///< Largest time-step [s]
+    bool      _started = false; ///< True once the first (damped) step has been taken
+
+    void march(double       dt,
+               double       theta,
+               unsigned int n_steps);
+};
+} // namespace
+#endif //QWWAD_INTERDIFFUSION_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -299,6 +299,259 @@ eigen_tridiag(arma::vec    &diag,
     return solutions;
 }
 
+/**
+ * \brief Find a range of solutions to a Hermitian eigenvalue problem
+ *
+ * \param[out]    E     Eigenvalues, in ascending order
+ * \param[out]    Z     Eigenvectors, with one solution per column
+ * \param[in,out] A     Hermitian matrix.  The upper triangle is used and is
+ *                      destroyed on output.
+ * \param[in]     i_min Index of lowest eigenvalue to find (counting from zero)
+ * \param[in]     i_max Index of highest eigenvalue to find
+ *
+ * \details    Uses the LAPACK zheevr function, which only computes the
+ *             requested eigenvectors.  This is much faster than a full
+ *             solution when only a few of the states are needed.
+ */
+void
+eig_sym_range(arma::vec    &E,
+              arma::cx_mat &Z,
+              arma::cx_mat &A,
+              unsigned int  i_min,
+              unsigned int  i_max)
+{
+    int N = A.n_rows;
+
+    if(A.n_cols != A.n_rows || i_min > i_max || i_max >= A.n_rows)
+    {
+        std::ostringstream oss;
+        oss << "Cannot find eigenvalues " << i_min << " to " << i_max << " of a "
+            << A.n_rows << "x" << A.n_cols << " matrix";
+        throw std::domain_error(oss.str());
+    }
+
+    char   jobz  = 'V'; // Task descriptor for LAPACK
+    char   range = 'I'; // Find solutions by index
+    char   uplo  = 'U'; // Specify that upper triangle is stored
+    double VL    = 0.0; // Unused value limits
+    double VU    = 0.0;
+    int    IL    = i_min + 1; // LAPACK indices count from 1
+    int    IU    = i_max + 1;
+    int    M     = 0; // Number of solutions found
+    int    info  = 0; // Output code from LAPACK
+
+    // Find error tolerance
+    char retval = 'S'; // Return value for LAPACK
+    double abstol = 2.0 * dlamch_(&retval
+#ifdef LAPACK_FORTRAN_STRLEN_END
+            ,1
+#endif
+            );
+
+    E.set_size(N);
+    Z.set_size(N, IU-IL+1);
+    arma::Col<int> isuppz(2*(IU-IL+1));
+
+    // LAPACK workspace.  The first pass only finds the optimal size
+    arma::cx_vec   work(1);
+    arma::vec      rwork(1);
+    arma::Col<int> iwork(1);
+    int lwork  = -1;
+    int lrwork = -1;
+    int liwork = -1;
+
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        zheevr_(&jobz, &range, &uplo, &N,
+                reinterpret_cast<lapack_complex_double *>(A.memptr()), &N,
+                &VL, &VU, &IL, &IU, &abstol, &M, E.memptr(),
+                reinterpret_cast<lapack_complex_double *>(Z.memptr()), &N,
+                isuppz.memptr(),
+                reinterpret_cast<lapack_complex_double *>(work.memptr()), &lwork,
+                rwork.memptr(), &lrwork,
+                iwork.memptr(), &liwork,
+                &info
+#ifdef LAPACK_FORTRAN_STRLEN_END
+                , 1, 1, 1
+#endif
+                );
+
+        if(info != 0)
+        {
+            std::ostringstream oss;
+            oss << "Could not solve eigenvalue problem. LAPACK error code: "
+                << info;
+            throw std::runtime_error(oss.str());
+        }
+
+        if(pass == 0)
+        {
+            lwork  = static_cast<int>(work[0].real());
+            lrwork = static_cast<int>(rwork[0]);
+            liwork = iwork[0];
+            work.set_size(lwork);
+            rwork.set_size(lrwork);
+            iwork.set_size(liwork);
+        }
+    }
+
+    E.resize(M);
+    Z.resize(N, M);
+}
+
+/**
+ * \brief Find the eigenstates of a Hermitian operator closest to a reference value
+ *
+ * \param[out]    E         Eigenvalues, in ascending order
+ * \param[in,out] X         Eigenvectors, with one solution per column.  If this
+ *                          has the correct size on input, it is used as the
+ *                          initial guess.  Otherwise, a random guess is used.
+ * \param[in]     apply_H   Function that multiplies a set of column vectors by the operator
+ * \param[in]     precond   Diagonal preconditioner for the folded operator
+ * \param[in]     E_ref     Reference value
+ * \param[in]     n_states  Number of solutions to find
+ * \param[in]     tolerance Largest acceptable residual, |H x - E x|, for each solution
+ * \param[in]     max_iter  Maximum number of iterations
+ *
+ * \details    The operator is never formed as a matrix, so only the cost of
+ *             applying it matters.  The solutions closest to E_ref are the
+ *             lowest states of the folded operator, A = (H - E_ref)^2, which
+ *             are found using the locally-optimal block preconditioned
+ *             conjugate gradient (LOBPCG) method.  A final Rayleigh-Ritz
+ *             step with H itself separates any states that lie symmetrically
+ *             either side of E_ref.
+ */
+void
+eig_folded(arma::vec                                              &E,
+           arma::cx_mat                                           &X,
+           const std::function<arma::cx_mat(const arma::cx_mat &)> &apply_H,
+           const arma::vec                                        &precond,
+           const double                                            E_ref,
+           const unsigned int                                      n_states,
+           const double                                            tolerance,
+           const unsigned int                                      max_iter)
+{
+    const size_t n = precond.size();
+
+    if(n_states == 0 || 3*n_states > n)
+    {
+        std::ostringstream oss;
+        oss << "Cannot find " << n_states << " states with a basis of " << n << " vectors";
+        throw std::domain_error(oss.str());
+    }
+
+    if(X.n_rows != n || X.n_cols != n_states) {
+        X = arma::randu<arma::cx_mat>(n, n_states) - std::complex<double>(0.5, 0.5);
+    }
+
+    // Apply the folded operator.  H V is also kept, so that H never needs
+    // to be applied to a combination of existing vectors.
+    const auto apply_folded = [&apply_H, E_ref](const arma::cx_mat &V,
+                                                arma::cx_mat       &HV,
+                                                arma::cx_mat       &AV)
+    {
+        HV = apply_H(V);
+        const arma::cx_mat Y = HV - E_ref*V;
+        AV = apply_H(Y) - E_ref*Y;
+    };
+
+    // Scale each column of a block to unit norm.  This keeps the search
+    // space well conditioned as the residuals become small.
+    const auto normalise_columns = [](arma::cx_mat &V,
+                                      arma::cx_mat &HV,
+                                      arma::cx_mat &AV)
+    {
+        arma::rowvec norms = arma::sqrt(arma::sum(arma::square(arma::abs(V)), 0));
+        norms.elem(arma::find(norms == 0.0)).ones();
+        const arma::cx_rowvec scale = arma::conv_to<arma::cx_rowvec>::from(1.0/norms);
+        V.each_row()  %= scale;
+        HV.each_row() %= scale;
+        AV.each_row() %= scale;
+    };
+
+    arma::cx_mat Q;
+    arma::cx_mat R;
+    arma::qr_econ(Q, R, X);
+    X = Q;
+
+    arma::cx_mat HX;
+    arma::cx_mat AX;
+    apply_folded(X, HX, AX);
+
+    // Search directions from the previous iteration
+    arma::cx_mat P(n, 0);
+    arma::cx_mat HP(n, 0);
+    arma::cx_mat AP(n, 0);
+
+    for(unsigned int iter = 0; iter < max_iter; ++iter)
+    {
+        // Check convergence using the eigenvectors of H in the current subspace
+        arma::cx_mat H_sub = X.t() * HX;
+        H_sub = 0.5*(H_sub + H_sub.t());
+        arma::cx_mat C;
+        arma::eig_sym(E, C, H_sub);
+
+        const arma::cx_mat X_H  = X * C;
+        const arma::cx_mat HX_H = HX * C;
+        const arma::cx_mat res  = HX_H - X_H * arma::diagmat(E);
+
+        if(arma::max(arma::sqrt(arma::sum(arma::square(arma::abs(res)), 0))) < tolerance)
+        {
+            X = X_H;
+            return;
+        }
+
+        // Preconditioned residuals of the folded problem give the new directions
+        const arma::vec theta = arma::real(arma::sum(arma::conj(X) % AX, 0)).t();
+        arma::cx_mat W = AX - X * arma::diagmat(theta);
+        W.each_col() %= arma::conv_to<arma::cx_vec>::from(precond);
+
+        arma::cx_mat HW;
+        arma::cx_mat AW;
+        apply_folded(W, HW, AW);
+        normalise_columns(W, HW, AW);
+        normalise_columns(P, HP, AP);
+
+        const arma::cx_mat S  = arma::join_rows(X,  W,  P);
+        const arma::cx_mat HS = arma::join_rows(HX, HW, HP);
+        const arma::cx_mat AS = arma::join_rows(AX, AW, AP);
+
+        // Orthonormalise the search space, dropping any dependent directions
+        arma::cx_mat M = S.t() * S;
+        M = 0.5*(M + M.t());
+        arma::vec    mu;
+        arma::cx_mat U;
+        arma::eig_sym(mu, U, M);
+
+        const arma::uvec keep = arma::find(mu > 1e-12*mu.max());
+        const arma::cx_mat T  = U.cols(keep) * arma::diagmat(1.0/arma::sqrt(mu(keep)));
+
+        // Rayleigh-Ritz for the folded operator
+        arma::cx_mat A_sub = T.t() * (S.t() * AS) * T;
+        A_sub = 0.5*(A_sub + A_sub.t());
+        arma::vec    lambda;
+        arma::cx_mat Z;
+        arma::eig_sym(lambda, Z, A_sub);
+
+        // Coefficients of the lowest Ritz vectors in terms of S
+        const arma::cx_mat Y = T * Z.cols(0, n_states-1);
+
+        X  = S  * Y;
+        HX = HS * Y;
+        AX = AS * Y;
+
+        // The new search directions exclude the contribution from the old X
+        const arma::cx_mat Y_WP = Y.rows(n_states, S.n_cols-1);
+        P  = S.cols(n_states, S.n_cols-1)  * Y_WP;
+        HP = HS.cols(n_states, S.n_cols-1) * Y_WP;
+        AP = AS.cols(n_states, S.n_cols-1) * Y_WP;
+    }
+
+    std::ostringstream oss;
+    oss << "Folded-spectrum eigensolver did not converge in " << max_iter << " iterations";
+    throw std::runtime_error(oss.str());
+}
+
 /**
  * \brief Solves a matrix of the cyclic form, generated from the cyclic form of the Poisson solver
  *
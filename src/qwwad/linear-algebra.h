@@ -12,6 +12,7 @@
 #endif //HAVE_CONFIG_H
 
 #include <complex>
+#include <functional>
 #include <utility>
 
 #include <vector>
@@ -153,6 +154,21 @@ auto eigen_tridiag(arma::vec    &diag,
                    double        VU,
                    unsigned int  n_max = 0) -> std::vector<EVP_solution<double>>;
 
+void eig_sym_range(arma::vec    &E,
+                   arma::cx_mat &Z,
+                   arma::cx_mat &A,
+                   unsigned int  i_min,
+                   unsigned int  i_max);
+
+void eig_folded(arma::vec                                              &E,
+                arma::cx_mat                                           &X,
+                const std::function<arma::cx_mat(const arma::cx_mat &)> &apply_H,
+                const arma::vec                                        &precond,
+                double                                                  E_ref,
+                unsigned int                                            n_states,
+                double                                                  tolerance,
+                unsigned int                                            max_iter = 1000);
+
 auto multiply_vec_tridiag(arma::vec const &M_sub,
                           arma::vec const &M_diag,
                           arma::vec const &M_super,
@@ -0,0 +1,613 @@
+/**
+ * \file   material-library-cache.cpp
+ * \brief  Compiled, memory-mapped form of the material library
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "material-library-cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+#include "material.h"
+#include "material-property-constant.h"
+#include "material-property-interp.h"
+#include "material-property-poly.h"
+#include "material-property-string.h"
+
+namespace QWWAD {
+namespace {
+/// Signature at the start of every cache file
+const char cache_magic[8] = {'Q', 'W', 'W', 'A', 'D', 'M', 'L', '\0'};
+
+/// Version of the cache format.  Increment this whenever the layout changes
+const uint32_t cache_version = 2;
+
+/**
+ * \brief Find the modification time of a file
+ *
+ * \param[in]  filename Name of file
+ * \param[out] mtime    Modification time [ns since epoch]
+ * \param[out] size     Size of file [bytes]
+ *
+ * \returns True if the file could be inspected
+ */
+auto stat_file(const std::string &filename,
+               int64_t           &mtime,
+               uint64_t          &size) -> bool
+{
+    std::error_code ec;
+    const auto t = std::filesystem::last_write_time(filename, ec);
+
+    if(ec) {
+        return false;
+    }
+
+    size = std::filesystem::file_size(filename, ec);
+
+    if(ec) {
+        return false;
+    }
+
+    mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    return true;
+}
+} // namespace
+
+/**
+ * \brief Map a cache file
+ *
+ * \param[in] cache_filename Name of the cache file
+ *
+ * \details The contents are not checked here.  See open().
+ */
+MaterialLibraryCache::MaterialLibraryCache(const std::string &cache_filename) :
+    _file(cache_filename)
+{}
+
+/**
+ * \brief Find the name of the cache file for a given XML library
+ *
+ * \param[in] xml_filename Name of the XML material library
+ *
+ * \returns The name of the cache file, or an empty string if no cache directory is available
+ */
+auto MaterialLibraryCache::get_cache_filename(const std::string &xml_filename) -> std::string
+{
+    std::filesystem::path dir;
+
+    if(const char *env = std::getenv("QWWAD_CACHE_DIR")) {
+        dir = env;
+    } else if(const char *env = std::getenv("XDG_CACHE_HOME")) {
+        dir = std::filesystem::path(env) / "qwwad";
+    } else if(const char *env = std::getenv("HOME")) {
+        dir = std::filesystem::path(env) / ".cache" / "qwwad";
+    } else {
+        return "";
+    }
+
+    // Name the cache after the absolute path of the XML file, so that several
+    // libraries can be cached side by side
+    std::error_code ec;
+    const auto path = std::filesystem::absolute(xml_filename, ec).string();
+
+    if(ec) {
+        return "";
+    }
+
+    std::ostringstream oss;
+    oss << "material-library-" << std::hex << fnv1a(path.data(), path.size()) << ".bin";
+    return (dir / oss.str()).string();
+}
+
+/**
+ * \brief Find the FNV-1a hash of the contents of a file
+ *
+ * \param[in]  filename Name of file
+ * \param[out] hash     Hash of file contents
+ *
+ * \returns True if the file could be read
+ */
+auto MaterialLibraryCache::hash_file(const std::string &filename,
+                                     uint64_t          &hash) -> bool
+{
+    std::ifstream stream(filename, std::ios::binary);
+
+    if(!stream.is_open()) {
+        return false;
+    }
+
+    std::vector<char> buffer(1 << 16);
+    hash = fnv1a_offset;
+
+    while(stream) {
+        stream.read(buffer.data(), buffer.size());
+        hash = fnv1a(buffer.data(), stream.gcount(), hash);
+    }
+
+    return stream.eof();
+}
+
+/**
+ * \brief Open the compiled cache for an XML material library
+ *
+ * \param[in] xml_filename Name of the XML material library
+ *
+ * \returns The cache, or a null pointer if no valid cache exists for the XML file
+ *
+ * \details A null pointer is returned rather than throwing an exception, since
+ *          the caller can always fall back to parsing the XML file.
+ */
+auto MaterialLibraryCache::open(const std::string &xml_filename) -> std::shared_ptr<const MaterialLibraryCache>
+{
+#ifdef _WIN32
+    static_cast<void>(xml_filename);
+    return nullptr;
+#else
+    int64_t  xml_mtime = 0;
+    uint64_t xml_size  = 0;
+
+    if(!stat_file(xml_filename, xml_mtime, xml_size)) {
+        return nullptr;
+    }
+
+    const auto cache_filename = get_cache_filename(xml_filename);
+
+    if(cache_filename.empty()) {
+        return nullptr;
+    }
+
+    // The constructor is private, so std::make_shared can't be used
+    std::shared_ptr<MaterialLibraryCache> cache;
+
+    try {
+        cache.reset(new MaterialLibraryCache(cache_filename));
+    } catch(const std::runtime_error &) {
+        return nullptr;
+    }
+
+    const auto  size   = cache->_file.size();
+    const char *bytes  = cache->_file.data();
+    const auto *header = reinterpret_cast<const Header *>(bytes);
+
+    if(size < sizeof(Header) ||
+       std::memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+       header->version != cache_version) {
+        return nullptr;
+    }
+
+    const size_t materials_offset  = sizeof(Header);
+    const size_t properties_offset = materials_offset  + header->n_materials  * sizeof(MaterialRecord);
+    const size_t values_offset     = properties_offset + header->n_properties * sizeof(PropertyRecord);
+    const size_t strings_offset    = values_offset     + header->n_doubles    * sizeof(double);
+
+    if(header->strings_size == 0 || strings_offset + header->strings_size != size ||
+       bytes[size - 1] != '\0') {
+        return nullptr;
+    }
+
+    // Only hash the XML file if its timestamp or size has changed
+    if(header->xml_mtime != xml_mtime || header->xml_size != xml_size) {
+        uint64_t xml_hash = 0;
+
+        if(!hash_file(xml_filename, xml_hash) || xml_hash != header->xml_hash) {
+            return nullptr;
+        }
+    }
+
+    cache->_header     = header;
+    cache->_materials  = reinterpret_cast<const MaterialRecord *>(bytes + materials_offset);
+    cache->_properties = reinterpret_cast<const PropertyRecord *>(bytes + properties_offset);
+    cache->_values     = reinterpret_cast<const double *>(bytes + values_offset);
+    cache->_strings    = bytes + strings_offset;
+
+    // Check that all indices lie within the file, so that a damaged cache
+    // can never be dereferenced out of range
+    const auto valid_string = [header](const uint32_t offset) {return offset < header->strings_size;};
+
+    for(uint32_t imat = 0; imat < header->n_materials; ++imat) {
+        const auto &mat = cache->_materials[imat];
+
+        if(!valid_string(mat.name) || !valid_string(mat.description) ||
+           mat.first_property > header->n_properties ||
+           mat.n_properties > header->n_properties - mat.first_property) {
+            return nullptr;
+        }
+    }
+
+    for(uint32_t iprop = 0; iprop < header->n_properties; ++iprop) {
+        const auto &prop = cache->_properties[iprop];
+
+        if(prop.type > PROPERTY_STRING ||
+           !valid_string(prop.name) || !valid_string(prop.description) ||
+           !valid_string(prop.reference) || !valid_string(prop.unit) || !valid_string(prop.text) ||
+           prop.first_value > header->n_doubles ||
+           prop.n_values > header->n_doubles - prop.first_value) {
+            return nullptr;
+        }
+    }
+
+    return cache;
+#endif
+}
+
+/**
+ * \brief Compile a parsed material library into a cache file
+ *
+ * \param[in] xml_filename Name of the XML file from which the library was parsed
+ * \param[in] materials    The parsed set of materials
+ *
+ * \returns True if the cache was written
+ *
+ * \details The file is written under a temporary name and then renamed, so
+ *          that concurrent programs never see a partially written cache.
+ *          Failure is not an error, since the cache is only an optimisation.
+ */
+auto MaterialLibraryCache::write(const std::string                             &xml_filename,
+                                 const boost::ptr_map<Glib::ustring, Material> &materials) -> bool
+{
+#ifdef _WIN32
+    static_cast<void>(xml_filename);
+    static_cast<void>(materials);
+    return false;
+#else
+    Header header {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+
+    if(!stat_file(xml_filename, header.xml_mtime, header.xml_size) ||
+       !hash_file(xml_filename, header.xml_hash)) {
+        return false;
+    }
+
+    const auto cache_filename = get_cache_filename(xml_filename);
+
+    if(cache_filename.empty()) {
+        return false;
+    }
+
+    // String table. Offset zero is always the empty string
+    std::string                     strings(1, '\0');
+    std::map<std::string, uint32_t> string_offsets;
+
+    const auto add_string = [&strings, &string_offsets](const Glib::ustring &str) -> uint32_t {
+        if(str.empty()) {
+            return 0;
+        }
+
+        const auto it = string_offsets.find(str.raw());
+
+        if(it != string_offsets.end()) {
+            return it->second;
+        }
+
+        const auto offset = static_cast<uint32_t>(strings.size());
+        strings.append(str.raw());
+        strings.push_back('\0');
+        string_offsets[str.raw()] = offset;
+        return offset;
+    };
+
+    // Sort materials and properties by their raw bytes, to match the
+    // comparison used in the lookup functions
+    const auto by_name = [](const auto *a, const auto *b) {
+        return std::strcmp(a->get_name().c_str(), b->get_name().c_str()) < 0;
+    };
+
+    std::vector<const Material *> mats;
+
+    for(auto it = materials.begin(); it != materials.end(); ++it) {
+        mats.push_back(it->second);
+    }
+
+    std::sort(mats.begin(), mats.end(), by_name);
+
+    std::vector<MaterialRecord> material_records;
+    std::vector<PropertyRecord> property_records;
+    std::vector<double>         values;
+
+    for(const auto *mat : mats) {
+        MaterialRecord mat_record {};
+        mat_record.name           = add_string(mat->get_name());
+        mat_record.description    = add_string(mat->get_description());
+        mat_record.first_property = property_records.size();
+
+        const auto all_properties = mat->get_all_properties();
+        std::vector<const MaterialProperty *> props;
+
+        for(auto it = all_properties.begin(); it != all_properties.end(); ++it) {
+            props.push_back(it->second);
+        }
+
+        std::sort(props.begin(), props.end(), by_name);
+
+        for(const auto *prop : props) {
+            PropertyRecord prop_record {};
+            prop_record.name        = add_string(prop->get_name());
+            prop_record.description = add_string(prop->get_description());
+            prop_record.reference   = add_string(prop->get_reference());
+            prop_record.first_value = values.size();
+
+            if(const auto *p = dynamic_cast<const MaterialPropertyConstant *>(prop)) {
+                prop_record.type = PROPERTY_CONSTANT;
+                prop_record.unit = add_string(p->get_unit());
+                values.push_back(p->get_val());
+            } else if(const auto *p = dynamic_cast<const MaterialPropertyInterp *>(prop)) {
+                double xmin = 0.0;
+                double xmax = 1.0;
+                p->get_limits(xmin, xmax);
+
+                prop_record.type = PROPERTY_INTERP;
+                prop_record.unit = add_string(p->get_unit());
+                values.insert(values.end(), {p->get_interp_y0(), p->get_interp_y1(), p->get_interp_b(),
+                                             xmin, xmax});
+            } else if(const auto *p = dynamic_cast<const MaterialPropertyPoly *>(prop)) {
+                prop_record.type = PROPERTY_POLY;
+                prop_record.unit = add_string(p->get_unit());
+
+                // Store each term as a triplet of (i, j, a_ij)
+                for(const auto &term : p->get_poly_coeffs()) {
+                    values.insert(values.end(), {static_cast<double>(term.first), 0.0, term.second});
+                }
+
+                for(const auto &term : p->get_poly_coeffs_xy()) {
+                    values.insert(values.end(), {static_cast<double>(term.first.first),
+                                                 static_cast<double>(term.first.second),
+                                                 term.second});
+                }
+            } else if(const auto *p = dynamic_cast<const MaterialPropertyString *>(prop)) {
+                prop_record.type = PROPERTY_STRING;
+                prop_record.text = add_string(p->get_text());
+            } else {
+                return false;
+            }
+
+            prop_record.n_values = values.size() - prop_record.first_value;
+            property_records.push_back(prop_record);
+        }
+
+        mat_record.n_properties = property_records.size() - mat_record.first_property;
+        material_records.push_back(mat_record);
+    }
+
+    header.n_materials  = material_records.size();
+    header.n_properties = property_records.size();
+    header.n_doubles    = values.size();
+    header.strings_size = strings.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(cache_filename).parent_path(), ec);
+
+    if(ec) {
+        return false;
+    }
+
+    std::ostringstream tmp_name;
+    tmp_name << cache_filename << "." << getpid() << ".tmp";
+    const auto tmp_filename = tmp_name.str();
+
+    {
+        std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+
+        if(!stream.is_open()) {
+            return false;
+        }
+
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        stream.write(reinterpret_cast<const char *>(material_records.data()),
+                     material_records.size() * sizeof(MaterialRecord));
+        stream.write(reinterpret_cast<const char *>(property_records.data()),
+                     property_records.size() * sizeof(PropertyRecord));
+        stream.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double));
+        stream.write(strings.data(), strings.size());
+
+        if(!stream) {
+            stream.close();
+            std::filesystem::remove(tmp_filename, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmp_filename, cache_filename, ec);
+
+    if(ec) {
+        std::filesystem::remove(tmp_filename, ec);
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+/**
+ * \param[in] offset Offset in the string table
+ *
+ * \returns The string at the given offset
+ */
+auto MaterialLibraryCache::get_string(const uint32_t offset) const -> const char *
+{
+    return _strings + offset;
+}
+
+/**
+ * \brief Find a material in the cache
+ *
+ * \param[in] name Name of the material
+ *
+ * \returns The index of the material, or -1 if it is not in the library
+ */
+auto MaterialLibraryCache::find_material(const std::string &name) const -> int
+{
+    const auto *begin = _materials;
+    const auto *end   = _materials + _header->n_materials;
+
+    const auto *it = std::lower_bound(begin, end, name.c_str(),
+                                      [this](const MaterialRecord &rec, const char *key) {
+                                          return std::strcmp(get_string(rec.name), key) < 0;
+                                      });
+
+    if(it == end || name != get_string(it->name)) {
+        return -1;
+    }
+
+    return static_cast<int>(it - begin);
+}
+
+/**
+ * \param[in] imat Index of material
+ *
+ * \returns The name of the material
+ */
+auto MaterialLibraryCache::get_material_name(const unsigned int imat) const -> const char *
+{
+    return get_string(_materials[imat].name);
+}
+
+/**
+ * \param[in] imat Index of material
+ *
+ * \returns The description of the material
+ */
+auto MaterialLibraryCache::get_material_description(const unsigned int imat) const -> const char *
+{
+    return get_string(_materials[imat].description);
+}
+
+/**
+ * \param[in] imat Index of material
+ *
+ * \returns The number of properties defined for the material
+ */
+auto MaterialLibraryCache::get_n_properties(const unsigned int imat) const -> unsigned int
+{
+    return _materials[imat].n_properties;
+}
+
+/**
+ * \param[in] imat  Index of material
+ * \param[in] iprop Index of property within the material
+ *
+ * \returns The index record for the property
+ */
+auto MaterialLibraryCache::get_property_record(const unsigned int imat,
+                                               const unsigned int iprop) const -> const PropertyRecord &
+{
+    return _properties[_materials[imat].first_property + iprop];
+}
+
+/**
+ * \param[in] imat  Index of material
+ * \param[in] iprop Index of property within the material
+ *
+ * \returns The name of the property
+ */
+auto MaterialLibraryCache::get_property_name(const unsigned int imat,
+                                             const unsigned int iprop) const -> const char *
+{
+    return get_string(get_property_record(imat, iprop).name);
+}
+
+/**
+ * \brief Find a property of a material in the cache
+ *
+ * \param[in] imat Index of material
+ * \param[in] name Name of the property
+ *
+ * \returns The index of the property within the material, or -1 if it is not defined
+ */
+auto MaterialLibraryCache::find_property(const unsigned int  imat,
+                                         const std::string  &name) const -> int
+{
+    const auto *begin = _properties + _materials[imat].first_property;
+    const auto *end   = begin + _materials[imat].n_properties;
+
+    const auto *it = std::lower_bound(begin, end, name.c_str(),
+                                      [this](const PropertyRecord &rec, const char *key) {
+                                          return std::strcmp(get_string(rec.name), key) < 0;
+                                      });
+
+    if(it == end || name != get_string(it->name)) {
+        return -1;
+    }
+
+    return static_cast<int>(it - begin);
+}
+
+/**
+ * \brief Decode a property from the cache
+ *
+ * \param[in] imat  Index of material
+ * \param[in] iprop Index of property within the material
+ *
+ * \returns A newly allocated property object, which is owned by the caller
+ */
+auto MaterialLibraryCache::make_property(const unsigned int imat,
+                                         const unsigned int iprop) const -> MaterialProperty *
+{
+    const auto &rec = get_property_record(imat, iprop);
+
+    const Glib::ustring name(get_string(rec.name));
+    const Glib::ustring description(get_string(rec.description));
+    const Glib::ustring reference(get_string(rec.reference));
+    const Glib::ustring unit(get_string(rec.unit));
+    const double *val = _values + rec.first_value;
+
+    switch(rec.type)
+    {
+        case PROPERTY_CONSTANT:
+            if(rec.n_values == 1) {
+                return new MaterialPropertyConstant(name, description, reference, unit, val[0]);
+            }
+            break;
+        case PROPERTY_INTERP:
+            if(rec.n_values == 5) {
+                auto prop = std::make_unique<MaterialPropertyInterp>(name, description, reference, unit,
+                                                                     val[0], val[1], val[2]);
+                prop->set_limits(val[3], val[4]);
+                return prop.release();
+            }
+            break;
+        case PROPERTY_POLY:
+            if(rec.n_values % 3 == 0) {
+                std::map<int, double>                 poly_coeffs;
+                std::map<std::pair<int, int>, double> poly_coeffs_xy;
+
+                for(unsigned int iterm = 0; iterm < rec.n_values/3; ++iterm) {
+                    const auto i = static_cast<int>(val[3*iterm]);
+                    const auto j = static_cast<int>(val[3*iterm + 1]);
+
+                    if(j == 0) {
+                        poly_coeffs[i] = val[3*iterm + 2];
+                    } else {
+                        poly_coeffs_xy[std::make_pair(i, j)] = val[3*iterm + 2];
+                    }
+                }
+
+                return new MaterialPropertyPoly(name, description, reference, unit,
+                                                poly_coeffs, poly_coeffs_xy);
+            }
+            break;
+        case PROPERTY_STRING:
+            return new MaterialPropertyString(name, description, reference, get_string(rec.text));
+        default:
+            break;
+    }
+
+    std::ostringstream oss;
+    oss << "Corrupt cache entry for property " << name << " in material " << get_material_name(imat);
+    throw std::runtime_error(oss.str());
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,135 @@
+/**
+ * \file   material-library-cache.h
+ * \brief  Compiled, memory-mapped form of the material library
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_MATERIAL_LIBRARY_CACHE_H
+#define QWWAD_MATERIAL_LIBRARY_CACHE_H
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif //HAVE_CONFIG_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/ptr_container/ptr_map.hpp>
+#include <glibmm/ustring.h>
+
+#include "file-io.h"
+
+namespace QWWAD {
+class Material;
+class MaterialProperty;
+
+/**
+ * \brief A compiled copy of a material-library XML file
+ *
+ * \details Parsing the XML library through a DOM builds every material and
+ *          property up front, which dominates the start-up time of short
+ *          programs.  This class stores the same data in a flat binary file
+ *          that is memory-mapped, so that nothing is decoded until a material
+ *          or property is actually requested.
+ *
+ *          The binary file is created by write() after the XML file has been
+ *          parsed for the first time.  It is kept in the user's cache directory
+ *          (\c $QWWAD_CACHE_DIR, \c $XDG_CACHE_HOME/qwwad or \c ~/.cache/qwwad)
+ *          and is named after a hash of the XML file's path.  The modification
+ *          time and size of the XML file are stored in the header and checked
+ *          when the cache is opened.  If either has changed, a hash of the XML
+ *          file contents is compared instead, so that the cache survives a
+ *          plain copy or reinstall of an identical library.
+ *
+ *          Materials are sorted by name, as are the properties within each
+ *          material, so that a lookup is a binary search in the mapped file.
+ */
+class MaterialLibraryCache {
+public:
+    MaterialLibraryCache(const MaterialLibraryCache &)                     = delete;
+    auto operator=(const MaterialLibraryCache &) -> MaterialLibraryCache & = delete;
+
+    [[nodiscard]] static auto open(const std::string &xml_filename) -> std::shared_ptr<const MaterialLibraryCache>;
+
+    static auto write(const std::string                             &xml_filename,
+                      const boost::ptr_map<Glib::ustring, Material> &materials) -> bool;
+
+    [[nodiscard]] auto find_material(const std::string &name) const -> int;
+
+    [[nodiscard]] auto get_material_name(unsigned int imat) const -> const char *;
+    [[nodiscard]] auto get_material_description(unsigned int imat) const -> const char *;
+    [[nodiscard]] auto get_n_properties(unsigned int imat) const -> unsigned int;
+
+    [[nodiscard]] auto get_property_name(unsigned int imat,
+                                         unsigned int iprop) const -> const char *;
+
+    [[nodiscard]] auto find_property(unsigned int       imat,
+                                     const std::string &name) const -> int;
+
+    [[nodiscard]] auto make_property(unsigned int imat,
+                                     unsigned int iprop) const -> MaterialProperty *;
+
+private:
+    /// Type of data stored in a property record
+    enum PropertyType : uint32_t {
+        PROPERTY_CONSTANT,
+        PROPERTY_INTERP,
+        PROPERTY_POLY,
+        PROPERTY_STRING
+    };
+
+    /// File header
+    struct Header {
+        char     magic[8];     ///< File signature
+        uint32_t version;      ///< Format version
+        uint32_t n_materials;  ///< Number of material records
+        uint32_t n_properties; ///< Number of property records
+        uint32_t n_doubles;    ///< Number of entries in the numeric pool
+        uint64_t strings_size; ///< Size of the string table [bytes]
+        int64_t  xml_mtime;    ///< Modification time of the XML file [ns since epoch]
+        uint64_t xml_size;     ///< Size of the XML file [bytes]
+        uint64_t xml_hash;     ///< FNV-1a hash of the XML file contents
+    };
+
+    /// Index entry for a single material
+    struct MaterialRecord {
+        uint32_t name;           ///< Offset of name in string table
+        uint32_t description;    ///< Offset of description in string table
+        uint32_t first_property; ///< Index of first property record
+        uint32_t n_properties;   ///< Number of property records
+    };
+
+    /// Index entry for a single property
+    struct PropertyRecord {
+        uint32_t type;        ///< Type of property data (a PropertyType)
+        uint32_t name;        ///< Offset of name in string table
+        uint32_t description; ///< Offset of description in string table
+        uint32_t reference;   ///< Offset of reference in string table
+        uint32_t unit;        ///< Offset of unit in string table
+        uint32_t text;        ///< Offset of text value in string table
+        uint32_t first_value; ///< Index of first entry in numeric pool
+        uint32_t n_values;    ///< Number of entries in numeric pool
+    };
+
+    explicit MaterialLibraryCache(const std::string &cache_filename);
+
+    [[nodiscard]] static auto get_cache_filename(const std::string &xml_filename) -> std::string;
+    [[nodiscard]] static auto hash_file(const std::string &filename,
+                                        uint64_t          &hash) -> bool;
+
+    [[nodiscard]] auto get_string(uint32_t offset) const -> const char *;
+    [[nodiscard]] auto get_property_record(unsigned int imat,
+                                           unsigned int iprop) const -> const PropertyRecord &;
+
+    FileView _file; ///< Contents of the cache file
+
+    const Header         *_header     = nullptr; ///< File header
+    const MaterialRecord *_materials  = nullptr; ///< Material index
+    const PropertyRecord *_properties = nullptr; ///< Property index
+    const double         *_values     = nullptr; ///< Numeric pool
+    const char           *_strings    = nullptr; ///< String table
+};
+} // namespace QWWAD
+#endif //QWWAD_MATERIAL_LIBRARY_CACHE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -12,6 +12,7 @@
  */
 
 #include "material-library.h"
+#include "material-library-cache.h"
 #include "material.h"
 #include "material-property-numeric.h"
 #include <cstdlib>
@@ -37,6 +38,10 @@ auto MaterialLibrary::get_property_unit(Glib::ustring &mat_name,
  * Constructor loads material data from XML file
  *
  * param[in] filename Name of input file
+ *
+ * \details If a valid compiled copy of the file exists, it is used instead and
+ *          nothing is parsed until a material is looked up.  Otherwise, the XML
+ *          file is parsed in full and a compiled copy is written for next time.
  */
 MaterialLibrary::MaterialLibrary(const Glib::ustring &filename)
 {
@@ -49,6 +54,24 @@ MaterialLibrary::MaterialLibrary(const Glib::ustring &filename)
         fname_str >> fname;
     }
 
+    cache = MaterialLibraryCache::open(fname);
+
+    if(!cache)
+    {
+        parse_xml(fname);
+
+        // Failure to write the cache isn't an error; we just parse the XML again next time
+        MaterialLibraryCache::write(fname, materials);
+    }
+}
+
+/**
+ * Read all materials from an XML file
+ *
+ * \param[in] fname Name of input file
+ */
+void MaterialLibrary::parse_xml(const std::string &fname)
+{
     xmlpp::DomParser parser(fname, true);
 
     auto *doc          = parser.get_document();
@@ -86,24 +109,29 @@ MaterialLibrary::MaterialLibrary(const Glib::ustring &filename)
  *
  * \return The material from the library
  *
- * \throws boost::bad_ptr_container_operation if the material could not be found
+ * \throws std::runtime_error if the material could not be found
  */
 auto MaterialLibrary::get_material(const Glib::ustring &mat_name) const -> Material const *
 {
-    Material const * mat;
+    const auto it = materials.find(mat_name);
 
-    try
-    {
-        mat = &materials.at(mat_name);
+    if(it != materials.end()) {
+        return it->second;
     }
-    catch(std::exception &e)
-    {
-        std::ostringstream oss;
-        oss << "Could not find material: " << mat_name << " in the material library" << std::endl;
-        throw std::runtime_error(oss.str());
+
+    // Decode the material from the compiled library if it hasn't been looked up yet
+    if(cache) {
+        const auto imat = cache->find_material(mat_name.raw());
+
+        if(imat >= 0) {
+            auto key = mat_name;
+            return materials.insert(key, new Material(cache, imat)).first->second;
+        }
     }
 
-    return mat;
+    std::ostringstream oss;
+    oss << "Could not find material: " << mat_name << " in the material library" << std::endl;
+    throw std::runtime_error(oss.str());
 }
 
 /**
@@ -117,13 +145,13 @@ auto MaterialLibrary::get_material(const Glib::ustring &mat_name) const -> Mater
 auto MaterialLibrary::get_property(Glib::ustring &mat_name,
                                                        Glib::ustring &property_name) const -> MaterialProperty const *
 {
-    return materials.at(mat_name).get_property(property_name);
+    return get_material(mat_name)->get_property(property_name);
 }
 
 auto MaterialLibrary::get_val(Glib::ustring &mat_name,
                                 Glib::ustring &property_name) -> double
 {
-    const auto * const property = materials.at(mat_name).get_property(property_name);
+    const auto * const property = get_material(mat_name)->get_property(property_name);
     const auto * const numeric_property = dynamic_cast<MaterialPropertyNumeric const *>(property);
 
     return numeric_property->get_val();
@@ -136,8 +164,8 @@ auto MaterialLibrary::get_val(Glib::ustring &mat_name,
  */
 auto MaterialLibrary::get_material(const char  *mat_name) const -> Material const *
 {
-    std::string str(mat_name);
-    return &materials.at(str);
+    Glib::ustring str(mat_name);
+    return get_material(str);
 }
 }
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -14,6 +14,8 @@
 #ifndef MATERIAL_LIBRARY_H
 #define MATERIAL_LIBRARY_H
 
+#include <memory>
+
 #include <boost/ptr_container/ptr_map.hpp>
 #include <libxml++/libxml++.h>
 
@@ -23,9 +25,16 @@ class ustring;
 
 namespace QWWAD {
 class Material;
+class MaterialLibraryCache;
 class MaterialProperty;
 
-/** Library of material data */
+/**
+ * Library of material data
+ *
+ * \details The XML library is compiled into a binary MaterialLibraryCache the
+ *          first time that it is read.  Subsequent runs memory-map the compiled
+ *          form, and only decode materials and properties as they are looked up.
+ */
 class MaterialLibrary {
 public:
     MaterialLibrary(const Glib::ustring &filename);
@@ -42,7 +51,10 @@ public:
     auto get_property_unit(Glib::ustring &mat_name,
                            Glib::ustring &property_name) const -> const Glib::ustring &;
 private:
-    boost::ptr_map<Glib::ustring, Material>  materials;
+    mutable boost::ptr_map<Glib::ustring, Material> materials; ///< Materials that have been looked up
+    std::shared_ptr<const MaterialLibraryCache>     cache;     ///< Compiled library (if available)
+
+    void parse_xml(const std::string &filename);
 };
 } // end namespace
 #endif //MATERIAL_LIBRARY_H
@@ -77,5 +77,17 @@ MaterialPropertyConstant::get_val(const double /* x */) const -> decltype(_const
 {
     return _constant;
 }
+
+/**
+ * \brief Return the numerical value of the property at a set of points
+ *
+ * \param[in] x Input variable at each point
+ *
+ * \returns The parameter value at each point
+ */
+auto MaterialPropertyConstant::get_val(const arma::vec &x) const -> arma::vec
+{
+    return _constant*arma::ones(x.n_elem);
+}
 } // end namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -17,9 +17,12 @@ public:
                              decltype(_unit)        unit,
                              decltype(_constant)    value);
 
+    using MaterialPropertyNumeric::get_val;
+
     [[nodiscard]] auto clone() const -> MaterialPropertyConstant * override;
 
     [[nodiscard]] auto get_val(double x = 0) const -> decltype(_constant) override;
+    [[nodiscard]] auto get_val(const arma::vec &x) const -> arma::vec override;
 };
 } // end namespace
 #endif
@@ -0,0 +1,47 @@
+/**
+ * \file   material-property-handle.cpp
+ * \brief  Resolved reference to a numeric material property
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "material-property-handle.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "material.h"
+#include "material-property-constant.h"
+#include "material-property-interp.h"
+#include "material-property-poly.h"
+
+namespace QWWAD {
+/**
+ * \brief Look up a numeric property of a material
+ *
+ * \param[in] mat           The material
+ * \param[in] property_name The name of the property
+ *
+ * \throws std::runtime_error if the property doesn't exist or isn't numeric
+ */
+MaterialPropertyHandle::MaterialPropertyHandle(const Material      &mat,
+                                               const Glib::ustring &property_name) :
+    _prop(dynamic_cast<const MaterialPropertyNumeric *>(mat.get_property(property_name))),
+    _kind(PROPERTY_KIND_CONSTANT)
+{
+    if(dynamic_cast<const MaterialPropertyInterp *>(_prop) != nullptr) {
+        _kind = PROPERTY_KIND_INTERP;
+    } else if(dynamic_cast<const MaterialPropertyPoly *>(_prop) != nullptr) {
+        _kind = PROPERTY_KIND_POLY;
+    } else if(dynamic_cast<const MaterialPropertyConstant *>(_prop) == nullptr) {
+        std::ostringstream oss;
+        oss << "Property " << property_name << " in material " << mat.get_name() << " is not numeric";
+        throw std::runtime_error(oss.str());
+    }
+}
+
+MaterialPropertyHandle::MaterialPropertyHandle(const Material &mat,
+                                               const char     *property_name) :
+    MaterialPropertyHandle(mat, Glib::ustring(property_name))
+{}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
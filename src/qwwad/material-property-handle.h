@@ -0,0 +1,77 @@
+/**
+ * \file   material-property-handle.h
+ * \brief  Resolved reference to a numeric material property
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_MATERIAL_PROPERTY_HANDLE_H
+#define QWWAD_MATERIAL_PROPERTY_HANDLE_H
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif //HAVE_CONFIG_H
+
+#include <armadillo>
+#include <glibmm/ustring.h>
+
+#include "material-property-numeric.h"
+
+namespace QWWAD {
+class Material;
+
+/// Concrete form of a numeric material property
+enum MaterialPropertyKind {
+    PROPERTY_KIND_CONSTANT, ///< Fixed value
+    PROPERTY_KIND_INTERP,   ///< Interpolation between two values with bowing
+    PROPERTY_KIND_POLY      ///< Polynomial in the input variable
+};
+
+/**
+ * \brief A numeric material property that has been looked up once
+ *
+ * \details Material::get_property_value() finds the property by name and casts
+ *          it to a numeric type on every call.  A handle does both once, on
+ *          construction, and keeps a pointer to the property inside the
+ *          material's property table.  That pointer doesn't change for the
+ *          lifetime of the Material, so the Material must outlive the handle.
+ *
+ *          The concrete kind of property is also stored, so that callers can
+ *          pick out the coefficients of interpolated properties directly.
+ */
+class MaterialPropertyHandle {
+public:
+    MaterialPropertyHandle(const Material      &mat,
+                           const Glib::ustring &property_name);
+    MaterialPropertyHandle(const Material &mat,
+                           const char     *property_name);
+
+    /// Get the concrete kind of property
+    [[nodiscard]] inline auto get_kind() const -> MaterialPropertyKind {return _kind;}
+
+    /// Get the underlying property
+    [[nodiscard]] inline auto get_property() const -> const MaterialPropertyNumeric & {return *_prop;}
+
+    /// Get the unit of the property
+    [[nodiscard]] inline auto get_unit() const -> const Glib::ustring & {return _prop->get_unit();}
+
+    /// Evaluate the property at a single point
+    [[nodiscard]] inline auto get_val(const double x = 0) const -> double {return _prop->get_val(x);}
+
+    /// Evaluate the property at a single point in a quaternary alloy
+    [[nodiscard]] inline auto get_val(const double x,
+                                      const double y) const -> double {return _prop->get_val(x, y);}
+
+    /// Evaluate the property over a whole alloy profile
+    [[nodiscard]] inline auto get_val(const arma::vec &x) const -> arma::vec {return _prop->get_val(x);}
+
+    /// Evaluate the property over a whole quaternary alloy profile
+    [[nodiscard]] inline auto get_val(const arma::vec &x,
+                                      const arma::vec &y) const -> arma::vec {return _prop->get_val(x, y);}
+
+private:
+    const MaterialPropertyNumeric *_prop; ///< The property in the material's table
+    MaterialPropertyKind           _kind; ///< Concrete kind of property
+};
+} // namespace QWWAD
+#endif //QWWAD_MATERIAL_PROPERTY_HANDLE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
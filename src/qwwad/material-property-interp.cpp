@@ -124,6 +124,29 @@ MaterialPropertyInterp::get_val(const double x) const -> decltype(_y0)
     return lin_interp(_y0, _y1, x, _b);
 }
 
+/**
+ * \brief Return the interpolated value of the property at a set of points
+ *
+ * \param[in] x Input variable at each point
+ *
+ * \returns The parameter value at each point
+ */
+auto MaterialPropertyInterp::get_val(const arma::vec &x) const -> arma::vec
+{
+    if(x.empty()) {
+        return {};
+    }
+
+    if(x.min() < _xmin or x.max() > _xmax or x.min() < 0 or x.max() > 1)
+    {
+        std::ostringstream oss;
+        oss << "x-values [" << x.min() << "," << x.max() << "] are outside the permitted range (" << _xmin << "," << _xmax << ") for property " << _name << std::endl;
+        throw std::domain_error(oss.str());
+    }
+
+    return _y0*(1.0-x) + _y1*x + _b*x%(1.0-x);
+}
+
 /**
  * Set the validity limits for the interpolation
  *
@@ -36,6 +36,8 @@ public:
                            decltype(_y1)                 y1,
                            decltype(_b)                  b = 0.0);
 
+    using MaterialPropertyNumeric::get_val;
+
     [[nodiscard]] auto clone() const -> MaterialPropertyInterp * override;
 
     void set_limits(decltype(_xmin) xmin,
@@ -49,6 +51,7 @@ public:
     [[nodiscard]] inline auto get_interp_b()  const {return _b;}
 
     [[nodiscard]] auto get_val(double x = 0) const -> decltype(_y0) override;
+    [[nodiscard]] auto get_val(const arma::vec &x) const -> arma::vec override;
 };
 } // end namespace
 #endif
@@ -50,5 +50,39 @@ MaterialPropertyNumeric::get_unit() const -> const decltype(MaterialPropertyNume
 {
     return _unit;
 }
+
+/**
+ * \brief Return the value of the property at a single point in a quaternary alloy
+ *
+ * \param[in] x First alloy variable
+ * \param[in] y Second alloy variable (unused)
+ *
+ * \returns The parameter value
+ *
+ * \details By default, properties only depend on the first alloy variable.
+ *          Derived classes that depend on both variables override this.
+ */
+auto MaterialPropertyNumeric::get_val(const double x,
+                                      const double /* y */) const -> double
+{
+    return get_val(x);
+}
+
+/**
+ * \brief Return the value of the property at a set of points in a quaternary alloy
+ *
+ * \param[in] x First alloy variable at each point
+ * \param[in] y Second alloy variable at each point (unused)
+ *
+ * \returns The parameter value at each point
+ *
+ * \details By default, properties only depend on the first alloy variable.
+ *          Derived classes that depend on both variables override this.
+ */
+auto MaterialPropertyNumeric::get_val(const arma::vec &x,
+                                      const arma::vec & /* y */) const -> arma::vec
+{
+    return get_val(x);
+}
 } // end namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
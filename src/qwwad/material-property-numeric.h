@@ -1,6 +1,8 @@
 #ifndef QWWAD_MATERIAL_PROPERTY_NUMERIC_H
 #define QWWAD_MATERIAL_PROPERTY_NUMERIC_H
 
+#include <armadillo>
+
 #include "material-property.h"
 
 namespace QWWAD {
@@ -8,6 +10,9 @@ namespace QWWAD {
  * A physical property of a material that can be described by a numerical value
  *
  * \details The numerical value may be obtained using the get_val() function.
+ *          An overload of get_val() evaluates the property over a whole alloy
+ *          profile at once, which avoids a virtual call per point.  Properties
+ *          of quaternary alloys may also depend on a second alloy variable.
  *          The relevant unit for the property may be obtained using get_unit().
  */
 class MaterialPropertyNumeric : public MaterialProperty {
@@ -25,6 +30,11 @@ public:
     [[nodiscard]] auto get_unit() const -> const decltype(_unit) &;
 
     [[nodiscard]] virtual auto get_val(double x = 0) const -> double = 0;
+    [[nodiscard]] virtual auto get_val(double x,
+                                       double y) const -> double;
+    [[nodiscard]] virtual auto get_val(const arma::vec &x) const -> arma::vec = 0;
+    [[nodiscard]] virtual auto get_val(const arma::vec &x,
+                                       const arma::vec &y) const -> arma::vec;
 };
 } // end namespace
 #endif
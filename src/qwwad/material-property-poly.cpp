@@ -7,6 +7,7 @@
 #include "material-property-poly.h"
 #include <cmath>
 #include <libxml++/libxml++.h>
+#include <sstream>
 #include <stdexcept>
 #include <utility>
 
@@ -30,14 +31,22 @@ MaterialPropertyPoly::MaterialPropertyPoly(xmlpp::Element *elem) :
 
                 auto *ai_elem = dynamic_cast<xmlpp::Element *>(term);
                 std::stringstream i_str(ai_elem->get_attribute_value("i").raw());
+                std::stringstream j_str(ai_elem->get_attribute_value("j").raw());
                 std::stringstream ai_str(ai_elem->get_child_text()->get_content().raw());
 
-                int    i  = 0;   // Index of polynomial term
+                int    i  = 0;   // Index of polynomial term in x
+                int    j  = 0;   // Index of polynomial term in y
                 double ai = 0.0; // Polynomial coefficient
 
                 i_str  >> i;
+                j_str  >> j;
                 ai_str >> ai;
-                _poly_coeffs[i] = ai;
+
+                if(j == 0) {
+                    _poly_coeffs[i] = ai;
+                } else {
+                    _poly_coeffs_xy[std::make_pair(i, j)] = ai;
+                }
             }
         }
     }
@@ -57,18 +66,22 @@ MaterialPropertyPoly::MaterialPropertyPoly(xmlpp::Element *elem) :
  * \param[in] description A description of the property
  * \param[in] reference   A literature reference for the property
  * \param[in] unit        The unit associated with the property
- * \param[in] poly_coeffs The set of polynomial coefficients
+ * \param[in] poly_coeffs    The set of polynomial coefficients for terms in x only
+ * \param[in] poly_coeffs_xy The set of polynomial coefficients for terms in y
  *
  * \details The coefficients are stored in a map, with the index being used to specify the
  *          order of the polynomial term, and the value being used to store the coefficient.
+ *          Terms that depend on y are indexed by the pair of orders (i,j) in x and y.
  */
 MaterialPropertyPoly::MaterialPropertyPoly(const decltype(_name)        &name,
                                            const decltype(_description) &description,
                                            const decltype(_reference)   &reference,
-                                           decltype(_unit)        unit,
-                                           decltype(_poly_coeffs) poly_coeffs) :
+                                           decltype(_unit)           unit,
+                                           decltype(_poly_coeffs)    poly_coeffs,
+                                           decltype(_poly_coeffs_xy) poly_coeffs_xy) :
     MaterialPropertyNumeric(name, description, reference, std::move(unit)),
-    _poly_coeffs(std::move(poly_coeffs))
+    _poly_coeffs(std::move(poly_coeffs)),
+    _poly_coeffs_xy(std::move(poly_coeffs_xy))
 {}
 
 /**
@@ -76,9 +89,19 @@ MaterialPropertyPoly::MaterialPropertyPoly(const decltype(_name)        &name,
  */
 auto MaterialPropertyPoly::clone() const -> MaterialPropertyPoly *
 {
-    return new MaterialPropertyPoly(_name, _description, _reference, _unit, _poly_coeffs);
+    return new MaterialPropertyPoly(_name, _description, _reference, _unit, _poly_coeffs, _poly_coeffs_xy);
 }
 
+/**
+ * \brief Evaluate the polynomial at a single point
+ *
+ * \param[in] x Input variable
+ *
+ * \returns The value of the polynomial
+ *
+ * \details The second variable is taken to be zero, so the terms that depend
+ *          on it vanish.  Use get_val(x, y) for a quaternary alloy.
+ */
 auto MaterialPropertyPoly::get_val(const double x) const -> double
 {
     double val = 0; // Output value
@@ -100,5 +123,104 @@ auto MaterialPropertyPoly::get_val(const double x) const -> double
 
     return val;
 }
+
+/**
+ * \brief Evaluate the polynomial in two variables at a single point
+ *
+ * \param[in] x First input variable
+ * \param[in] y Second input variable
+ *
+ * \returns The value of the polynomial
+ */
+auto MaterialPropertyPoly::get_val(const double x,
+                                   const double y) const -> double
+{
+    double val = get_val(x);
+
+    for(const auto &term : _poly_coeffs_xy)
+    {
+        const auto i  = term.first.first;
+        const auto j  = term.first.second;
+        const auto ai = term.second;
+
+        val += ai*std::pow(x, i)*std::pow(y, j);
+    }
+
+    return val;
+}
+
+/**
+ * \brief Evaluate the polynomial at a set of points
+ *
+ * \param[in] x Input variable at each point
+ *
+ * \returns The value of the polynomial at each point
+ *
+ * \details Horner's rule is used, so the cost is a single multiply-add per
+ *          polynomial order for the whole set of points
+ */
+auto MaterialPropertyPoly::get_val(const arma::vec &x) const -> arma::vec
+{
+    arma::vec val(x.n_elem, arma::fill::zeros);
+
+    if(_poly_coeffs.empty()) {
+        return val;
+    }
+
+    const auto imin = _poly_coeffs.begin()->first;
+    const auto imax = _poly_coeffs.rbegin()->first;
+
+    for(auto i = imax; i >= imin; --i) {
+        val %= x;
+
+        const auto term = _poly_coeffs.find(i);
+
+        if(term != _poly_coeffs.end()) {
+            val += term->second;
+        }
+    }
+
+    // Shift the result if the lowest-order term isn't a constant
+    if(imin != 0) {
+        val %= arma::pow(x, imin);
+    }
+
+    return val;
+}
+
+/**
+ * \brief Evaluate the polynomial in two variables at a set of points
+ *
+ * \param[in] x First input variable at each point
+ * \param[in] y Second input variable at each point
+ *
+ * \returns The value of the polynomial at each point
+ */
+auto MaterialPropertyPoly::get_val(const arma::vec &x,
+                                   const arma::vec &y) const -> arma::vec
+{
+    if(x.n_elem != y.n_elem) {
+        std::ostringstream oss;
+        oss << "Got " << x.n_elem << " x-values but " << y.n_elem << " y-values for property " << _name;
+        throw std::length_error(oss.str());
+    }
+
+    arma::vec val = get_val(x);
+
+    for(const auto &term : _poly_coeffs_xy)
+    {
+        const auto i  = term.first.first;
+        const auto j  = term.first.second;
+        const auto ai = term.second;
+
+        if(i == 0) {
+            val += ai*arma::pow(y, j);
+        } else {
+            val += ai*arma::pow(x, i)%arma::pow(y, j);
+        }
+    }
+
+    return val;
+}
 } // end namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
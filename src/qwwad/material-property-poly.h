@@ -2,24 +2,43 @@
 #define QWWAD_MATERIAL_PROPERTY_POLY_H
 
 #include <map>
+#include <utility>
 #include "material-property-numeric.h"
 
 namespace QWWAD {
+/**
+ * A MaterialProperty that is given by a polynomial in one or two alloy variables
+ *
+ * \details Each term \f$a_{ij}x^i y^j\f$ is given by an \<ai\> element with attributes
+ *          \c i and \c j.  The \c j attribute may be omitted for terms that do not
+ *          depend on the second variable \f$y\f$, which is all that is needed
+ *          for a ternary alloy.
+ */
 class MaterialPropertyPoly : public MaterialPropertyNumeric {
 private:
-    std::map<int, double> _poly_coeffs; ///< The terms in the polynomial
+    std::map<int, double>                 _poly_coeffs;    ///< The terms in the polynomial that depend only on x
+    std::map<std::pair<int, int>, double> _poly_coeffs_xy; ///< The terms that depend on y, indexed by (i,j)
 
 public:
     MaterialPropertyPoly(xmlpp::Element *elem);
     MaterialPropertyPoly(const decltype(_name)        &name,
                          const decltype(_description) &description,
                          const decltype(_reference)   &reference,
-                         decltype(_unit)        unit,
-                         decltype(_poly_coeffs) poly_coeffs);
+                         decltype(_unit)           unit,
+                         decltype(_poly_coeffs)    poly_coeffs,
+                         decltype(_poly_coeffs_xy) poly_coeffs_xy = {});
 
     [[nodiscard]] auto clone() const -> MaterialPropertyPoly * override;
 
+    [[nodiscard]] inline auto get_poly_coeffs()    const -> const decltype(_poly_coeffs)    & {return _poly_coeffs;}
+    [[nodiscard]] inline auto get_poly_coeffs_xy() const -> const decltype(_poly_coeffs_xy) & {return _poly_coeffs_xy;}
+
     [[nodiscard]] auto get_val(double x = 0) const -> double override;
+    [[nodiscard]] auto get_val(double x,
+                               double y) const -> double override;
+    [[nodiscard]] auto get_val(const arma::vec &x) const -> arma::vec override;
+    [[nodiscard]] auto get_val(const arma::vec &x,
+                               const arma::vec &y) const -> arma::vec override;
 };
 } // end namespace
 #endif
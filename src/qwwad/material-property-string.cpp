@@ -5,6 +5,7 @@
  */
 
 #include <stdexcept>
+#include <utility>
 #include <libxml++/libxml++.h>
 #include "material-property-string.h"
 
@@ -32,6 +33,30 @@ MaterialPropertyString::MaterialPropertyString(xmlpp::Element *elem) :
     }
 }
 
+/**
+ * Create a material property object using specified values
+ *
+ * \param[in] name        The name of the property
+ * \param[in] description A description of the property
+ * \param[in] reference   A literature reference for the property
+ * \param[in] text        The text value of the property
+ */
+MaterialPropertyString::MaterialPropertyString(const decltype(_name)        &name,
+                                               const decltype(_description) &description,
+                                               const decltype(_reference)   &reference,
+                                               decltype(_text)               text) :
+    MaterialProperty(name, description, reference),
+    _text(std::move(text))
+{}
+
+/**
+ * \returns a copy of the current object
+ */
+auto MaterialPropertyString::clone() const -> MaterialPropertyString *
+{
+    return new MaterialPropertyString(_name, _description, _reference, _text);
+}
+
 /**
  * Return the property as a string
  *
@@ -5,14 +5,20 @@
 
 namespace QWWAD {
 class MaterialPropertyString : public MaterialProperty {
+private:
+    Glib::ustring _text; ///< The text value of the property
+
 public:
     MaterialPropertyString() = default;
     MaterialPropertyString(xmlpp::Element *elem);
+    MaterialPropertyString(const decltype(_name)        &name,
+                           const decltype(_description) &description,
+                           const decltype(_reference)   &reference,
+                           decltype(_text)               text);
 
-    [[nodiscard]] auto get_text() const -> const Glib::ustring &;
+    [[nodiscard]] auto clone() const -> MaterialPropertyString * override;
 
-private:
-    Glib::ustring _text; ///< The text value of the property
+    [[nodiscard]] auto get_text() const -> const Glib::ustring &;
 };
 } // end namespace
 #endif
@@ -4,7 +4,9 @@
  * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
  */
 #include <stdexcept>
+#include <utility>
 #include "material.h"
+#include "material-library-cache.h"
 #include "material-property-interp.h"
 #include "material-property-poly.h"
 #include "material-property-constant.h"
@@ -29,12 +31,33 @@ auto Material::get_description() const -> const Glib::ustring &
     return description;
 }
 
-Material::Material(const Material *mat)
+Material::Material(const Material *mat) :
+    name(mat->name),
+    description(mat->description),
+    cache(mat->cache),
+    cache_index(mat->cache_index)
 {
     properties = mat->properties.clone();
 }
 
-Material::Material(xmlpp::Element *elem)
+/**
+ * Create a material that is backed by a compiled library
+ *
+ * \param[in] cache       The compiled library
+ * \param[in] cache_index Index of the material in the compiled library
+ *
+ * \details No properties are decoded until they are looked up
+ */
+Material::Material(std::shared_ptr<const MaterialLibraryCache> cache,
+                   unsigned int                                cache_index) :
+    name(cache->get_material_name(cache_index)),
+    description(cache->get_material_description(cache_index)),
+    cache(std::move(cache)),
+    cache_index(cache_index)
+{}
+
+Material::Material(xmlpp::Element *elem) :
+    cache_index(0)
 {
     if(elem != nullptr) {
         // Set name and description of this material
@@ -76,6 +99,22 @@ Material::Material(xmlpp::Element *elem)
     }
 }
 
+/**
+ * Check whether a property is defined for the material
+ *
+ * \param[in] property_name Name of the property
+ *
+ * \return True if the property exists
+ */
+auto Material::has_property(const Glib::ustring &property_name) const -> bool
+{
+    if(properties.find(property_name) != properties.end()) {
+        return true;
+    }
+
+    return cache && cache->find_property(cache_index, property_name.raw()) >= 0;
+}
+
 auto Material::get_property(const char *name) const -> MaterialProperty const *
 {
     Glib::ustring prop_name(name);
@@ -91,20 +130,50 @@ auto Material::get_property(const char *name) const -> MaterialProperty const *
  */
 auto Material::get_property(const Glib::ustring &property_name) const -> MaterialProperty const *
 {
-    MaterialProperty const * prop;
+    const auto it = properties.find(property_name);
 
-    try
-    {
-        prop = &properties.at(property_name);
+    if(it != properties.end()) {
+        return it->second;
     }
-    catch(std::exception &e)
-    {
-        std::ostringstream oss;
-        oss << "Could not find property: " << property_name << " in the material library" << std::endl;
-        throw std::runtime_error(oss.str());
+
+    // Decode the property from the compiled library if it hasn't been looked up yet
+    if(cache) {
+        const auto iprop = cache->find_property(cache_index, property_name.raw());
+
+        if(iprop >= 0) {
+            auto key = property_name;
+            return properties.insert(key, cache->make_property(cache_index, iprop)).first->second;
+        }
     }
 
-    return prop;
+    std::ostringstream oss;
+    oss << "Could not find property: " << property_name << " in the material library" << std::endl;
+    throw std::runtime_error(oss.str());
+}
+
+/**
+ * Get the full set of properties for the material
+ *
+ * \returns A copy of all the properties
+ *
+ * \details If the material is backed by a compiled library, all remaining
+ *          properties are decoded first.
+ */
+auto Material::get_all_properties() const -> decltype(properties)
+{
+    if(cache) {
+        const auto n_properties = cache->get_n_properties(cache_index);
+
+        for(unsigned int iprop = 0; iprop < n_properties; ++iprop) {
+            Glib::ustring key(cache->get_property_name(cache_index, iprop));
+
+            if(properties.find(key) == properties.end()) {
+                properties.insert(key, cache->make_property(cache_index, iprop));
+            }
+        }
+    }
+
+    return properties;
 }
 
 auto Material::get_numeric_property(const char *name) const -> MaterialPropertyNumeric const *
@@ -1,6 +1,8 @@
 #ifndef QWWAD_MATERIAL
 #define QWWAD_MATERIAL
 
+#include <memory>
+
 #include <boost/ptr_container/ptr_map.hpp>
 #include <libxml++/libxml++.h>
 
@@ -13,25 +15,41 @@ class ustring;
 }
 
 namespace QWWAD {
+class MaterialLibraryCache;
 class MaterialProperty;
 class MaterialPropertyNumeric;
 
-/** Wrapper for XML data for a material */
+/**
+ * Wrapper for XML data for a material
+ *
+ * \details A material is either parsed in full from an XML element, or is
+ *          backed by a compiled MaterialLibraryCache.  In the latter case,
+ *          each property is only decoded the first time that it is looked up.
+ *          Lookups therefore modify the internal property cache, and must not
+ *          be made concurrently from several threads.
+ */
 class Material {
 private:
     /// Cached set of material properties
-    boost::ptr_map<Glib::ustring, MaterialProperty> properties;
+    mutable boost::ptr_map<Glib::ustring, MaterialProperty> properties;
 
     Glib::ustring          name;           ///< The name of the material
     Glib::ustring          description;    ///< The description of the material
 
+    std::shared_ptr<const MaterialLibraryCache> cache;       ///< Compiled library (if any)
+    unsigned int                                cache_index; ///< Index of material in compiled library
+
 public:
     Material(const Material *mat);
     Material(xmlpp::Element *elem);
+    Material(std::shared_ptr<const MaterialLibraryCache> cache,
+             unsigned int                                cache_index);
 
     [[nodiscard]] auto get_name() const -> const Glib::ustring &;
     [[nodiscard]] auto get_description() const -> const Glib::ustring &;
 
+    [[nodiscard]] auto has_property(const Glib::ustring &property_name) const -> bool;
+
     auto get_property(const char          *property_name) const -> MaterialProperty const *;
     [[nodiscard]] auto get_property(const Glib::ustring &property_name) const -> MaterialProperty const *;
 
@@ -44,7 +62,7 @@ public:
     auto get_property_value(Glib::ustring &property_name,
                             double         x = 0) const -> double;
 
-    inline auto get_all_properties() const -> decltype(properties) {return properties;}
+    [[nodiscard]] auto get_all_properties() const -> decltype(properties);
 
 };
 } // end namespace
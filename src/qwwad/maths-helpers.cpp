@@ -6,6 +6,8 @@
 
 #include "maths-helpers.h"
 
+#include <cmath>
+
 namespace QWWAD
 {
 /**
@@ -128,5 +130,121 @@ auto sf_brillouin(const double J,
     const auto y = tJp1_tJ * coth(tJp1_tJ * x) - 1.0/tJ*coth(x/tJ);
     return y;
 }
+
+/**
+ * \brief Find the smallest FFT-friendly size that is no smaller than a given value
+ *
+ * \param[in] n Minimum size
+ *
+ * \returns The smallest number >= n whose only prime factors are 2, 3 and 5
+ */
+auto get_fft_size(arma::uword n) -> arma::uword
+{
+    for(;; ++n)
+    {
+        auto m = n;
+
+        for(const arma::uword p : {2, 3, 5}) {
+            while(m % p == 0) {
+                m /= p;
+            }
+        }
+
+        if(m == 1) {
+            return n;
+        }
+    }
+}
+
+/**
+ * \brief Perform a 3D discrete Fourier transform in place
+ *
+ * \param[in,out] X       Data to transform
+ * \param[in]     inverse Perform an inverse transform?
+ *
+ * \details Armadillo only transforms along matrix columns, so the data is
+ *          viewed (or transposed) as a matrix for each axis in turn.
+ *          The inverse transform includes the 1/N normalisation.
+ */
+void fft3(arma::cx_cube &X,
+          const bool     inverse)
+{
+    const auto n0 = X.n_rows;
+    const auto n1 = X.n_cols;
+    const auto n2 = X.n_slices;
+
+    const auto transform = [inverse](const arma::cx_mat &M) -> arma::cx_mat {
+        return inverse ? arma::ifft(M) : arma::fft(M);
+    };
+
+    // A transform of length 1 does nothing, so those axes are skipped.  This
+    // also ensures that Armadillo never treats a single row as a vector.
+
+    // First axis: each column of an (n0 x n1*n2) view
+    if(n0 > 1)
+    {
+        arma::cx_mat X0(X.memptr(), n0, n1*n2, false, true);
+        X0 = transform(X0);
+    }
+
+    // Second axis: rows of each slice
+    if(n1 > 1)
+    {
+        for(arma::uword i2 = 0; i2 < n2; ++i2) {
+            X.slice(i2) = transform(X.slice(i2).st()).st();
+        }
+    }
+
+    // Third axis: rows of an (n0*n1 x n2) view
+    if(n2 > 1)
+    {
+        arma::cx_mat X2(X.memptr(), n0*n1, n2, false, true);
+        X2 = transform(X2.st()).st();
+    }
+}
+
+/**
+ * \brief Generate a set of samples between two limits, as used for batch-mode sweeps
+ *
+ * \param[in] xmin        Lowest sample
+ * \param[in] xmax        Highest sample
+ * \param[in] n           Number of samples
+ * \param[in] log_spacing Use logarithmic rather than linear spacing
+ *
+ * \returns The samples, in ascending order.  If only one sample is requested, it is xmin.
+ */
+auto make_sample_range(const double xmin,
+                       const double xmax,
+                       const size_t n,
+                       const bool   log_spacing) -> arma::vec
+{
+    if(n < 1) {
+        throw std::domain_error("Number of samples in range must be positive");
+    }
+
+    if(xmax < xmin)
+    {
+        std::ostringstream oss;
+        oss << "Upper limit of sample range, " << xmax << ", is less than lower limit, " << xmin;
+        throw std::domain_error(oss.str());
+    }
+
+    if(log_spacing and xmin <= 0)
+    {
+        std::ostringstream oss;
+        oss << "Logarithmic sample range must have positive limits. Got " << xmin << " to " << xmax;
+        throw std::domain_error(oss.str());
+    }
+
+    if(n == 1) {
+        return arma::vec{xmin};
+    }
+
+    if(log_spacing) {
+        return arma::exp(arma::linspace(std::log(xmin), std::log(xmax), n));
+    }
+
+    return arma::linspace(xmin, xmax, n);
+}
 } // namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
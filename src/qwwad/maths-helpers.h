@@ -134,6 +134,16 @@ auto Theta(double x) -> unsigned int;
 
 auto sf_brillouin(double J,
                   double x) -> double;
+
+auto get_fft_size(arma::uword n) -> arma::uword;
+
+void fft3(arma::cx_cube &X,
+          bool           inverse);
+
+auto make_sample_range(double xmin,
+                       double xmax,
+                       size_t n,
+                       bool   log_spacing = false) -> arma::vec;
 } // namespace
 #endif
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
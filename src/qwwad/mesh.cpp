@@ -234,6 +234,32 @@ auto Mesh::get_n3D_in_layer(const unsigned int iL) const -> double
     return _n3D_layer[iL%_n3D_layer.size()];
 }
 
+/**
+ * \brief Find which layer contains each cell of the mesh
+ *
+ * \returns The index of the layer (within a single period) that contains each cell
+ */
+auto Mesh::get_layer_index() const -> arma::uvec
+{
+    const auto n_layer_1per = _W_layer.size();
+    const auto n_layer      = _layer_top_index.size();
+    arma::uvec index(_z.size());
+
+    unsigned int icell = 0;
+
+    for(unsigned int iL = 0; iL < n_layer; ++iL)
+    {
+        // Any cells beyond the top of the final layer are assigned to that layer
+        const auto top = (iL == n_layer-1) ? _z.size() : _layer_top_index[iL];
+
+        for(; icell < top; ++icell) {
+            index(icell) = iL%n_layer_1per;
+        }
+    }
+
+    return index;
+}
+
 /** Get the doping concentration at a given point in the structure */
 auto Mesh::get_n3D_at_point(const unsigned int iz) const -> double
 {
@@ -81,6 +81,11 @@ public:
     [[nodiscard]] inline auto get_layer_widths() const {return _W_layer;}
     [[nodiscard]] inline auto get_x_array()      const {return _x;}
 
+    /** Return the alloy fractions in each layer of a single period */
+    [[nodiscard]] inline auto get_x_layers()     const {return _x_layer;}
+
+    [[nodiscard]] auto get_layer_index() const -> arma::uvec;
+
     [[nodiscard]] auto get_n3D_in_layer(const unsigned int iL) const -> double;
     [[nodiscard]] auto get_n3D_at_point(const unsigned int iz) const -> double;
 
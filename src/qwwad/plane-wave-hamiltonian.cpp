@@ -0,0 +1,378 @@
+/**
+ * \file   plane-wave-hamiltonian.cpp
+ * \brief  Matrix-free pseudopotential Hamiltonian in a plane-wave basis
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "plane-wave-hamiltonian.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "constants.h"
+#include "maths-helpers.h"
+#include "ppsop.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Set up the Hamiltonian for a list of atoms
+ *
+ * \param[in] A0         Lattice constant [m]
+ * \param[in] m_per_au   Conversion factor from SI to a.u.
+ * \param[in] atoms      Atomic definitions
+ * \param[in] G          Reciprocal lattice vectors [1/m]
+ * \param[in] spin_orbit Include spin-orbit coupling?
+ */
+PlaneWaveHamiltonian::PlaneWaveHamiltonian(const double                  A0,
+                                           const double                  m_per_au,
+                                           const std::vector<atom>      &atoms,
+                                           const std::vector<arma::vec> &G,
+                                           const bool                    spin_orbit) :
+    PlaneWaveHamiltonian(A0, m_per_au, Supercell(atoms), G, spin_orbit)
+{}
+
+/**
+ * \brief Set up the Hamiltonian for a supercell
+ *
+ * \param[in] A0         Lattice constant [m]
+ * \param[in] m_per_au   Conversion factor from SI to a.u.
+ * \param[in] cell       Atomic species and positions
+ * \param[in] G          Reciprocal lattice vectors [1/m]
+ * \param[in] spin_orbit Include spin-orbit coupling?
+ *
+ * \details The potential is found on the real-space grid once, here, using
+ *          the same form factors and structure factors as the dense matrix.
+ */
+PlaneWaveHamiltonian::PlaneWaveHamiltonian(const double                  A0,
+                                           const double                  m_per_au,
+                                           const Supercell              &cell,
+                                           const std::vector<arma::vec> &G,
+                                           const bool                    spin_orbit) :
+    _spin_orbit(spin_orbit),
+    _n_G(G.size())
+{
+    const size_t n_atoms = cell.get_n_atoms();
+
+    if(n_atoms == 0 || G.empty()) {
+        throw std::domain_error("Atoms and reciprocal lattice vectors are needed for the Hamiltonian");
+    }
+
+    auto potential = std::make_shared<Potential>();
+    auto &pot = *potential;
+
+    pot.G.set_size(3, _n_G);
+    pot.grid_index.set_size(_n_G);
+
+    for(unsigned int iG = 0; iG < _n_G; ++iG) {
+        pot.G.col(iG) = G[iG];
+    }
+
+    // Find the spacing of the reciprocal lattice along each axis, and the
+    // integer coordinates of each vector
+    std::array<double, 3> step {};  // Reciprocal lattice spacing [1/m]
+    arma::imat m(3, _n_G);          // Integer coordinates of each vector
+    std::array<arma::sword, 3> m_max {};
+
+    for(unsigned int c = 0; c < 3; ++c)
+    {
+        const arma::rowvec G_abs = arma::abs(pot.G.row(c));
+        const arma::uvec   nonzero = arma::find(G_abs > 1e-9*2.0*pi/A0);
+        step[c] = nonzero.is_empty() ? 2.0*pi/A0 : G_abs(nonzero).min();
+
+        for(unsigned int iG = 0; iG < _n_G; ++iG)
+        {
+            m(c, iG) = std::llround(pot.G(c, iG)/step[c]);
+
+            if(std::abs(pot.G(c, iG) - m(c, iG)*step[c]) > 1e-6*step[c])
+            {
+                std::ostringstream oss;
+                oss << "Reciprocal lattice vector " << iG+1 << " is not on an orthorhombic "
+                    << "grid, so the matrix-free Hamiltonian can't be used";
+                throw std::domain_error(oss.str());
+            }
+        }
+
+        // The grid must hold every difference between basis vectors, and the
+        // product of the potential with a wave function, without aliasing
+        m_max[c]  = arma::max(arma::abs(m.row(c)));
+        pot.n_grid[c] = get_fft_size(4*m_max[c] + 1);
+    }
+
+    const auto wrap = [&pot](const arma::sword mc, const unsigned int c) -> arma::uword {
+        return (mc < 0) ? mc + pot.n_grid[c] : mc;
+    };
+
+    for(unsigned int iG = 0; iG < _n_G; ++iG) {
+        pot.grid_index(iG) = wrap(m(0,iG), 0) + pot.n_grid[0]*(wrap(m(1,iG), 1) + pot.n_grid[1]*wrap(m(2,iG), 2));
+    }
+
+    // The atoms are grouped by species, so that each form factor is only
+    // looked up by name once per shell
+    const auto &species      = cell.get_species_names();
+    const auto &atom_species = cell.get_species();
+
+    // The dense matrix only contains q = G - G', so the potential is cut off
+    // at twice the largest basis vector
+    const double G_max     = std::sqrt(arma::max(arma::sum(arma::square(pot.G), 0)));
+    const double q_sqr_max = 4.0*G_max*G_max*(1.0 + 1e-9);
+
+    // Find every grid point within the cut-off, and group into |q|^2 shells
+    struct Point {
+        arma::uword  index;    ///< Position on grid
+        arma::sword  m[3];     ///< Integer coordinates
+        unsigned int shell;    ///< Index of |q|^2 shell
+    };
+
+    std::vector<Point> points;
+    std::map<std::array<arma::sword, 3>, unsigned int> shell_index; // Shell for each set of squared coordinates
+    std::vector<double> shell_q_sqr;
+
+    for(arma::sword m2 = -2*m_max[2]; m2 <= 2*m_max[2]; ++m2) {
+        for(arma::sword m1 = -2*m_max[1]; m1 <= 2*m_max[1]; ++m1) {
+            for(arma::sword m0 = -2*m_max[0]; m0 <= 2*m_max[0]; ++m0)
+            {
+                const double q0 = m0*step[0];
+                const double q1 = m1*step[1];
+                const double q2 = m2*step[2];
+                const double q_sqr = q0*q0 + q1*q1 + q2*q2;
+
+                if(q_sqr > q_sqr_max) {
+                    continue;
+                }
+
+                // Points with the same squared integer coordinates along every
+                // axis share a shell
+                const std::array<arma::sword, 3> key = {m0*m0, m1*m1, m2*m2};
+                const auto it = shell_index.emplace(key, shell_q_sqr.size());
+
+                if(it.second) {
+                    shell_q_sqr.push_back(q_sqr);
+                }
+
+                points.push_back({wrap(m0, 0) + pot.n_grid[0]*(wrap(m1, 1) + pot.n_grid[1]*wrap(m2, 2)),
+                                  {m0, m1, m2},
+                                  it.first->second});
+            }
+        }
+    }
+
+    // Form factors and spin-orbit parameters for each species
+    arma::mat form_factor(shell_q_sqr.size(), species.size());
+    arma::vec lambda_s = arma::zeros(species.size());
+
+    for(unsigned int is = 0; is < species.size(); ++is)
+    {
+        for(unsigned int ishell = 0; ishell < shell_q_sqr.size(); ++ishell) {
+            form_factor(ishell, is) = Vf(A0, m_per_au, shell_q_sqr[ishell], species[is].c_str());
+        }
+
+        if(_spin_orbit) {
+            lambda_s(is) = lambda(species[is].c_str());
+        }
+    }
+
+    // The phase factor exp(-i q.tau) separates into a factor for each axis,
+    // so tabulate these for every atom
+    std::array<arma::cx_mat, 3> phase;
+    const std::array<const std::vector<double> *, 3> r = {&cell.get_x(), &cell.get_y(), &cell.get_z()};
+
+    for(unsigned int c = 0; c < 3; ++c)
+    {
+        phase[c].set_size(4*m_max[c]+1, n_atoms);
+
+        for(size_t ia = 0; ia < n_atoms; ++ia) {
+            for(arma::sword mc = -2*m_max[c]; mc <= 2*m_max[c]; ++mc) {
+                phase[c](mc + 2*m_max[c], ia) = std::polar(1.0, -mc*step[c]*(*r[c])[ia]);
+            }
+        }
+    }
+
+    // Potential and spin-orbit structure factor at each q [QWWAD3, 15.76 & 15.81]
+    arma::cx_cube V_q(pot.n_grid[0], pot.n_grid[1], pot.n_grid[2], arma::fill::zeros);
+    arma::cx_cube Lambda_q;
+
+    if(_spin_orbit) {
+        Lambda_q.zeros(pot.n_grid[0], pot.n_grid[1], pot.n_grid[2]);
+    }
+
+#pragma omp parallel for schedule(static)
+    for(size_t ip = 0; ip < points.size(); ++ip)
+    {
+        const auto &point = points[ip];
+        const arma::rowvec vf = form_factor.row(point.shell);
+
+        // Skip shells where the potential vanishes for every species
+        if(!_spin_orbit && arma::all(vf == 0.0)) {
+            continue;
+        }
+
+        std::complex<double> V      = 0.0;
+        std::complex<double> Lambda = 0.0;
+
+        for(size_t ia = 0; ia < n_atoms; ++ia)
+        {
+            const auto p = phase[0](point.m[0] + 2*m_max[0], ia)
+                         * phase[1](point.m[1] + 2*m_max[1], ia)
+                         * phase[2](point.m[2] + 2*m_max[2], ia);
+
+            V      += vf(atom_species[ia]) * p;
+            Lambda += lambda_s(atom_species[ia]) * p;
+        }
+
+        V_q[point.index] = V*2.0/static_cast<double>(n_atoms);
+
+        if(_spin_orbit) {
+            Lambda_q[point.index] = Lambda/static_cast<double>(n_atoms);
+        }
+    }
+
+    pot.V_mean = V_q[0].real();
+
+    // Transform to real space.  Undo the normalisation of the inverse FFT,
+    // since these are sums over all Fourier components
+    const double n_grid_total = V_q.n_elem;
+    fft3(V_q, true);
+    pot.V_r = V_q * n_grid_total;
+
+    if(_spin_orbit)
+    {
+        fft3(Lambda_q, true);
+        pot.Lambda_r = Lambda_q * n_grid_total;
+    }
+
+    _potential = potential;
+    set_k(arma::zeros(3));
+}
+
+/**
+ * \brief Set the wave vector
+ *
+ * \param[in] k Wave vector [1/m]
+ */
+void PlaneWaveHamiltonian::set_k(const arma::vec &k)
+{
+    _k        = k;
+    _G_plus_k = _potential->G.each_col() + k;
+
+    // Kinetic energy [QWWAD3, 15.77]
+    _T = hBar*hBar/(2*me) * arma::sum(arma::square(_G_plus_k), 0).t();
+}
+
+/**
+ * \brief Get the kinetic energy of each basis function
+ *
+ * \returns Kinetic energy [J]
+ */
+auto PlaneWaveHamiltonian::get_kinetic_energy() const -> arma::vec
+{
+    return _spin_orbit ? arma::vec(arma::join_cols(_T, _T)) : _T;
+}
+
+/**
+ * \brief Transform plane-wave coefficients onto the real-space grid
+ *
+ * \param[in] c Coefficient of each plane wave
+ *
+ * \returns Wave function at each grid point (divided by the number of grid points)
+ */
+auto PlaneWaveHamiltonian::to_real_space(const arma::cx_vec &c) const -> arma::cx_cube
+{
+    const auto &n_grid = _potential->n_grid;
+    arma::cx_cube psi(n_grid[0], n_grid[1], n_grid[2], arma::fill::zeros);
+    psi.elem(_potential->grid_index) = c;
+    fft3(psi, true);
+
+    return psi;
+}
+
+/**
+ * \brief Transform a function on the real-space grid back to plane-wave coefficients
+ *
+ * \param[in,out] psi Function at each grid point.  This is overwritten.
+ *
+ * \returns Coefficient of each plane wave
+ */
+auto PlaneWaveHamiltonian::to_reciprocal_space(arma::cx_cube &psi) const -> arma::cx_vec
+{
+    fft3(psi, false);
+    return psi.elem(_potential->grid_index);
+}
+
+/**
+ * \brief Multiply a set of vectors by the Hamiltonian
+ *
+ * \param[in] X Plane-wave coefficients, with one vector per column
+ *
+ * \returns H X
+ */
+auto PlaneWaveHamiltonian::apply(const arma::cx_mat &X) const -> arma::cx_mat
+{
+    if(X.n_rows != get_n_basis())
+    {
+        std::ostringstream oss;
+        oss << "Vectors have " << X.n_rows << " elements. Expected " << get_n_basis();
+        throw std::length_error(oss.str());
+    }
+
+    const unsigned int n_spin = _spin_orbit ? 2 : 1;
+    arma::cx_mat HX(X.n_rows, X.n_cols);
+
+    for(arma::uword j = 0; j < X.n_cols; ++j)
+    {
+        // Kinetic energy and local potential act on each spin separately
+        std::array<arma::cx_vec, 2> c;
+
+        for(unsigned int is = 0; is < n_spin; ++is)
+        {
+            c[is] = X.col(j).rows(is*_n_G, (is+1)*_n_G - 1);
+
+            auto psi = to_real_space(c[is]);
+            psi %= _potential->V_r;
+            HX.col(j).rows(is*_n_G, (is+1)*_n_G - 1) = to_reciprocal_space(psi) + _T % c[is];
+        }
+
+        if(!_spin_orbit) {
+            continue;
+        }
+
+        // Spin-orbit coupling [QWWAD3, 15.81].  The matrix element contains
+        // (G+k) x (G'+k).sigma, so convolve each component of (G'+k) c(G')
+        // with the structure factor, then take the cross product with (G+k).
+        std::array<arma::cx_mat, 2> w; // (G+k) x convolution, for each spin
+
+        for(unsigned int is = 0; is < 2; ++is)
+        {
+            arma::cx_mat u(_n_G, 3);
+
+            for(unsigned int e = 0; e < 3; ++e)
+            {
+                auto psi = to_real_space(_G_plus_k.row(e).t() % c[is]);
+                psi %= _potential->Lambda_r;
+                u.col(e) = to_reciprocal_space(psi);
+            }
+
+            const arma::cx_mat a = arma::conv_to<arma::cx_mat>::from(_G_plus_k.t());
+            w[is].set_size(_n_G, 3);
+            w[is].col(0) = a.col(1) % u.col(2) - a.col(2) % u.col(1);
+            w[is].col(1) = a.col(2) % u.col(0) - a.col(0) % u.col(2);
+            w[is].col(2) = a.col(0) % u.col(1) - a.col(1) % u.col(0);
+        }
+
+        const std::complex<double> I(0.0, 1.0);
+
+        HX.col(j).rows(0, _n_G-1) += -I*(w[0].col(2) + w[1].col(0) - I*w[1].col(1));
+        HX.col(j).rows(_n_G, 2*_n_G-1) += -I*(w[0].col(0) + I*w[0].col(1) - w[1].col(2));
+    }
+
+    return HX;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,102 @@
+/**
+ * \file   plane-wave-hamiltonian.h
+ * \brief  Matrix-free pseudopotential Hamiltonian in a plane-wave basis
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_PLANE_WAVE_HAMILTONIAN_H
+#define QWWAD_PLANE_WAVE_HAMILTONIAN_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <armadillo>
+
+#include "ppff.h"
+#include "supercell.h"
+
+namespace QWWAD {
+/**
+ * \brief Pseudopotential Hamiltonian for a supercell, applied without forming a matrix
+ *
+ * \details The dense Hamiltonian, H_GG', needs O(N^2) memory for N plane waves,
+ *          which limits supercells to a few thousand plane waves.  This class
+ *          only stores O(N) data, and applies each term where it is cheapest:
+ *
+ *          - The kinetic energy is diagonal in reciprocal space.
+ *          - The local potential is diagonal in real space.  The wave function
+ *            is transformed onto a real-space grid with a 3D FFT, multiplied
+ *            by the potential and transformed back.
+ *          - The optional spin-orbit term [QWWAD3, 15.81] is a convolution of
+ *            each Cartesian component of (G'+k) psi with the spin-orbit
+ *            structure factor, so it is applied with the same transforms.
+ *
+ *          Each application therefore costs O(N log N).  The real-space grid
+ *          is large enough that the result is identical to multiplying by the
+ *          dense matrix.
+ *
+ *          The supercell must be orthorhombic, with every reciprocal lattice
+ *          vector an integer multiple of 2 pi/L along each axis, as created by
+ *          qwwad_reciprocal_cube.  With spin-orbit coupling, the basis holds
+ *          all spin-up coefficients followed by all spin-down coefficients.
+ *
+ *          The real-space potential is fixed on construction and shared
+ *          between copies, so a copy only duplicates the O(N) k-dependent data.
+ *          Each thread can therefore take its own copy and call set_k().
+ */
+class PlaneWaveHamiltonian {
+public:
+    PlaneWaveHamiltonian(double                        A0,
+                         double                        m_per_au,
+                         const std::vector<atom>      &atoms,
+                         const std::vector<arma::vec> &G,
+                         bool                          spin_orbit = false);
+
+    PlaneWaveHamiltonian(double                        A0,
+                         double                        m_per_au,
+                         const Supercell              &cell,
+                         const std::vector<arma::vec> &G,
+                         bool                          spin_orbit = false);
+
+    void set_k(const arma::vec &k);
+
+    /// Get the number of basis functions
+    [[nodiscard]] inline auto get_n_basis() const -> size_t {return _spin_orbit ? 2*_n_G : _n_G;}
+
+    /// Get the size of the real-space grid along each axis
+    [[nodiscard]] inline auto get_grid_size() const -> const std::array<arma::uword, 3> & {return _potential->n_grid;}
+
+    /// Get the average crystal potential [J]
+    [[nodiscard]] inline auto get_mean_potential() const -> double {return _potential->V_mean;}
+
+    [[nodiscard]] auto get_kinetic_energy() const -> arma::vec;
+
+    [[nodiscard]] auto apply(const arma::cx_mat &X) const -> arma::cx_mat;
+
+private:
+    /// Data that doesn't depend on the wave vector
+    struct Potential {
+        std::array<arma::uword, 3> n_grid;     ///< Size of real-space grid
+        arma::mat                  G;          ///< Reciprocal lattice vectors [1/m] (one per column)
+        arma::uvec                 grid_index; ///< Position of each plane wave on the grid
+        double                     V_mean;     ///< Average crystal potential [J]
+        arma::cx_cube              V_r;        ///< Crystal potential on real-space grid [J]
+        arma::cx_cube              Lambda_r;   ///< Spin-orbit structure factor on real-space grid [J]
+    };
+
+    [[nodiscard]] auto to_real_space(const arma::cx_vec &c) const -> arma::cx_cube;
+    [[nodiscard]] auto to_reciprocal_space(arma::cx_cube &psi) const -> arma::cx_vec;
+
+    bool   _spin_orbit; ///< Include spin-orbit coupling?
+    size_t _n_G;        ///< Number of plane waves (per spin)
+
+    std::shared_ptr<const Potential> _potential; ///< Grid and potential (shared between copies)
+
+    arma::vec _k;        ///< Wave vector [1/m]
+    arma::mat _G_plus_k; ///< G + k for each plane wave [1/m]
+    arma::vec _T;        ///< Kinetic energy of each plane wave [J]
+};
+} // namespace QWWAD
+#endif // QWWAD_PLANE_WAVE_HAMILTONIAN_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
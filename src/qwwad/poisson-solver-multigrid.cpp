@@ -0,0 +1,629 @@
+/**
+ * \file   poisson-solver-multigrid.cpp
+ * \brief  Multigrid Poisson solver for 2D and 3D structured grids
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "poisson-solver-multigrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace QWWAD
+{
+namespace
+{
+/// Smallest number of cells along an axis that will be coarsened further
+const arma::uword min_coarsen_cells = 4;
+
+/// Number of cells below which the hierarchy is not coarsened any further
+const arma::uword min_level_cells = 64;
+
+/**
+ * \brief Find the interpolation stencil for a fine cell along one axis
+ *
+ * \param[in]  i         Index of the fine cell
+ * \param[in]  c         Coarsening factor along this axis
+ * \param[in]  nc        Number of coarse cells along this axis
+ * \param[in]  dirichlet True if the potential vanishes on the boundary faces
+ * \param[out] idx       Indices of the two coarse cells that contribute
+ * \param[out] w         Weights of the two coarse cells
+ *
+ * \details Linear interpolation between cell centres, giving weights of 3/4 for
+ *          the parent cell and 1/4 for its nearest neighbour.  Beyond the
+ *          boundary, the neighbour is a mirror image (zero-field) or an
+ *          antisymmetric image (Dirichlet) of the parent.
+ */
+inline void interp_weights(const arma::uword  i,
+                           const unsigned int c,
+                           const arma::uword  nc,
+                           const bool         dirichlet,
+                           arma::uword        idx[2],
+                           double             w[2])
+{
+    if(c == 1)
+    {
+        idx[0] = idx[1] = i;
+        w[0] = 1.0;
+        w[1] = 0.0;
+        return;
+    }
+
+    const auto I    = i/2;
+    const bool left = (i % 2 == 0);
+
+    idx[0] = I;
+    w[0]   = 0.75;
+
+    if((left && I == 0) || (!left && I+1 == nc))
+    {
+        idx[1] = I;
+        w[1]   = dirichlet ? -0.25 : 0.25;
+    }
+    else
+    {
+        idx[1] = left ? I-1 : I+1;
+        w[1]   = 0.25;
+    }
+}
+} // namespace
+
+/**
+ * \brief Create a 3D multigrid Poisson solver
+ *
+ * \param[in] eps Permittivity in each cell [F/m]
+ * \param[in] dx  Cell size along x (rows) [m]
+ * \param[in] dy  Cell size along y (columns) [m]
+ * \param[in] dz  Cell size along z (slices) [m]
+ * \param[in] bx  Boundary condition on the x faces
+ * \param[in] by  Boundary condition on the y faces
+ * \param[in] bz  Boundary condition on the z faces
+ */
+PoissonSolverMultigrid::PoissonSolverMultigrid(const arma::cube    &eps,
+                                               const double         dx,
+                                               const double         dy,
+                                               const double         dz,
+                                               PoissonBoundaryType  bx,
+                                               PoissonBoundaryType  by,
+                                               PoissonBoundaryType  bz) :
+    _bt{bx, by, bz}
+{
+    if(eps.is_empty()) {
+        throw std::runtime_error("Permittivity array is empty");
+    }
+
+    if(dx <= 0.0 || dy <= 0.0 || dz <= 0.0) {
+        throw std::domain_error("Cell size must be positive");
+    }
+
+    for(auto bt : _bt)
+    {
+        if(bt == MIXED) {
+            throw std::runtime_error("Mixed boundary conditions are not supported by the multigrid Poisson solver");
+        }
+    }
+
+    _levels.push_back(Level{eps, {dx, dy, dz}, {1, 1, 1}});
+    build_hierarchy();
+}
+
+/**
+ * \brief Create a 2D multigrid Poisson solver
+ *
+ * \param[in] eps Permittivity in each cell [F/m]
+ * \param[in] dx  Cell size along x (rows) [m]
+ * \param[in] dy  Cell size along y (columns) [m]
+ * \param[in] bx  Boundary condition on the x faces
+ * \param[in] by  Boundary condition on the y faces
+ *
+ * \details The system is treated as a single slice of a 3D grid, with no
+ *          flux through the out-of-plane faces.
+ */
+PoissonSolverMultigrid::PoissonSolverMultigrid(const arma::mat     &eps,
+                                               const double         dx,
+                                               const double         dy,
+                                               PoissonBoundaryType  bx,
+                                               PoissonBoundaryType  by) :
+    PoissonSolverMultigrid(arma::cube(eps.memptr(), eps.n_rows, eps.n_cols, 1),
+                           dx, dy, 1.0, bx, by, ZERO_FIELD)
+{}
+
+/**
+ * \brief Create the coarse levels of the multigrid hierarchy
+ *
+ * \details The permittivity on each coarse cell is the mean of its children
+ */
+void PoissonSolverMultigrid::build_hierarchy()
+{
+    while(true)
+    {
+        const auto &fine = _levels.back();
+        const std::array<arma::uword, 3> n = {fine.eps.n_rows, fine.eps.n_cols, fine.eps.n_slices};
+
+        std::array<unsigned int, 3> c = {1, 1, 1};
+        bool can_coarsen = false;
+
+        for(unsigned int d = 0; d < 3; ++d)
+        {
+            if(n[d] % 2 == 0 && n[d] >= min_coarsen_cells)
+            {
+                c[d] = 2;
+                can_coarsen = true;
+            }
+        }
+
+        if(!can_coarsen || fine.eps.n_elem <= min_level_cells) {
+            break;
+        }
+
+        Level coarse{arma::cube(n[0]/c[0], n[1]/c[1], n[2]/c[2]),
+                     {fine.h[0]*c[0], fine.h[1]*c[1], fine.h[2]*c[2]},
+                     {1, 1, 1}};
+
+        const double norm = 1.0/(c[0]*c[1]*c[2]);
+
+        for(arma::uword K = 0; K < coarse.eps.n_slices; ++K)
+        {
+            for(arma::uword J = 0; J < coarse.eps.n_cols; ++J)
+            {
+                for(arma::uword I = 0; I < coarse.eps.n_rows; ++I)
+                {
+                    double sum = 0.0;
+
+                    for(unsigned int dk = 0; dk < c[2]; ++dk) {
+                        for(unsigned int dj = 0; dj < c[1]; ++dj) {
+                            for(unsigned int di = 0; di < c[0]; ++di) {
+                                sum += fine.eps(I*c[0]+di, J*c[1]+dj, K*c[2]+dk);
+                            }
+                        }
+                    }
+
+                    coarse.eps(I,J,K) = sum*norm;
+                }
+            }
+        }
+
+        _levels.back().coarsen = c;
+        _levels.push_back(std::move(coarse));
+    }
+}
+
+/**
+ * \brief Check whether the potential is only defined up to a constant
+ *
+ * \return True if there are zero-field boundaries on all faces
+ */
+auto PoissonSolverMultigrid::is_singular() const -> bool
+{
+    return std::all_of(_bt.begin(), _bt.end(),
+                       [](PoissonBoundaryType bt){return bt == ZERO_FIELD;});
+}
+
+/**
+ * \brief Evaluate the discretised Poisson operator at a single cell
+ *
+ * \param[in]  lev  The grid level
+ * \param[in]  phi  Potential on the grid level
+ * \param[in]  i    Index along x
+ * \param[in]  j    Index along y
+ * \param[in]  k    Index along z
+ * \param[out] diag Diagonal element of the operator for this cell
+ *
+ * \return The sum of the off-diagonal contributions, such that the operator
+ *         gives diag*phi(i,j,k) - [return value]
+ *
+ * \details The permittivity on each cell face is the mean of the adjacent cells
+ */
+auto PoissonSolverMultigrid::apply_stencil(const Level      &lev,
+                                           const arma::cube &phi,
+                                           const arma::uword i,
+                                           const arma::uword j,
+                                           const arma::uword k,
+                                           double           &diag) const -> double
+{
+    const auto &eps = lev.eps;
+    const auto  e0  = eps(i,j,k);
+
+    const auto rx = 1.0/(lev.h[0]*lev.h[0]);
+    const auto ry = 1.0/(lev.h[1]*lev.h[1]);
+    const auto rz = 1.0/(lev.h[2]*lev.h[2]);
+
+    double off = 0.0;
+    diag = 0.0;
+
+    // Faces normal to x
+    if(i > 0) {
+        const auto w = 0.5*(e0 + eps(i-1,j,k))*rx;
+        diag += w;
+        off  += w*phi(i-1,j,k);
+    } else if(_bt[0] == DIRICHLET) {
+        diag += 2.0*e0*rx;
+    }
+
+    if(i+1 < eps.n_rows) {
+        const auto w = 0.5*(e0 + eps(i+1,j,k))*rx;
+        diag += w;
+        off  += w*phi(i+1,j,k);
+    } else if(_bt[0] == DIRICHLET) {
+        diag += 2.0*e0*rx;
+    }
+
+    // Faces normal to y
+    if(j > 0) {
+        const auto w = 0.5*(e0 + eps(i,j-1,k))*ry;
+        diag += w;
+        off  += w*phi(i,j-1,k);
+    } else if(_bt[1] == DIRICHLET) {
+        diag += 2.0*e0*ry;
+    }
+
+    if(j+1 < eps.n_cols) {
+        const auto w = 0.5*(e0 + eps(i,j+1,k))*ry;
+        diag += w;
+        off  += w*phi(i,j+1,k);
+    } else if(_bt[1] == DIRICHLET) {
+        diag += 2.0*e0*ry;
+    }
+
+    // Faces normal to z
+    if(k > 0) {
+        const auto w = 0.5*(e0 + eps(i,j,k-1))*rz;
+        diag += w;
+        off  += w*phi(i,j,k-1);
+    } else if(_bt[2] == DIRICHLET) {
+        diag += 2.0*e0*rz;
+    }
+
+    if(k+1 < eps.n_slices) {
+        const auto w = 0.5*(e0 + eps(i,j,k+1))*rz;
+        diag += w;
+        off  += w*phi(i,j,k+1);
+    } else if(_bt[2] == DIRICHLET) {
+        diag += 2.0*e0*rz;
+    }
+
+    return off;
+}
+
+/**
+ * \brief Apply red-black Gauss-Seidel sweeps to a grid level
+ *
+ * \param[in]     lev      The grid level
+ * \param[in,out] phi      Potential on the grid level
+ * \param[in]     rhs      Right-hand side on the grid level
+ * \param[in]     n_sweeps Number of sweeps
+ *
+ * \details All cells of one colour depend only on cells of the other colour, so
+ *          each half-sweep is updated in parallel.
+ */
+void PoissonSolverMultigrid::smooth(const Level        &lev,
+                                    arma::cube         &phi,
+                                    const arma::cube   &rhs,
+                                    const unsigned int  n_sweeps) const
+{
+    const auto nx = phi.n_rows;
+    const auto ny = phi.n_cols;
+    const auto nz = phi.n_slices;
+
+    for(unsigned int isweep = 0; isweep < n_sweeps; ++isweep)
+    {
+        for(unsigned int colour = 0; colour < 2; ++colour)
+        {
+#pragma omp parallel for collapse(2) schedule(static)
+            for(arma::uword k = 0; k < nz; ++k)
+            {
+                for(arma::uword j = 0; j < ny; ++j)
+                {
+                    for(arma::uword i = (j+k+colour) % 2; i < nx; i += 2)
+                    {
+                        double diag = 0.0;
+                        const auto off = apply_stencil(lev, phi, i, j, k, diag);
+
+                        if(diag > 0.0) {
+                            phi(i,j,k) = (rhs(i,j,k) + off)/diag;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * \brief Find the Euclidean norm of the residual on a grid level
+ *
+ * \param[in] lev The grid level
+ * \param[in] phi Potential on the grid level
+ * \param[in] rhs Right-hand side on the grid level
+ */
+auto PoissonSolverMultigrid::residual_norm(const Level      &lev,
+                                           const arma::cube &phi,
+                                           const arma::cube &rhs) const -> double
+{
+    const auto nx = phi.n_rows;
+    const auto ny = phi.n_cols;
+    const auto nz = phi.n_slices;
+
+    double sum = 0.0;
+
+#pragma omp parallel for collapse(2) reduction(+:sum) schedule(static)
+    for(arma::uword k = 0; k < nz; ++k)
+    {
+        for(arma::uword j = 0; j < ny; ++j)
+        {
+            for(arma::uword i = 0; i < nx; ++i)
+            {
+                double diag = 0.0;
+                const auto off = apply_stencil(lev, phi, i, j, k, diag);
+                const auto r   = rhs(i,j,k) - (diag*phi(i,j,k) - off);
+                sum += r*r;
+            }
+        }
+    }
+
+    return std::sqrt(sum);
+}
+
+/**
+ * \brief Compute the residual on a grid level and restrict it to the next level
+ *
+ * \param[in]  fine       The fine grid level
+ * \param[in]  phi        Potential on the fine grid
+ * \param[in]  rhs        Right-hand side on the fine grid
+ * \param[out] rhs_coarse Right-hand side on the coarse grid
+ *
+ * \details The residual is never stored on the fine grid.  Each coarse cell
+ *          takes the mean residual of its children.
+ */
+void PoissonSolverMultigrid::restrict_residual(const Level      &fine,
+                                               const arma::cube &phi,
+                                               const arma::cube &rhs,
+                                               arma::cube       &rhs_coarse) const
+{
+    const auto &c   = fine.coarsen;
+    const auto  nX  = rhs_coarse.n_rows;
+    const auto  nY  = rhs_coarse.n_cols;
+    const auto  nZ  = rhs_coarse.n_slices;
+    const double norm = 1.0/(c[0]*c[1]*c[2]);
+
+#pragma omp parallel for collapse(2) schedule(static)
+    for(arma::uword K = 0; K < nZ; ++K)
+    {
+        for(arma::uword J = 0; J < nY; ++J)
+        {
+            for(arma::uword I = 0; I < nX; ++I)
+            {
+                double sum = 0.0;
+
+                for(unsigned int dk = 0; dk < c[2]; ++dk) {
+                    for(unsigned int dj = 0; dj < c[1]; ++dj) {
+                        for(unsigned int di = 0; di < c[0]; ++di) {
+                            const auto i = I*c[0] + di;
+                            const auto j = J*c[1] + dj;
+                            const auto k = K*c[2] + dk;
+
+                            double diag = 0.0;
+                            const auto off = apply_stencil(fine, phi, i, j, k, diag);
+                            sum += rhs(i,j,k) - (diag*phi(i,j,k) - off);
+                        }
+                    }
+                }
+
+                rhs_coarse(I,J,K) = sum*norm;
+            }
+        }
+    }
+}
+
+/**
+ * \brief Interpolate a coarse-grid correction and add it to the fine-grid potential
+ *
+ * \param[in]     fine       The fine grid level
+ * \param[in]     phi_coarse Correction on the coarse grid
+ * \param[in,out] phi        Potential on the fine grid
+ */
+void PoissonSolverMultigrid::prolongate_correction(const Level      &fine,
+                                                   const arma::cube &phi_coarse,
+                                                   arma::cube       &phi) const
+{
+    const auto &c  = fine.coarsen;
+    const auto  nx = phi.n_rows;
+    const auto  ny = phi.n_cols;
+    const auto  nz = phi.n_slices;
+
+#pragma omp parallel for collapse(2) schedule(static)
+    for(arma::uword k = 0; k < nz; ++k)
+    {
+        for(arma::uword j = 0; j < ny; ++j)
+        {
+            arma::uword ik[2];
+            arma::uword ij[2];
+            double      wk[2];
+            double      wj[2];
+            interp_weights(k, c[2], phi_coarse.n_slices, _bt[2] == DIRICHLET, ik, wk);
+            interp_weights(j, c[1], phi_coarse.n_cols,   _bt[1] == DIRICHLET, ij, wj);
+
+            for(arma::uword i = 0; i < nx; ++i)
+            {
+                arma::uword ii[2];
+                double      wi[2];
+                interp_weights(i, c[0], phi_coarse.n_rows, _bt[0] == DIRICHLET, ii, wi);
+
+                double correction = 0.0;
+
+                for(unsigned int a = 0; a < 2; ++a) {
+                    for(unsigned int b = 0; b < 2; ++b) {
+                        for(unsigned int d = 0; d < 2; ++d) {
+                            correction += wi[d]*wj[b]*wk[a]*phi_coarse(ii[d], ij[b], ik[a]);
+                        }
+                    }
+                }
+
+                phi(i,j,k) += correction;
+            }
+        }
+    }
+}
+
+/**
+ * \brief Solve the system on the coarsest grid level
+ *
+ * \param[in]     lev The grid level
+ * \param[in,out] phi Potential on the grid level
+ * \param[in]     rhs Right-hand side on the grid level
+ *
+ * \details The coarsest grid is small, so we just keep smoothing until the
+ *          residual has dropped by three orders of magnitude.
+ */
+void PoissonSolverMultigrid::solve_coarsest(const Level      &lev,
+                                            arma::cube       &phi,
+                                            const arma::cube &rhs) const
+{
+    const arma::uword n_max = std::max({phi.n_rows, phi.n_cols, phi.n_slices});
+    const arma::uword max_sweeps = std::max<arma::uword>(50, 2*n_max*n_max);
+    const unsigned int sweeps_per_check = 10;
+
+    const auto target = 1e-3*residual_norm(lev, phi, rhs);
+
+    for(arma::uword isweep = 0; isweep < max_sweeps; isweep += sweeps_per_check)
+    {
+        smooth(lev, phi, rhs, sweeps_per_check);
+
+        if(residual_norm(lev, phi, rhs) <= target) {
+            break;
+        }
+    }
+}
+
+/**
+ * \brief Perform a multigrid V-cycle, starting at a given grid level
+ *
+ * \param[in]     ilevel Index of the starting grid level
+ * \param[in,out] phi    Potential on each grid level
+ * \param[in,out] rhs    Right-hand side on each grid level
+ */
+void PoissonSolverMultigrid::v_cycle(const size_t             ilevel,
+                                     std::vector<arma::cube> &phi,
+                                     std::vector<arma::cube> &rhs) const
+{
+    const auto &lev = _levels[ilevel];
+
+    if(ilevel + 1 == _levels.size())
+    {
+        solve_coarsest(lev, phi[ilevel], rhs[ilevel]);
+        return;
+    }
+
+    smooth(lev, phi[ilevel], rhs[ilevel], _n_pre);
+    restrict_residual(lev, phi[ilevel], rhs[ilevel], rhs[ilevel+1]);
+
+    phi[ilevel+1].zeros();
+    v_cycle(ilevel+1, phi, rhs);
+
+    prolongate_correction(lev, phi[ilevel+1], phi[ilevel]);
+    smooth(lev, phi[ilevel], rhs[ilevel], _n_post);
+}
+
+/**
+ * \brief Solve the Poisson equation for a given charge density
+ *
+ * \param[in] rho Charge density in each cell [C/m^3]
+ *
+ * \return The potential in each cell [V]
+ */
+auto PoissonSolverMultigrid::solve(const arma::cube &rho) const -> arma::cube
+{
+    const arma::cube phi_guess(arma::size(_levels[0].eps), arma::fill::zeros);
+    return solve(rho, phi_guess);
+}
+
+/**
+ * \brief Solve the Poisson equation for a given charge density, using an initial guess
+ *
+ * \param[in] rho       Charge density in each cell [C/m^3]
+ * \param[in] phi_guess Initial estimate of the potential in each cell [V]
+ *
+ * \return The potential in each cell [V]
+ *
+ * \details This is useful in self-consistent calculations, where the solution
+ *          from the previous iteration is usually a good starting point.
+ *          If zero-field boundaries are used on all faces, the potential is only
+ *          defined up to a constant, and the solution is chosen to have a mean of
+ *          zero.  Any net charge is removed from the system in this case.
+ */
+auto PoissonSolverMultigrid::solve(const arma::cube &rho,
+                                   const arma::cube &phi_guess) const -> arma::cube
+{
+    const auto &eps = _levels[0].eps;
+
+    if(arma::size(rho) != arma::size(eps) || arma::size(phi_guess) != arma::size(eps)) {
+        throw std::runtime_error("Permittivity and charge density arrays have different sizes");
+    }
+
+    // Workspace for every level in the hierarchy
+    const auto nlevels = _levels.size();
+    std::vector<arma::cube> phi(nlevels);
+    std::vector<arma::cube> rhs(nlevels);
+
+    for(size_t il = 1; il < nlevels; ++il)
+    {
+        phi[il].zeros(arma::size(_levels[il].eps));
+        rhs[il].zeros(arma::size(_levels[il].eps));
+    }
+
+    phi[0] = phi_guess;
+    rhs[0] = rho;
+
+    const bool singular = is_singular();
+
+    if(singular) {
+        rhs[0] -= arma::accu(rhs[0])/rhs[0].n_elem;
+    }
+
+    const auto rhs_norm = std::sqrt(arma::accu(arma::square(rhs[0])));
+
+    if(rhs_norm == 0.0) {
+        phi[0].zeros();
+        return phi[0];
+    }
+
+    for(unsigned int icycle = 0; icycle < _max_cycles; ++icycle)
+    {
+        v_cycle(0, phi, rhs);
+
+        if(singular) {
+            phi[0] -= arma::accu(phi[0])/phi[0].n_elem;
+        }
+
+        if(residual_norm(_levels[0], phi[0], rhs[0]) <= _tolerance*rhs_norm) {
+            return phi[0];
+        }
+    }
+
+    std::ostringstream oss;
+    oss << "Multigrid Poisson solver did not converge after " << _max_cycles << " cycles";
+    throw std::runtime_error(oss.str());
+}
+
+/**
+ * \brief Solve the Poisson equation for a given charge density on a 2D grid
+ *
+ * \param[in] rho Charge density in each cell [C/m^3]
+ *
+ * \return The potential in each cell [V]
+ */
+auto PoissonSolverMultigrid::solve(const arma::mat &rho) const -> arma::mat
+{
+    if(_levels[0].eps.n_slices != 1) {
+        throw std::runtime_error("2D charge density given to a 3D Poisson solver");
+    }
+
+    const arma::cube rho_cube(rho.memptr(), rho.n_rows, rho.n_cols, 1);
+    const arma::cube phi = solve(rho_cube);
+
+    return phi.slice(0);
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,129 @@
+/**
+ * \file   poisson-solver-multigrid.h
+ * \brief  Multigrid Poisson solver for 2D and 3D structured grids
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_POISSON_SOLVER_MULTIGRID_H
+#define QWWAD_POISSON_SOLVER_MULTIGRID_H
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif //HAVE_CONFIG_H
+
+#include <array>
+#include <vector>
+
+#include <armadillo>
+
+#include "poisson-solver.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Geometric-multigrid solver for the Poisson equation on a structured grid
+ *
+ * \details Solves \f$-\nabla\cdot(\epsilon\nabla\phi) = \rho\f$ on a uniform
+ *          cell-centred grid with a spatially varying permittivity.  The
+ *          boundary condition can be set independently along each axis:
+ *
+ *          - DIRICHLET:  the potential is zero on the outer faces of the grid
+ *          - ZERO_FIELD: the normal component of the field is zero on the outer faces
+ *
+ *          The grid is coarsened by a factor of two along each axis for as long as
+ *          the number of cells along that axis is even.  Best performance is therefore
+ *          obtained when the number of cells is a power of two (multiplied by a small
+ *          integer).  Each V-cycle uses red-black Gauss-Seidel smoothing, which is
+ *          parallelised across all available cores if OpenMP is enabled.  The total
+ *          cost is O(N) in the number of grid cells.
+ */
+class PoissonSolverMultigrid
+{
+public:
+    PoissonSolverMultigrid(const arma::cube    &eps,
+                           double               dx,
+                           double               dy,
+                           double               dz,
+                           PoissonBoundaryType  bx=DIRICHLET,
+                           PoissonBoundaryType  by=DIRICHLET,
+                           PoissonBoundaryType  bz=DIRICHLET);
+
+    PoissonSolverMultigrid(const arma::mat     &eps,
+                           double               dx,
+                           double               dy,
+                           PoissonBoundaryType  bx=DIRICHLET,
+                           PoissonBoundaryType  by=DIRICHLET);
+
+    [[nodiscard]] auto solve(const arma::cube &rho) const -> arma::cube;
+    [[nodiscard]] auto solve(const arma::cube &rho,
+                             const arma::cube &phi_guess) const -> arma::cube;
+    [[nodiscard]] auto solve(const arma::mat &rho) const -> arma::mat;
+
+    /// Set the target residual, relative to the norm of the charge density
+    inline void set_tolerance(const double tolerance) {_tolerance = tolerance;}
+
+    /// Set the maximum number of V-cycles before giving up
+    inline void set_max_cycles(const unsigned int max_cycles) {_max_cycles = max_cycles;}
+
+    /// Get the number of grid levels in the multigrid hierarchy
+    [[nodiscard]] inline auto get_n_levels() const {return _levels.size();}
+
+private:
+    /**
+     * \brief A single level in the multigrid hierarchy
+     */
+    struct Level
+    {
+        arma::cube eps;                      ///< Permittivity in each cell [F/m]
+        std::array<double, 3>       h;       ///< Cell size along each axis [m]
+        std::array<unsigned int, 3> coarsen; ///< Coarsening factor to the next level (1 or 2)
+    };
+
+    std::vector<Level>                 _levels; ///< Grid hierarchy (finest first)
+    std::array<PoissonBoundaryType, 3> _bt;     ///< Boundary condition along each axis
+
+    double       _tolerance  = 1e-8; ///< Relative residual at which to stop iterating
+    unsigned int _max_cycles = 100;  ///< Maximum number of V-cycles
+    unsigned int _n_pre      = 2;    ///< Number of pre-smoothing sweeps
+    unsigned int _n_post     = 2;    ///< Number of post-smoothing sweeps
+
+    void build_hierarchy();
+
+    [[nodiscard]] auto is_singular() const -> bool;
+
+    [[nodiscard]] auto apply_stencil(const Level      &lev,
+                                     const arma::cube &phi,
+                                     arma::uword       i,
+                                     arma::uword       j,
+                                     arma::uword       k,
+                                     double           &diag) const -> double;
+
+    void smooth(const Level      &lev,
+                arma::cube       &phi,
+                const arma::cube &rhs,
+                unsigned int      n_sweeps) const;
+
+    [[nodiscard]] auto residual_norm(const Level      &lev,
+                                     const arma::cube &phi,
+                                     const arma::cube &rhs) const -> double;
+
+    void restrict_residual(const Level      &fine,
+                           const arma::cube &phi,
+                           const arma::cube &rhs,
+                           arma::cube       &rhs_coarse) const;
+
+    void prolongate_correction(const Level      &fine,
+                               const arma::cube &phi_coarse,
+                               arma::cube       &phi) const;
+
+    void solve_coarsest(const Level      &lev,
+                        arma::cube       &phi,
+                        const arma::cube &rhs) const;
+
+    void v_cycle(size_t                   ilevel,
+                 std::vector<arma::cube> &phi,
+                 std::vector<arma::cube> &rhs) const;
+};
+} // namespace
+#endif //QWWAD_POISSON_SOLVER_MULTIGRID_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
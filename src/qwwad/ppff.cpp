@@ -414,13 +414,16 @@ auto read_atoms(const char * filename) -> std::vector<atom>
      throw std::runtime_error("Could not read number of atoms");
  }
 
+ char type[32]; // Buffer for atom type
  double rx;
  double ry;
  double rz;
  int ia=0;
- while((fscanf(Fatoms,"%s %lf %lf %lf",atoms[ia].type,
-        &rx,&ry,&rz))!=EOF)
+ while(ia < n_atoms && (fscanf(Fatoms,"%31s %lf %lf %lf",type,
+        &rx,&ry,&rz))==4)
  {
+     atoms[ia].type = type;
+
      arma::vec r(3);
      r(0) = rx;
      r(1) = ry;
@@ -434,6 +437,9 @@ auto read_atoms(const char * filename) -> std::vector<atom>
  }
  fclose(Fatoms);
 
+ // Discard any entries that weren't found in the file
+ atoms.resize(ia);
+
  return atoms;
 }   
 
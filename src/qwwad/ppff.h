@@ -11,12 +11,13 @@
 #define PPFF_H
 
 #include <armadillo>
+#include <string>
 #include <vector>
 
 struct atom
 {
- char	   *type;
- arma::vec  r;
+ std::string type; ///< Atomic species, as used by Vf()
+ arma::vec   r;    ///< Position [m]
 };
 
 auto Vf(double        A0,
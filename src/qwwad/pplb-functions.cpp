@@ -1,38 +1,10 @@
 #include "pplb-functions.h"
 
-/** Writes the eigenvectors (a_nk(G)) to the files ank.r
- * \param[in] ank    Eigenvector coefficients
- * \param[in] ik     k point identifier
- * \param[in] N      Number of eigenvectors
- * \param[in] n_min  lowest output band
- * \param[in] n_max  highest output band
- */
-void
-write_ank(arma::cx_mat &ank,
-          int           ik,
-          int           N,
-          int           n_min,
-          int           n_max)
-{
-    int	iG;		/* index over G vectors				*/
-    int	in;		/* index over bands				*/
-    std::ostringstream filename;	/* eigenfunction output filename		*/
-    FILE 	*Fank;		/* file pointer to eigenvectors file		*/
-
-    filename << "ank" << ik << ".r";
-    Fank=fopen(filename.str().c_str(),"w");
-
-    for(iG=0;iG<N;iG++)
-    {
-        for(in=n_min;in<=n_max && in < N;in++) {
-            fprintf(Fank,"%20.16le %20.16le ",ank(iG,in).real(), ank(iG,in).imag());
-	}
-
-        fprintf(Fank,"\n");
-    }
+#include "constants.h"
+#include "reciprocal-lattice.h"
 
-    fclose(Fank);
-}
+using namespace QWWAD;
+using namespace constants;
 
 /**
  * \brief Get potential component of H_GG
@@ -54,7 +26,7 @@ auto V(double                   A0,
     for(auto const &atom : atoms)
     {
         const double q_dot_t = dot(q, atom.r);
-        const double vf = Vf(A0,m_per_au,q_dot_q, atom.type);
+        const double vf = Vf(A0,m_per_au,q_dot_q, atom.type.c_str());
         v += exp(std::complex<double>(0.0,-q_dot_t)) * vf; // [QWWAD3, 15.76]
     }
 
@@ -62,3 +34,48 @@ auto V(double                   A0,
 
     return v;
 }
+
+/**
+ * \brief Add options for generating the reciprocal lattice vectors
+ *
+ * \param[in,out] opt Set of options
+ */
+void add_rlv_options(Options &opt)
+{
+    opt.add_option<double>("Ecut",          0, "Kinetic-energy cutoff for generating reciprocal lattice vectors "
+                                               "[eV].  If zero, the vectors are read from G.r");
+    opt.add_option<bool>  ("fcc",              "Generate the reciprocal lattice of a primitive fcc cell, rather "
+                                               "than a supercell of cubic cells");
+    opt.add_option<size_t>("nx",            1, "Number of cubic cells along x in supercell");
+    opt.add_option<size_t>("ny",            1, "Number of cubic cells along y in supercell");
+    opt.add_option<size_t>("nz",            1, "Number of cubic cells along z in supercell");
+}
+
+/**
+ * \brief Get the reciprocal lattice vectors
+ *
+ * \param[in] opt Set of options, including those from add_rlv_options()
+ * \param[in] A0  Lattice constant [m]
+ *
+ * \returns The vectors [1/m], sorted by magnitude if they are generated
+ */
+auto get_rlv(const Options &opt,
+             const double   A0) -> std::vector<arma::vec>
+{
+    const auto E_cut = opt.get_option<double>("Ecut") * e;
+
+    if(E_cut <= 0) {
+        return read_rlv(A0);
+    }
+
+    const auto G_max = ReciprocalLattice::get_G_max(A0, E_cut);
+
+    if(opt.get_option<bool>("fcc")) {
+        return ReciprocalLattice::fcc(G_max).get_G(A0);
+    }
+
+    return ReciprocalLattice::cubic_supercell(G_max,
+                                              opt.get_option<size_t>("nx"),
+                                              opt.get_option<size_t>("ny"),
+                                              opt.get_option<size_t>("nz")).get_G(A0);
+}
@@ -10,14 +10,13 @@
 
 #include <armadillo>
 
+#include "options.h"
 #include "ppff.h"
 
-void
-write_ank(arma::cx_mat &ank,
-          int           ik,
-          int           N,
-          int           n_min,
-          int           n_max);
+void add_rlv_options(QWWAD::Options &opt);
+
+auto get_rlv(const QWWAD::Options &opt,
+             double                A0) -> std::vector<arma::vec>;
 
 auto V(double                   A0,
                        double                   m_per_au,
@@ -0,0 +1,275 @@
+/**
+ * \file   pseudopotential-table.cpp
+ * \brief  Precomputed form factors and structure factors for pseudopotential calculations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "pseudopotential-table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "constants.h"
+#include "ppsop.h"
+
+namespace QWWAD {
+using namespace constants;
+
+namespace {
+/// Number of grid points per unit of 2 pi/A0 used to identify vectors
+const double key_resolution = 1 << 20;
+
+/// Relative tolerance for treating two values of |q|^2 as the same shell
+const double shell_tolerance = 1e-12;
+} // namespace
+
+auto PseudopotentialTable::KeyHash::operator()(const Key &key) const -> size_t
+{
+    size_t hash = 0;
+
+    for(const auto k : key) {
+        hash ^= std::hash<int64_t>()(k) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+
+    return hash;
+}
+
+/**
+ * \brief Build the tables for a crystal
+ *
+ * \param[in] A0       Lattice constant [m]
+ * \param[in] m_per_au Conversion factor from SI to a.u.
+ * \param[in] atoms    Atomic definitions
+ * \param[in] G        Reciprocal lattice vectors [1/m]
+ */
+PseudopotentialTable::PseudopotentialTable(const double                   A0,
+                                           const double                   m_per_au,
+                                           const std::vector<atom>       &atoms,
+                                           const std::vector<arma::vec>  &G) :
+    PseudopotentialTable(A0, m_per_au, Supercell(atoms), G)
+{}
+
+/**
+ * \brief Build the tables for a supercell
+ *
+ * \param[in] A0       Lattice constant [m]
+ * \param[in] m_per_au Conversion factor from SI to a.u.
+ * \param[in] cell     Atomic species and positions
+ * \param[in] G        Reciprocal lattice vectors [1/m]
+ */
+PseudopotentialTable::PseudopotentialTable(const double                   A0,
+                                           const double                   m_per_au,
+                                           const Supercell               &cell,
+                                           const std::vector<arma::vec>  &G)
+{
+    if(cell.get_n_atoms() == 0) {
+        throw std::domain_error("No atoms defined for pseudopotential table");
+    }
+
+    const double unit = 2.0*pi/A0; // Size of reciprocal lattice unit [1/m]
+    const size_t N    = G.size();
+
+    _n_atoms = cell.get_n_atoms();
+
+    // Integer form of each reciprocal lattice vector
+    _G_index.resize(N);
+
+    for(unsigned int iG = 0; iG < N; ++iG) {
+        for(unsigned int c = 0; c < 3; ++c) {
+            _G_index[iG][c] = std::llround(G[iG](c)/unit*key_resolution);
+        }
+    }
+
+    // The atoms are already grouped by species, so that each form factor is
+    // only looked up by name once per shell
+    _species = cell.get_species_names();
+    _atom_species.assign(cell.get_species().begin(), cell.get_species().end());
+
+    const size_t n_species = _species.size();
+
+    // Find every distinct q = G - G'
+    std::vector<Key> q_keys;
+
+    for(unsigned int iG = 0; iG < N; ++iG)
+    {
+        for(unsigned int jG = 0; jG < N; ++jG)
+        {
+            const Key q = {_G_index[iG][0] - _G_index[jG][0],
+                           _G_index[iG][1] - _G_index[jG][1],
+                           _G_index[iG][2] - _G_index[jG][2]};
+
+            if(_q_index.emplace(q, q_keys.size()).second) {
+                q_keys.push_back(q);
+            }
+        }
+    }
+
+    const size_t n_q = q_keys.size();
+
+    // Convert back to SI units
+    _q.set_size(3, n_q);
+    std::vector<std::pair<double, unsigned int>> q_sqr(n_q); // |q|^2 [1/m^2] and q index
+
+    for(unsigned int iq = 0; iq < n_q; ++iq)
+    {
+        for(unsigned int c = 0; c < 3; ++c) {
+            _q(c, iq) = q_keys[iq][c]*unit/key_resolution;
+        }
+
+        q_sqr[iq] = std::make_pair(dot(_q.col(iq), _q.col(iq)), iq);
+    }
+
+    // Sort by magnitude and group into shells
+    std::sort(q_sqr.begin(), q_sqr.end());
+    _shell.resize(n_q);
+    std::vector<double> shell_q_sqr;
+
+    for(const auto &[q2, iq] : q_sqr)
+    {
+        if(shell_q_sqr.empty() || q2 - shell_q_sqr.back() > shell_tolerance*std::max(q2, unit*unit)) {
+            shell_q_sqr.push_back(q2);
+        }
+
+        _shell[iq] = shell_q_sqr.size() - 1;
+    }
+
+    // Form factor for each species in each shell
+    _form_factor.set_size(shell_q_sqr.size(), n_species);
+
+    for(unsigned int is = 0; is < n_species; ++is) {
+        for(unsigned int ishell = 0; ishell < shell_q_sqr.size(); ++ishell) {
+            _form_factor(ishell, is) = Vf(A0, m_per_au, shell_q_sqr[ishell], _species[is].c_str());
+        }
+    }
+
+    // Structure factor for each species at each q [QWWAD3, 15.76].  The
+    // coordinates are read from separate arrays, in order
+    _structure_factor.zeros(n_q, n_species);
+
+    const auto &species = cell.get_species();
+    const auto &x       = cell.get_x();
+    const auto &y       = cell.get_y();
+    const auto &z       = cell.get_z();
+
+#pragma omp parallel for schedule(static)
+    for(unsigned int iq = 0; iq < n_q; ++iq)
+    {
+        const double q_x = _q(0, iq);
+        const double q_y = _q(1, iq);
+        const double q_z = _q(2, iq);
+
+        for(size_t ia = 0; ia < _n_atoms; ++ia)
+        {
+            const double q_dot_t = q_x*x[ia] + q_y*y[ia] + q_z*z[ia];
+            _structure_factor(iq, species[ia]) += std::polar(1.0, -q_dot_t);
+        }
+    }
+
+    // Combine into the total potential
+    _V.zeros(n_q);
+
+    for(unsigned int iq = 0; iq < n_q; ++iq) {
+        for(unsigned int is = 0; is < n_species; ++is) {
+            _V[iq] += _form_factor(_shell[iq], is) * _structure_factor(iq, is);
+        }
+    }
+
+    _V *= 2.0/_n_atoms;
+}
+
+/**
+ * \brief Find the index of the difference between a pair of reciprocal lattice vectors
+ *
+ * \param[in] iG Index of G
+ * \param[in] jG Index of G'
+ *
+ * \returns The index of q = G - G' in the tables
+ */
+auto PseudopotentialTable::get_q_index(const unsigned int iG,
+                                       const unsigned int jG) const -> unsigned int
+{
+    if(iG >= _G_index.size() || jG >= _G_index.size())
+    {
+        std::ostringstream oss;
+        oss << "Reciprocal lattice vector index (" << iG << ", " << jG << ") out of range. "
+            << "Only " << _G_index.size() << " vectors are defined";
+        throw std::out_of_range(oss.str());
+    }
+
+    const Key q = {_G_index[iG][0] - _G_index[jG][0],
+                   _G_index[iG][1] - _G_index[jG][1],
+                   _G_index[iG][2] - _G_index[jG][2]};
+
+    return _q_index.at(q);
+}
+
+/**
+ * \brief Get the potential matrix for all pairs of plane waves
+ *
+ * \returns The matrix V_GG' [J]
+ */
+auto PseudopotentialTable::get_matrix() const -> arma::cx_mat
+{
+    return expand(_V);
+}
+
+/**
+ * \brief Get the spin-orbit potential for all pairs of plane waves
+ *
+ * \returns The matrix Lambda_GG' [J]
+ *
+ * \details This is the k-independent part of the spin-orbit matrix element
+ *          [QWWAD3, 15.81]:
+ *
+ *            Lambda(q) = (1/n_atoms) sum_s lambda_s S_s(q),
+ *
+ *          which only needs the spin-orbit parameter of each species once.
+ *          The full matrix element is -i Lambda_GG' (G+k)x(G'+k).sigma
+ */
+auto PseudopotentialTable::get_spin_orbit_matrix() const -> arma::cx_mat
+{
+    arma::vec lambda_s(get_n_species()); // Spin-orbit parameter for each species [J]
+
+    for(unsigned int is = 0; is < get_n_species(); ++is) {
+        lambda_s(is) = lambda(_species[is].c_str());
+    }
+
+    const arma::cx_vec Lambda = _structure_factor * lambda_s / _n_atoms;
+
+    return expand(Lambda);
+}
+
+/**
+ * \brief Expand a function of q into a matrix over all pairs of plane waves
+ *
+ * \param[in] f Value for each unique q vector
+ *
+ * \returns The matrix f(G - G')
+ *
+ * \details f(-q) must equal f(q)*, so that the result is Hermitian.
+ */
+auto PseudopotentialTable::expand(const arma::cx_vec &f) const -> arma::cx_mat
+{
+    const size_t N = get_n_G();
+    arma::cx_mat f_GG(N, N);
+
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned int iG = 0; iG < N; ++iG)
+    {
+        // Fill in the upper triangle, and the lower triangle by taking the
+        // Hermitian transpose of the elements
+        for(unsigned int jG = iG; jG < N; ++jG)
+        {
+            f_GG(iG, jG) = f[get_q_index(iG, jG)];
+            f_GG(jG, iG) = conj(f_GG(iG, jG));
+        }
+    }
+
+    return f_GG;
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
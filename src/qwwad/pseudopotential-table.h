@@ -0,0 +1,152 @@
+/**
+ * \file   pseudopotential-table.h
+ * \brief  Precomputed form factors and structure factors for pseudopotential calculations
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_PSEUDOPOTENTIAL_TABLE_H
+#define QWWAD_PSEUDOPOTENTIAL_TABLE_H
+
+#include <array>
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <armadillo>
+
+#include "ppff.h"
+#include "supercell.h"
+
+namespace QWWAD {
+/**
+ * \brief Crystal potential for every pair of reciprocal lattice vectors
+ *
+ * \details The potential matrix element between plane waves G and G' depends
+ *          only on q = G - G' [QWWAD3, 15.76]:
+ *
+ *            V(q) = (2/n_atoms) sum_s Vf_s(|q|^2) S_s(q),
+ *
+ *          where the structure factor for species s is
+ *
+ *            S_s(q) = sum_{atoms of s} exp(-i q.tau).
+ *
+ *          Only a small fraction of the (G, G') pairs give distinct q vectors,
+ *          and fewer still give distinct |q|^2 "shells".  This table finds the
+ *          unique vectors and shells once.  The form factor of each species is
+ *          evaluated once per shell, and the structure factor once per q vector,
+ *          so that each matrix element is a table lookup.
+ *
+ *          Vectors are identified by rounding their components to a fine grid
+ *          (about 1e-6 of 2 pi/A0), so vectors that differ by less than this
+ *          are treated as equal.
+ */
+class PseudopotentialTable {
+public:
+    PseudopotentialTable(double                         A0,
+                         double                         m_per_au,
+                         const std::vector<atom>       &atoms,
+                         const std::vector<arma::vec>  &G);
+
+    PseudopotentialTable(double                         A0,
+                         double                         m_per_au,
+                         const Supercell               &cell,
+                         const std::vector<arma::vec>  &G);
+
+    /// Get the number of plane waves (reciprocal lattice vectors)
+    [[nodiscard]] inline auto get_n_G()       const -> size_t {return _G_index.size();}
+
+    /// Get the number of atomic species
+    [[nodiscard]] inline auto get_n_species() const -> size_t {return _species.size();}
+
+    /// Get the number of unique difference vectors, q = G - G'
+    [[nodiscard]] inline auto get_n_q()       const -> size_t {return _shell.size();}
+
+    /// Get the number of unique |q|^2 values
+    [[nodiscard]] inline auto get_n_shells()  const -> size_t {return _form_factor.n_rows;}
+
+    /// Get the name of a species
+    [[nodiscard]] inline auto get_species(const size_t is) const -> const std::string & {return _species.at(is);}
+
+    /// Get the species index of every atom
+    [[nodiscard]] inline auto get_atom_species() const -> const std::vector<unsigned int> & {return _atom_species;}
+
+    [[nodiscard]] auto get_q_index(unsigned int iG,
+                                   unsigned int jG) const -> unsigned int;
+
+    /**
+     * \brief Get a difference vector, q = G - G'
+     *
+     * \param[in] iq Index of q vector (see get_q_index)
+     *
+     * \returns The vector q [1/m]
+     */
+    [[nodiscard]] inline auto get_q(const size_t iq) const -> arma::vec {return _q.col(iq);}
+
+    /**
+     * \brief Get the structure factor for a species
+     *
+     * \param[in] is Species index
+     * \param[in] iq Index of q vector (see get_q_index)
+     */
+    [[nodiscard]] inline auto get_structure_factor(const size_t is,
+                                                   const size_t iq) const -> std::complex<double>
+    {
+        return _structure_factor(iq, is);
+    }
+
+    /**
+     * \brief Get the form factor for a species
+     *
+     * \param[in] is Species index
+     * \param[in] iq Index of q vector (see get_q_index)
+     */
+    [[nodiscard]] inline auto get_form_factor(const size_t is,
+                                              const size_t iq) const -> double
+    {
+        return _form_factor(_shell[iq], is);
+    }
+
+    /**
+     * \brief Get the potential matrix element between a pair of plane waves
+     *
+     * \param[in] iG Index of G
+     * \param[in] jG Index of G'
+     */
+    [[nodiscard]] inline auto get_V(const unsigned int iG,
+                                    const unsigned int jG) const -> std::complex<double>
+    {
+        return _V[get_q_index(iG, jG)];
+    }
+
+    [[nodiscard]] auto get_matrix() const -> arma::cx_mat;
+    [[nodiscard]] auto get_spin_orbit_matrix() const -> arma::cx_mat;
+
+private:
+    /// Integer representation of a vector
+    using Key = std::array<int64_t, 3>;
+
+    /// Hash for vector keys
+    struct KeyHash {
+        auto operator()(const Key &key) const -> size_t;
+    };
+
+    std::vector<Key>                                    _G_index;        ///< Integer form of each G
+    std::unordered_map<Key, unsigned int, KeyHash>      _q_index;        ///< Index of each unique q
+    std::vector<unsigned int>                           _shell;          ///< Shell index of each q
+    arma::mat                                           _q;              ///< Each unique q [1/m]
+    size_t                                              _n_atoms;        ///< Number of atoms in the cell
+
+    std::vector<std::string>  _species;          ///< Name of each species
+    std::vector<unsigned int> _atom_species;     ///< Species index of each atom
+
+    arma::mat    _form_factor;      ///< Form factor [J] (shell x species)
+    arma::cx_mat _structure_factor; ///< Structure factor (q x species)
+    arma::cx_vec _V;                ///< Potential for each q [J]
+
+    [[nodiscard]] auto expand(const arma::cx_vec &f) const -> arma::cx_mat;
+};
+} // namespace QWWAD
+#endif // QWWAD_PSEUDOPOTENTIAL_TABLE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
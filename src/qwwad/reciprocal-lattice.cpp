@@ -0,0 +1,195 @@
+/**
+ * \file   reciprocal-lattice.cpp
+ * \brief  Reciprocal lattice vectors within a cutoff, sorted by magnitude
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "reciprocal-lattice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "constants.h"
+#include "file-io.h"
+
+namespace QWWAD {
+using namespace constants;
+
+/**
+ * \brief Generate all vectors of a lattice within a cutoff
+ *
+ * \param[in] B     Reciprocal basis vectors [2 pi/A0], one per column
+ * \param[in] G_max Largest magnitude of vector [2 pi/A0]
+ *
+ * \details Each index is bounded by |m_i| <= |G_max| |row i of B^-1|, so
+ *          only the bounding box of the sphere is searched.
+ */
+ReciprocalLattice::ReciprocalLattice(const arma::mat &B,
+                                     const double     G_max) :
+    _B(B)
+{
+    if(B.n_rows != 3 || B.n_cols != 3 || std::abs(arma::det(B)) < 1e-12)
+    {
+        throw std::domain_error("Reciprocal lattice needs three independent basis vectors");
+    }
+
+    if(G_max < 0)
+    {
+        std::ostringstream oss;
+        oss << "Cutoff for reciprocal lattice vectors must be positive: " << G_max << " received.";
+        throw std::domain_error(oss.str());
+    }
+
+    const arma::mat B_inv = arma::inv(B);
+    std::array<int, 3> m_max;
+
+    for(unsigned int i = 0; i < 3; ++i) {
+        m_max[i] = static_cast<int>(std::floor(G_max*arma::norm(B_inv.row(i)) + 1e-9));
+    }
+
+    // Allow for rounding error in vectors that lie exactly on the cutoff
+    const double G_sqr_max = G_max*G_max*(1.0 + 1e-9);
+
+    // Find every vector within the sphere, with its squared magnitude
+    std::vector<std::pair<double, Miller>> found;
+
+    for(int m0 = -m_max[0]; m0 <= m_max[0]; ++m0)
+    {
+        for(int m1 = -m_max[1]; m1 <= m_max[1]; ++m1)
+        {
+            for(int m2 = -m_max[2]; m2 <= m_max[2]; ++m2)
+            {
+                double G_sqr = 0.0;
+
+                for(unsigned int c = 0; c < 3; ++c)
+                {
+                    const double G_c = B(c,0)*m0 + B(c,1)*m1 + B(c,2)*m2;
+                    G_sqr += G_c*G_c;
+                }
+
+                if(G_sqr <= G_sqr_max) {
+                    found.emplace_back(G_sqr, Miller{m0, m1, m2});
+                }
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+
+    _miller.reserve(found.size());
+
+    for(const auto &item : found) {
+        _miller.push_back(item.second);
+    }
+}
+
+/**
+ * \brief Generate the reciprocal lattice of a primitive face-centred cubic cell
+ *
+ * \param[in] G_max Largest magnitude of vector [2 pi/A0]
+ *
+ * \details The reciprocal lattice is body-centred cubic.
+ */
+auto ReciprocalLattice::fcc(const double G_max) -> ReciprocalLattice
+{
+    const arma::mat B = {{ 1, -1,  1},
+                         { 1,  1, -1},
+                         {-1,  1,  1}};
+
+    return {B, G_max};
+}
+
+/**
+ * \brief Generate the reciprocal lattice of a supercell of cubic unit cells
+ *
+ * \param[in] G_max Largest magnitude of vector [2 pi/A0]
+ * \param[in] n_x   Number of unit cells along x
+ * \param[in] n_y   Number of unit cells along y
+ * \param[in] n_z   Number of unit cells along z
+ */
+auto ReciprocalLattice::cubic_supercell(const double       G_max,
+                                        const unsigned int n_x,
+                                        const unsigned int n_y,
+                                        const unsigned int n_z) -> ReciprocalLattice
+{
+    if(n_x == 0 || n_y == 0 || n_z == 0) {
+        throw std::domain_error("Supercell must contain at least one unit cell along each axis");
+    }
+
+    const arma::mat B = arma::diagmat(arma::vec{1.0/n_x, 1.0/n_y, 1.0/n_z});
+
+    return {B, G_max};
+}
+
+/**
+ * \brief Find the largest reciprocal lattice vector for a kinetic-energy cutoff
+ *
+ * \param[in] A0    Lattice constant [m]
+ * \param[in] E_cut Largest kinetic energy of a free-electron plane wave [J]
+ *
+ * \returns The largest magnitude of vector [2 pi/A0]
+ */
+auto ReciprocalLattice::get_G_max(const double A0,
+                                  const double E_cut) -> double
+{
+    return std::sqrt(2.0*me*E_cut)/hBar * A0/(2.0*pi);
+}
+
+/**
+ * \brief Get a vector in Cartesian coordinates
+ *
+ * \param[in] iG Index of vector
+ *
+ * \returns The vector [2 pi/A0]
+ */
+auto ReciprocalLattice::get_G_unit(const size_t iG) const -> arma::vec
+{
+    const auto &m = _miller.at(iG);
+    return _B * arma::vec{static_cast<double>(m[0]), static_cast<double>(m[1]), static_cast<double>(m[2])};
+}
+
+/**
+ * \brief Get all vectors in SI units
+ *
+ * \param[in] A0 Lattice constant [m]
+ *
+ * \returns The vectors [1/m], in the same form as read_rlv()
+ */
+auto ReciprocalLattice::get_G(const double A0) const -> std::vector<arma::vec>
+{
+    std::vector<arma::vec> G(get_n_G());
+
+    for(unsigned int iG = 0; iG < get_n_G(); ++iG) {
+        G[iG] = get_G_unit(iG) * 2.0*pi/A0;
+    }
+
+    return G;
+}
+
+/**
+ * \brief Write all vectors to file, in units of 2 pi/A0
+ *
+ * \param[in] filename Name of file (e.g., G.r)
+ */
+void ReciprocalLattice::write(const std::string &filename) const
+{
+    const size_t N = get_n_G();
+    arma::vec Gx(N);
+    arma::vec Gy(N);
+    arma::vec Gz(N);
+
+    for(unsigned int iG = 0; iG < N; ++iG)
+    {
+        const auto G = get_G_unit(iG);
+        Gx(iG) = G(0);
+        Gy(iG) = G(1);
+        Gz(iG) = G(2);
+    }
+
+    write_table(filename, Gx, Gy, Gz);
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,63 @@
+/**
+ * \file   reciprocal-lattice.h
+ * \brief  Reciprocal lattice vectors within a cutoff, sorted by magnitude
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_RECIPROCAL_LATTICE_H
+#define QWWAD_RECIPROCAL_LATTICE_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <armadillo>
+
+namespace QWWAD {
+/**
+ * \brief Set of reciprocal lattice vectors for a plane-wave basis
+ *
+ * \details Each vector is stored by its integer (Miller) indices, m, in the
+ *          basis of the reciprocal lattice, so that G = (2 pi/A0) B m, where
+ *          the columns of B are the reciprocal basis vectors in units of
+ *          2 pi/A0.  All vectors with |G| <= G_max are generated and sorted
+ *          by |G|^2, so that truncating the list always leaves complete
+ *          shells of equal |G|.
+ */
+class ReciprocalLattice {
+public:
+    /// Integer indices of a vector in the reciprocal basis
+    using Miller = std::array<int, 3>;
+
+    ReciprocalLattice(const arma::mat &B,
+                      double           G_max);
+
+    [[nodiscard]] static auto fcc(double G_max) -> ReciprocalLattice;
+
+    [[nodiscard]] static auto cubic_supercell(double       G_max,
+                                              unsigned int n_x,
+                                              unsigned int n_y,
+                                              unsigned int n_z) -> ReciprocalLattice;
+
+    [[nodiscard]] static auto get_G_max(double A0,
+                                        double E_cut) -> double;
+
+    /// Get the number of vectors
+    [[nodiscard]] inline auto get_n_G() const -> size_t {return _miller.size();}
+
+    /// Get the Miller indices of a vector
+    [[nodiscard]] inline auto get_miller(const size_t iG) const -> const Miller & {return _miller.at(iG);}
+
+    [[nodiscard]] auto get_G_unit(size_t iG) const -> arma::vec;
+
+    [[nodiscard]] auto get_G(double A0) const -> std::vector<arma::vec>;
+
+    void write(const std::string &filename) const;
+
+private:
+    arma::mat           _B;      ///< Reciprocal basis vectors [2 pi/A0], one per column
+    std::vector<Miller> _miller; ///< Indices of each vector
+};
+} // namespace QWWAD
+#endif // QWWAD_RECIPROCAL_LATTICE_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
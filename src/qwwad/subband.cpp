@@ -5,6 +5,10 @@
  */
 
 #include "subband.h"
+
+#include <algorithm>
+#include <stdexcept>
+
 #include "file-io.h"
 #include "maths-helpers.h"
 #include "constants.h"
@@ -14,6 +18,47 @@ namespace QWWAD
 {
 using namespace constants;
 
+namespace
+{
+/// Number of samples in each occupation table
+const arma::uword occupation_table_size = 4096;
+
+/// Range of occupation tables above the Fermi energy, in multiples of kT
+const double occupation_table_range = 40.0;
+
+/**
+ * \brief Look up a value from a uniformly-sampled table using linear interpolation
+ *
+ * \param[in]  table Tabulated values, starting at x = 0
+ * \param[in]  dx    Spacing between samples
+ * \param[in]  x     Point at which to find value
+ * \param[out] y     Interpolated value
+ *
+ * \return True if x lies within the table.  False if the table is empty or has
+ *         zero spacing, so that the caller evaluates the exact value instead.
+ */
+inline auto interp_table(const arma::vec &table,
+                         const double     dx,
+                         const double     x,
+                         double          &y) -> bool
+{
+    if(x < 0.0 || table.n_elem < 2 || !(dx > 0.0)) {
+        return false;
+    }
+
+    const auto   u = x/dx;
+    const auto   i = static_cast<arma::uword>(u);
+
+    if(i+1 >= table.n_elem) {
+        return false;
+    }
+
+    const auto t = u - i;
+    y = table(i) + t*(table(i+1) - table(i));
+    return true;
+}
+} // namespace
+
 /**
  * \brief Create a parabolic subband
  *
@@ -57,13 +102,68 @@ Subband::Subband(const Eigenstate &ground_state,
 void Subband::set_distribution_from_Ef_Te(double Ef,
                                           double Te)
 {
+    // The occupation tables are spaced in multiples of kT, so a zero
+    // temperature would give zero spacing
     if(Te <= 0.0) {
-        throw "Carrier temperature must be positive";
+        throw std::domain_error("Carrier temperature must be positive");
     }
 
     _dist_known = true;
     Ef_         = Ef;
     Te_         = Te;
+
+    tabulate_occupation();
+}
+
+/**
+ * \brief Choose whether occupation probabilities are looked up from a table
+ *
+ * \param[in] enabled True to tabulate the occupation; false to evaluate the
+ *                    Fermi-Dirac distribution directly for every state
+ *
+ * \details The table is enabled by default.  Direct evaluation is slower, but
+ *          is useful as a reference for checking the interpolation error.
+ */
+void Subband::set_occupation_table(const bool enabled)
+{
+    _use_occupation_table = enabled;
+
+    if(_dist_known) {
+        tabulate_occupation();
+    }
+}
+
+/**
+ * \brief Tabulate the occupation probability for the current distribution
+ *
+ * \details The occupation is sampled at uniform intervals of wave-vector and
+ *          kinetic energy, up to 40kT above the Fermi energy (or subband minimum).
+ *          Lookups then use linear interpolation, rather than evaluating the
+ *          dispersion relation and an exponential for each sample.
+ */
+void Subband::tabulate_occupation()
+{
+    if(!_use_occupation_table) {
+        // Empty tables force every lookup to fall back to direct evaluation
+        _f_at_Ek.reset();
+        _f_at_k.reset();
+        return;
+    }
+
+    const auto n      = occupation_table_size;
+    const auto E_min  = get_E_min();
+    const auto Ek_max = std::max(Ef_ - E_min, 0.0) + occupation_table_range*kB*Te_;
+
+    _dE_table = Ek_max/(n-1);
+    const arma::vec E = E_min + arma::linspace(0, Ek_max, n);
+    _f_at_Ek = f_FD(Ef_, E, Te_);
+
+    _dk_table = get_k_at_Ek(Ek_max)/(n-1);
+    _f_at_k.set_size(n);
+
+    for(arma::uword ik = 0; ik < n; ++ik) {
+        _f_at_k(ik) = f_FD(Ef_, get_E_total_at_k(ik*_dk_table), Te_);
+    }
 }
 
 /**
@@ -383,6 +483,12 @@ auto Subband::get_occupation_at_E_total(const double E) const -> double
         throw std::runtime_error("Distribution has not been set");
     }
 
+    double f = 0.0;
+
+    if(interp_table(_f_at_Ek, _dE_table, E - get_E_min(), f)) {
+        return f;
+    }
+
     return f_FD(Ef_, E, Te_);
 }
 
@@ -397,8 +503,32 @@ auto Subband::get_occupation_at_k(const double k) const -> double
         throw std::runtime_error("Distribution has not been set");
     }
 
+    double f = 0.0;
+
+    if(interp_table(_f_at_k, _dk_table, k, f)) {
+        return f;
+    }
+
     const auto E = get_E_total_at_k(k);
-    return get_occupation_at_E_total(E);
+    return f_FD(Ef_, E, Te_);
+}
+
+/**
+ * \brief Find the occupation probability of states at a set of wave vectors
+ *
+ * \param[in] k  The in-plane wave-vector of each state [1/m]
+ *
+ * \details This is a convenience wrapper that calls the scalar version for each sample
+ */
+auto Subband::get_occupation_at_k(const arma::vec &k) const -> arma::vec
+{
+    arma::vec f(k.n_elem);
+
+    for(arma::uword ik = 0; ik < k.n_elem; ++ik) {
+        f(ik) = get_occupation_at_k(k(ik));
+    }
+
+    return f;
 }
 
 /**
@@ -26,6 +26,15 @@ private:
     double Ef_;                 ///< Quasi-Fermi energy [J]
     double Te_ = 0.0;           ///< Temperature of carrier distribution [K]
 
+    // Tabulated occupation, rebuilt whenever the distribution is set
+    bool      _use_occupation_table = true; ///< False if occupation is always computed directly
+    arma::vec _f_at_k;          ///< Occupation at uniformly-spaced wave-vectors
+    double    _dk_table = 0.0;  ///< Wave-vector spacing in occupation table [1/m]
+    arma::vec _f_at_Ek;         ///< Occupation at uniformly-spaced kinetic energies
+    double    _dE_table = 0.0;  ///< Energy spacing in occupation table [J]
+
+    void tabulate_occupation();
+
 public:
     Subband(const Eigenstate &ground_state,
             double            m);
@@ -38,6 +47,10 @@ public:
     void set_distribution_from_Ef_Te(double Ef,
                                      double Te);
 
+    void set_occupation_table(bool enabled);
+
+    [[nodiscard]] inline auto get_occupation_table() const {return _use_occupation_table;}
+
     [[nodiscard]] inline auto get_ground() const {return _ground_state;}
 
     [[nodiscard]] inline auto z_array() const
@@ -114,6 +127,8 @@ public:
        
     [[nodiscard]] auto get_occupation_at_k(double k) const -> double;
 
+    [[nodiscard]] auto get_occupation_at_k(const arma::vec &k) const -> arma::vec;
+
     [[nodiscard]] auto get_population_at_k(double k) const -> double;
 };
 } // namespace
@@ -0,0 +1,547 @@
+/**
+ * \file   supercell.cpp
+ * \brief  Atomic positions and species in a crystal supercell
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "supercell.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace QWWAD {
+namespace {
+/// Signature at the start of every binary supercell file
+const char supercell_magic[8] = {'Q', 'W', 'W', 'A', 'D', 'S', 'C', '\0'};
+
+/// Version of the binary format.  Increment this whenever the layout changes
+const uint32_t supercell_version = 1;
+
+/// Number of bytes of padding needed after the species indices
+auto get_padding(const uint64_t n_atoms) -> size_t
+{
+    const size_t bytes = n_atoms*sizeof(Supercell::SpeciesID);
+    return (sizeof(double) - bytes % sizeof(double)) % sizeof(double);
+}
+} // namespace
+
+/**
+ * \brief Create a supercell from a list of atoms
+ *
+ * \param[in] atoms Atomic definitions
+ */
+Supercell::Supercell(const std::vector<atom> &atoms)
+{
+    reserve(atoms.size());
+
+    for(const auto &a : atoms) {
+        add_atom(add_species(a.type), a.r(0), a.r(1), a.r(2));
+    }
+}
+
+/**
+ * \brief Generate a cuboid of zinc blende crystal
+ *
+ * \param[in] A0     Lattice constant [m]
+ * \param[in] n_x    Number of cubic unit cells along x
+ * \param[in] n_y    Number of cubic unit cells along y
+ * \param[in] n_z    Number of cubic unit cells along z
+ * \param[in] cation Cation species
+ * \param[in] anion  Anion species
+ *
+ * \details Each cubic cell holds four cation-anion pairs, at the fcc lattice
+ *          points offset by -(1,1,1)A0/8 and +(1,1,1)A0/8 respectively.
+ */
+auto Supercell::zinc_blende(const double       A0,
+                            const unsigned int n_x,
+                            const unsigned int n_y,
+                            const unsigned int n_z,
+                            const std::string &cation,
+                            const std::string &anion) -> Supercell
+{
+    // fcc lattice points in a cubic cell [A0]
+    const std::array<std::array<double, 3>, 4> a = {{{0.0, 0.0, 0.0},
+                                                     {0.5, 0.5, 0.0},
+                                                     {0.0, 0.5, 0.5},
+                                                     {0.5, 0.0, 0.5}}};
+    const double T = 1.0/8; // Offset of each atom in basis [A0]
+
+    Supercell cell;
+    const auto id_cation = cell.add_species(cation);
+    const auto id_anion  = cell.add_species(anion);
+    cell.reserve(8*static_cast<size_t>(n_x)*n_y*n_z);
+
+    for(unsigned int ix = 0; ix < n_x; ++ix) {
+        for(unsigned int iy = 0; iy < n_y; ++iy) {
+            for(unsigned int iz = 0; iz < n_z; ++iz) {
+                for(const auto &point : a)
+                {
+                    const double x = ix + point[0];
+                    const double y = iy + point[1];
+                    const double z = iz + point[2];
+                    cell.add_atom(id_cation, (x-T)*A0, (y-T)*A0, (z-T)*A0);
+                    cell.add_atom(id_anion,  (x+T)*A0, (y+T)*A0, (z+T)*A0);
+                }
+            }
+        }
+    }
+
+    return cell;
+}
+
+/**
+ * \brief Generate a single spiral of zinc blende crystal along the z axis
+ *
+ * \param[in] A0     Lattice constant [m]
+ * \param[in] n_z    Number of lattice constants along z
+ * \param[in] cation Cation species
+ * \param[in] anion  Anion species
+ */
+auto Supercell::single_spiral(const double       A0,
+                              const unsigned int n_z,
+                              const std::string &cation,
+                              const std::string &anion) -> Supercell
+{
+    // Position of each atom in the basis [A0]
+    const std::array<std::array<double, 3>, 4> T = {{{-1.0/8, -1.0/8, -1.0/8},
+                                                     {+1.0/8, +1.0/8, +1.0/8},
+                                                     {-1.0/8, +3.0/8, +3.0/8},
+                                                     {-3.0/8, +1.0/8, +5.0/8}}};
+
+    Supercell cell;
+    const std::array<SpeciesID, 4> id = {cell.add_species(cation), cell.add_species(anion),
+                                         cell.add_species(cation), cell.add_species(anion)};
+    cell.reserve(4*static_cast<size_t>(n_z));
+
+    for(unsigned int iz = 0; iz < n_z; ++iz) {
+        for(unsigned int ib = 0; ib < T.size(); ++ib) {
+            cell.add_atom(id[ib], T[ib][0]*A0, T[ib][1]*A0, (iz + T[ib][2])*A0);
+        }
+    }
+
+    return cell;
+}
+
+/**
+ * \brief Read a supercell from file
+ *
+ * \param[in] filename Name of a binary supercell file, or an XYZ file with
+ *                     positions in angstrom
+ *
+ * \details The format is found from the contents of the file
+ */
+auto Supercell::read(const std::string &filename) -> Supercell
+{
+    return is_binary(filename) ? read_binary(filename) : read_xyz(filename);
+}
+
+/**
+ * \brief Check whether a file is a binary supercell file
+ *
+ * \param[in] filename Name of the file
+ *
+ * \returns True if the file starts with the binary signature
+ */
+auto Supercell::is_binary(const std::string &filename) -> bool
+{
+    std::ifstream stream(filename, std::ios::binary);
+    char magic[sizeof(supercell_magic)] = {};
+    stream.read(magic, sizeof(magic));
+
+    return stream.gcount() == sizeof(magic) &&
+           std::memcmp(magic, supercell_magic, sizeof(magic)) == 0;
+}
+
+/**
+ * \brief Read a binary supercell file
+ *
+ * \param[in] filename Name of the file
+ */
+auto Supercell::read_binary(const std::string &filename) -> Supercell
+{
+    std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    const auto size = static_cast<uint64_t>(stream.tellg());
+    stream.seekg(0);
+
+    Header header {};
+    stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    if(size < sizeof(Header) ||
+       std::memcmp(header.magic, supercell_magic, sizeof(supercell_magic)) != 0)
+    {
+        std::ostringstream oss;
+        oss << filename << " is not a binary supercell file";
+        throw std::runtime_error(oss.str());
+    }
+
+    if(header.version != supercell_version)
+    {
+        std::ostringstream oss;
+        oss << filename << " uses supercell format version " << header.version
+            << ". Expected version " << supercell_version;
+        throw std::runtime_error(oss.str());
+    }
+
+    const uint64_t n_atoms = header.n_atoms;
+    const uint64_t expected_size = sizeof(Header) + header.n_species*name_size
+                                 + n_atoms*sizeof(SpeciesID) + get_padding(n_atoms)
+                                 + 3*n_atoms*sizeof(double);
+
+    if(header.n_species > std::numeric_limits<SpeciesID>::max() + 1ULL ||
+       n_atoms > size || expected_size != size)
+    {
+        std::ostringstream oss;
+        oss << filename << " is damaged: size does not match " << n_atoms << " atoms of "
+            << header.n_species << " species";
+        throw std::runtime_error(oss.str());
+    }
+
+    Supercell cell;
+    cell._species_names.resize(header.n_species);
+
+    for(auto &name : cell._species_names)
+    {
+        char buffer[name_size + 1] = {};
+        stream.read(buffer, name_size);
+        name = buffer;
+    }
+
+    cell._species.resize(n_atoms);
+    cell._x.resize(n_atoms);
+    cell._y.resize(n_atoms);
+    cell._z.resize(n_atoms);
+
+    stream.read(reinterpret_cast<char *>(cell._species.data()), n_atoms*sizeof(SpeciesID));
+    stream.ignore(get_padding(n_atoms));
+    stream.read(reinterpret_cast<char *>(cell._x.data()), n_atoms*sizeof(double));
+    stream.read(reinterpret_cast<char *>(cell._y.data()), n_atoms*sizeof(double));
+    stream.read(reinterpret_cast<char *>(cell._z.data()), n_atoms*sizeof(double));
+
+    if(!stream) {
+        throw std::runtime_error("Could not read atoms from " + filename);
+    }
+
+    const auto bad = std::find_if(cell._species.begin(), cell._species.end(),
+                                  [&header](const SpeciesID id) {return id >= header.n_species;});
+
+    if(bad != cell._species.end())
+    {
+        std::ostringstream oss;
+        oss << filename << " is damaged: atom " << std::distance(cell._species.begin(), bad)
+            << " has undefined species " << *bad;
+        throw std::runtime_error(oss.str());
+    }
+
+    return cell;
+}
+
+/**
+ * \brief Read an XYZ file
+ *
+ * \param[in] filename Name of the file
+ *
+ * \details The first entry in the file is the number of atoms, and each atom
+ *          is given as its species followed by its position in angstrom.
+ *          Any atoms after the stated number are ignored, as in read_atoms().
+ */
+auto Supercell::read_xyz(const std::string &filename) -> Supercell
+{
+    std::ifstream stream(filename);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Cannot open input file " << filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    size_t n_atoms = 0;
+
+    if(!(stream >> n_atoms)) {
+        throw std::runtime_error("Could not read number of atoms");
+    }
+
+    Supercell cell;
+    cell.reserve(n_atoms);
+
+    std::string type;
+    double x = 0;
+    double y = 0;
+    double z = 0;
+
+    while(cell.get_n_atoms() < n_atoms && (stream >> type >> x >> y >> z)) {
+        cell.add_atom(cell.add_species(type), x*1e-10, y*1e-10, z*1e-10);
+    }
+
+    if(cell.get_n_atoms() < n_atoms)
+    {
+        std::ostringstream oss;
+        oss << filename << " should contain " << n_atoms << " atoms, but only "
+            << cell.get_n_atoms() << " could be read";
+        throw std::runtime_error(oss.str());
+    }
+
+    return cell;
+}
+
+/**
+ * \brief Find the index of a species, adding it to the table if needed
+ *
+ * \param[in] name Name of species, as used by Vf()
+ *
+ * \returns The species index
+ */
+auto Supercell::add_species(const std::string &name) -> SpeciesID
+{
+    const auto it = std::find(_species_names.begin(), _species_names.end(), name);
+
+    if(it != _species_names.end()) {
+        return std::distance(_species_names.begin(), it);
+    }
+
+    if(name.empty() || name.size() >= name_size)
+    {
+        std::ostringstream oss;
+        oss << "Species name \"" << name << "\" must contain between 1 and "
+            << name_size - 1 << " characters";
+        throw std::length_error(oss.str());
+    }
+
+    if(_species_names.size() > std::numeric_limits<SpeciesID>::max()) {
+        throw std::length_error("Too many species in supercell");
+    }
+
+    _species_names.push_back(name);
+    return _species_names.size() - 1;
+}
+
+/**
+ * \brief Add an atom to the supercell
+ *
+ * \param[in] id Species index (see add_species)
+ * \param[in] x  x coordinate [m]
+ * \param[in] y  y coordinate [m]
+ * \param[in] z  z coordinate [m]
+ */
+void Supercell::add_atom(const SpeciesID id,
+                         const double    x,
+                         const double    y,
+                         const double    z)
+{
+    if(id >= _species_names.size())
+    {
+        std::ostringstream oss;
+        oss << "Species index " << id << " out of range. Only " << _species_names.size()
+            << " species are defined";
+        throw std::out_of_range(oss.str());
+    }
+
+    _species.push_back(id);
+    _x.push_back(x);
+    _y.push_back(y);
+    _z.push_back(z);
+}
+
+/**
+ * \brief Reserve memory for a number of atoms
+ *
+ * \param[in] n_atoms Total number of atoms expected
+ */
+void Supercell::reserve(const size_t n_atoms)
+{
+    _species.reserve(n_atoms);
+    _x.reserve(n_atoms);
+    _y.reserve(n_atoms);
+    _z.reserve(n_atoms);
+}
+
+/**
+ * \brief Replace a random selection of atoms of one species with another
+ *
+ * \param[in] host     Species to be replaced
+ * \param[in] guest    Replacement species
+ * \param[in] fraction Fraction of host atoms to replace (0 to 1)
+ * \param[in] seed     Seed for the random number generator
+ *
+ * \returns The number of atoms replaced
+ *
+ * \details The number of replaced atoms is the fraction of host atoms,
+ *          rounded to the nearest integer, so the composition is exact.  The
+ *          atoms are chosen by a Fisher-Yates shuffle driven directly by the
+ *          64-bit Mersenne Twister, whose output is fixed by the C++
+ *          standard, so a given seed gives the same alloy on any platform.
+ */
+auto Supercell::make_alloy(const std::string &host,
+                           const std::string &guest,
+                           const double       fraction,
+                           const uint64_t     seed) -> size_t
+{
+    if(fraction < 0 || fraction > 1)
+    {
+        std::ostringstream oss;
+        oss << "Alloy fraction must be between 0 and 1: " << fraction << " received.";
+        throw std::domain_error(oss.str());
+    }
+
+    const auto it = std::find(_species_names.begin(), _species_names.end(), host);
+
+    if(it == _species_names.end())
+    {
+        std::ostringstream oss;
+        oss << "Cannot form alloy: supercell contains no " << host << " atoms";
+        throw std::domain_error(oss.str());
+    }
+
+    const SpeciesID id_host  = std::distance(_species_names.begin(), it);
+    const SpeciesID id_guest = add_species(guest);
+
+    // Indices of all host atoms
+    std::vector<size_t> sites;
+
+    for(size_t ia = 0; ia < get_n_atoms(); ++ia) {
+        if(_species[ia] == id_host) {
+            sites.push_back(ia);
+        }
+    }
+
+    const auto n_guest = static_cast<size_t>(std::llround(fraction*sites.size()));
+
+    // Partial shuffle, so that the first n_guest sites are a random selection
+    std::mt19937_64 rng(seed);
+
+    for(size_t i = 0; i < n_guest; ++i)
+    {
+        const size_t j = i + rng() % (sites.size() - i);
+        std::swap(sites[i], sites[j]);
+        _species[sites[i]] = id_guest;
+    }
+
+    return n_guest;
+}
+
+/**
+ * \brief Get the position of an atom
+ *
+ * \param[in] ia Index of atom
+ *
+ * \returns The position [m]
+ */
+auto Supercell::get_position(const size_t ia) const -> arma::vec
+{
+    return arma::vec{_x.at(ia), _y.at(ia), _z.at(ia)};
+}
+
+/**
+ * \brief Convert to a list of atoms, as returned by read_atoms()
+ */
+auto Supercell::to_atoms() const -> std::vector<atom>
+{
+    std::vector<atom> atoms(get_n_atoms());
+
+    for(size_t ia = 0; ia < get_n_atoms(); ++ia)
+    {
+        atoms[ia].type = _species_names[_species[ia]];
+        atoms[ia].r    = get_position(ia);
+    }
+
+    return atoms;
+}
+
+/**
+ * \brief Write the supercell to a binary file
+ *
+ * \param[in] filename Name of the file
+ *
+ * \details The data is written to a temporary file, which then replaces the
+ *          named file, so a failed write never leaves a partial file.
+ */
+void Supercell::write(const std::string &filename) const
+{
+    const std::string tmp_filename = filename + ".tmp";
+    std::ofstream stream(tmp_filename, std::ios::binary | std::ios::trunc);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << tmp_filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    const uint64_t n_atoms = get_n_atoms();
+
+    Header header {};
+    std::memcpy(header.magic, supercell_magic, sizeof(supercell_magic));
+    header.version   = supercell_version;
+    header.n_species = get_n_species();
+    header.n_atoms   = n_atoms;
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for(const auto &name : _species_names)
+    {
+        char buffer[name_size] = {};
+        std::memcpy(buffer, name.c_str(), name.size());
+        stream.write(buffer, name_size);
+    }
+
+    const char padding[sizeof(double)] = {};
+    stream.write(reinterpret_cast<const char *>(_species.data()), n_atoms*sizeof(SpeciesID));
+    stream.write(padding, get_padding(n_atoms));
+    stream.write(reinterpret_cast<const char *>(_x.data()), n_atoms*sizeof(double));
+    stream.write(reinterpret_cast<const char *>(_y.data()), n_atoms*sizeof(double));
+    stream.write(reinterpret_cast<const char *>(_z.data()), n_atoms*sizeof(double));
+    stream.close();
+
+    if(!stream || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmp_filename.c_str());
+        std::ostringstream oss;
+        oss << "Could not write " << filename;
+        throw std::runtime_error(oss.str());
+    }
+}
+
+/**
+ * \brief Write the supercell to an XYZ file, with positions in angstrom
+ *
+ * \param[in] filename Name of the file
+ */
+void Supercell::write_xyz(const std::string &filename) const
+{
+    FILE *file = fopen(filename.c_str(), "w");
+
+    if(file == nullptr)
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    // Write number of atoms to first line of file, then leave blank line
+    fprintf(file, "%zu\n\n", get_n_atoms());
+
+    for(size_t ia = 0; ia < get_n_atoms(); ++ia)
+    {
+        fprintf(file, "%s %9.3f %9.3f %9.3f\n", _species_names[_species[ia]].c_str(),
+                _x[ia]*1e10, _y[ia]*1e10, _z[ia]*1e10);
+    }
+
+    fclose(file);
+}
+} // namespace QWWAD
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
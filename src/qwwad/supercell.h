@@ -0,0 +1,131 @@
+/**
+ * \file   supercell.h
+ * \brief  Atomic positions and species in a crystal supercell
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_SUPERCELL_H
+#define QWWAD_SUPERCELL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <armadillo>
+
+#include "ppff.h"
+
+namespace QWWAD {
+/**
+ * \brief The atoms in a crystal supercell, stored as one array per property
+ *
+ * \details Alloy-disorder calculations need supercells of up to a million
+ *          atoms.  Each atom's species is held as a small integer, which
+ *          indexes a table of species names, and the x, y and z coordinates
+ *          are held in separate arrays.  This keeps the memory compact, and
+ *          lets the structure-factor sums read the coordinates sequentially.
+ *
+ *          A supercell can be saved as XYZ text, for visualisation and older
+ *          tools, or in a binary format.  The binary file holds:
+ *
+ *          - A header with the number of atoms and species.
+ *          - The name of each species, in a fixed-size field.
+ *          - The species index of every atom.
+ *          - The x, y and z coordinates of every atom [m], as three blocks.
+ *
+ *          Each array is written and read with a single block transfer, so
+ *          there is no parsing or formatting, and no rounding of positions.
+ */
+class Supercell {
+public:
+    /// Index of an atomic species
+    using SpeciesID = uint16_t;
+
+    Supercell() = default;
+    explicit Supercell(const std::vector<atom> &atoms);
+
+    [[nodiscard]] static auto zinc_blende(double             A0,
+                                          unsigned int       n_x,
+                                          unsigned int       n_y,
+                                          unsigned int       n_z,
+                                          const std::string &cation,
+                                          const std::string &anion) -> Supercell;
+
+    [[nodiscard]] static auto single_spiral(double             A0,
+                                            unsigned int       n_z,
+                                            const std::string &cation,
+                                            const std::string &anion) -> Supercell;
+
+    [[nodiscard]] static auto read(const std::string &filename) -> Supercell;
+
+    [[nodiscard]] static auto is_binary(const std::string &filename) -> bool;
+
+    auto add_species(const std::string &name) -> SpeciesID;
+
+    void add_atom(SpeciesID id,
+                  double    x,
+                  double    y,
+                  double    z);
+
+    void reserve(size_t n_atoms);
+
+    auto make_alloy(const std::string &host,
+                    const std::string &guest,
+                    double             fraction,
+                    uint64_t           seed) -> size_t;
+
+    /// Get the number of atoms
+    [[nodiscard]] inline auto get_n_atoms()   const -> size_t {return _species.size();}
+
+    /// Get the number of species
+    [[nodiscard]] inline auto get_n_species() const -> size_t {return _species_names.size();}
+
+    /// Get the name of a species
+    [[nodiscard]] inline auto get_species_name(const size_t is) const -> const std::string & {return _species_names.at(is);}
+
+    /// Get the name of every species
+    [[nodiscard]] inline auto get_species_names() const -> const std::vector<std::string> & {return _species_names;}
+
+    /// Get the species index of every atom
+    [[nodiscard]] inline auto get_species() const -> const std::vector<SpeciesID> & {return _species;}
+
+    /// Get the x coordinate of every atom [m]
+    [[nodiscard]] inline auto get_x() const -> const std::vector<double> & {return _x;}
+
+    /// Get the y coordinate of every atom [m]
+    [[nodiscard]] inline auto get_y() const -> const std::vector<double> & {return _y;}
+
+    /// Get the z coordinate of every atom [m]
+    [[nodiscard]] inline auto get_z() const -> const std::vector<double> & {return _z;}
+
+    [[nodiscard]] auto get_position(size_t ia) const -> arma::vec;
+
+    [[nodiscard]] auto to_atoms() const -> std::vector<atom>;
+
+    void write(const std::string &filename) const;
+    void write_xyz(const std::string &filename) const;
+
+private:
+    /// File header
+    struct Header {
+        char     magic[8];  ///< File signature
+        uint32_t version;   ///< Format version
+        uint32_t n_species; ///< Number of species
+        uint64_t n_atoms;   ///< Number of atoms
+    };
+
+    /// Size of the field for each species name [bytes]
+    static const size_t name_size = 32;
+
+    [[nodiscard]] static auto read_binary(const std::string &filename) -> Supercell;
+    [[nodiscard]] static auto read_xyz(const std::string &filename) -> Supercell;
+
+    std::vector<std::string> _species_names; ///< Name of each species
+    std::vector<SpeciesID>   _species;       ///< Species index of each atom
+    std::vector<double>      _x;             ///< x coordinate of each atom [m]
+    std::vector<double>      _y;             ///< y coordinate of each atom [m]
+    std::vector<double>      _z;             ///< z coordinate of each atom [m]
+};
+} // namespace QWWAD
+#endif // QWWAD_SUPERCELL_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,155 @@
+/**
+ * \file   thermal-conductivity.cpp
+ * \brief  Temperature-dependent thermal conductivity of a material
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#include "thermal-conductivity.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+#include <glibmm/ustring.h>
+#include "material.h"
+#include "material-property-numeric.h"
+
+namespace QWWAD
+{
+/**
+ * \brief Find the thermal-conductivity model for a material
+ *
+ * \param[in] mat The material system
+ * \param[in] x   Alloy fraction (if applicable)
+ *
+ * \details The material library is searched for each of the supported
+ *          forms in turn, and the first one that is found is used.
+ *
+ * \todo Figure out where all these values come from!
+ * \todo These values only work for a limited range of
+ *       temperatures. Restrict the domain accordingly?
+ */
+ThermalConductivity::ThermalConductivity(const Material &mat,
+                                         const double    x)
+    : _x(x)
+{
+    try
+    {
+        _k_1 = mat.get_property_value("thermal-conductivity-vs-alloy", x);
+        _law = K_CONSTANT;
+    }
+    catch(std::exception &e)
+    {
+        try
+        {
+            _k_1   = mat.get_property_value("thermal-conductivity-0K-1");
+            _k_2   = mat.get_property_value("thermal-conductivity-0K-2");
+            _tau_1 = mat.get_property_value("thermal-conductivity-decay-index-1");
+            _tau_2 = mat.get_property_value("thermal-conductivity-decay-index-2");
+            _law   = K_POWER_ALLOY;
+
+            if(x < 0 or x > 1) {
+                throw std::domain_error("x value out of range");
+            }
+        }
+        catch(std::exception &e)
+        {
+            try
+            {
+                _k_1   = mat.get_property_value("thermal-conductivity-0K");
+                _tau_1 = mat.get_property_value("thermal-conductivity-decay-index");
+                _law   = K_POWER;
+            }
+            catch(std::exception &e)
+            {
+                try
+                {
+                    _k_1 = mat.get_property_value("thermal-conductivity-high-T");
+                    _k_2 = mat.get_property_value("thermal-conductivity-inverse-T");
+                    _law = K_INVERSE_T;
+                }
+                catch(std::exception &e)
+                {
+                    _k_T = mat.get_numeric_property("thermal-conductivity-T");
+
+                    if(_k_T == nullptr)
+                    {
+                        std::ostringstream oss;
+                        oss << "Could not find thermal conductivity for " << mat.get_description();
+                        throw std::runtime_error(oss.str());
+                    }
+
+                    _law = K_TABULATED;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * \brief Find the thermal conductivity at a given temperature
+ *
+ * \param[in] T Temperature [K]
+ *
+ * \returns Thermal conductivity [W/m/K]
+ */
+auto ThermalConductivity::get_k(const double T) const -> double
+{
+    double k = 0.0;
+
+    switch(_law)
+    {
+        case K_CONSTANT:
+            k = _k_1;
+            break;
+        case K_POWER_ALLOY:
+            k = (1.0 - _x)*_k_1*pow(T, _tau_1) + _x*_k_2*pow(T, _tau_2);
+            break;
+        case K_POWER:
+            k = _k_1*pow(T, _tau_1);
+            break;
+        case K_INVERSE_T:
+            k = _k_1 + _k_2/T;
+            break;
+        case K_TABULATED:
+            k = _k_T->get_val(T);
+            break;
+    }
+
+    return k;
+}
+
+/**
+ * \brief Find the thermal conductivity at a set of temperatures
+ *
+ * \param[in] T Temperature at each point [K]
+ *
+ * \returns Thermal conductivity at each point [W/m/K]
+ */
+auto ThermalConductivity::get_k(const arma::vec &T) const -> arma::vec
+{
+    arma::vec k(T.size());
+
+    switch(_law)
+    {
+        case K_CONSTANT:
+            k.fill(_k_1);
+            break;
+        case K_POWER_ALLOY:
+            k = (1.0 - _x)*_k_1*arma::pow(T, _tau_1) + _x*_k_2*arma::pow(T, _tau_2);
+            break;
+        case K_POWER:
+            k = _k_1*arma::pow(T, _tau_1);
+            break;
+        case K_INVERSE_T:
+            k = _k_1 + _k_2/T;
+            break;
+        case K_TABULATED:
+            k = _k_T->get_val(T);
+            break;
+    }
+
+    return k;
+}
+} // namespace
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
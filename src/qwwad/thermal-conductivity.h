@@ -0,0 +1,62 @@
+/**
+ * \file   thermal-conductivity.h
+ * \brief  Temperature-dependent thermal conductivity of a material
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifndef QWWAD_THERMAL_CONDUCTIVITY_H
+#define QWWAD_THERMAL_CONDUCTIVITY_H
+
+#include <armadillo>
+
+namespace QWWAD
+{
+class Material;
+class MaterialPropertyNumeric;
+
+/// Form of the temperature dependence of thermal conductivity
+enum ThermalConductivityLaw {
+    K_CONSTANT,    ///< Fixed value for the given alloy composition
+    K_POWER_ALLOY, ///< Interpolation between two power laws in temperature
+    K_POWER,       ///< Power law in temperature
+    K_INVERSE_T,   ///< Constant plus term inversely proportional to temperature
+    K_TABULATED    ///< Arbitrary material-library function of temperature
+};
+
+/**
+ * \brief Thermal-conductivity model for a material
+ *
+ * \details The form of the model is resolved from the material library once,
+ *          on construction, so that the conductivity can then be evaluated
+ *          quickly at each time-step of a simulation.
+ *
+ *          If the material library only gives the conductivity as a tabulated
+ *          function of temperature, the model refers directly to that property,
+ *          so the Material must outlive the model.
+ */
+class ThermalConductivity
+{
+public:
+    ThermalConductivity(const Material &mat,
+                        double          x = 0);
+
+    [[nodiscard]] auto get_k(double T) const -> double;
+    [[nodiscard]] auto get_k(const arma::vec &T) const -> arma::vec;
+
+    /// Get the form of the temperature dependence
+    [[nodiscard]] inline auto get_law() const -> ThermalConductivityLaw {return _law;}
+
+private:
+    ThermalConductivityLaw _law = K_CONSTANT;
+
+    double _x     = 0.0; ///< Alloy fraction
+    double _k_1   = 0.0; ///< First coefficient [W/m/K, or as required by law]
+    double _k_2   = 0.0; ///< Second coefficient [W/m/K, or as required by law]
+    double _tau_1 = 0.0; ///< First power-law index
+    double _tau_2 = 0.0; ///< Second power-law index
+
+    MaterialPropertyNumeric const *_k_T = nullptr; ///< Tabulated conductivity vs. temperature
+};
+} // namespace
+#endif //QWWAD_THERMAL_CONDUCTIVITY_H
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -17,6 +17,10 @@ WfOptions::WfOptions()
     add_option<std::string>("wffileprefix","wf_e", "Prefix of wavefunction filenames.");
     add_option<std::string>("wffileext",   ".r",   "File extension for wavefunction files.");
     add_option<std::string>("energyfile",  "Ee.r", "Filename of energy file.");
+    add_option<std::string>("wffileformat", "text", "Format of output energy and wavefunction files: 'text' "
+                                                    "(one file per state) or 'binary' (a single archive, "
+                                                    "written in place of the energy file). Either format "
+                                                    "is detected automatically on input.");
 }
 
 /*
@@ -60,5 +64,28 @@ auto WfOptions::get_energy_filename() const -> std::string{
     auto filename = get_option<std::string>("energyfile");
     return filename;
 }
+
+/**
+ * \brief Check whether energies and wavefunctions should be written as a binary archive
+ *
+ * \return True for a single EigenstateArchive file, or false for text files
+ */
+auto WfOptions::get_wf_binary() const -> bool
+{
+    const auto format = get_option<std::string>("wffileformat");
+
+    if(format == "binary") {
+        return true;
+    }
+
+    if(format != "text")
+    {
+        std::ostringstream oss;
+        oss << "Unknown wavefunction file format: " << format << ". Use 'text' or 'binary'";
+        throw std::runtime_error(oss.str());
+    }
+
+    return false;
+}
 } // end namespace
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -27,6 +27,7 @@ public:
     [[nodiscard]] auto get_wf_prefix() const -> std::string;
     [[nodiscard]] auto get_wf_ext() const -> std::string;
     [[nodiscard]] auto get_energy_filename() const -> std::string;
+    [[nodiscard]] auto get_wf_binary() const -> bool;
 };
 } // end namespace
 #endif // QWWAD_WF_OPTIONS_H
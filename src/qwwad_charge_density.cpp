@@ -12,12 +12,14 @@
 #include <cstdio>
 #include <cmath>
 #include <fstream>
+#include <memory>
 #include <gsl/gsl_math.h>
 
 #include "qwwad/data-checker.h"
 #include "qwwad/file-io.h"
 #include "qwwad/constants.h"
 #include "qwwad/eigenstate.h"
+#include "qwwad/eigenstate-archive.h"
 #include "qwwad/wf_options.h"
 
 using namespace QWWAD;
@@ -43,6 +45,8 @@ ChargeDensityOptions::ChargeDensityOptions(int argc, char** argv)
     add_option<std::string>("carrierdensityfile", "dens.r", "File to which electron density profile will be written");
     add_option<bool>       ("ptype",                        "Dopants are to be treated as acceptors, and wavefunctions "
                                                             "treated as hole states");
+    add_option<bool>       ("streaming",                    "Read and accumulate one wavefunction at a time, rather than "
+                                                            "holding all of them in memory at once");
 
     add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -56,30 +60,27 @@ class ChargeDensityData
 {
     private:
         size_t _nper;   ///< Number of periods crossed by wavefunction
-        std::vector<Eigenstate> states_;  ///< Wf and energy data
         arma::vec  pop_;  ///< Subband population [m^{-2}]
         arma::uvec nval_; ///< Degeneracy of subbands
 
     public:
         ChargeDensityData(const ChargeDensityOptions& opt);
 
-        [[nodiscard]] inline auto get_states() const -> decltype(states_) {return states_;}
         [[nodiscard]] inline auto get_pop()    const -> decltype(pop_)    {return pop_;}
         [[nodiscard]] inline auto get_nval()   const -> decltype(nval_)   {return nval_;}
+
+        /// Number of carriers in each state, including degeneracy [m^{-2}]
+        [[nodiscard]] inline auto get_weights() const -> arma::vec {return pop_ % arma::conv_to<arma::vec>::from(nval_);}
 };
 
 ChargeDensityData::ChargeDensityData(const ChargeDensityOptions& opt) :
-    _nper(opt.get_option<size_t>("nper")),
-    states_(Eigenstate::read_from_file(opt.get_energy_filename(),
-                                       opt.get_wf_prefix(),
-                                       opt.get_wf_ext())),
-    pop_(arma::zeros(states_.size())),
-    nval_(arma::ones<arma::uvec>(states_.size()))
+    _nper(opt.get_option<size_t>("nper"))
 {
     // Read population of each subband
     const auto population_file = opt.get_option<std::string>("populationfile");
     read_table(population_file.c_str(), pop_);
     const size_t nst = pop_.size();
+    nval_ = arma::ones<arma::uvec>(nst);
 
     // Check that populations are all positive
     DataChecker::check_positive(pop_);
@@ -102,6 +103,143 @@ ChargeDensityData::ChargeDensityData(const ChargeDensityOptions& opt) :
     }
 }
 
+/**
+ * \brief Check that a wavefunction covers the requested number of periods
+ *
+ * \param[in] nz       Number of samples in the wavefunction
+ * \param[in] nz_1per  Number of samples in a single period
+ * \param[in] nper     Number of periods
+ */
+static void check_wf_size(const size_t nz,
+                          const size_t nz_1per,
+                          const size_t nper)
+{
+    if(nz < nz_1per*nper)
+    {
+        std::ostringstream oss;
+        oss << "Wavefunction has " << nz << " samples, but " << nper << " periods of "
+            << nz_1per << " samples were requested.";
+        throw std::length_error(oss.str());
+    }
+}
+
+/**
+ * \brief Find the carrier density in a single period, with all states held in memory
+ *
+ * \param[in] states  The set of states
+ * \param[in] weights Number of carriers in each state [m^{-2}]
+ * \param[in] nz_1per Number of spatial samples in a single period
+ * \param[in] nper    Number of periods crossed by each wavefunction
+ *
+ * \returns The carrier density at each point in a single period [m^{-3}]
+ *
+ * \details The probability densities are stored in a single nz x nst matrix.
+ *          The periods are then folded into extra columns (without copying), so that
+ *          the summation in [QWWAD4, 3.108] becomes a single matrix-vector product.
+ */
+static auto find_carrier_density(const std::vector<Eigenstate> &states,
+                                 const arma::vec               &weights,
+                                 const size_t                   nz_1per,
+                                 const size_t                   nper) -> arma::vec
+{
+    const size_t nst = states.size();
+    const size_t nz  = nz_1per*nper;
+
+    if(weights.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Populations were given for " << weights.size() << " states, but "
+            << nst << " states were found.";
+        throw std::length_error(oss.str());
+    }
+
+    // Probability density for each state, over all periods
+    arma::mat PD(nz, nst);
+
+    for(unsigned int ist = 0; ist < nst; ist++)
+    {
+        const auto psi = states[ist].get_wavefunction_samples();
+        check_wf_size(psi.size(), nz_1per, nper);
+        PD.col(ist) = arma::square(arma::abs(psi.head(nz)));
+    }
+
+    // View the matrix as one column per (period, state) pair. In column-major
+    // ordering, column ist*nper + iper is the part of state ist in period iper
+    const arma::mat PD_fold(PD.memptr(), nz_1per, nper*nst, false, true);
+
+    // Each period of a state carries the same weight
+    const arma::vec w = arma::vectorise(arma::repmat(weights.t(), nper, 1));
+
+    return PD_fold * w;
+}
+
+/**
+ * \brief Find the carrier density in a single period, reading one state at a time
+ *
+ * \param[in] opt     User options
+ * \param[in] weights Number of carriers in each state [m^{-2}]
+ * \param[in] nz_1per Number of spatial samples in a single period
+ * \param[in] nper    Number of periods crossed by each wavefunction
+ *
+ * \returns The carrier density at each point in a single period [m^{-3}]
+ *
+ * \details Only a single wavefunction is held in memory at any time, which
+ *          is useful for very large structures.
+ */
+static auto find_carrier_density_streaming(const ChargeDensityOptions &opt,
+                                           const arma::vec            &weights,
+                                           const size_t                nz_1per,
+                                           const size_t                nper) -> arma::vec
+{
+    const auto filename = opt.get_energy_filename();
+    const auto E        = Eigenstate::read_energies_from_file(filename);
+    const size_t nst    = E.size();
+
+    if(weights.size() != nst)
+    {
+        std::ostringstream oss;
+        oss << "Populations were given for " << weights.size() << " states, but "
+            << nst << " states were found in " << filename;
+        throw std::length_error(oss.str());
+    }
+
+    // An archive is memory-mapped, so each wavefunction is only read from
+    // disk when it is used
+    std::unique_ptr<EigenstateArchive> archive;
+
+    if(EigenstateArchive::is_archive(filename)) {
+        archive = std::make_unique<EigenstateArchive>(filename);
+    }
+
+    arma::vec carrier_density_1per = arma::zeros(nz_1per);
+
+    for(unsigned int ist = 0; ist < nst; ist++)
+    {
+        arma::vec    z;
+        arma::cx_vec psi;
+
+        if(archive) {
+            z   = archive->get_position_samples();
+            psi = archive->get_wavefunctions().col(ist);
+        } else {
+            read_table(opt.get_wf_filename(ist+1), z, psi);
+        }
+
+        check_wf_size(psi.size(), nz_1per, nper);
+
+        // Construct the state so that it is normalised in the same way as
+        // in the in-memory calculation
+        const Eigenstate state(E(ist), z, psi);
+        arma::vec PD = state.get_PD();
+
+        // Sum over all periods using a view of the probability density
+        const arma::mat PD_fold(PD.memptr(), nz_1per, nper, false, true);
+        carrier_density_1per += weights(ist) * arma::sum(PD_fold, 1);
+    }
+
+    return carrier_density_1per;
+}
+
 auto main(int argc, char* argv[]) -> int
 {
     const ChargeDensityOptions opt(argc, argv);
@@ -109,11 +247,7 @@ auto main(int argc, char* argv[]) -> int
     const auto nper = opt.get_option<size_t>("nper"); // Number of periods over which wavefunction spreads
 
     const ChargeDensityData data(opt);
-    const auto states = data.get_states();
-    const auto pop    = data.get_pop();
-    const auto nval   = data.get_nval();
- 
-    const auto nst  = states.size();          // Number of states localised in one period
+    const auto weights = data.get_weights();
 
     // Read doping profile (for entire multi-period structure)
     arma::vec z; // Spatial location [m]
@@ -125,32 +259,27 @@ auto main(int argc, char* argv[]) -> int
 
     // Get doping for one period by slicing it from total profile
     const arma::vec z_1per = z.subvec(0, nz_1per-1);
-    const auto d_1per = d.subvec(0, nz_1per-1);
+    const arma::vec d_1per = d.subvec(0, nz_1per-1);
 
     // Find carrier density at each point in a single period
     // by summing the "tails" of wavefunctions in each period.
     // This implements the summation in [QWWAD4, 3.108]
     // [m^{-3}]
-    arma::vec carrier_density_1per = arma::zeros<arma::vec>(nz_1per);
+    arma::vec carrier_density_1per;
 
-    for(unsigned int iper = 0; iper < nper; iper++)
-    {
-        for(unsigned int ist = 0; ist < nst; ist++)
-        {
-            // Find probability density function for carrier over the entire structure
-            const auto PD     = states[ist].get_PD();
+    if(opt.get_option<bool>("streaming")) {
+        carrier_density_1per = find_carrier_density_streaming(opt, weights, nz_1per, nper);
+    } else {
+        const auto states = Eigenstate::read_from_file(opt.get_energy_filename(),
+                                                       opt.get_wf_prefix(),
+                                                       opt.get_wf_ext());
 
-            // Grab the part of the PDF that lies in this period
-            const arma::vec PD_per = PD.subvec(iper*nz_1per, (iper+1)*nz_1per-1);
-
-            // Add this into the total carrier density profile
-            carrier_density_1per += pop[ist] * static_cast<double>(nval[ist]) * PD_per;
-        }
+        carrier_density_1per = find_carrier_density(states, weights, nz_1per, nper);
     }
 
     // Charge density is obtained by subtracting carrier density from doping density
     // [QWWAD4, 3.108]. Note q = -e by default (for electrons). [C m^{-3}]
-    arma::vec rho_1per = e*(d - carrier_density_1per);
+    arma::vec rho_1per = e*(d_1per - carrier_density_1per);
 
     // Invert charge profile if it's a p-type system
     if (opt.get_option<bool>("ptype")) {
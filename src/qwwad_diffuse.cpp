@@ -21,21 +21,125 @@
  *    X.r           final (diffused) concentration profile 
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cstdlib>
-#include <valarray>
 
+#include <armadillo>
 #include <gsl/gsl_math.h>
 
 #include "qwwad/file-io.h"
+#include "qwwad/linear-algebra.h"
 #include "qwwad/options.h"
 
 using namespace QWWAD;
 
-static void diffuse(const std::valarray<double> &z,
-                    std::valarray<double>       &x,
-                    const std::valarray<double> &D,
-                    const double                delta_t);
+/// Form of the diffusion coefficient
+enum DiffusionMode {
+    DIFFUSION_CONSTANT,      ///< Fixed value everywhere
+    DIFFUSION_CONCENTRATION, ///< Dependent on concentration of diffusant
+    DIFFUSION_DEPTH,         ///< Gaussian function of depth
+    DIFFUSION_TIME           ///< Gaussian function of depth, decaying with time
+};
+
+static auto parse_mode(const std::string &mode) -> DiffusionMode
+{
+    if(mode == "constant") {
+        return DIFFUSION_CONSTANT;
+    }
+
+    if(mode == "concentration-dependent") {
+        return DIFFUSION_CONCENTRATION;
+    }
+
+    if(mode == "depth-dependent") {
+        return DIFFUSION_DEPTH;
+    }
+
+    if(mode == "time-dependent") {
+        return DIFFUSION_TIME;
+    }
+
+    std::cerr << "Diffusion mode: " << mode << " not recognised" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * Find the diffusion coefficient at each point
+ *
+ * \param[in]  mode Form of diffusion coefficient
+ * \param[in]  D0   Diffusion coefficient for constant mode [m^2/s]
+ * \param[in]  z    Spatial profile [m]
+ * \param[in]  x    Diffusant profile
+ * \param[in]  t    Time [s]
+ * \param[out] D    Diffusion coefficient at each point [m^2/s]
+ */
+static void find_D(const DiffusionMode  mode,
+                   const double         D0,
+                   const arma::vec     &z,
+                   const arma::vec     &x,
+                   const double         t,
+                   arma::vec           &D)
+{
+    switch(mode)
+    {
+        case DIFFUSION_CONSTANT:
+            D.fill(D0); // set constant diffusion coeff.
+            break;
+
+        case DIFFUSION_CONCENTRATION:
+            {
+                // TODO: Make this configurable
+                const double k = 1e-20; // Concentration factor [m^2/s]
+
+                // Find concentration-dependent diffusion coefficient
+                // [4.14, QWWAD4]
+                D = k*x%x;
+            }
+            break;
+
+        case DIFFUSION_DEPTH:
+            {
+                // TODO: Make this configurable
+                const double D0    = 10*1e-20;   // Magnitude of distribution [m^2/s]
+                const double z0    = 1800*1e-10; // Centre of diff. coeff. distribution [m]
+                const double sigma = 600*1e-10;  // Width of distribution [m]
+
+                // Find depth-dependent diffusion coefficient
+                // [4.16, QWWAD4]
+                D = D0*arma::exp(-arma::square((z-z0)/sigma)/2);
+            }
+            break;
+
+        case DIFFUSION_TIME:
+            {
+                // TODO: Make this configurable
+                const double D0    = 10*1e-20;   // Magnitude of distribution [m^2/s]
+                const double z0    = 1800*1e-10; // Centre of diff. coeff. distribution [m]
+                const double sigma = 600*1e-10;  // Width of distribution [m]
+                const double tau   = 100;        // Decay time-constant for diffusion [s]
+
+                // Find time and depth-dependent diffusion coefficient
+                // [4.18, QWWAD4]
+                D = D0*arma::exp(-arma::square((z-z0)/sigma)/2)*exp(-t/tau);
+            }
+            break;
+    }
+}
+
+static void diffuse(const arma::vec &z,
+                    arma::vec       &x,
+                    arma::vec       &x_new,
+                    const arma::vec &D,
+                    double           delta_t);
+
+static auto crank_nicolson_step(DiffusionMode    mode,
+                                double           D0,
+                                const arma::vec &z,
+                                const arma::vec &x,
+                                double           t,
+                                double           delta_t) -> arma::vec;
 
 static void check_stability(const double dt,
                             const double dz,
@@ -57,10 +161,14 @@ int main(int argc,char *argv[])
     Options opt;
     std::string doc("Solve the generalised diffusion equation");
 
-    opt.add_option<double>     ("dt,d",          0.01, "Time-step [s]");
+    opt.add_option<double>     ("dt,d",          0.01, "Time-step [s]. For the Crank-Nicolson method, this is "
+                                                       "the initial time-step.");
     opt.add_option<double>     ("coeff,D",        1.0, "Diffusion coefficient [Angstrom^2/s]");
     opt.add_option<double>     ("time,t",         1.0, "End time for simulation [s]");
     opt.add_option<std::string>("mode,a",  "constant", "Form of diffusion coefficient");
+    opt.add_option<std::string>("method,m",    "ftcs", "Numerical method: ftcs or crank-nicolson");
+    opt.add_option<double>     ("tolerance",     1e-6, "Largest allowed error in each time-step, relative to the "
+                                                       "peak diffusant value (Crank-Nicolson method only)");
     opt.add_option<std::string>("infile",       "x.r", "File from which input profile of diffusant will be read");
     opt.add_option<std::string>("outfile",      "X.r", "File to which output profile of diffusant will be written");
 
@@ -69,61 +177,80 @@ int main(int argc,char *argv[])
     const auto t_final = opt.get_option<double>("time");          // [s]
     const auto dt      = opt.get_option<double>("dt");            // [s]
     const auto D0      = opt.get_option<double>("coeff") * 1e-20; // [m^2/s]
-    const auto mode    = opt.get_option<std::string>("mode");
+    const auto mode    = parse_mode(opt.get_option<std::string>("mode"));
+    const auto method  = opt.get_option<std::string>("method");
 
-    std::valarray<double> z; // Spatial location [m]
-    std::valarray<double> x; // Initial diffusant profile
+    arma::vec z; // Spatial location [m]
+    arma::vec x; // Initial diffusant profile
     read_table(opt.get_option<std::string>("infile").c_str(), z, x);
 
     const size_t nz = z.size(); // Number of spatial points
 
-    std::valarray<double> D(nz); // Diffusion coefficient
-
-    for(double t=dt; t<=t_final; t+=dt)
+    if(method == "ftcs")
     {
-        if (mode == "constant")
-        {
-            D = D0;	// set constant diffusion coeff.
-        }
-        else if(mode == "concentration-dependent")
-        {
-            // TODO: Make this configurable
-            const double k = 1e-20; // Concentration factor [m^2/s]
+        arma::vec D(nz);     // Diffusion coefficient
+        arma::vec x_new(nz); // Workspace for updated profile
 
-            // Find concentration-dependent diffusion coefficient
-            // [4.14, QWWAD4]
-            D = k*x*x;
-        }
-        else if(mode == "depth-dependent")
-        {
-            // TODO: Make this configurable
-            const double D0    = 10*1e-20;   // Magnitude of distribution [m^2/s]
-            const double z0    = 1800*1e-10; // Centre of diff. coeff. distribution [m]
-            const double sigma = 600*1e-10;  // Width of distribution [m]
-
-            // Find depth-dependent diffusion coefficient
-            // [4.16, QWWAD4]
-            D = D0*exp(-pow((z-z0)/sigma, 2)/2);
-        }
-        else if(mode == "time-dependent")
+        // Only concentration- and time-dependent coefficients
+        // change during the simulation
+        const bool D_varies = (mode == DIFFUSION_CONCENTRATION || mode == DIFFUSION_TIME);
+        find_D(mode, D0, z, x, dt, D);
+
+        for(double t=dt; t<=t_final; t+=dt)
         {
-            // TODO: Make this configurable
-            const double D0    = 10*1e-20;   // Magnitude of distribution [m^2/s]
-            const double z0    = 1800*1e-10; // Centre of diff. coeff. distribution [m]
-            const double sigma = 600*1e-10;  // Width of distribution [m]
-            const double tau   = 100;        // Decay time-constant for diffusion [s]
-
-            // Find time and depth-dependent diffusion coefficient
-            // [4.18, QWWAD4]
-            D = D0*exp(-pow((z-z0)/sigma, 2)/2)*exp(-t/tau);
+            if(D_varies) {
+                find_D(mode, D0, z, x, t, D);
+            }
+
+            diffuse(z, x, x_new, D, dt);
         }
-        else
+    }
+    else if(method == "crank-nicolson")
+    {
+        const auto tol = opt.get_option<double>("tolerance");
+
+        double t = 0.0;
+        double h = std::min(dt, t_final); // Current time-step [s]
+        size_t n_steps    = 0;
+        size_t n_rejected = 0;
+
+        while(t < t_final)
         {
-            std::cerr << "Diffusion mode: " << mode << " not recognised" << std::endl;
-            exit(EXIT_FAILURE);
+            h = std::min(h, t_final - t);
+
+            // Estimate the error by comparing a single step with a pair of
+            // half-steps.  Crank-Nicolson is second order, so the difference
+            // is about three times the error in the pair of half-steps.
+            const arma::vec x_full = crank_nicolson_step(mode, D0, z, x, t, h);
+            const arma::vec x_half = crank_nicolson_step(mode, D0, z, x, t, h/2);
+            const arma::vec x_pair = crank_nicolson_step(mode, D0, z, x_half, t+h/2, h/2);
+
+            const double scale = tol * std::max(arma::abs(x).max(), 1e-300);
+            const double err   = arma::abs(x_pair - x_full).max()/(3.0*scale);
+
+            if(err <= 1.0)
+            {
+                t += h;
+                x  = x_pair;
+                ++n_steps;
+            }
+            else {
+                ++n_rejected;
+            }
+
+            // Choose next step size, allowing for third-order local error
+            const double factor = (err > 0.0) ? 0.9*std::cbrt(1.0/err) : 4.0;
+            h *= std::min(4.0, std::max(0.2, factor));
         }
 
-        diffuse(z, x, D, dt);
+        if(opt.get_verbose()) {
+            std::cout << "Completed in " << n_steps << " steps (" << n_rejected << " rejected)" << std::endl;
+        }
+    }
+    else
+    {
+        std::cerr << "Numerical method: " << method << " not recognised" << std::endl;
+        exit(EXIT_FAILURE);
     }
 
     write_table(opt.get_option<std::string>("outfile").c_str(), z, x);
@@ -136,21 +263,21 @@ int main(int argc,char *argv[])
  *
  * \param[in]     z        spatial profile [m]
  * \param[in,out] x        diffusant profile
+ * \param[out]    x_new    workspace for the modified profile
  * \param[in]     D        Diffusion coefficient at each point [m^2/s]
  * \param[in]     delta_t  time step [s]
  */
-static void diffuse(const std::valarray<double> &z,
-                    std::valarray<double>       &x,
-                    const std::valarray<double> &D,
-                    const double                 delta_t)
+static void diffuse(const arma::vec &z,
+                    arma::vec       &x,
+                    arma::vec       &x_new,
+                    const arma::vec &D,
+                    const double     delta_t)
 {
     const double dz = z[1] - z[0];
     const size_t nz = z.size();
 
     check_stability(delta_t, dz, D.max());
 
-    std::valarray<double> x_new(nz); // Modified diffusion profile
-
     for(unsigned int iz=1; iz<nz-1; ++iz)
     {
         x_new[iz]=delta_t*
@@ -165,6 +292,86 @@ static void diffuse(const std::valarray<double> &z,
     x_new[0]    = x_new[1];
     x_new[nz-1] = x_new[nz-2];
 
-    x = x_new; // Copy new profile
+    x.swap(x_new); // Use new profile
+}
+
+/**
+ * Projects the diffusant profile a time interval delta_t into the future,
+ * using the Crank-Nicolson method
+ *
+ * \param[in] mode    Form of diffusion coefficient
+ * \param[in] D0      Diffusion coefficient for constant mode [m^2/s]
+ * \param[in] z       spatial profile [m]
+ * \param[in] x       diffusant profile at start of step
+ * \param[in] t       time at start of step [s]
+ * \param[in] delta_t time step [s]
+ *
+ * \returns The diffusant profile at the end of the step
+ *
+ * \details The diffusion equation is discretised in conservative form,
+ *          using the mean diffusion coefficient at the interface between
+ *          each pair of points.  No diffusant flows through the ends of
+ *          the structure (i.e., it is a closed system), so the total
+ *          quantity of diffusant is conserved exactly.
+ *
+ *          The method is unconditionally stable, so there is no limit on
+ *          the time-step.  If the diffusion coefficient depends on the
+ *          concentration, the implicit part of the step is linearised by
+ *          Picard iteration: the coefficient is evaluated using the latest
+ *          estimate of the new profile, until the estimate converges.
+ */
+static auto crank_nicolson_step(const DiffusionMode  mode,
+                                const double         D0,
+                                const arma::vec     &z,
+                                const arma::vec     &x,
+                                const double         t,
+                                const double         delta_t) -> arma::vec
+{
+    const double dz    = z[1] - z[0];
+    const size_t nz    = z.size();
+    const double r     = delta_t/(2*dz*dz);
+    const size_t n_max = (mode == DIFFUSION_CONCENTRATION) ? 50 : 1; // Max number of Picard iterations
+
+    // Find the explicit half of the step, using the coefficient at the start
+    arma::vec D(nz);
+    find_D(mode, D0, z, x, t, D);
+
+    arma::vec rhs = x;
+
+    for(unsigned int iz=0; iz<nz-1; ++iz)
+    {
+        const double flux = r*(D[iz] + D[iz+1])/2*(x[iz+1] - x[iz]);
+        rhs[iz]   += flux;
+        rhs[iz+1] -= flux;
+    }
+
+    arma::vec x_new = x;
+
+    for(unsigned int iter = 0; iter < n_max; ++iter)
+    {
+        find_D(mode, D0, z, x_new, t+delta_t, D);
+
+        arma::vec diag  = arma::ones(nz);
+        arma::vec sub   = arma::zeros(nz-1);
+        arma::vec super = arma::zeros(nz-1);
+
+        for(unsigned int iz=0; iz<nz-1; ++iz)
+        {
+            const double a = r*(D[iz] + D[iz+1])/2;
+            diag[iz]   += a;
+            diag[iz+1] += a;
+            super[iz]   = -a;
+            sub[iz]     = -a;
+        }
+
+        const arma::vec x_prev = x_new;
+        x_new = solve_tridiag(sub, diag, super, rhs);
+
+        if(arma::abs(x_new - x_prev).max() <= 1e-12*arma::abs(x_new).max()) {
+            break;
+        }
+    }
+
+    return x_new;
 }
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -16,6 +16,7 @@
 #include <cstdlib>
 
 #include "qwwad/constants.h"
+#include "qwwad/eigenstate-archive.h"
 #include "qwwad/file-io.h"
 #include "qwwad/linear-algebra.h"
 #include "qwwad/schroedinger-solver-full.h"
@@ -130,6 +131,49 @@ class FwfOptions : public WfOptions {
         }
 };
 
+/**
+ * \brief Write solutions to a single binary archive
+ *
+ * \param[in] solutions The set of states to output
+ * \param[in] opt       User options
+ *
+ * \details The archive replaces the energy file.  The particle is taken from
+ *          the last character of the wavefunction prefix (e.g., 'wf_e'), and
+ *          the input hash covers every file that was read by the solver.
+ */
+static void write_archive(const std::vector<Eigenstate> &solutions,
+                          const FwfOptions              &opt)
+{
+    EigenstateArchive::Metadata metadata;
+
+    const auto prefix = opt.get_wf_prefix();
+
+    if(!prefix.empty() && std::string("ehl").find(prefix.back()) != std::string::npos) {
+        metadata.particle = prefix.back();
+    }
+
+    metadata.solver = opt.get_option<std::string>("solver");
+
+    std::vector<std::string> inputs = {opt.get_option<std::string>("totalpotentialfile")};
+
+    if(opt.get_argument_known("mass")) {
+        metadata.mass = opt.get_option<double>("mass") * me;
+    } else {
+        inputs.push_back(opt.get_option<std::string>("massfile"));
+    }
+
+    if(opt.get_type() == MATRIX_TAYLOR_NONPARABOLIC ||
+       opt.get_type() == MATRIX_FULL_NONPARABOLIC   ||
+       opt.get_type() == SHOOTING_NONPARABOLIC)
+    {
+        inputs.push_back(opt.get_option<std::string>("alphafile"));
+    }
+
+    metadata.input_hash = EigenstateArchive::hash_files(inputs);
+
+    EigenstateArchive::write(opt.get_energy_filename(), solutions, metadata);
+}
+
 /**
  * Function to format and output solutions
  *
@@ -158,11 +202,15 @@ static void output(const std::vector<Eigenstate> &solutions,
             }
         }
 
-        Eigenstate::write_to_file(opt.get_energy_filename(),
-                                  opt.get_wf_prefix(),
-                                  opt.get_wf_ext(),
-                                  solutions,
-                                  true);
+        if(opt.get_wf_binary()) {
+            write_archive(solutions, opt);
+        } else {
+            Eigenstate::write_to_file(opt.get_energy_filename(),
+                                      opt.get_wf_prefix(),
+                                      opt.get_wf_ext(),
+                                      solutions,
+                                      true);
+        }
     }
 }
 
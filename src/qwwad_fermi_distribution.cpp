@@ -12,18 +12,26 @@
  *          Output files:
  *            FDX.r F-D distribution for subband X
  *
+ *          In batch mode, the Fermi energies for a whole grid of total
+ *          populations and temperatures are found in a single run and
+ *          written to a single table.
+ *
  * \author Paul Harrison  <p.harrison@shu.ac.uk>
  * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
  */
 
 #include <iostream>
+#include <iomanip>
+#include <fstream>
 #include <sstream>
 #include <cstdio>
 #include <cstdlib>
 #include <gsl/gsl_math.h>
 #include "qwwad/constants.h"
+#include "qwwad/eigenstate.h"
 #include "qwwad/fermi.h"
 #include "qwwad/file-io.h"
+#include "qwwad/maths-helpers.h"
 #include "qwwad/options.h"
 
 using namespace QWWAD;
@@ -66,8 +74,37 @@ class SBPOptions : public Options
             add_option<double>("global-population,N", 0.0,    "Use equilibrium population for the entire system "
                     "instead of reading subband "
                     "populations from file [x1e10 cm^{-2}]");
+            add_option<double>("Tmin",                Te_def, "Lowest carrier temperature for batch mode [K].");
+            add_option<double>("Tmax",                Te_def, "Highest carrier temperature for batch mode [K].");
+            add_option<size_t>("nT",                  0,      "Number of temperatures for batch mode. If nonzero, "
+                    "the Fermi energies are found at each temperature and written to the batch file.");
+            add_option<double>("Nmin",                1e15,   "Lowest global population for batch mode [m^{-2}].");
+            add_option<double>("Nmax",                1e15,   "Highest global population for batch mode [m^{-2}].");
+            add_option<size_t>("nN",                  0,      "Number of global populations for batch mode. If "
+                    "nonzero, the system is in equilibrium at each population, and the Fermi energies "
+                    "are written to the batch file.");
+            add_option<bool>  ("logN",                        "Use logarithmic spacing for global populations in "
+                    "batch mode.");
+            add_option<std::string>("batchfile", "Ef-batch.r", "Filename to which batch-mode results are written.");
+            add_option<std::string>("fdbatchfile", "FD-batch.r", "Filename to which batch-mode Fermi-Dirac distributions "
+                    "are written (if --fd option is used).");
 
             add_prog_specific_options_and_parse(argc, argv, summary);
+
+            if(get_option<size_t>("nN") > 0 and
+               (get_option<double>("Nmin") <= 0.0 or get_option<double>("Nmax") < get_option<double>("Nmin")))
+            {
+                std::ostringstream oss;
+                oss << "Batch-mode global populations must be positive, with Nmax >= Nmin. Got Nmin = "
+                    << get_option<double>("Nmin") << " m^{-2} and Nmax = " << get_option<double>("Nmax") << " m^{-2}.";
+                throw std::domain_error(oss.str());
+            }
+        }
+
+        /// \returns true if batch mode has been requested
+        [[nodiscard]] auto batch() const -> bool
+        {
+            return get_option<size_t>("nT") > 0 or get_option<size_t>("nN") > 0;
         }
 
         /// \returns the global population [m^{-2}]
@@ -84,6 +121,12 @@ class SBPOptions : public Options
         }
 };
 
+static void run_batch(const SBPOptions &opt,
+                      const arma::vec  &E,
+                      double            m,
+                      double            alpha,
+                      double            V);
+
 auto main(int argc,char *argv[]) -> int
 {
     SBPOptions opt(argc, argv);
@@ -99,13 +142,16 @@ auto main(int argc,char *argv[]) -> int
     // Read energies from file
     std::ostringstream Efile;
     Efile << "E" << p << ".r";
-    arma::uvec idx;
-    arma::vec  E;
-    read_table(Efile.str().c_str(), idx, E);
-    E*=e/1000; // Rescale to J
+    const auto E = Eigenstate::read_energies_from_file(Efile.str(), 1000.0/e, true); // [J]
 
     const auto nst = E.size();
 
+    if(opt.batch())
+    {
+        run_batch(opt, E, m, alpha, V);
+        return EXIT_SUCCESS;
+    }
+
     arma::vec Ef(nst); // Fermi energies for each subband [J]
     arma::vec N(nst); // Population of each subband [m^{-2}]
 
@@ -126,6 +172,7 @@ auto main(int argc,char *argv[]) -> int
     else
     {
         // reads subband populations file
+        arma::uvec idx;
         read_table("N.r", idx, N);
 
         if(N.size() != nst) {
@@ -207,4 +254,184 @@ static auto calc_dist(const double       Emin,
     write_table(filename_stream.str(), E, f);
     return find_pop(Emin, Ef, m, T,alpha,V);
 }
+
+/**
+ * \brief Find Fermi energies for a grid of global populations and temperatures
+ *
+ * \param[in] opt   User options
+ * \param[in] E     Subband minima [J]
+ * \param[in] m     Effective mass at band edge [kg]
+ * \param[in] alpha Nonparabolicity [1/J]
+ * \param[in] V     Band edge [J]
+ *
+ * \details The temperature is swept if --nT is nonzero; otherwise the value of --Te
+ *          is used.  The global population is swept if --nN is nonzero; otherwise
+ *          the value of --global-population is used if given.
+ *
+ *          If there is a global population, the system is assumed to be in
+ *          equilibrium at each grid point.  Each row of the output file then contains
+ *          the global population [m^{-2}], temperature [K], global Fermi energy [meV]
+ *          and the population of each subband [m^{-2}].  This is the same layout as
+ *          the batch file from qwwad_population_init.
+ *
+ *          Otherwise, the subband populations are read from file, and each row contains
+ *          the temperature [K] followed by the quasi-Fermi energy of each subband [meV].
+ *
+ *          The temperature varies fastest, and the rows for each global population are
+ *          followed by a blank line.
+ */
+static void run_batch(const SBPOptions &opt,
+                      const arma::vec  &E,
+                      const double      m,
+                      const double      alpha,
+                      const double      V)
+{
+    const auto nst = E.size();
+    const auto nE  = opt.get_option<size_t>("nenergy");
+    const auto nT_opt = opt.get_option<size_t>("nT");
+    const auto nN_opt = opt.get_option<size_t>("nN");
+
+    const auto T = (nT_opt > 0) ? make_sample_range(opt.get_option<double>("Tmin"),
+                                                    opt.get_option<double>("Tmax"),
+                                                    nT_opt)
+                                : arma::vec{opt.get_option<double>("Te")};
+    const auto nT = T.size();
+
+    // Global populations [m^{-2}]. If there are none, use a single dummy value
+    // so that each temperature has one grid point.
+    const bool equilibrium = (nN_opt > 0) or opt.equilibrium();
+    arma::vec N_global = arma::zeros(1);
+
+    if(nN_opt > 0) {
+        N_global = make_sample_range(opt.get_option<double>("Nmin"),
+                                     opt.get_option<double>("Nmax"),
+                                     nN_opt,
+                                     opt.get_option<bool>("logN"));
+    } else if(equilibrium) {
+        N_global.fill(opt.get_global_pop());
+    }
+
+    const auto nN   = N_global.size();
+    const auto npts = nN*nT;
+
+    // Flatten the grid, with temperature varying fastest
+    const arma::vec T_pts = arma::repmat(T, nN, 1);
+    const arma::vec N_pts = arma::vectorise(arma::repmat(N_global.t(), nT, 1));
+
+    // Quasi-Fermi energy [J] and population [m^{-2}] of each subband at each grid point
+    arma::mat Ef(npts, nst);
+    arma::mat N(npts, nst);
+
+    if(equilibrium)
+    {
+        const arma::vec Ef_global = find_fermi_global(E, m, N_pts, T_pts, alpha, V);
+
+        for(unsigned int ist = 0; ist < nst; ++ist)
+        {
+            Ef.col(ist) = Ef_global;
+            N.col(ist)  = find_pop(E(ist), Ef_global, m, T_pts, alpha, V);
+        }
+    }
+    else
+    {
+        arma::uvec idx;
+        arma::vec  N_sb;
+        read_table("N.r", idx, N_sb);
+
+        if(N_sb.size() != nst)
+        {
+            std::ostringstream oss;
+            oss << "Populations file, N.r contains data for " << N_sb.size() << " states but "
+                << nst << " energies were found";
+            throw std::length_error(oss.str());
+        }
+
+        // Use the same closed-form solution as for a single run, which
+        // also copes with empty subbands
+        for(unsigned int ist = 0; ist < nst; ++ist)
+        {
+            for(unsigned int ipt = 0; ipt < npts; ++ipt) {
+                Ef(ipt, ist) = find_fermi(E(ist), m, N_sb(ist), T_pts(ipt), alpha, V);
+            }
+
+            N.col(ist).fill(N_sb(ist));
+        }
+    }
+
+    const auto batchfile = opt.get_option<std::string>("batchfile");
+    std::ofstream stream(batchfile);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << batchfile;
+        throw std::runtime_error(oss.str());
+    }
+
+    stream << std::setprecision(12) << std::scientific;
+
+    for(unsigned int ipt = 0; ipt < npts; ++ipt)
+    {
+        if(equilibrium)
+        {
+            stream << N_pts(ipt) << "\t" << T_pts(ipt) << "\t" << Ef(ipt, 0)*1000.0/e;
+
+            for(unsigned int ist = 0; ist < nst; ++ist) {
+                stream << "\t" << N(ipt, ist);
+            }
+        }
+        else
+        {
+            stream << T_pts(ipt);
+
+            for(unsigned int ist = 0; ist < nst; ++ist) {
+                stream << "\t" << Ef(ipt, ist)*1000.0/e;
+            }
+        }
+
+        stream << std::endl;
+
+        if((ipt+1) % nT == 0) {
+            stream << std::endl;
+        }
+    }
+
+    // Output the occupation function for every subband at every grid point
+    if(opt.get_option<bool>("fd"))
+    {
+        const auto fdfile = opt.get_option<std::string>("fdbatchfile");
+        std::ofstream fdstream(fdfile);
+
+        if(!fdstream.is_open())
+        {
+            std::ostringstream oss;
+            oss << "Could not open " << fdfile;
+            throw std::runtime_error(oss.str());
+        }
+
+        fdstream << std::setprecision(12) << std::scientific;
+
+        for(unsigned int ipt = 0; ipt < npts; ++ipt)
+        {
+            for(unsigned int ist = 0; ist < nst; ++ist)
+            {
+                // Use the same energy range as for a single run
+                auto Emax = Ef(ipt, ist) + 10*kB*T_pts(ipt);
+
+                if(Emax < E(ist)) {
+                    Emax = E(ist) + 10*kB*T_pts(ipt);
+                }
+
+                const arma::vec E_samples = arma::linspace(E(ist), Emax, nE);
+                const arma::vec f = f_FD(Ef(ipt, ist), E_samples, T_pts(ipt));
+
+                for(unsigned int iE = 0; iE < nE; ++iE) {
+                    fdstream << E_samples(iE)*1000.0/e << "\t" << f(iE) << std::endl;
+                }
+
+                fdstream << std::endl;
+            }
+        }
+    }
+}
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
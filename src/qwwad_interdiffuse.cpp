@@ -0,0 +1,151 @@
+/**
+ * \file    qwwad_interdiffuse.cpp
+ * \brief   Interdiffusion of group-III species in an In(1-x-y)Al(x)Ga(y)As structure
+ * \author  Alex Valavanis <a.valavanis@leeds.ac.uk>
+ *
+ * \details Anneals an In(1-x-y)Al(x)Ga(y)As heterostructure, in which the
+ *          Al and Ga fractions diffuse together on the group-III sublattice
+ *          and In makes up the balance.  At each requested anneal time,
+ *          the band-edge potential is found from the material library and the
+ *          Schroedinger equation is solved directly, without writing any
+ *          intermediate files.
+ *
+ *  Input files:
+ *    x.r           as-grown alloy profile: z [m], Al fraction, Ga fraction
+ *
+ *  Output files:
+ *    E-anneal.r    energy of each state [meV] versus anneal time [s]
+ *    X.r           final alloy profile
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "qwwad/band-edge-model.h"
+#include "qwwad/file-io.h"
+#include "qwwad/interdiffusion.h"
+#include "qwwad/material.h"
+#include "qwwad/material-library.h"
+#include "qwwad/options.h"
+#include "qwwad/schroedinger-solver-tridiagonal.h"
+
+using namespace QWWAD;
+
+/**
+ * Handler for command-line options
+ */
+class InterdiffuseOptions : public Options
+{
+    public:
+        InterdiffuseOptions(int argc, char** argv)
+        {
+            add_option<double>     ("DAl",               1.0, "Diffusion coefficient of Al [Angstrom^2/s]");
+            add_option<double>     ("DGa",               1.0, "Diffusion coefficient of Ga [Angstrom^2/s]");
+            add_option<double>     ("DAlGa",             0.0, "Cross-diffusion of Al due to Ga gradient [Angstrom^2/s]");
+            add_option<double>     ("DGaAl",             0.0, "Cross-diffusion of Ga due to Al gradient [Angstrom^2/s]");
+            add_option<double>     ("time,t",            1.0, "Longest anneal time [s]");
+            add_option<size_t>     ("ntime,n",            11, "Number of anneal times (equally spaced from zero)");
+            add_option<double>     ("dt,d",              0.1, "Largest time-step [s]");
+            add_option<char>       ("particle,p",        'e', "Particle to be used: 'e', 'h' or 'l'");
+            add_option<std::string>("material,M",  "inalgaas", "Alloy system from the material library, with Al and Ga "
+                                                               "as the first and second alloy components");
+            add_option<std::string>("materiallibrary",      "", "Material library file (default: installed library)");
+            add_option<size_t>     ("nst,N",               1, "Number of states to find");
+            add_option<std::string>("alloyfile",       "x.r", "File from which as-grown alloy profile is read");
+            add_option<std::string>("energyfile", "E-anneal.r", "File to which energies versus anneal time are written");
+            add_option<std::string>("outfile",         "X.r", "File to which final alloy profile is written");
+
+            std::string doc("Find the states in an In(1-x-y)Al(x)Ga(y)As structure after interdiffusion");
+
+            add_prog_specific_options_and_parse(argc, argv, doc);
+
+            if(get_option<size_t>("ntime") < 1) {
+                throw std::domain_error("At least one anneal time is needed");
+            }
+
+            if(get_option<double>("dt") <= 0) {
+                throw std::domain_error("Time-step must be positive");
+            }
+        }
+};
+
+auto main(int argc, char *argv[]) -> int
+{
+    const InterdiffuseOptions opt(argc, argv);
+
+    const auto p     = opt.get_option<char>("particle");
+    const auto nst   = opt.get_option<size_t>("nst");
+    const auto t_max = opt.get_option<double>("time");
+    const auto nt    = opt.get_option<size_t>("ntime");
+
+    arma::vec z; // Spatial location [m]
+    arma::vec x; // Al fraction
+    arma::vec y; // Ga fraction
+    read_table(opt.get_option<std::string>("alloyfile"), z, x, y);
+
+    // Diffusion matrix for (Al, Ga) [m^2/s]
+    arma::mat D(2,2);
+    D(0,0) = opt.get_option<double>("DAl");
+    D(0,1) = opt.get_option<double>("DAlGa");
+    D(1,0) = opt.get_option<double>("DGaAl");
+    D(1,1) = opt.get_option<double>("DGa");
+    D *= 1e-20;
+
+    const MaterialLibrary library(opt.get_option<std::string>("materiallibrary"));
+    const auto *material = library.get_material(Glib::ustring(opt.get_option<std::string>("material")));
+    const BandEdgeModel model(*material);
+
+    if(model.get_particles().find(p) == std::string::npos)
+    {
+        std::ostringstream oss;
+        oss << "Data not defined for particle " << p << " in " << material->get_description();
+        throw std::domain_error(oss.str());
+    }
+
+    Interdiffusion diffusion(z, arma::join_rows(x, y), D);
+    diffusion.set_max_step(opt.get_option<double>("dt"));
+
+    const auto energyfile = opt.get_option<std::string>("energyfile");
+    std::ofstream stream(energyfile);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << energyfile;
+        throw std::runtime_error(oss.str());
+    }
+
+    stream << std::setprecision(12) << std::scientific;
+
+    arma::mat c; // Alloy profile at current time
+
+    for(unsigned int it = 0; it < nt; ++it)
+    {
+        const double t = (nt > 1) ? t_max*it/(nt-1) : t_max;
+        diffusion.advance(t);
+
+        c = diffusion.get_profile();
+        const auto prof = model.get_profiles(c);
+
+        SchroedingerSolverTridiag se(prof.m.at(p), prof.V.at(p), z, nst);
+        const auto states = se.get_solutions(true);
+
+        if(opt.get_verbose()) {
+            std::cout << "t = " << t << " s: found " << states.size() << " states" << std::endl;
+        }
+
+        stream << t;
+
+        for(const auto &state : states) {
+            stream << "\t" << state.get_energy();
+        }
+
+        stream << std::endl;
+    }
+
+    write_table(opt.get_option<std::string>("outfile"), z, arma::vec(c.col(0)), arma::vec(c.col(1)));
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -33,6 +33,8 @@ class MatLibOptions : public Options
                 add_option<std::string>("material",        "Name of material to look up.");
                 add_option<bool>       ("show-unit,u",     "Show the unit for the property rather than just its value");
                 add_option<double>     ("variable,x",   0, "Optional input parameter for properties of the form y=f(x)");
+                add_option<double>     ("variable2,y",  0, "Optional second input parameter, for properties of "
+                                                           "quaternary alloys");
                 add_option<bool>       ("list-properties", "List all known property names for material, and then exit");
 
                 make_option_positional("material");
@@ -120,7 +122,8 @@ auto main(int argc, char* argv[]) -> int
         const auto * const numeric_property = dynamic_cast<MaterialPropertyNumeric const *>(prop);
 
         const auto x = opt.get_option<double>("variable");
-        std::cout << numeric_property->get_val(x);
+        const auto y = opt.get_option<double>("variable2");
+        std::cout << numeric_property->get_val(x, y);
 
         if(opt.get_option<bool>("show-unit")) {
             std::cout << " " << numeric_property->get_unit();
@@ -12,10 +12,19 @@
  *         input file, and then outputs tables of alloy fraction and
  *         doping density at each point in the structure, using a 
  *         user-specified spatial profile.
+ *
+ *         If an alloy system is specified, the band-edge parameters
+ *         are also found directly from the material library, in the
+ *         same way as qwwad_ef_band_edge, but evaluated only once for
+ *         each layer.
  */
 
 #include <iostream>
+#include "qwwad/band-edge-model.h"
+#include "qwwad/constants.h"
 #include "qwwad/file-io.h"
+#include "qwwad/material.h"
+#include "qwwad/material-library.h"
 #include "qwwad/mesh.h"
 #include "qwwad/options.h"
 
@@ -79,6 +88,15 @@ MeshOptions::MeshOptions(int argc, char** argv)
     add_option<std::string>("interfacesfile,f", "interfaces.r", "Filename to which interface locations are written.");
     add_option<std::string>("alloyfile,x",      "x.r",          "Filename to which alloy profile is written.");
     add_option<std::string>("dopingfile,d",     "d.r",          "Filename to which doping profile is written.");
+    add_option<std::string>("material,M",                       "Alloy system from the material library (e.g., \"gaalas\"). "
+                                                                "If specified, band-edge parameters are also written, "
+                                                                "as for qwwad_ef_band_edge.");
+    add_option<std::string>("materiallibrary",  "",             "Material library file (default: installed library)");
+    add_option<char>       ("particle",         'e',            "Particle for band-edge parameters: 'e', 'h' or 'l'");
+    add_option<double>     ("mass,m",                           "Set a constant effective-mass across the structure "
+                                                                "(relative to free electron).");
+    add_option<std::string>("bandedgepotentialfile", "v_b.r",   "Filename to which band-edge potential is written.");
+    add_option<std::string>("dcpermittivityfile",    "eps_dc.r", "Filename to which dc permittivity is written.");
 
     add_prog_specific_options_and_parse(argc, argv, description);
 
@@ -107,6 +125,54 @@ void MeshOptions::print() const
     std::cout << std::endl;
 }
 
+/**
+ * \brief Find and write the band-edge parameters for the mesh
+ *
+ * \param[in] opt  Program options
+ * \param[in] mesh The heterostructure mesh
+ */
+static void write_band_edge(const MeshOptions &opt,
+                            const Mesh        &mesh)
+{
+    using constants::me;
+
+    const auto p = opt.get_option<char>("particle");
+
+    const MaterialLibrary library(opt.get_option<std::string>("materiallibrary"));
+    const auto *material = library.get_material(Glib::ustring(opt.get_option<std::string>("material")));
+    const BandEdgeModel model(*material);
+
+    if(model.get_particles().find(p) == std::string::npos)
+    {
+        std::ostringstream oss;
+        oss << "Data not defined for particle " << p << " in " << material->get_description();
+        throw std::domain_error(oss.str());
+    }
+
+    if(mesh.get_n_alloy() < model.get_n_alloy())
+    {
+        std::ostringstream oss;
+        oss << material->get_description() << " needs " << model.get_n_alloy()
+            << " alloy components, but the structure only has " << mesh.get_n_alloy();
+        throw std::length_error(oss.str());
+    }
+
+    if(!model.has_potential(p)) {
+        std::cerr << "Warning: Potential data not defined for particle " << p << " in " << material->get_description() << std::endl;
+    }
+
+    const auto prof = model.get_profiles(mesh);
+    const auto      z_array = mesh.get_z();
+    const arma::vec z(&z_array[0], z_array.size());
+
+    const auto m_const = opt.get_argument_known("mass") ? opt.get_option<double>("mass")*me : 0.0;
+
+    write_band_edge_profiles(z, prof, p,
+                             opt.get_option<std::string>("bandedgepotentialfile"),
+                             opt.get_option<std::string>("dcpermittivityfile"),
+                             m_const);
+}
+
 auto main(int argc, char* argv[]) -> int
 {
     // Read command-line options
@@ -158,6 +224,11 @@ auto main(int argc, char* argv[]) -> int
     }
 
     write_table(opt.get_option<std::string>("dopingfile").c_str(), het->get_z(), het->get_n3D_array());
+
+    if(opt.get_argument_known("material")) {
+        write_band_edge(opt, *het);
+    }
+
     delete het;
 
     return EXIT_SUCCESS;
@@ -14,8 +14,11 @@
 #include <cmath>
 #include <string>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include "qwwad/constants.h"
+#include "qwwad/eigenstate.h"
 #include "qwwad/maths-helpers.h"
 #include "qwwad/file-io.h"
 #include "qwwad/fermi.h"
@@ -54,6 +57,17 @@ DensityinputOptions::DensityinputOptions(int argc, char** argv)
     add_option<size_t>     ("nval",                1,  "Split population between a number of equivalent valleys");
     add_option<std::string>("type",           "even",  "Type of carrier distribution across states. Permitted "
                                                        "options are: fermi, ground or even");
+    add_option<double>     ("Tmin",              100,  "Lowest temperature for batch-mode thermal distribution [K]");
+    add_option<double>     ("Tmax",              100,  "Highest temperature for batch-mode thermal distribution [K]");
+    add_option<size_t>     ("nT",                  0,  "Number of temperatures for batch-mode thermal distribution. "
+                                                       "If nonzero, the populations are found at each temperature "
+                                                       "and written to the batch file");
+    add_option<double>     ("Nmin",             1e15,  "Lowest sheet density for batch-mode thermal distribution [m^{-2}]");
+    add_option<double>     ("Nmax",             1e15,  "Highest sheet density for batch-mode thermal distribution [m^{-2}]");
+    add_option<size_t>     ("nN",                  0,  "Number of sheet densities for batch-mode thermal distribution. "
+                                                       "If zero, the sheet density is found from the doping profile");
+    add_option<bool>       ("logN",                    "Use logarithmic spacing for sheet densities in batch mode");
+    add_option<std::string>("batchfile", "N-batch.r",  "Set filename to which batch-mode populations are written");
 
     add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -82,6 +96,90 @@ DensityinputOptions::DensityinputOptions(int argc, char** argv)
             exit(EXIT_FAILURE);
         }
     }
+
+    if(get_option<size_t>("nN") > 0 and
+       (get_option<double>("Nmin") <= 0.0 or get_option<double>("Nmax") < get_option<double>("Nmin")))
+    {
+        std::ostringstream oss;
+        oss << "Batch-mode sheet densities must be positive, with Nmax >= Nmin. Got Nmin = "
+            << get_option<double>("Nmin") << " m^{-2} and Nmax = " << get_option<double>("Nmax") << " m^{-2}.";
+        throw std::domain_error(oss.str());
+    }
+}
+
+/**
+ * \brief Write thermal distributions over a grid of sheet densities and temperatures
+ *
+ * \param[in] opt User options
+ * \param[in] E   Energies of subband minima [J]
+ * \param[in] n2D Sheet doping found from the doping profile [m^{-2}]
+ *
+ * \details Each row of the batch file contains the sheet density [m^{-2}], temperature [K],
+ *          Fermi energy [meV] and the population of each subband [m^{-2}].  The rows for
+ *          each sheet density are followed by a blank line.
+ */
+static void write_batch(const DensityinputOptions &opt,
+                        const arma::vec           &E,
+                        const double               n2D)
+{
+    const auto _md  = opt.get_option<double>("mass") * me; // Density-of-states mass [kg]
+    const auto nval = opt.get_option<size_t>("nval");
+
+    const auto nT_opt = opt.get_option<size_t>("nT");
+    const auto nN_opt = opt.get_option<size_t>("nN");
+
+    const auto T_sweep = (nT_opt > 0) ? make_sample_range(opt.get_option<double>("Tmin"),
+                                                          opt.get_option<double>("Tmax"),
+                                                          nT_opt)
+                                      : arma::vec{opt.get_option<double>("Te")};
+
+    const auto N_sweep = (nN_opt > 0) ? make_sample_range(opt.get_option<double>("Nmin"),
+                                                          opt.get_option<double>("Nmax"),
+                                                          nN_opt,
+                                                          opt.get_option<bool>("logN"))
+                                      : arma::vec{n2D};
+
+    const auto nT  = T_sweep.size();
+    const auto nN  = N_sweep.size();
+    const auto nst = E.size();
+
+    // Solve for the whole grid together, with temperature varying fastest
+    const arma::vec T_batch = arma::repmat(T_sweep, nN, 1);
+    const arma::vec N_batch = arma::vectorise(arma::repmat(N_sweep.t(), nT, 1));
+    const arma::vec Ef_batch = find_fermi_global(E, _md, N_batch, T_batch);
+
+    arma::mat pop_batch(nN*nT, nst);
+
+    for(unsigned int i=0; i<nst; i++) {
+        pop_batch.col(i) = find_pop(E[i], Ef_batch, _md, T_batch) / nval;
+    }
+
+    const auto batchfile = opt.get_option<std::string>("batchfile");
+    std::ofstream stream(batchfile);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << batchfile;
+        throw std::runtime_error(oss.str());
+    }
+
+    stream << std::setprecision(12) << std::scientific;
+
+    for(unsigned int ib=0; ib<nN*nT; ib++)
+    {
+        stream << N_batch[ib] << "\t" << T_batch[ib] << "\t" << Ef_batch[ib]*1000/e;
+
+        for(unsigned int i=0; i<nst; i++) {
+            stream << "\t" << pop_batch(ib, i);
+        }
+
+        stream << std::endl;
+
+        if((ib+1) % nT == 0) {
+            stream << std::endl;
+        }
+    }
 }
 
 auto main(int argc, char *argv[]) -> int
@@ -98,10 +196,16 @@ auto main(int argc, char *argv[]) -> int
     const double dz  = z[1] - z[0];  // Spatial step [m]
     const double n2D = trapz(d,dz); // Sheet doping [m^{-2}]
 
-    arma::uvec _inx; // State indices
-    arma::vec E;          // Energies of subband minima [J]
-    read_table(opt.get_option<std::string>("energyfile").c_str(), _inx, E);
-    E *= e/1000; // Rescale to J
+    // Energies of subband minima [J]
+    const auto E = Eigenstate::read_energies_from_file(opt.get_option<std::string>("energyfile"), 1000.0/e, true);
+
+    // In batch mode, only the batch file is written
+    if(opt.get_dist_type() == DIST_FERMI and
+       (opt.get_option<size_t>("nT") > 0 or opt.get_option<size_t>("nN") > 0))
+    {
+        write_batch(opt, E, n2D);
+        return EXIT_SUCCESS;
+    }
 
     const size_t nst = E.size();    // Number of subbands
     arma::vec pop(nst); // Population of each subband
@@ -119,7 +223,7 @@ auto main(int argc, char *argv[]) -> int
         case DIST_FERMI:
             {
                 const auto _md = opt.get_option<double>("mass") * me; // Density-of-states mass [kg]
-                const auto T   = opt.get_option<double>("temperature");
+                const auto T   = opt.get_option<double>("Te");
 
                 // Fermi energy for entire system [J]
                 double Ef = find_fermi_global(E, _md, n2D, T);
@@ -4,15 +4,22 @@
 
    This program sums the charge densities over a selected number
    of bands, for a user defined cuboid at a specified resolution 
-   from the eigenvectors generated by pplb.c.  Written only for the 
-   zone center (k=0) at present.
+   from the eigenvectors generated by pplb.c, at any one of the wave
+   vectors in the eigenvector file (k=0 by default).  Both spin
+   components are included if the file was written by pplbso.c.
 
    Input files:
-               a_nk.r       expansion coefficients of eigenvectors
+              ank.bin       expansion coefficients of eigenvectors
+                            (see BandStore)
                   G.r       reciprocal lattice vectors
 
+   The wave function for each band is found on a periodic grid by a
+   single 3D FFT of its plane-wave coefficients, and the grid is then
+   sampled over the cuboid.
+
    Output files:
-                cd.r		charge density grid
+                cd.vtk		charge density grid (legacy VTK format,
+				positions in units of A0)
 
 
    Paul Harrison, March 1995  
@@ -24,46 +31,49 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <gsl/gsl_math.h>
+#include "qwwad/band-store.h"
 #include "qwwad/maths-helpers.h"
 #include "qwwad/constants.h"
 #include "qwwad/ppff.h"
 
-static arma::cx_vec read_ank(const int  N,
-                             int       *Nn);
+using namespace QWWAD;
+using namespace constants;
+
+static arma::uword find_period(const arma::rowvec &g);
+
+static void write_vtk(const arma::cube &cd,
+                      const double      x_min,
+                      const double      y_min,
+                      const double      z_min,
+                      const int         n_xyz);
 
 int main(int argc,char *argv[])
 {
-std::complex<double> psi;    	/* the wave function psi_nk(r)			*/
 double A0;		/* Lattice constant			       	*/
-double Gdotr;		/* G.r						*/
-double Omega;           /* normalisation constant                       */
-double psi_sqr;         /* charge density                               */
 double x_min;           /*             -+                               */
 double x_max;           /*              |                               */
 double y_min;           /*               \    spatial extent            */
 double y_max;           /*               /    of cuboid                 */
 double z_min;           /*              |                               */
 double z_max;           /*             -+                               */
-unsigned int	iG;		/* index over G vectors                         */
-int	in;		/* index over bands                             */
-int	ix;		/* index along x-axis                           */
-int	iy;		/* index along y-axis                           */
-int	iz;		/* index along z-axis                           */
-int	Nn;		/* number of bands in eigenvector file		*/
+int	ik;		/* index of wave vector in eigenvector file	*/
 int	n_min;          /* lowest band in summation			*/
 int	n_max;		/* highest band in summation		 	*/
 int	n_xyz;          /* number of points per lattice constant        */
-FILE	*Fcd;           /* pointer to charge density file, cd.r         */
-FILE	*Fcdx;          /* pointer to x coordinates file, cdx.r         */
-FILE	*Fcdy;          /* pointer to y coordinates file, cdy.r         */
-FILE	*Fcdz;		/* pointer to z coordinates file, cdz.r         */
-arma::vec r;		/* position                                     */
 
 /* default values	*/
 
 A0=5.65e-10;
 n_xyz=20;
+ik=0;
 n_min=0;
 n_max=3;
 x_min=0;
@@ -83,6 +93,9 @@ while((argc>1)&&(argv[1][0]=='-'))
   case 'N':
 	   n_xyz=atoi(argv[2]);
 	   break;
+  case 'k':
+	   ik=atoi(argv[2]);
+	   break;
   case 'n':
            n_min=atoi(argv[2])-1;         /* Note -1=>top VB=4, CB=5 */
            break;
@@ -112,7 +125,8 @@ while((argc>1)&&(argv[1][0]=='-'))
 	   printf("            [-y # (\033[1m0\033[0mA0)][-Y # (\033[1m0\033[0mA0)]     extent of charge\n");
 	   printf("            [-z # (\033[1m0\033[0mA0)][-Z # (\033[1m1\033[0mA0)]     density cuboid\n");
 	   printf("            [-N # points per A0 \033[1m20\033[0m]\n");
-	   printf("            [-n # lowest band \033[1m1\033[0m][-m highest band \033[1m4\033[0m], lowest band in ank file=1\n");
+	   printf("            [-n # lowest band \033[1m1\033[0m][-m highest band \033[1m4\033[0m], top VB=4, CB=5\n");
+	   printf("            [-k # index of wave vector in ank.bin \033[1m0\033[0m]\n");
 	   printf("            [-A Lattice constant (\033[1m5.65\033[0mAngstrom)]\n");
 	   exit(0);
  }
@@ -122,77 +136,129 @@ while((argc>1)&&(argv[1][0]=='-'))
  argc--;
 }
 
-Omega=1.0;
-
 std::vector<arma::vec> G=read_rlv(A0);	/* read in reciprocal lattice vectors	*/
 size_t	N = G.size();		/* number of reciprocal lattice vectors		*/
-auto ank=read_ank(N,&Nn); // real coefficients of eigenvectors
+const BandStore store("ank.bin"); // map eigenvectors into memory
+
+/* Spin-orbit calculations store a spin-up and a spin-down coefficient
+   for each reciprocal lattice vector */
+if(store.get_n_basis() != N && store.get_n_basis() != 2*N)
+{
+    std::ostringstream oss;
+    oss << "Eigenvectors in ank.bin have " << store.get_n_basis()
+        << " coefficients, but G.r contains " << N << " reciprocal lattice vectors";
+    throw std::runtime_error(oss.str());
+}
 
-/* Check number of eigenvectors in file is greater than or equal to number
-   required for summation						*/
+const size_t n_spin = store.get_n_basis()/N;
 
-if((n_max-n_min+1)>Nn)
+/* Check that the eigenvector file contains all the bands in the summation */
+if(!store.has_band_index())
 {
-	fprintf(stderr,"Incorrect number of states in `ank.r'!\n");
-	exit(EXIT_FAILURE);
+    throw std::runtime_error("ank.bin was written by the matrix-free solver, and holds the states "
+                             "closest to a reference energy rather than a known set of bands. "
+                             "Use qwwad_pp_large_basis without --matrixfree to find the charge density");
 }
 
-/* Open file for charge density */
+const int band_min = store.get_band_min();
+const int band_max = band_min + static_cast<int>(store.get_n_bands()) - 1;
 
-Fcd=fopen("cd.r","w");
+if(n_min<band_min || n_min>n_max || n_max>band_max)
+{
+    std::ostringstream oss;
+    oss << "Cannot sum over bands " << n_min+1 << " to " << n_max+1
+        << ". ank.bin contains bands " << band_min+1 << " to " << band_max+1;
+    throw std::runtime_error(oss.str());
+}
 
-for(ix=0;ix<=(x_max-x_min)*n_xyz;ix++)		/* index along x-axis */
+if(ik<0 || static_cast<size_t>(ik)>=store.get_n_k())
 {
- r(0) = (x_min+(float)ix/(float)n_xyz)*A0;
- for(iy=0;iy<=(y_max-y_min)*n_xyz;iy++)		/* index along y-axis */
- {
-  r(1) =(y_min+(float)iy/(float)n_xyz)*A0;
-  for(iz=0;iz<=(z_max-z_min)*n_xyz;iz++)	/* index along z-axis */
-  {
-   r(2) =(z_min+(float)iz/(float)n_xyz)*A0;
-   psi_sqr=0;
-   for(in=n_min;in<=n_max;in++)			/* sum over bands */
-   {
-    /* Calculate psi_nk(r)	*/
-    psi=0;
-    for(iG=0;iG<N;iG++)				/* sum over G */
-    {
-     Gdotr = dot(G[iG], r);
-     psi += ank[iG*Nn+in] * exp(std::complex<double>(0.0, Gdotr));
-    }
-    const double psi_abs = abs(psi);
-    psi_sqr += psi_abs*psi_abs / Omega;
-   }
-   fprintf(Fcd,"%le\n",psi_sqr);
-  }
- }
+    std::ostringstream oss;
+    oss << "Cannot use wave vector " << ik << ". ank.bin contains "
+        << store.get_n_k() << " wave vectors";
+    throw std::runtime_error(oss.str());
 }
 
-fclose(Fcd);	/* Close charge density file	*/
+const auto ank = store.get_coefficients(ik); // coefficients of eigenvectors, one band per column
 
-/* now regenerate positions r for writing to file */
+// Reciprocal lattice vectors in units of 2pi/A0, one per column
+arma::mat g(3,N);
 
-/* Open files for spatial co-ordinates */
+for(unsigned int iG=0;iG<N;iG++)
+    g.col(iG) = G[iG]*A0/(2*pi);
 
-Fcdx=fopen("cd-x.r","w");Fcdy=fopen("cd-y.r","w");Fcdz=fopen("cd-z.r","w");
+// Each G is a multiple of 2pi/(L A0) along each axis, so psi is periodic
+// over L lattice constants.  Sampling n_xyz points per lattice constant then
+// gives exactly a discrete Fourier transform over L*n_xyz points.
+std::array<arma::uword, 3> n_grid; // FFT grid size along each axis
+arma::umat grid_index(3,N);        // Position of each G in the FFT grid
 
-for(ix=0;ix<=(x_max-x_min)*n_xyz;ix++)      /* index along x-axis */
+for(unsigned int c=0;c<3;c++)
 {
- r(0) = (x_min+(float)ix/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdx,"%6.3f\n",r(0));
-}
-for(iy=0;iy<=(y_max-y_min)*n_xyz;iy++)      /* index along x-axis */
-{
- r(1) = (y_min+(float)iy/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdy,"%6.3f\n",r(1));
+    const auto L = find_period(g.row(c));
+    n_grid[c] = L*n_xyz;
+
+    for(unsigned int iG=0;iG<N;iG++)
+    {
+        const auto m = std::lround(g(c,iG)*L);
+        grid_index(c,iG) = ((m % (long)n_grid[c]) + n_grid[c]) % n_grid[c];
+    }
 }
-for(iz=0;iz<=(z_max-z_min)*n_xyz;iz++)      /* index along x-axis */
+
+// Shift the origin of the grid to the corner of the cuboid
+const arma::vec r_min = {x_min, y_min, z_min};
+arma::cx_vec phase(N);
+
+for(unsigned int iG=0;iG<N;iG++)
+    phase(iG) = std::polar(1.0, 2*pi*dot(g.col(iG), r_min));
+
+arma::cube cd_grid(n_grid[0], n_grid[1], n_grid[2], arma::fill::zeros);
+
+/* sum over bands */
+#pragma omp parallel
 {
- r(2) =(z_min+(float)iz/(float)n_xyz);        /* this time in units of A0 */
- fprintf(Fcdz,"%6.3f\n",r(2));
+    arma::cx_cube psi(n_grid[0], n_grid[1], n_grid[2]); // the wave function psi_nk(r)
+    arma::cube cd_local(n_grid[0], n_grid[1], n_grid[2], arma::fill::zeros);
+
+#pragma omp for schedule(dynamic)
+    for(int in=n_min;in<=n_max;in++)
+    {
+        // The factor exp(ik.r) has unit magnitude, so it is left out
+        for(size_t is=0;is<n_spin;is++)
+        {
+            psi.zeros();
+
+            // Vectors outside the grid are aliased onto it, which gives the same
+            // samples as the direct sum
+            for(unsigned int iG=0;iG<N;iG++)
+                psi(grid_index(0,iG), grid_index(1,iG), grid_index(2,iG)) += ank(is*N+iG, in-band_min)*phase(iG);
+
+            fft3(psi, true);
+            cd_local += arma::square(arma::abs(psi));
+        }
+    }
+
+#pragma omp critical
+    cd_grid += cd_local;
 }
 
-fclose(Fcdx);fclose(Fcdy);fclose(Fcdz);
+// Undo the normalisation of the inverse transform
+cd_grid *= gsl_pow_2(n_grid[0]*n_grid[1]*n_grid[2]);
+
+/* Sample the periodic grid over the cuboid */
+
+const arma::uword n_x = floor((x_max-x_min)*n_xyz + 1e-9) + 1;
+const arma::uword n_y = floor((y_max-y_min)*n_xyz + 1e-9) + 1;
+const arma::uword n_z = floor((z_max-z_min)*n_xyz + 1e-9) + 1;
+
+arma::cube cd(n_x, n_y, n_z);
+
+for(arma::uword iz=0;iz<n_z;iz++)
+    for(arma::uword iy=0;iy<n_y;iy++)
+        for(arma::uword ix=0;ix<n_x;ix++)
+            cd(ix,iy,iz) = cd_grid(ix % n_grid[0], iy % n_grid[1], iz % n_grid[2]);
+
+write_vtk(cd, x_min, y_min, z_min, n_xyz);
 
 return EXIT_SUCCESS;
 }/* end main */
@@ -203,60 +269,80 @@ return EXIT_SUCCESS;
 
 
 /**
- * Reads the eigenvectors (a_nk(G)) from the file a_nk.r
- * created by the code pplb.c into the array a_nk[N][Nn]
+ * \brief Find the period of the wave functions along an axis
+ *
+ * \param[in] g Component of each reciprocal lattice vector [2pi/A0]
  *
- * \param[in] N  The number of terms in each eigenvector
- * \param     Nn The number of bands in file
+ * \returns The smallest number of lattice constants, L, for which every
+ *          component is a multiple of 1/L
  */
-static arma::cx_vec read_ank(const int  N,
-                             int       *Nn)
+static arma::uword find_period(const arma::rowvec &g)
 {
- int	in;		/* index across bands				*/
- int	iG;		/* index across G vectors			*/
- int	n;		/* counter for number of elements in file	*/
- FILE   *Fank;		/* file pointer to eigenvectors file		*/
-
-if((Fank=fopen("ank.r","r"))==0)
-{
- fprintf(stderr,"Cannot open input file 'ank.r'!\n");
- exit(EXIT_FAILURE);
-}
-
-/* Deduce number of complexes in file and hence number of bands	*/
-
-n=0;
-while(fscanf(Fank,"%*f %*f")!=EOF)
- n++;
-rewind(Fank);
-
-/* The number of bands Nn is therefore the total number of elements divided
-   by the number of terms in each eigenvector				*/
-
-*Nn=n/N;
+    const arma::uword L_max = 1000;
 
-/* Allocate memory for eigenvectors	*/
-
-arma::cx_vec ank(n);
+    for(arma::uword L=1;L<=L_max;L++)
+    {
+        const arma::rowvec m = g*L;
 
-/* Finally read eigenvectors into structure	*/
+        if(arma::all(arma::abs(m - arma::round(m)) < 1e-6))
+            return L;
+    }
 
-for(iG=0;iG<N;iG++)
- for(in=0;in<*Nn;in++)
- {
-  double re, im;
-  int n_read = fscanf(Fank,"%lf %lf",&re,&im);
-  if(n_read != 2)
-  {
-    fprintf(stderr, "Data missing in ank.r");
-    exit(EXIT_FAILURE);
-  }
-
-  ank[iG*(*Nn)+in] = std::complex<double>(re, im);
- }
+    std::ostringstream oss;
+    oss << "Reciprocal lattice vectors in G.r do not describe a supercell of up to "
+        << L_max << " lattice constants";
+    throw std::runtime_error(oss.str());
+}
 
-fclose(Fank);
+/**
+ * \brief Write the charge density to a legacy VTK file, cd.vtk
+ *
+ * \param[in] cd    Charge density at each point in the cuboid
+ * \param[in] x_min Position of the first point in the cuboid [A0]
+ * \param[in] y_min Position of the first point in the cuboid [A0]
+ * \param[in] z_min Position of the first point in the cuboid [A0]
+ * \param[in] n_xyz Number of points per lattice constant
+ *
+ * \details The data is written in the binary (big-endian) form of the
+ *          format, with the x-index varying fastest.
+ */
+static void write_vtk(const arma::cube &cd,
+                      const double      x_min,
+                      const double      y_min,
+                      const double      z_min,
+                      const int         n_xyz)
+{
+    std::ofstream stream("cd.vtk", std::ios::binary);
+
+    if(!stream.is_open())
+        throw std::runtime_error("Could not open cd.vtk");
+
+    stream << "# vtk DataFile Version 3.0\n"
+           << "Pseudopotential charge density\n"
+           << "BINARY\n"
+           << "DATASET STRUCTURED_POINTS\n"
+           << "DIMENSIONS " << cd.n_rows << " " << cd.n_cols << " " << cd.n_slices << "\n"
+           << "ORIGIN " << x_min << " " << y_min << " " << z_min << "\n"
+           << "SPACING " << 1.0/n_xyz << " " << 1.0/n_xyz << " " << 1.0/n_xyz << "\n"
+           << "POINT_DATA " << cd.n_elem << "\n"
+           << "SCALARS charge_density double 1\n"
+           << "LOOKUP_TABLE default\n";
+
+    // Armadillo stores cubes with the first index varying fastest, which is
+    // the order VTK expects, so only the byte order needs changing
+    const uint16_t one = 1;
+    const bool little_endian = (*reinterpret_cast<const char *>(&one) == 1);
+
+    std::vector<char> buffer(cd.n_elem*sizeof(double));
+    std::memcpy(buffer.data(), cd.memptr(), buffer.size());
+
+    if(little_endian)
+    {
+        for(size_t i=0;i<cd.n_elem;i++)
+            std::reverse(buffer.begin()+i*sizeof(double), buffer.begin()+(i+1)*sizeof(double));
+    }
 
-return(ank);
+    stream.write(buffer.data(), buffer.size());
+    stream << "\n";
 }
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -6,18 +6,35 @@
  *
  * \details This program performs a PseudoPotential Large Basis calculation
  *          on a user-defined cell, the atomic species of which are defined
- *          in the file atoms.xyz (XYZ format file).
+ *          in the file atoms.xyz (XYZ format file), or in a binary supercell
+ *          file written by qwwad_cs_zinc_blende (see --atoms).
  *
  *          Note this code is written for clarity of understanding and not
- *          solely computational speed.  
+ *          solely computational speed.  However, only the output bands are
+ *          found by default, and k-points are shared between OpenMP threads.
+ *          Each thread needs its own copy of the Hamiltonian, so set
+ *          OMP_NUM_THREADS to limit memory use for large bases.
+ *
+ *          For very large supercells, the --matrixfree option applies the
+ *          Hamiltonian with FFTs instead of forming it, and finds only the
+ *          --nstates states closest to --Eref using a folded-spectrum solver.
+ *          This needs O(N) memory, and can include spin-orbit coupling.
+ *          The band indices of these states are unknown, so the ank.bin file
+ *          that it writes can't be used by qwwad_pp_charge_density.
+ *
+ *          With --kpath, the wave vectors in k.r are the corners of a path.
+ *          The matrix-free solver is restarted from the states at each point
+ *          on the path, bands are tracked through crossings by the overlap
+ *          of their eigenvectors, and extra points are added where the bands
+ *          curve sharply.  The results are written to Ek-path.r.
  *
  *          Input files:
- *		atoms.xyz	atomic species and positions
+ *		atoms.xyz	atomic species and positions (XYZ or binary)
  *		G.r		reciprocal lattice vectors
  *		k.r		electron wave vectors (k)
  *
  *          Output files:
- *		ank.r		eigenvectors	
+ *		ank.bin		eigenvalues and eigenvectors for all k (see BandStore)
  *		Ek?.r		eigenenergies for each k
  */
 
@@ -26,6 +43,7 @@
 #endif
 
 #include <complex>
+#include <memory>
 #include <valarray>
 #include <cstdio>
 #include <cstdlib>
@@ -36,12 +54,17 @@
 
 #include "struct.h"
 #include "maths.h"
+#include "qwwad/band-store.h"
+#include "qwwad/band-tracker.h"
 #include "qwwad/constants.h"
 #include "qwwad/linear-algebra.h"
 #include "qwwad/options.h"
+#include "qwwad/plane-wave-hamiltonian.h"
 #include "qwwad/ppff.h"
 #include "qwwad/file-io.h"
 #include "qwwad/pplb-functions.h"
+#include "qwwad/pseudopotential-table.h"
+#include "qwwad/supercell.h"
 
 using namespace QWWAD;
 using namespace constants;
@@ -53,15 +76,222 @@ Options configure_options(int argc, char* argv[])
     std::string doc("Large-basis pseudopotential calculation for user-defined cell");
 
     opt.add_option<double>("latticeconst,A", 5.65, "Lattice constant [angstrom]");
+    opt.add_option<std::string>("atoms", "atoms.xyz", "File containing atomic species and positions, in "
+                                                      "XYZ or binary supercell format");
     opt.add_option<size_t>("nmin,n",            4, "Lowest output band index (VB = 4, CB = 5)");
     opt.add_option<size_t>("nmax,m",            5, "Highest output band index (VB = 4, CB = 5)");
-    opt.add_option<bool>  ("printev,w",            "Print eigenvectors to file");
+    opt.add_option<bool>  ("printev,w",            "Write eigenvalues and eigenvectors to ank.bin");
+    opt.add_option<bool>  ("fullspectrum",         "Find all eigenstates at each k-point, rather than only the "
+                                                    "output bands");
+    opt.add_option<bool>  ("matrixfree",           "Apply the Hamiltonian using FFTs rather than forming the "
+                                                    "matrix, and find the states closest to a reference energy. "
+                                                    "This is needed for very large supercells");
+    opt.add_option<double>("Eref",              0, "Reference energy for the matrix-free solver [eV]. This "
+                                                    "should lie within the band gap");
+    opt.add_option<size_t>("nstates",           8, "Number of states to find with the matrix-free solver");
+    opt.add_option<double>("tolerance",       0.1, "Largest residual for states found by the matrix-free "
+                                                    "solver [meV]");
+    opt.add_option<bool>  ("spinorbit",            "Include spin-orbit coupling in the matrix-free solver");
+    opt.add_option<bool>  ("kpath",                "Treat the wave vectors in k.r as the corners of a path, and "
+                                                    "track the bands found by the matrix-free solver along it");
+    opt.add_option<size_t>("nsteps",           10, "Initial number of steps along each segment of the k-path");
+    opt.add_option<double>("pathtolerance",   1.0, "Largest deviation of a band from a straight line before a "
+                                                    "step along the k-path is bisected [meV]");
+
+    add_rlv_options(opt);
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
     return opt;
 }
 
+/**
+ * \brief Find the states closest to a reference energy at a wave vector
+ *
+ * \param[in,out] H     Matrix-free Hamiltonian
+ * \param[in]     k     Wave vector [1/m]
+ * \param[in]     E_ref Reference energy [J]
+ * \param[in]     nst   Number of states to find
+ * \param[in]     tol   Largest acceptable residual [J]
+ * \param[out]    E     Energy of each state [J]
+ * \param[in,out] ank   Eigenvectors.  If the size is correct on input, this
+ *                      is used as the starting guess.
+ */
+static void find_states(PlaneWaveHamiltonian &H,
+                        const arma::vec      &k,
+                        const double          E_ref,
+                        const size_t          nst,
+                        const double          tol,
+                        arma::vec            &E,
+                        arma::cx_mat         &ank)
+{
+    H.set_k(k);
+
+    // Teter-style preconditioner for the folded operator, which damps
+    // plane waves with kinetic energy well away from the reference
+    const double E_scale = h*c*Rinf;
+    const arma::vec dT = H.get_kinetic_energy() + H.get_mean_potential() - E_ref;
+    const arma::vec precond = 1.0/(arma::square(dT) + E_scale*E_scale);
+
+    const auto apply_H = [&H](const arma::cx_mat &X) {return H.apply(X);};
+    eig_folded(E, ank, apply_H, precond, E_ref, nst, tol);
+}
+
+/**
+ * \brief Find the states closest to a reference energy without forming H_GG'
+ *
+ * \param[in] opt      User options
+ * \param[in] A0       Lattice constant [m]
+ * \param[in] m_per_au Unit conversion factor [m/a.u.]
+ * \param[in] cell     Atomic basis
+ * \param[in] G        Reciprocal lattice vectors [1/m]
+ * \param[in] k        Wave vectors [1/m]
+ *
+ * \details Each thread handles a contiguous block of k-points, and the states
+ *          found at each k-point are used as the starting guess for the next.
+ */
+static void solve_matrix_free(const Options                &opt,
+                              const double                  A0,
+                              const double                  m_per_au,
+                              const Supercell              &cell,
+                              const std::vector<arma::vec> &G,
+                              const std::vector<arma::vec> &k)
+{
+    const auto nst   = opt.get_option<size_t>("nstates");
+    const auto E_ref = opt.get_option<double>("Eref") * e;
+    const auto tol   = opt.get_option<double>("tolerance") * e * MILLI;
+    const auto ev    = opt.get_option<bool>("printev");
+    const auto nk    = k.size();
+
+    const PlaneWaveHamiltonian H(A0, m_per_au, cell, G, opt.get_option<bool>("spinorbit"));
+
+    if(opt.get_verbose())
+    {
+        const auto &n_grid = H.get_grid_size();
+        std::cout << "Matrix-free Hamiltonian: " << H.get_n_basis() << " basis functions; "
+                  << n_grid[0] << "x" << n_grid[1] << "x" << n_grid[2] << " real-space grid" << std::endl;
+    }
+
+    std::unique_ptr<BandStore::Writer> store; // Output file for eigenvectors
+
+    if(ev) {
+        // The folded-spectrum solver doesn't find how many bands lie below
+        // the output states, so their band indices are unknown
+        store = std::make_unique<BandStore::Writer>("ank.bin", H.get_n_basis(), G.size(), nst,
+                                                    BandStore::unknown_band, k);
+    }
+
+    std::string error; // Message from the first failed k-point (if any)
+
+#pragma omp parallel
+    {
+        auto H_k = H;     // Hamiltonian at the current k-point (shares the potential with H)
+        arma::cx_mat ank; // Coefficients of eigenvectors (reused as the next guess)
+        arma::vec    E;   // Energy eigenvalues
+
+#pragma omp for schedule(static)
+        for(unsigned int ik = 0; ik < nk; ++ik)
+        {
+            try {
+                find_states(H_k, k[ik], E_ref, nst, tol, E, ank);
+
+                if(opt.get_verbose())
+                {
+#pragma omp critical
+                    std::cout << "Found " << nst << " states at k = " << k[ik].t()
+                              << " (" << ik + 1 << "/" << nk << ")" << std::endl;
+                }
+
+                std::ostringstream filenameE;
+                filenameE << "Ek" << ik << ".r";
+                FILE *FEk=fopen(filenameE.str().c_str(),"w");
+
+                for(unsigned int iE = 0; iE < nst; ++iE)
+                    fprintf(FEk,"%10.6f\n",E(iE)/e);
+
+                fclose(FEk);
+
+                if(ev){
+                    store->write(ik, E, ank);
+                }
+            } catch(std::exception &ex) {
+#pragma omp critical
+                if(error.empty()) {
+                    error = ex.what();
+                }
+            }
+        }
+    }
+
+    if(!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    if(ev) {
+        store->close();
+    }
+}
+
+/**
+ * \brief Track the states closest to a reference energy along a path in k-space
+ *
+ * \param[in] opt      User options
+ * \param[in] A0       Lattice constant [m]
+ * \param[in] m_per_au Unit conversion factor [m/a.u.]
+ * \param[in] cell     Atomic basis
+ * \param[in] G        Reciprocal lattice vectors [1/m]
+ * \param[in] vertices Wave vectors at the corners of the path [1/m]
+ *
+ * \details The states at each k-point start the solver at the next one, and
+ *          keep their labels through band crossings.  The results are
+ *          written to Ek-path.r, with the distance along the path and the
+ *          wave vector [2pi/A0] followed by the energy of each band [eV].
+ */
+static void solve_k_path(const Options                &opt,
+                         const double                  A0,
+                         const double                  m_per_au,
+                         const Supercell              &cell,
+                         const std::vector<arma::vec> &G,
+                         const std::vector<arma::vec> &vertices)
+{
+    const auto nst   = opt.get_option<size_t>("nstates");
+    const auto E_ref = opt.get_option<double>("Eref") * e;
+    const auto tol   = opt.get_option<double>("tolerance") * e * MILLI;
+    const auto E_tol = opt.get_option<double>("pathtolerance") * e * MILLI;
+
+    PlaneWaveHamiltonian H(A0, m_per_au, cell, G, opt.get_option<bool>("spinorbit"));
+
+    BandTracker tracker([&](const arma::vec &k, arma::vec &E, arma::cx_mat &ank) {
+                            find_states(H, k, E_ref, nst, tol, E, ank);
+                        }, E_tol);
+
+    tracker.trace(vertices, opt.get_option<size_t>("nsteps"));
+
+    const auto &k = tracker.get_k();
+    const auto &s = tracker.get_path_length();
+    const auto &E = tracker.get_energies();
+
+    if(opt.get_verbose()) {
+        std::cout << "Tracked " << nst << " bands through " << k.size() << " k-points using "
+                  << tracker.get_n_solves() << " solutions" << std::endl;
+    }
+
+    FILE *FEk=fopen("Ek-path.r","w");
+
+    for(unsigned int ik = 0; ik < k.size(); ++ik)
+    {
+        const arma::vec k_unit = k[ik]*A0/(2.0*pi);
+        fprintf(FEk,"%10.6f %10.6f %10.6f %10.6f", s[ik]*A0/(2.0*pi), k_unit(0), k_unit(1), k_unit(2));
+
+        for(unsigned int iE = 0; iE < nst; ++iE)
+            fprintf(FEk," %10.6f",E(ik,iE)/e);
+
+        fprintf(FEk,"\n");
+    }
+
+    fclose(FEk);
+}
+
 int main(int argc,char *argv[])
 {
     const auto opt = configure_options(argc, argv);
@@ -70,6 +300,7 @@ int main(int argc,char *argv[])
     const auto n_min = opt.get_option<size_t>("nmin")-1;               // Lowest output band
     const auto n_max = opt.get_option<size_t>("nmax")-1;               // Highest output band
     const auto ev    = opt.get_option<bool>  ("printev");              // Print eigenvectors?
+    const auto full  = opt.get_option<bool>  ("fullspectrum");         // Find all eigenstates?
 
     // Read desired wave vector points from file
     std::valarray<double> kx;
@@ -89,72 +320,128 @@ int main(int argc,char *argv[])
         k[ik] *= 2.0*pi/A0;
     }
 
-    std::string filename("atoms.xyz");
-    auto const atoms = read_atoms(filename.c_str());		/* read in atomic basis	*/
+    const auto cell = Supercell::read(opt.get_option<std::string>("atoms")); // read in atomic basis
 
-    const auto G = read_rlv(A0); // read in reciprocal lattice vectors
+    const auto G = get_rlv(opt, A0); // read or generate reciprocal lattice vectors
     const auto N = G.size(); // number of reciprocal lattice vectors
 
     const auto m_per_au = 4.0*pi*eps0*hBar*hBar/(e*e*me); // Unit conversion factor, m/a.u
 
-    // Compute crystal potential matrix. Note that this is independent of wave-vector
-    // so we only need to do this once.
-    arma::cx_mat V_GG(N,N);
-
-    for(unsigned int i=0;i<N;i++)        /* index down rows */
+    if(opt.get_option<bool>("kpath"))
     {
-        // Fill in the upper triangle of the matrix
-        for(unsigned int j=i;j<N;j++)
-        {
-            const auto q = G[i] - G[j];
-            V_GG(i,j) = V(A0,m_per_au,atoms,q);
-
-            // Fill in the lower triangle by taking the Hermitian transpose of the elements
-            V_GG(j,i) = conj(V_GG(i,j));
-        }
+        solve_k_path(opt, A0, m_per_au, cell, G, k);
+        return EXIT_SUCCESS;
     }
 
-    /* Add diagonal elements to matrix H_GG' */
-    for(unsigned int ik = 0; ik < nk; ++ik)
+    if(opt.get_option<bool>("matrixfree"))
     {
-        if(opt.get_verbose())
-            std::cout << "Calculating energy at k = " << std::endl
-                << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
+        solve_matrix_free(opt, A0, m_per_au, cell, G, k);
+        return EXIT_SUCCESS;
+    }
 
-        // Construct the complete Hamiltonian matrix now, using crystal potential and
-        // kinetic energy on the diagonals
-        auto H_GG = V_GG;
+    if(opt.get_option<bool>("spinorbit")) {
+        throw std::domain_error("Spin-orbit coupling is only available with the matrix-free solver. "
+                                "Use qwwad_pp_large_basis_so for a dense calculation.");
+    }
 
-        for(unsigned int i=0;i<N;i++)
-        {
-            // kinetic energy component of H_GG [QWWAD3, 15.77]
-            arma::vec G_plus_k = G[i] + k[ik];
-            const double G_plus_k_sq = dot(G_plus_k, G_plus_k);
-            std::complex<double> T_GG=hBar*hBar/(2*me) * G_plus_k_sq;
-            H_GG(i,i) += T_GG;
-        }
+    // Compute crystal potential matrix. Note that this is independent of wave-vector
+    // so we only need to do this once.
+    const PseudopotentialTable table(A0, m_per_au, cell, G);
+    const auto V_GG = table.get_matrix();
 
-        // Find the eigenvalues & eigenvectors of the Hamiltonian matrix
-        arma::vec E(N); // Energy eigenvalues
-        arma::cx_mat ank(N,N); // coefficients of eigenvectors
-        arma::eig_sym(E, ank, H_GG);
+    if(n_min > n_max || n_max >= N)
+    {
+        std::ostringstream oss;
+        oss << "Cannot output bands " << n_min+1 << " to " << n_max+1 << " using "
+            << N << " reciprocal lattice vectors";
+        throw std::domain_error(oss.str());
+    }
 
-        /* Output eigenvalues in a separate file for each k point */
-        char	filenameE[9];	/* character string for Energy output filename	*/
-        sprintf(filenameE,"Ek%i.r",ik);
-        FILE *FEk=fopen(filenameE,"w");
+    std::unique_ptr<BandStore::Writer> store; // Output file for eigenvectors
 
-        for(auto iE=n_min; iE<=n_max; iE++)
-            fprintf(FEk,"%10.6f\n",E(iE)/e);
+    if(ev) {
+        store = std::make_unique<BandStore::Writer>("ank.bin", N, N, n_max-n_min+1, n_min, k);
+    }
 
-        fclose(FEk);
+    // Each k-point is independent, so they are shared between threads.  Each
+    // thread keeps its own Hamiltonian buffer, since the eigensolver overwrites it.
+    std::string error;    // Message from the first failed k-point (if any)
 
-        /* Output eigenvectors */
+#pragma omp parallel
+    {
+        arma::cx_mat H_GG; // Complete Hamiltonian matrix
+        arma::vec    E;    // Energy eigenvalues
+        arma::cx_mat ank;  // coefficients of eigenvectors
 
-        if(ev){
-            write_ank(ank,ik,N,n_min,n_max);
+#pragma omp for schedule(dynamic)
+        for(unsigned int ik = 0; ik < nk; ++ik)
+        {
+            try {
+                if(opt.get_verbose())
+                {
+#pragma omp critical
+                    std::cout << "Calculating energy at k = " << std::endl
+                        << k[ik] << " (" << ik + 1 << "/" << nk << ")" << std::endl;
+                }
+
+                // Construct the complete Hamiltonian matrix now, using crystal potential and
+                // kinetic energy on the diagonals
+                H_GG = V_GG;
+
+                for(unsigned int i=0;i<N;i++)
+                {
+                    // kinetic energy component of H_GG [QWWAD3, 15.77]
+                    arma::vec G_plus_k = G[i] + k[ik];
+                    const double G_plus_k_sq = dot(G_plus_k, G_plus_k);
+                    std::complex<double> T_GG=hBar*hBar/(2*me) * G_plus_k_sq;
+                    H_GG(i,i) += T_GG;
+                }
+
+                // Find the eigenvalues & eigenvectors of the Hamiltonian matrix.
+                // Unless requested, only the output bands are found, so that
+                // band i is stored at index i - i_first
+                size_t i_first = n_min;
+
+                if(full) {
+                    arma::eig_sym(E, ank, H_GG);
+                    i_first = 0;
+                } else {
+                    eig_sym_range(E, ank, H_GG, n_min, n_max);
+                }
+
+                /* Output eigenvalues in a separate file for each k point */
+                std::ostringstream filenameE;
+                filenameE << "Ek" << ik << ".r";
+                FILE *FEk=fopen(filenameE.str().c_str(),"w");
+
+                for(auto iE=n_min; iE<=n_max; iE++)
+                    fprintf(FEk,"%10.6f\n",E(iE-i_first)/e);
+
+                fclose(FEk);
+
+                /* Output eigenvectors */
+
+                if(ev){
+                    store->write(ik,
+                                 E.subvec(n_min-i_first, n_max-i_first),
+                                 ank.cols(n_min-i_first, n_max-i_first));
+                }
+            } catch(std::exception &ex) {
+#pragma omp critical
+                if(error.empty()) {
+                    error = ex.what();
+                }
+            }
         }
-    }/* end while*/
+    }
+
+    if(!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    if(ev) {
+        store->close();
+    }
 
     return EXIT_SUCCESS;
 }/* end main */
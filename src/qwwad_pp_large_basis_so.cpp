@@ -9,12 +9,12 @@
    solely computational speed.  
 
    Input files:
-		atoms.xyz	atomic species and positions
+		atoms.xyz	atomic species and positions (XYZ or binary)
 		G.r		reciprocal lattice vectors
 		k.r		electron wave vectors (k)
 
    Output files:
-		ank.r		eigenvectors	
+		ank.bin		eigenvalues and eigenvectors for all k (see BandStore)
 		Ek?.r		eigenenergies for each k
 
 
@@ -30,25 +30,71 @@
 #include <cstdlib>
 #include <cmath>
 #include <complex>
+#include <memory>
 #include "struct.h"
 #include "maths.h"
+#include "qwwad/band-store.h"
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
 #include "qwwad/options.h"
 #include "qwwad/ppff.h"	/* the PseudoPotential Form Factors	*/
 #include "qwwad/pplb-functions.h"
-#include "qwwad/ppsop.h"	/* the Spin-Orbit Parameters		*/
+#include "qwwad/pseudopotential-table.h"
+#include "qwwad/supercell.h"
 
 using namespace QWWAD;
 using namespace constants;
 
-std::complex<double>
-Vso(const std::vector<atom>      &atoms,
-    const std::vector<arma::vec> &G,
-    arma::vec const              &k,
-    const unsigned int            i,
-    const unsigned int            j,
-    const size_t                  N);
+/**
+ * \brief Add the spin-orbit components to H_GG
+ *
+ * \param[in,out] H_GG      Hamiltonian matrix (2N x 2N)
+ * \param[in]     Lambda_GG k-independent part of the spin-orbit potential (N x N) [J]
+ * \param[in]     G_plus_k  Each column is a vector G+k [1/m]
+ *
+ * \details The element for each pair of plane waves is
+ *          -i Lambda_GG' (G+k)x(G'+k).sigma [QWWAD3, 15.81], and the Pauli
+ *          matrices give a different combination of the cross-product
+ *          components in each of the four spin blocks.  The cross product is
+ *          formed inline, so the kernel makes no allocations.
+ */
+static void add_spin_orbit(arma::cx_mat       &H_GG,
+                           const arma::cx_mat &Lambda_GG,
+                           const arma::mat    &G_plus_k)
+{
+    const arma::uword N = Lambda_GG.n_rows;
+    const std::complex<double> I(0,1);
+
+#pragma omp parallel for schedule(static)
+    for(arma::uword j = 0; j < N; ++j)
+    {
+        const double * const b = G_plus_k.colptr(j);
+        const std::complex<double> * const Lambda = Lambda_GG.colptr(j);
+
+        // Columns of each block of H_GG
+        std::complex<double> * const H_up_up     = H_GG.colptr(j);
+        std::complex<double> * const H_down_up   = H_up_up + N;
+        std::complex<double> * const H_up_down   = H_GG.colptr(j+N);
+        std::complex<double> * const H_down_down = H_up_down + N;
+
+        for(arma::uword i = 0; i < N; ++i)
+        {
+            const double * const a = G_plus_k.colptr(i);
+
+            // (G+k)x(G'+k)
+            const double A_x = a[1]*b[2] - a[2]*b[1];
+            const double A_y = a[2]*b[0] - a[0]*b[2];
+            const double A_z = a[0]*b[1] - a[1]*b[0];
+
+            const auto v = -I*Lambda[i];
+
+            H_up_up[i]     += v*A_z;
+            H_up_down[i]   += v*std::complex<double>(A_x, -A_y);
+            H_down_up[i]   += v*std::complex<double>(A_x,  A_y);
+            H_down_down[i] -= v*A_z;
+        }
+    }
+}
 
 Options configure_options(int argc, char* argv[])
 {
@@ -57,9 +103,13 @@ Options configure_options(int argc, char* argv[])
     std::string doc("Large-basis pseudopotential calculation for user-defined cell");
 
     opt.add_option<double>("latticeconst,A", 5.65, "Lattice constant [angstrom]");
+    opt.add_option<std::string>("atoms", "atoms.xyz", "File containing atomic species and positions, in "
+                                                      "XYZ or binary supercell format");
     opt.add_option<size_t>("nmin,n",            4, "Lowest output band index (VB = 4, CB = 5)");
     opt.add_option<size_t>("nmax,m",            5, "Highest output band index (VB = 4, CB = 5)");
-    opt.add_option<bool>  ("printev,w",            "Print eigenvectors to file");
+    opt.add_option<bool>  ("printev,w",            "Write eigenvalues and eigenvectors to ank.bin");
+
+    add_rlv_options(opt);
 
     opt.add_prog_specific_options_and_parse(argc, argv, doc);
 
@@ -93,10 +143,9 @@ int main(int argc,char *argv[])
         k[ik] *= 2.0*pi/A0;
     }
 
-    std::string filename("atoms.xyz");
-    const auto atoms = read_atoms(filename.c_str()); // read in atomic basis
+    const auto cell = Supercell::read(opt.get_option<std::string>("atoms")); // read in atomic basis
 
-    const auto G  = read_rlv(A0); // read in reciprocal lattice vectors
+    const auto G  = get_rlv(opt, A0); // read or generate reciprocal lattice vectors
     const auto N  = G.size(); // number of reciprocal lattice vectors
     const auto Ns = 2*N;      // order of H_GG with spin (2*N)
 
@@ -104,22 +153,22 @@ int main(int argc,char *argv[])
 
     // Compute crystal potential matrix. Note that this is independent of wave-vector
     // so we only need to do this once.
-    arma::cx_mat V_GG(Ns,Ns);
+    const PseudopotentialTable table(A0, m_per_au, cell, G);
+    const auto V_block = table.get_matrix();
 
-    for(unsigned int i=0;i<N;i++) // index down rows within Block 1 and 2 of matrix
-    {
-        // Create upper triangle of Block 1
-        for(unsigned int j=i; j<N; j++)
-        {
-            const auto q = G[i] - G[j];
-            V_GG(i,j) = V(A0,m_per_au,atoms,q);
+    // The crystal potential is independent of spin, so it only couples plane
+    // waves with the same spin.  This matches the matrix-free Hamiltonian.
+    const arma::cx_mat V_GG = arma::kron(arma::eye<arma::cx_mat>(2, 2), V_block);
 
-            // Copy elements to upper triangle of all other blocks
-            V_GG(i+N, j) = V_GG(i, j+N) = V_GG(i+N, j+N) = V_GG(i,j);
+    // The spin-orbit potential only depends on G-G', so find it once
+    const auto Lambda_GG = table.get_spin_orbit_matrix();
+    arma::mat G_plus_k(3, N);
 
-            // Since matrix is Hermitian, fill in the lower triangles in all 4 blocks
-            V_GG(j, i) = V_GG(j+N, i) = V_GG(j, i+N) = V_GG(j+N, i+N) = conj(V_GG(i,j));
-        }
+    // Both spin components of each eigenvector are stored
+    std::unique_ptr<BandStore::Writer> store;
+
+    if(ev) {
+        store = std::make_unique<BandStore::Writer>("ank.bin", Ns, N, n_max-n_min+1, n_min, k);
     }
 
     /* Add k-dependent elements to matrix H_GG' */
@@ -134,21 +183,14 @@ int main(int argc,char *argv[])
         for(unsigned int i=0;i<N;i++)        /* add kinetic energy to diagonal elements */
         {
             // kinetic energy component of H_GG [QWWAD3, 15.77]
-            arma::vec G_plus_k = G[i] + k[ik];
-            const double G_plus_k_sq = dot(G_plus_k, G_plus_k);
+            G_plus_k.col(i) = G[i] + k[ik];
+            const double G_plus_k_sq = dot(G_plus_k.col(i), G_plus_k.col(i));
             std::complex<double> T_GG=hBar*hBar/(2*me) * G_plus_k_sq;
             H_GG(i, i) += T_GG; // Block 1
             H_GG(i+N, i+N) += T_GG; // Block 4
         }
 
-        /* Add spin-orbit components to lower triangle	*/
-        for(unsigned int i=0;i<Ns;i++)
-        {
-            for(unsigned int j=0;j<=i;j++)	
-            {
-                H_GG(i,j) += Vso(atoms,G,k[ik],i,j,N);
-            }
-        }
+        add_spin_orbit(H_GG, Lambda_GG, G_plus_k);
 
         // Find the eigenvalues & eigenvectors of the Hamiltonian matrix
         arma::vec E(N); // Energy eigenvalues
@@ -168,73 +210,14 @@ int main(int argc,char *argv[])
         /* Output eigenvectors */
 
         if(ev){
-            write_ank(ank,ik,N,n_min,n_max);
+            store->write(ik, E.subvec(n_min, n_max), ank.cols(n_min, n_max));
         }
     }
 
-    return EXIT_SUCCESS;
-}/* end main */
-
-/**
- * \brief Spin-orbit component of H_GG
- *
- * \param[in] atoms   atomic definitions
- * \param[in] G	      reciprocal lattice vectors
- * \param[in] k       the electron momentum
- * \param[in] i	      index
- * \param[in] j       index
- * \param[in] N       number of reciprocal lattice vectors
- */
-std::complex<double>
-Vso(const std::vector<atom>      &atoms,
-    const std::vector<arma::vec> &G,
-    arma::vec const              &k,
-    const unsigned int            i,
-    const unsigned int            j,
-    const size_t                  N)
-{
-    std::complex<double> vso = 0; // intermediate value of spin-orbit interaction
-    arma::vec q;	/* a reciprocal lattice vector, G'-G 		*/
-
-    if((i<N)&&(j<N))	/* Block 1	*/
-    {   
-        const arma::vec A = cross(G[i] + k, G[j] + k);
-        vso = A(2);
-        q = G[i] - G[j];
+    if(ev) {
+        store->close();
     }
-    if((i<N)&&(j>=N))	/* Block 2	*/
-    {
-        const arma::vec A = cross(G[i] + k, G[j-N] + k);
-        vso = std::complex<double>(A(0), -A(1));
-        q = G[i] - G[j-N];
-    }
-    if((i>=N)&&(j<N))	/* Block 3	*/
-    {
-        const arma::vec A = cross(G[i-N] + k, G[j] + k);
-        vso = std::complex<double>(A(0), A(1));
-        q = G[i-N] - G[j];
-    }
-    if((i>=N)&&(j>=N))	/* Block 4	*/
-    {
-        const arma::vec A = cross(G[i-N] + k, G[j-N] + k);
-        vso = -A(2);
-        q = G[i-N] - G[j-N];
-    }	
-    vso *= std::complex<double>(0,-1); /* -i(G'+k)x(G+k).sigma	*/
-
-    // Potential term
-    std::complex<double> v=0;				/* Initialise for sum	*/
-
-    for(auto const atom : atoms)
-    {
-        const double q_dot_t = dot(q, atom.r);
-        const auto Lambda = lambda(atom.type);
-        v += Lambda * exp(std::complex<double>(0.0,-q_dot_t)); // [QWWAD3, 15.81]
-    }
-
-    v *= vso;
-    v/=atoms.size();
 
-    return v;
-}
+    return EXIT_SUCCESS;
+}/* end main */
 // vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
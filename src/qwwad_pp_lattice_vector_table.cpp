@@ -15,91 +15,39 @@
  *                 G.r       sorted reciprocal lattice vectors
  */
 
-#include<cmath>
-#include<cstdio>
-#include<cstdlib>
-#include"struct.h"
-#include"maths.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
 
-static vector * read_rlv(int *N);
+#include <armadillo>
 
-int main()
-{
-int	i;		/* index					*/
-int	iG;		/* index over G vectors				*/
-int	N;		/* number of reciprocal lattice vectors		*/
-vector	*G;		/* reciprocal lattice vectors			*/
-vector	Gt;		/* temporary storage of G			*/
-FILE	*FG;		/* file pointer to wavefunction file		*/
+#include "qwwad/file-io.h"
 
-G=read_rlv(&N);
-
-if(system("cp G.r G.r~") != EXIT_SUCCESS)
-{
-    fprintf(stderr, "Could not copy files");
-    exit(EXIT_FAILURE);
-}
+using namespace QWWAD;
 
-/* Need to repeat N times, to allow G[0] to propogate to G[N] */
-for(i=0;i<N;i++)    
+int main()
 {
- for(iG=0;iG<N-1;iG++)                    
- {
-  if(vmod(*(G+iG))>vmod(*(G+iG+1)))
-  {
-   Gt=*(G+iG+1);
-   *(G+iG+1)=*(G+iG);
-   *(G+iG)=Gt;
-  }
- }
-}
-
-FG=fopen("G.r","w");
+    arma::vec Gx; // Components of reciprocal lattice vectors [2pi/A0]
+    arma::vec Gy;
+    arma::vec Gz;
+    read_table("G.r", Gx, Gy, Gz);
 
-for(iG=0;iG<N;iG++)                    
- fprintf(FG,"%f %f %f\n",(G+iG)->x,(G+iG)->y,(G+iG)->z);
-
-fclose(FG);
-
-free(G);
-
-return EXIT_SUCCESS;
-}/* end main */
-
-/**
- * \brief reads the reciprocal lattice vectors
- *
- * \details lattice vectors (defined in 
- *          the file G.r) are read into the array G[] and then converted
- *          into SI units
- */
-static vector * read_rlv(int *N)
-{
- int	i=0;
- vector	*G;
- FILE 	*FG;           /* file pointer to wavefunction file */
+    // Keep a copy of the original
+    write_table("G.r~", Gx, Gy, Gz);
 
- if((FG=fopen("G.r","r"))==0)
- {
-  fprintf(stderr,"Error: Cannot open input file 'G.r'!\n");
-  exit(0);
- }
+    const arma::vec G_sqr = Gx%Gx + Gy%Gy + Gz%Gz;
 
- *N=0;
- while(fscanf(FG,"%*f %*f %*f")!=EOF)
-  (*N)++;
- rewind(FG);
+    // Sort into ascending magnitude, keeping the original order for equal
+    // magnitudes
+    std::vector<arma::uword> order(G_sqr.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&G_sqr](const arma::uword i, const arma::uword j) {return G_sqr(i) < G_sqr(j);});
 
- G=(vector *)calloc(*N,sizeof(vector));
- if (G==0)  {
-  fprintf(stderr,"Cannot allocate memory!\n");
-  exit(0);
- }
+    const arma::uvec index(order);
+    write_table("G.r", arma::vec(Gx.elem(index)), arma::vec(Gy.elem(index)), arma::vec(Gz.elem(index)));
 
- while(fscanf(FG,"%lf %lf %lf",&(G+i)->x,&(G+i)->y,&(G+i)->z)!=EOF)
-  {i++;}
- 
- fclose(FG);
- 
- return(G);
+    return EXIT_SUCCESS;
 }
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
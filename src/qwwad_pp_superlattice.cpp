@@ -9,44 +9,63 @@
    calculation on a user-defined cell, the atomic species of which are defined
    in the file atoms.xyz (XYZ format file).
  
-   Note this code is written for clarity of understanding and not
-   solely computational speed.  
+   Each block of H' between a pair of bulk wave vectors is found as
+   the matrix product A'^dagger W A, where the columns of A are the bulk
+   eigenvectors and W is the perturbing potential for each pair of
+   reciprocal lattice vectors.  W only depends on G'-G, so it is
+   evaluated once for each distinct difference vector.
 
    Input files:
-		ank?.r		bulk eigenvectors a_nk(G)
-		Ek?.r		bulk eigenvalues E_nk, for each k
+		ank.bin		bulk eigenvalues E_nk, eigenvectors a_nk(G)
+				and wave vectors k (see BandStore)
 		atoms.xyz	atomic species and positions of the
 				unperturbed lattice
 		atomsp.xyz	atomic species and positions of the 
 				perturbed lattice
 		G.r		reciprocal lattice vectors
-		k.r		electron wave vectors (k)
 
    Output files:
    		Exi.r		superlattice eigenvalues E_xi
 */
 
+#include <algorithm>
 #include <cstdio>
 #include <cmath>
 #include <cstdlib>
 #include <complex>
 #include "maths.h"
+#include "qwwad/band-store.h"
 #include "qwwad/constants.h"
 #include "qwwad/file-io.h"
 #include "qwwad/linear-algebra.h"
 #include "qwwad/ppff.h"
+#include "qwwad/pseudopotential-table.h"
 
 using namespace QWWAD;
 using namespace constants;
 
 static std::complex<double> i1(0,1);
 
+/// An atom whose species is changed by the perturbation
+struct Substitution
+{
+    arma::vec    r;       ///< Position [m]
+    unsigned int is;      ///< Index of unperturbed species
+    unsigned int is_dash; ///< Index of perturbed species
+};
+
 static std::complex<double>
-V(double           A0,
-  double           m_per_au,
-  std::vector<atom> const &atoms,
-  std::vector<atom> const &atomsp,
-  arma::vec const &g);
+V(double                           A0,
+  double                           m_per_au,
+  std::vector<std::string> const  &species,
+  std::vector<Substitution> const &subs,
+  size_t                           n_atoms,
+  arma::vec const                 &g);
+
+static std::vector<Substitution>
+find_substitutions(std::vector<atom> const  &atoms,
+                   std::vector<atom> const  &atomsp,
+                   std::vector<std::string> &species);
 
 static std::complex<double>
 VF(double           A0,
@@ -55,17 +74,6 @@ VF(double           A0,
    std::vector<atom> const &atoms,
    arma::vec const &g);
 
-static std::valarray<std::complex<double>> read_ank(int N,
-                                                    int Nn,
-                                                    int Nkxi);
-
-static double * read_Enk(int Nn,
-                         int Nkxi);
-
-static int read_ank0(int N);
-
-static std::vector<arma::vec> read_kxi(double  A0);
-
 static void write_VF(double  A0,
                      double  F,
                      double  q,
@@ -75,7 +83,6 @@ static void clean_Hdash(arma::cx_mat &Hdash);
 
 int main(int argc,char *argv[])
 {
-    double	*Enk;		/* bulk energy eigenvalues			*/
     char	filename[12];	/* character string for Energy output filename	*/
 
     /* default values	*/
@@ -138,67 +145,100 @@ int main(int argc,char *argv[])
 
     auto const G = read_rlv(A0); // read in reciprocal lattice vectors
     auto const N = G.size(); // number of reciprocal lattice vectors
-    auto const Nn=read_ank0(N); /* reads a single ank.r file just to 
-                                   deduce the number of bands Nn	*/
 
-    auto const kxi = read_kxi(A0); // read in set of kxi points
-    auto const Nkxi = kxi.size();  // Number of k-points
+    // Map the bulk solutions into memory
+    const BandStore store("ank.bin");
 
-    auto const ank=read_ank(N,Nn,Nkxi);/* read in bulk eigenvectors		*/
-    Enk=read_Enk(Nn,Nkxi);	/* read in bulk eigenvalues		*/
+    if(store.get_n_basis() != N)
+    {
+        std::ostringstream oss;
+        oss << "Bulk eigenvectors in ank.bin have " << store.get_n_basis()
+            << " coefficients, but G.r contains " << N << " reciprocal lattice vectors";
+        throw std::runtime_error(oss.str());
+    }
+
+    auto const Nn   = store.get_n_bands(); // Number of bulk bands
+    auto const Nkxi = store.get_n_k();     // Number of k-points
+    auto const Enk  = store.get_energies(); // Bulk energy eigenvalues [J]
+
+    std::vector<arma::vec> kxi(Nkxi); // Bulk wave vectors [1/m]
+
+    for(unsigned int ikxi=0;ikxi<Nkxi;ikxi++) {
+        kxi[ikxi] = store.get_k(ikxi);
+    }
 
     /* Output the  Fourier Transform of the electric field	*/
 
     if(o) write_VF(A0,F,q,atoms);
 
+    std::vector<std::string> species; // Names of all species in either lattice
+    const auto subs = find_substitutions(atoms, atomsp, species);
+
+    // The potential only depends on the difference, G'-G, between plane
+    // waves, so find the distinct differences once
+    const PseudopotentialTable table(A0, m_per_au, atoms, G);
+    const auto n_q = table.get_n_q();
+    arma::umat q_index(N, N);
+
+    for(unsigned int iG=0;iG<N;iG++)
+    {
+        for(unsigned int iGdash=0;iGdash<N;iGdash++) {
+            q_index(iGdash, iG) = table.get_q_index(iGdash, iG);
+        }
+    }
+
     arma::cx_mat Hdash(Nn*Nkxi, Nn*Nkxi);
 
-    /* Create H' matrix elements	*/
-    for(unsigned int i=0;i<Nn*Nkxi;i++)	/* index down rows, recall order of Hdash is Nn*Nkxi */
+    /* Create H' matrix elements, one block of Nn x Nn for each pair of bulk
+       wave vectors.  The blocks below the diagonal follow from Hermiticity */
+#pragma omp parallel
     {
-        // TODO: Just fill in the upper triangle 
-        for(unsigned int j=0; j<N;j++)
+        arma::cx_vec w(n_q); // Potential for each distinct g-vector
+        arma::cx_mat W(N,N); // Potential for each pair of G vectors
+
+#pragma omp for schedule(dynamic)
+        for(unsigned int ikxidash=0;ikxidash<Nkxi;ikxidash++)
         {
-            /* Deduce the indices of of the bulk eigenvectors for each H' element	*/
-            auto const ikxidash=i/Nn;
-            auto const ikxi=j/Nn;
+            for(unsigned int ikxi=ikxidash;ikxi<Nkxi;ikxi++)
+            {
+                // Calculate each distinct g vector [QWWAD4, 16.38]
+                const arma::vec dk = kxi[ikxidash] - kxi[ikxi];
 
-            auto const indash=i%Nn;
-            auto const in=j%Nn;
+                for(unsigned int iq=0;iq<n_q;iq++)
+                {
+                    const arma::vec g = table.get_q(iq) + dk;
+                    w(iq) = V(A0,m_per_au,species,subs,atoms.size(),g) + VF(A0,F,q,atoms,g);
+                }
 
-            /* Initialise the matrix element before the sum and add energy
-               eigenvalues as specified by delta functions 	*/
-            if((indash==in)&&(ikxidash==ikxi))
-                Hdash(i, j) = Enk[ikxi*Nn+in];
-            else
-                Hdash(i, j) = 0;
+                for(unsigned int iG=0;iG<N;iG++)
+                {
+                    for(unsigned int iGdash=0;iGdash<N;iGdash++) {
+                        W(iGdash, iG) = w(q_index(iGdash, iG));
+                    }
+                }
 
-            for(unsigned int iGdash=0;iGdash<N;iGdash++)	/* sum over G'	*/
-            {
-                for(unsigned int iG=0;iG<N;iG++)			/* sum over G	*/
+                // Sum over G and G' for every pair of bands at once.  The
+                // bulk eigenvectors are read directly from the mapped store
+                const auto ank      = store.get_coefficients(ikxi);
+                const auto ank_dash = store.get_coefficients(ikxidash);
+                arma::cx_mat block = ank_dash.t() * W * ank;
+
+                // Add energy eigenvalues as specified by delta functions
+                if(ikxidash==ikxi)
                 {
-                    // Calculate appropriate g vector [QWWAD4, 16.38]
-                    auto g = G[iGdash] - G[iG] + kxi[ikxidash] - kxi[ikxi];
-
-                    // Add on potential term
-                    Hdash(i, j) +=
-                        (
-                         ( conj(   ank[ikxidash*N*Nn+iGdash*Nn+indash]   )
-
-                           *
-
-                           ank[ikxi*N*Nn+iG*Nn+in]
-                         )
-                         *
-                         (
-                          V(A0,m_per_au,atoms,atomsp,g) +
-                          VF(A0,F,q,atoms,g)
-                         )
-                        );
-                } /* end iG */
-            } /* end iGdash */
-        } /* end j */
-    } /* end i */
+                    for(unsigned int in=0;in<Nn;in++) {
+                        block(in,in) += Enk(in,ikxi);
+                    }
+                }
+
+                Hdash.submat(ikxidash*Nn, ikxi*Nn, arma::size(Nn,Nn)) = block;
+
+                if(ikxidash!=ikxi) {
+                    Hdash.submat(ikxi*Nn, ikxidash*Nn, arma::size(Nn,Nn)) = block.t();
+                }
+            } /* end ikxi */
+        } /* end ikxidash */
+    }
 
     // Clean up matrix H'
     clean_Hdash(Hdash);
@@ -219,8 +259,6 @@ int main(int argc,char *argv[])
     }
     fclose(FExi);
 
-    free(Enk);
-
     return EXIT_SUCCESS;
 }/* end main */
 
@@ -249,217 +287,96 @@ static void clean_Hdash(arma::cx_mat &Hdash)
 }
 
 /**
- * \brief Reads the first of the ank.r files, i.e., ank0.r, just
- *        with the purpose of deducing the number of bands included in the
- *        calculation
+ * \brief Find the atoms whose species differ between two lattices
  *
- * \param N The number of terms in each eigenvector
- */
-static int read_ank0(int N)
-{
- int	n;		/* counter for the number of elements in file	*/
- int	Nn;		/* number of bands in calculation		*/
- FILE	*Fank;		/* file pointer to eigenvectors file		*/
-
- if((Fank=fopen("ank0.r","r"))==0)
-{
- fprintf(stderr,"Error: Cannot open input file 'ank0.r'!\n");
- exit(0);
-}
-
-/* Deduce number of complexes in file and hence number of bands	*/
-
-n=0;
-while(fscanf(Fank,"%*f %*f")!=EOF)
- n++;
-
-/* The number of bands Nn is therefore the total number of elements divided
-   by the number of terms in each eigenvector				*/
-
-Nn=n/N;
-
-return(Nn);
-
-}
-
-/**
- * \brief Reads the eigenvectors (a_nk(G)) from the file a_nk.r
- *        created by the code pplb.c into the array a_nk[N][Nn]
+ * \param[in]  atoms   atomic definitions of the unperturbed lattice
+ * \param[in]  atomsp  atomic definitions of the perturbed lattice
+ * \param[out] species names of all species in either lattice
  *
- * \param N    The number of terms in each eigenvector
- * \param Nn   The number of bands in file
- * \param Nkxi number of k points in calculation
+ * \return The position and species indices of each substituted atom
  */
-static std::valarray<std::complex<double>> read_ank(int N,
-                                                    int Nn,
-                                                    int Nkxi)
+static std::vector<Substitution>
+find_substitutions(std::vector<atom> const  &atoms,
+                   std::vector<atom> const  &atomsp,
+                   std::vector<std::string> &species)
 {
-    FILE   *Fank;		/* file pointer to eigenvectors file		*/
-
-    /* Allocate memory for eigenvectors	*/
-    std::valarray<std::complex<double> > ank(N*Nn*Nkxi);
-
-    /* Finally read eigenvectors into structure	*/
-    for(int ikxi=0;ikxi<Nkxi;ikxi++)
+    if(atoms.size() != atomsp.size())
     {
-        /* Open the bulk eigenvector file at each of the bulk k (kxi) points	*/
-        std::ostringstream filename; /* eigenfunction output filename                */
-        filename << "ank" << ikxi << ".r";
-        if((Fank=fopen(filename.str().c_str(),"r"))==0)
-        {fprintf(stderr,"Error: Cannot open input file 'ank%i.r'!\n",ikxi);exit(0);}
-
-        /* Read in data	*/
-
-        // Loop over all G vectors
-        for(int iG=0;iG<N;iG++)
-        {
-            // Loop over all bands
-            for(int in=0;in<Nn;in++)
-            {
-                double temp_re=0.0;
-                double temp_im=0.0;
-                int n_read = fscanf(Fank,"%lf %lf", &temp_re, &temp_im);
-                if (n_read == 2)
-                {
-                    ank[ikxi*N*Nn+iG*Nn+in] = std::complex<double>(temp_re, temp_im);
-                }
-                else
-                {
-                    fprintf(stderr, "Could not read number.\n");
-                    exit(EXIT_FAILURE);
-                }
-            }
-        }
-
-        fclose(Fank);
+        std::ostringstream oss;
+        oss << "Perturbed lattice has " << atomsp.size() << " atoms, but the "
+            << "unperturbed lattice has " << atoms.size();
+        throw std::domain_error(oss.str());
     }
 
-    return(ank);
-}
-
-
-/**
- * \brief Reads the eigenvalues (E_nk) from the files Ek?.r
- *        created by the code pplb.c
- *
- * \param Nn   The number of bands in file
- * \param Nkxi number of k points in calculation
- */
-static double * read_Enk(int Nn,
-                         int Nkxi)
-{
-    int	in;		/* index across bands				*/
-    int	ikxi;		/* index across kxi				*/
-    double	*Enk;
-    FILE   *FEnk;		/* file pointer to eigenvectors file		*/
-
-    /* Allocate memory for eigenvalues	*/
-
-    Enk=(double *)calloc(Nn*Nkxi,sizeof(double));
-    if(Enk==0){fprintf(stderr,"Cannot allocate memory!\n");exit(0);}
+    // Find the index of a species, adding it to the list if needed
+    auto species_index = [&species](std::string const &type) -> unsigned int {
+        const auto it = std::find(species.begin(), species.end(), type);
 
-    /* Read eigenvalues into structure	*/
-
-    for(ikxi=0;ikxi<Nkxi;ikxi++)
-    {
-        /* Open the bulk eigenvalues file at each of the bulk k (kxi) points	*/
-        std::ostringstream filename; // eigenfunction output filename
-        filename << "Ek" << ikxi << ".r";
-        if((FEnk=fopen(filename.str().c_str(),"r"))==0)
-        {fprintf(stderr,"Error: Cannot open input file 'Ek%i.r'!\n",ikxi);exit(0);}
-
-        /* Read in data	*/
-
-        for(in=0;in<Nn;in++)
+        if(it == species.end())
         {
-            int n_read = fscanf(FEnk,"%lf",(Enk+ikxi*Nn+in));
-            if (n_read == 1)
-                Enk[ikxi*Nn+in] *= e;		/* convert from eV->S.I.	*/
-            else
-            {
-                fprintf(stderr, "Could not read number\n");
-                exit(EXIT_FAILURE);
-            }
+            species.push_back(type);
+            return species.size() - 1;
         }
 
-        fclose(FEnk);
-    }
+        return std::distance(species.begin(), it);
+    };
 
-    return(Enk);
-}
+    std::vector<Substitution> subs;
 
-/**
- * \brief Reads the set of electron momenta vectors kxi (defined
- *        in the file k.r---as needed to produce the bulk band structure) into the 
- *        allocated memory space accessed via the pointer kxi, then converting them
- *        from units of (2*pi/A0) into S.I.
- *
- * \param[in] A0 lattice constant
- *
- * \return array of momenta
- */
-static std::vector<arma::vec> read_kxi(double  A0)
-{
-    std::valarray<double> x;
-    std::valarray<double> y;
-    std::valarray<double> z;
-    read_table("k.r", x, y, z);
-
-    std::vector<arma::vec> k;
-    size_t N = x.size();
-    for(unsigned int i = 0; i < N; ++i)
+    for(unsigned int ia=0;ia<atoms.size();ia++)
     {
-        arma::vec temp(3);
-        temp(0) = x[i];
-        temp(1) = y[i];
-        temp(2) = z[i];
-        temp *= 2*pi/A0;
-        k.push_back(temp);
+        // Atoms that are unchanged do not contribute to the perturbation
+        if(atoms[ia].type != atomsp[ia].type) {
+            subs.push_back({atoms[ia].r,
+                            species_index(atoms[ia].type),
+                            species_index(atomsp[ia].type)});
+        }
     }
 
-    return k;
+    return subs;
 }
 
 /**
  * \brief Potential component of Hdash
  *
- * \param A0	   Lattice constant
+ * \param A0	    Lattice constant
  * \param m_per_au conversion factor from SI to a.u.
- * \param atoms    atomic definitions
- * \param atomsp   atomic definitions
+ * \param species  names of all species
+ * \param subs     atoms that are changed by the perturbation
+ * \param n_atoms  total number of atoms in the cell
  * \param g        the vector, g=G'-G+kxi'-kxi
  */
 static std::complex<double>
-V(double           A0,
-  double           m_per_au,
-  std::vector<atom> const &atoms,
-  std::vector<atom> const &atomsp,
-  arma::vec const &g)
+V(double                           A0,
+  double                           m_per_au,
+  std::vector<std::string> const  &species,
+  std::vector<Substitution> const &subs,
+  size_t                           n_atoms,
+  arma::vec const                 &g)
 {
- std::complex<double> v;     /* potential					*/
- double	vf;	/* storage for returned data from Vf()		*/
- double	vfdash;	/* storage for returned data from Vf()		*/
- v=0;
-
- // Sum over atoms [QWWAD4, 16.50]
- auto const n_atoms = atoms.size();
- for(unsigned int ia=0;ia<n_atoms;ia++)
- {
-     // general vector representing atom within cell
-     auto const t = atoms[ia].r;
-     auto const g_dot_g = arma::dot(g,g);
-     auto const g_dot_t = arma::dot(g,t);
-
-     vf=Vf(A0, m_per_au,   g_dot_g, atoms[ia].type);
-     vfdash=Vf(A0,m_per_au,g_dot_g, atomsp[ia].type);
-     v += exp(-i1*g_dot_t)*(vfdash-vf);
- }
+    auto const g_dot_g = arma::dot(g,g);
+
+    // Form factor of each species, evaluated once
+    std::vector<double> vf(species.size());
+
+    for(unsigned int is=0;is<species.size();is++) {
+        vf[is] = Vf(A0, m_per_au, g_dot_g, species[is].c_str());
+    }
+
+    std::complex<double> v = 0; // potential
+
+    // Sum over atoms [QWWAD4, 16.50]
+    for(auto const &sub : subs)
+    {
+        auto const g_dot_t = arma::dot(g,sub.r);
+        v += exp(-i1*g_dot_t)*(vf[sub.is_dash]-vf[sub.is]);
+    }
 
- /* These last divisions represent Omega_c/Omega_sl included here for
-    convenience	*/
- v/=(double)(n_atoms/2);
+    /* These last divisions represent Omega_c/Omega_sl included here for
+       convenience	*/
+    v/=(double)(n_atoms/2);
 
- return(v);
+    return(v);
 }
 
 /**
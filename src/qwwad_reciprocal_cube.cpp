@@ -20,23 +20,24 @@ where b_1= 2*pi  i   b_2= 2*pi  j , etc.
 where i, j and k are the cartesian basis vectors.  
       -  -     -
 
+The vectors are written in order of increasing magnitude.
+
 Paul Harrison, June 1996                                
 
 Paul Harrison, Modifications 1998	               */
  
 #include <stdio.h>
 #include <stdlib.h>
+#include "qwwad/reciprocal-lattice.h"
+
+using namespace QWWAD;
 
 int main(int argc, char *argv[])
 {
-double	beta_1;		/* coefficients of the reciprocal lattice vectors */
-double	beta_2;		/*  b_1, b_2 and b_3 constituting the general     */
-double	beta_3;		/*  reciprocal lattice vector G                   */
 int	n_x;		/* number fcc cells along x-axis of large basis   */
 int	n_y;		/* number fcc cells along y-axis of large basis   */
 int	n_z;		/* number fcc cells along z-axis of large basis   */
 int	G_max;		/* maximum value of |G|, e.g. [400]=>|G|=4        */
-FILE	*FG;
 
 /* default values	*/
 
@@ -70,15 +71,6 @@ while((argc>1)&&(argv[1][0]=='-'))
  argc--;
 }
 
-FG=fopen("G.r","w");
-
-for(beta_1=-G_max;beta_1<=G_max;beta_1+=1/(double)n_x)
- for(beta_2=-G_max;beta_2<=G_max;beta_2+=1/(double)n_y)
-  for(beta_3=-G_max;beta_3<=G_max;beta_3+=1/(double)n_z)
-  {
-   if(beta_1*beta_1+beta_2*beta_2+beta_3*beta_3<=(double)(G_max*G_max))
-    fprintf(FG,"%20.17lf %20.17lf %20.17lf\n",beta_1,beta_2,beta_3);
-  }
-fclose(FG);
+ReciprocalLattice::cubic_supercell(G_max, n_x, n_y, n_z).write("G.r");
 return EXIT_SUCCESS;
 }
@@ -19,24 +19,20 @@ then
                       -         -         -
 
 where i, j and k are the cartesian basis vectors.
+
+The vectors are written in order of increasing magnitude.
 */
  
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
-#include "struct.h"
-#include "maths.h"
+#include "qwwad/reciprocal-lattice.h"
+
+using namespace QWWAD;
 
 int main(int argc, char *argv[])
 {
-int beta_1;          /* coefficients of the reciprocal lattice vectors */
-int beta_2;          /*  b_1, b_2 and b_3 constituting the general     */
-int beta_3;          /*  reciprocal lattice vector G                   */
-float gamma_1;
-float gamma_2;
-float gamma_3;
 double G_max;           /* maximum value of |G|, e.g. [400]=>|G|=4        */
-FILE *FG;
 
 /* default values	*/
 
@@ -59,23 +55,7 @@ while((argc>1)&&(argv[1][0]=='-'))
  argc--;
 }
 
-
-
-
-
-FG=fopen("G.r","w");
-
-for(beta_1=-G_max;beta_1<=G_max;beta_1++)
- for(beta_2=-G_max;beta_2<=G_max;beta_2++)
-  for(beta_3=-G_max;beta_3<=G_max;beta_3++)
-  {
-   gamma_1=(float)(beta_1-beta_2+beta_3);
-   gamma_2=(float)(beta_1+beta_2-beta_3);
-   gamma_3=(float)(-beta_1+beta_2+beta_3);
-   if(round(gamma_1*gamma_1+gamma_2*gamma_2+gamma_3*gamma_3)<=G_max*G_max)
-    fprintf(FG,"%f %f %f\n",gamma_1,gamma_2,gamma_3);
-  }
-fclose(FG);
+ReciprocalLattice::fcc(G_max).write("G.r");
 
 return EXIT_SUCCESS;
 }
@@ -2,6 +2,8 @@
 # include "config.h"
 #endif
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -11,72 +13,24 @@
 #include "qwwad/material-library.h"
 #include "qwwad/debye.h"
 #include "qwwad/material-property-numeric.h"
+#include "qwwad/thermal-conductivity.h"
 #include "qwwad/maths-helpers.h"
 #include "qwwad/file-io.h"
-#include "qwwad/linear-algebra.h"
+#include "qwwad/heat-equation.h"
 #include <glibmm/ustring.h>
 
 using namespace QWWAD;
 
 /**
- * Find the thermal conductivity of a material [W/m/K]
- *
- * \param[in] mat The material system
- * \param[in] x   Alloy fraction (if applicable)
- * \param[in] T   Temperature [K]
- *
- * \todo Figure out where all these values come from!
- * \todo These values only work for a limited range of
- *       temperatures. Restrict the domain accordingly?
+ * Thermal properties of a single layer in the structure
  */
-static auto thermal_cond(const Material &mat,
-                           const double    x,
-                           const double    T) -> double
+struct ThermalLayer
 {
-    double k = 0.0;
-
-    try
-    {
-        k = mat.get_property_value("thermal-conductivity-vs-alloy", x);
-    }
-    catch(std::exception &e)
-    {
-        try
-        {
-            double k0_1  = mat.get_property_value("thermal-conductivity-0K-1");
-            double k0_2  = mat.get_property_value("thermal-conductivity-0K-2");
-            double tau_1 = mat.get_property_value("thermal-conductivity-decay-index-1");
-            double tau_2 = mat.get_property_value("thermal-conductivity-decay-index-2");
-            double k_1 = k0_1*pow(T,tau_1);
-            double k_2 = k0_2*pow(T,tau_2);
-            k = lin_interp(k_1,k_2, x);
-        }
-        catch(std::exception &e)
-        {
-            try
-            {
-                const double k0  = mat.get_property_value("thermal-conductivity-0K");
-                const double tau = mat.get_property_value("thermal-conductivity-decay-index");
-                k = k0 * pow(T,tau);
-            }
-            catch(std::exception &e)
-            {
-                try
-                {
-                    const double k_hi    = mat.get_property_value("thermal-conductivity-high-T");
-                    const double k_decay = mat.get_property_value("thermal-conductivity-inverse-T");
-                    k = k_hi + k_decay/T;
-                }
-                catch(std::exception &e)
-                {
-                    k = mat.get_property_value("thermal-conductivity-T", T);
-                }
-            }
-        }
-    }
-
-    return k;
-}
+    DebyeModel          dm;     ///< Heat-capacity model
+    ThermalConductivity k;      ///< Thermal-conductivity model
+    double              rho;    ///< Density [kg/m^3]
+    arma::uvec          points; ///< Indices of grid points inside the layer
+};
 
 class Thermal1DOptions: public Options
 {
@@ -110,6 +64,15 @@ Thermal1DOptions::Thermal1DOptions(int argc, char ** argv)
     add_option<double>     ("frequency,f",               10, "Pulse repetition rate [kHz]");
     add_option<double>     ("power,P",                17.65, "Pulse power [W]");
     add_option<size_t>     ("nrep",                       1, "Number of pulse periods to simulate");
+    add_option<size_t>     ("steps-per-period",        1000, "Number of time steps in each pulse period");
+    add_option<bool>       ("steady-state",                  "Start from the periodic steady-state temperature "
+                                                             "profile, rather than from the heatsink temperature");
+    add_option<double>     ("ss-tolerance",            1e-6, "Largest change in temperature over a period at "
+                                                             "which the steady state is considered to be found [K]");
+    add_option<size_t>     ("ss-max-iter",              200, "Maximum number of periods to use when finding the "
+                                                             "steady state");
+    add_option<bool>       ("adaptive",                      "Use short time steps just after each pulse edge, "
+                                                             "and longer steps elsewhere");
 
     add_prog_specific_options_and_parse(argc,argv,doc);
 
@@ -157,6 +120,16 @@ Thermal1DOptions::Thermal1DOptions(int argc, char ** argv)
         throw std::domain_error(oss.str());
     }
 
+    // Check that the pulse spans at least one time step
+    const auto nt_per = get_option<size_t>("steps-per-period");
+    if(nt_per == 0 or nt_per*dc < 1.0)
+    {
+        std::ostringstream oss;
+        oss << "Too few time steps per period (" << nt_per << ") to resolve a "
+            << get_duty_cycle()*100 << "% duty cycle.";
+        throw std::domain_error(oss.str());
+    }
+
     // Check that area is positive
     const auto area = get_option<double>("area");
     if(area <= 0.0)
@@ -180,6 +153,9 @@ void Thermal1DOptions::print() const
               << "Duty cycle            = " << get_duty_cycle()*100         << "%"            << std::endl
               << "Period length         = " << 1e6/f                        << " microsecond" << std::endl
               << "Number of periods     = " << get_option<size_t>("nrep")                     << std::endl
+              << "Steps per period      = " << get_option<size_t>("steps-per-period")         << std::endl
+              << "Periodic steady state = " << (get_option<bool>("steady-state") ? "yes" : "no") << std::endl
+              << "Adaptive time steps   = " << (get_option<bool>("adaptive") ? "yes" : "no")     << std::endl
               << "Spatial resolution    = " << get_option<double>("dy")*1e6 << " micron"      << std::endl
               << "Ridge area            = " << get_option<double>("area")   << " mm^2"        << std::endl;
 }
@@ -229,16 +205,24 @@ Thermal1DData::Thermal1DData(const Thermal1DOptions &opt,
 static auto calctave(const arma::vec &g,
                        const arma::vec &T) -> double;
 
-static auto calctemp(double dt,
-                          arma::vec        &Told,
-                          arma::vec  const &q_old,
-                          arma::vec  const &q_new,
-                          arma::uvec const &iLayer,
-                          const std::vector<Material> &mat,
-                          const arma::vec   &x,
-                          const std::vector<DebyeModel> &dm_layer,
-                          const arma::vec   &rho_layer,
-                          Thermal1DOptions& opt) -> arma::vec;
+static auto calctemp(double                           dt,
+                     const arma::vec                 &Told,
+                     const arma::vec                 &q_old,
+                     const arma::vec                 &q_new,
+                     const std::vector<ThermalLayer> &layers,
+                     const Thermal1DOptions          &opt) -> arma::vec;
+
+static auto make_time_grid(double time_period,
+                           double pw,
+                           double dt_max,
+                           bool   adaptive) -> arma::vec;
+
+static auto find_periodic_steady_state(const arma::vec                 &T0,
+                                       const arma::vec                 &t_grid,
+                                       double                           pw,
+                                       const arma::vec                 &g,
+                                       const std::vector<ThermalLayer> &layers,
+                                       const Thermal1DOptions          &opt) -> arma::vec;
 
 auto main(int argc, char *argv[]) -> int
 {
@@ -287,9 +271,8 @@ auto main(int argc, char *argv[]) -> int
     double bottom_of_layer=0;
     unsigned int iy=1;
 
-    std::vector<DebyeModel> dm_layer;
+    std::vector<ThermalLayer> layers;
     const size_t nL = d.size();
-    arma::vec rho_layer = arma::zeros(nL);
 
     // Loop through each layer and figure out which points it contains
     for(unsigned int iL=0; iL < nL; iL++){
@@ -312,22 +295,38 @@ auto main(int argc, char *argv[]) -> int
         double T_D = 0.0;
         double M   = 0.0;
         unsigned int natoms = 0;
+        double rho = 0.0;
 
         try {
             T_D = mat_layer[iL].get_property_value("debye-temperature", x[iL]);
             M   = mat_layer[iL].get_property_value("molar-mass", x[iL]);
             natoms = static_cast<unsigned int>(mat_layer[iL].get_property_value("natoms"));
-            rho_layer[iL] = mat_layer[iL].get_property_value("density", x[iL]);
+            rho = mat_layer[iL].get_property_value("density", x[iL]);
+
+            layers.push_back({DebyeModel(T_D, M, natoms),
+                              ThermalConductivity(mat_layer[iL], x[iL]),
+                              rho,
+                              arma::uvec()});
         } catch (std::exception &e) {
             std::cerr << "Could not find material parameters for "
                       << mat_layer[iL].get_description() << std::endl;
             exit(EXIT_FAILURE);
         }
+    }
 
-        dm_layer.emplace_back(T_D, M, natoms);
+    // Note which grid points lie in each layer
+    for(unsigned int iL=0; iL < nL; iL++) {
+        layers[iL].points = arma::find(iLayer == iL);
     }
 
     const auto Tsink_ = opt.get_option<double>("Tsink");
+
+    // Tabulate the heat capacity of each layer over the range of temperatures
+    // that the device is likely to reach.  Any points that stray outside this
+    // range are still computed exactly.
+    for(auto &layer : layers) {
+        layer.dm.tabulate_cp(0.5*Tsink_, Tsink_ + 1000.0);
+    }
     
     // Spatial temperature profile through structure [K].
     // Assume that initially all points are in thermal equilibrium with heat sink.
@@ -355,15 +354,29 @@ auto main(int argc, char *argv[]) -> int
     // timestep is much shorter than the smallest "feature" in the time
     // period
     //double dt_max=timestep(data, T);
-    double dt_max=1.0/(1000*opt.get_f_rep());
+    double dt_max=1.0/(opt.get_option<size_t>("steps-per-period")*opt.get_f_rep());
 
     double _f_rep = opt.get_f_rep(); // Pulse repetition rate [Hz]
     double time_period = 1.0/_f_rep; // Length of a period [s]
-    size_t nt_per = ceil(time_period/dt_max); // Divide period into steps
-    double dt = time_period/float(nt_per); // Time-increment to use
 
-    if(opt.get_verbose()) {
-        printf("dt=%.4f ns.\n",dt*1e9);
+    // Sample times within a period, including the end of the period [s]
+    const auto t_grid = make_time_grid(time_period, pw, dt_max, opt.get_option<bool>("adaptive"));
+    const size_t nt_per = t_grid.size() - 1; // Number of steps in a period
+
+    if(opt.get_verbose())
+    {
+        const arma::vec dt_steps = arma::diff(t_grid);
+        printf("%zu time steps per period. dt=%.4f to %.4f ns.\n",
+               nt_per,
+               dt_steps.min()*1e9,
+               dt_steps.max()*1e9);
+    }
+
+    // Skip straight to the periodic steady state if wanted
+    if(opt.get_option<bool>("steady-state"))
+    {
+        Told = find_periodic_steady_state(Told, t_grid, pw, g, layers, opt);
+        T    = Told;
     }
 
     const auto _n_rep = opt.get_option<size_t>("nrep"); // Number of pulse repetitions
@@ -409,7 +422,7 @@ auto main(int argc, char *argv[]) -> int
         {
             // Index of time_sample relative to start of pulse train
             const unsigned int it_total = it + nt_per*iper;
-            t[it_total] = t_start+dt*it;
+            t[it_total] = t_start+t_grid(it);
 
             // Heating term at this time-step and at the last
             // timestep
@@ -418,24 +431,24 @@ auto main(int argc, char *argv[]) -> int
 
             // If this time-step is within the pulse, then
             // "switch on" the electrical power
-            if (dt*it <= pw) {
+            if (t_grid(it) <= pw) {
                 q_now = g;
             }
 
             // Likewise for the previous time-step
-            if (it > 0 and dt*(it-1) <= pw) {
+            if (it > 0 and t_grid(it-1) <= pw) {
                 q_old = g;
             }
 
             // Calculate the spatial temperature profile at this 
             // timestep
-            T = calctemp(dt, Told, q_old, q_now, iLayer, mat_layer, x, dm_layer, rho_layer, opt);
+            T = calctemp(t_grid(it+1)-t_grid(it), Told, q_old, q_now, layers, opt);
 
             // Find spatial average of T_AR
             T_avg(it_total) = calctave(g, T);
             
             // Find T_AR at middle of the pulse
-	    if(dt*it <= pw/2.0) {
+	    if(t_grid(it) <= pw/2.0) {
                 t_mid(iper) = t(it_total);
                 T_mid(iper) = T_avg(it_total);
             }
@@ -511,104 +524,216 @@ auto main(int argc, char *argv[]) -> int
 
 // Calculate the spatial temperature profile across the device at the
 // next time step in the sequence.
-static auto calctemp(double dt,
-                          arma::vec  &Told,
-                          arma::vec  const &q_old,
-                          arma::vec  const &q_new,
-                          arma::uvec const &iLayer,
-                          const std::vector<Material> &mat_layer,
-                          const arma::vec &x,
-                          const std::vector<DebyeModel> &dm_layer,
-                          const arma::vec &rho_layer,
-                          Thermal1DOptions& opt) -> arma::vec
+static auto calctemp(const double                     dt,
+                     const arma::vec                 &Told,
+                     const arma::vec                 &q_old,
+                     const arma::vec                 &q_new,
+                     const std::vector<ThermalLayer> &layers,
+                     const Thermal1DOptions          &opt) -> arma::vec
 {
-    const auto ny = iLayer.size();
-    const auto dy = opt.get_option<double>("dy");
-    const auto dy_sq = dy*dy;
+    const auto ny = Told.size();
+
+    // Thermal conductivity [W/m/K] and product of density and specific heat
+    // capacity [J/(m^3.K)] at each point, found for a whole layer at a time
+    arma::vec k(ny);
+    arma::vec rho_cp(ny);
+
+    for(const auto &layer : layers)
+    {
+        if(!layer.points.empty())
+        {
+            const arma::vec T_layer = Told.elem(layer.points);
+            k.elem(layer.points)      = layer.k.get_k(T_layer);
+            rho_cp.elem(layer.points) = layer.rho * layer.dm.get_cp(T_layer);
+        }
+    }
+
+    return heat_step_crank_nicolson(dt, opt.get_option<double>("dy"), Told, k, rho_cp, q_old, q_new);
+}
+
+/**
+ * Generate the sample times within a single pulse period
+ *
+ * \param[in] time_period Length of period [s]
+ * \param[in] pw          Pulse width [s]
+ * \param[in] dt_max      Time step for uniform sampling [s]
+ * \param[in] adaptive    Use short steps just after each pulse edge
+ *
+ * \returns Sample times from the start to the end of the period, inclusive [s]
+ *
+ * \details In adaptive mode, the first step after the pulse switches on or off
+ *          is a tenth of dt_max.  The steps then grow by 10% each time, up to
+ *          ten times dt_max, so that the slow cooling during the off-time needs
+ *          few steps.  The falling edge of the pulse is always a sample point.
+ */
+static auto make_time_grid(const double time_period,
+                           const double pw,
+                           const double dt_max,
+                           const bool   adaptive) -> arma::vec
+{
+    if(!adaptive)
+    {
+        const size_t nt_per = ceil(time_period/dt_max); // Divide period into steps
+        return arma::linspace(0, time_period, nt_per+1);
+    }
+
+    const double growth = 1.1;
+
+    std::vector<double> t_samples = {0.0};
 
-    // Note that the bottom of the device is not calculated.  We leave it
-    // set to the heatsink temperature (Dirichlet boundary)
-    arma::vec LHS_diag      = arma::ones(ny);
-    arma::vec LHS_subdiag   = arma::zeros(ny-1);
-    arma::vec LHS_superdiag = arma::zeros(ny-1);
+    // Fill the pulse-on and pulse-off sections of the period separately
+    const double edges[] = {0.0, pw, time_period};
 
-    // Material parameter matrix for RHS of Crank-Nicolson solver
-    arma::vec B_diag      = arma::ones(ny);
-    arma::vec B_superdiag = arma::zeros(ny-1);
-    arma::vec B_subdiag   = arma::zeros(ny-1);
+    for(unsigned int isec = 0; isec < 2; ++isec)
+    {
+        double dt    = 0.1*dt_max;
+        double t_now = edges[isec];
+
+        while(t_now < edges[isec+1])
+        {
+            t_now = std::min(t_now + dt, edges[isec+1]);
+            t_samples.push_back(t_now);
+            dt = std::min(dt*growth, 10.0*dt_max);
+        }
+    }
 
-    // Indices of layers containing the current, previous and next points
-    auto iL_prev = iLayer(0);
-    auto iL_this = iLayer(1);
-    auto iL_next = iLayer(2);
+    return arma::conv_to<arma::vec>::from(t_samples);
+}
 
-    double k_prev = thermal_cond(mat_layer[iL_prev], x(iL_prev), Told(0));
-    double k_this = thermal_cond(mat_layer[iL_this], x(iL_this), Told(1));
-    double k_next = thermal_cond(mat_layer[iL_next], x(iL_next), Told(2));
+/**
+ * Advance the temperature profile through a single pulse period
+ *
+ * \param[in] T0     Temperature profile at start of period [K]
+ * \param[in] t_grid Sample times within period [s]
+ * \param[in] pw     Pulse width [s]
+ * \param[in] g      Power density profile during pulse [W/m^3]
+ * \param[in] layers Thermal properties of each layer
+ * \param[in] opt    User options
+ *
+ * \returns Temperature profile at end of period [K]
+ */
+static auto advance_period(const arma::vec                 &T0,
+                           const arma::vec                 &t_grid,
+                           const double                     pw,
+                           const arma::vec                 &g,
+                           const std::vector<ThermalLayer> &layers,
+                           const Thermal1DOptions          &opt) -> arma::vec
+{
+    const arma::vec q_off = arma::zeros(T0.size());
+    arma::vec T = T0;
+
+    for(unsigned int it = 0; it+1 < t_grid.size(); ++it)
+    {
+        const auto &q_now = (t_grid(it) <= pw) ? g : q_off;
+        const auto &q_old = (it > 0 and t_grid(it-1) <= pw) ? g : q_off;
+
+        T = calctemp(t_grid(it+1)-t_grid(it), T, q_old, q_now, layers, opt);
+    }
+
+    return T;
+}
+
+/**
+ * Find the periodic steady-state temperature profile
+ *
+ * \param[in] T0     Initial guess at temperature profile [K]
+ * \param[in] t_grid Sample times within period [s]
+ * \param[in] pw     Pulse width [s]
+ * \param[in] g      Power density profile during pulse [W/m^3]
+ * \param[in] layers Thermal properties of each layer
+ * \param[in] opt    User options
+ *
+ * \returns The temperature profile at the start of each period, once the
+ *          system has settled [K]
+ *
+ * \details The steady state is the fixed point of the map, P, that takes the
+ *          temperature profile through one period, i.e., T = P(T).  Simply
+ *          iterating the map converges very slowly when the heat-sink time
+ *          constant is much longer than a period.  Instead, Anderson
+ *          acceleration is used to extrapolate from the last few periods
+ *          to the fixed point.  This typically needs a few tens of periods,
+ *          rather than many thousands.
+ */
+static auto find_periodic_steady_state(const arma::vec                 &T0,
+                                       const arma::vec                 &t_grid,
+                                       const double                     pw,
+                                       const arma::vec                 &g,
+                                       const std::vector<ThermalLayer> &layers,
+                                       const Thermal1DOptions          &opt) -> arma::vec
+{
+    const size_t depth    = 5; // Number of previous periods used in extrapolation
+    const auto   tol      = opt.get_option<double>("ss-tolerance");
+    const auto   max_iter = opt.get_option<size_t>("ss-max-iter");
 
-    double rho_cp = 0;
+    // Changes in the residual and the mapped profile between recent periods
+    std::deque<arma::vec> dR;
+    std::deque<arma::vec> dP;
 
-    arma::vec q = arma::zeros(ny); // heating vector for RHS of Crank-Nicolson solver
+    arma::vec T = T0;
+    arma::vec r_prev;
+    arma::vec P_prev;
 
-    for(unsigned int iy=1; iy<ny-1; iy++)
+    for(unsigned int iter = 0; iter < max_iter; ++iter)
     {
-        iL_this = iLayer(iy); // Update the current layer index
-        iL_next = iLayer(iy+1);
-
-        // Product of density and spec. heat cap [J/(m^3.K)]
-        const auto _cp = dm_layer[iL_this].get_cp(Told(iy));
-        rho_cp = rho_layer(iL_this) * _cp;
-
-        // Find interface values of the thermal conductivity using
-        // Eq. 3.25 in Craig's thesis.
-        const auto kn=(2*k_this*k_next)/(k_this+k_next);
-        const auto ks=(2*k_this*k_prev)/(k_this+k_prev);
-        const auto r = dt/(2.0*rho_cp);
-        const auto alpha = r*ks/dy_sq;
-        const auto gamma = r*kn/dy_sq;
-
-        B_subdiag(iy-1) = alpha;
-        B_superdiag(iy) = gamma;
-        B_diag(iy)      = 1.0 - (alpha+gamma);
-
-        LHS_subdiag(iy-1) = -alpha;
-        LHS_superdiag(iy) = -gamma;
-        LHS_diag(iy)      = 1.0 + (alpha+gamma);
-
-        q(iy) = r*(q_old(iy)+q_new(iy));
-
-        k_prev = k_this;
-        k_this = k_next;
-        k_next = thermal_cond(mat_layer[iL_next], x(iL_next), Told(iy+1));
+        const arma::vec P = advance_period(T, t_grid, pw, g, layers, opt);
+        const arma::vec r = P - T;
+        const double    residual = arma::abs(r).max();
+
+        if(opt.get_verbose()) {
+            printf("Steady-state iteration %u: largest change = %.3e K\n", iter+1, residual);
+        }
+
+        if(residual < tol) {
+            return P;
+        }
+
+        if(iter > 0)
+        {
+            dR.push_back(r - r_prev);
+            dP.push_back(P - P_prev);
+
+            if(dR.size() > depth)
+            {
+                dR.pop_front();
+                dP.pop_front();
+            }
+        }
+
+        r_prev = r;
+        P_prev = P;
+
+        // Use a plain period step unless the extrapolation gives a sensible result
+        arma::vec T_next = P;
+
+        if(!dR.empty())
+        {
+            arma::mat A(T.size(), dR.size());
+            arma::mat B(T.size(), dP.size());
+
+            for(unsigned int i = 0; i < dR.size(); ++i)
+            {
+                A.col(i) = dR[i];
+                B.col(i) = dP[i];
+            }
+
+            // Least-squares fit of the residual to its recent changes
+            arma::vec gamma;
+
+            if(arma::solve(gamma, A, r))
+            {
+                const arma::vec T_extrap = P - B*gamma;
+
+                if(T_extrap.is_finite() && T_extrap.min() > 0) {
+                    T_next = T_extrap;
+                }
+            }
+        }
+
+        T = T_next;
     }
 
-    // At last point, use Neumann boundary, i.e. dT/dy=0, which gives
-    // T[n] = T[n-2] in the finite-difference approximation
-    double kns=(2*k_next*k_this)/(k_next+k_this);
-    const double rho = rho_layer(iLayer(ny-1));
-    rho_cp = rho * dm_layer[iLayer(ny-1)].get_cp(Told(ny-1));
-    double r = dt/(2.0*rho_cp);
-    double alpha_gamma = r*kns/dy_sq;
-    B_subdiag(ny-2) = 2.0*alpha_gamma;
-    B_diag(ny-1)    = 1.0 - 2.0*alpha_gamma;
-
-    LHS_subdiag(ny-2) = -2.0*alpha_gamma;
-    LHS_diag(ny-1) = 1.0 + 2.0*alpha_gamma;
-
-    q(ny-1) = r*(q_old(ny-1)+q_new(ny-1));
-
-    // Perform matrix multiplication to get the RHS vector of the
-    // Crank-Nicolson solver
-    auto RHS = multiply_vec_tridiag(B_subdiag,
-                                    B_diag,
-                                    B_superdiag,
-                                    Told,
-                                    q);
-
-    auto T = solve_tridiag(LHS_subdiag,
-                           LHS_diag,
-                           LHS_superdiag,
-                           RHS);
+    std::cerr << "Warning: periodic steady state was not found after " << max_iter
+              << " periods" << std::endl;
 
     return T;
 }
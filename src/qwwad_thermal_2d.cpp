@@ -0,0 +1,632 @@
+/**
+ * \file   qwwad_thermal_2d.cpp
+ * \brief  Calculate temperature variation over a ridge cross-section
+ *
+ * \details This solves the transient heat equation over a 2D cross-section
+ *          of a ridge device, in the growth (y) and lateral (x) directions.
+ *          The layers are read in the same format as qwwad_thermal_1d.  All
+ *          layers from the "ridge" layer upwards are etched to the width of
+ *          the ridge, and the sides of the ridge are assumed to be thermally
+ *          insulated.  The layers below the ridge span the full substrate width.
+ *
+ *          Only half of the cross-section is simulated, since it is symmetric
+ *          about the centre of the ridge.
+ *
+ *          Each time-step uses the Peaceman-Rachford alternating-direction
+ *          implicit (ADI) method, which needs only a set of independent
+ *          tridiagonal solutions along each row and column of the grid.  These
+ *          are solved in parallel, if OpenMP is enabled.
+ *
+ * \author Alex Valavanis <a.valavanis@leeds.ac.uk>
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "qwwad/options.h"
+#include "qwwad/material.h"
+#include "qwwad/material-library.h"
+#include "qwwad/debye.h"
+#include "qwwad/thermal-conductivity.h"
+#include "qwwad/file-io.h"
+#include "qwwad/linear-algebra.h"
+#include <glibmm/ustring.h>
+
+using namespace QWWAD;
+
+/**
+ * Thermal properties of a single layer in the structure
+ */
+struct ThermalLayer
+{
+    DebyeModel          dm;     ///< Heat-capacity model
+    ThermalConductivity k;      ///< Thermal-conductivity model
+    double              rho;    ///< Density [kg/m^3]
+    arma::uvec          points; ///< Indices of (solid) grid points inside the layer
+};
+
+class Thermal2DOptions: public Options
+{
+    double dc = 0.02; // Duty cycle
+    double f  = 10e3; // Pulse repetition rate [Hz]
+
+public:
+    Thermal2DOptions(int argc, char** argv);
+
+    /// Return fractional duty cycle (i.e. 0 to 1)
+    [[nodiscard]] auto get_duty_cycle() const -> double {return dc;}
+
+    /// Return pulse repetition rate [Hz]
+    [[nodiscard]] auto get_f_rep() const -> double {return f;}
+
+    void print() const;
+};
+
+// Define and parse all user options
+Thermal2DOptions::Thermal2DOptions(int argc, char ** argv)
+{
+    std::string doc = "Calculate temperature variation over the cross-section of a ridge device";
+
+    add_option<size_t>     ("active,a",                   2, "Index of active-region layer");
+    add_option<size_t>     ("ridge,r",                    2, "Index of lowest layer in the etched ridge");
+    add_option<double>     ("ridge-width,w",            150, "Width of ridge [micron]");
+    add_option<double>     ("substrate-width,W",        500, "Width of substrate [micron]");
+    add_option<double>     ("length,l",                 0.8, "Length of ridge [mm]");
+    add_option<std::string>("infile",  "thermal_layers.dat", "Waveguide layers data file");
+    add_option<double>     ("Tsink,T",                 80.0, "Heatsink temperature [K]");
+    add_option<double>     ("dy,y",                 1.00e-7, "Spatial resolution in growth direction [m]");
+    add_option<double>     ("dx,x",                 1.00e-6, "Spatial resolution in lateral direction [m]");
+    add_option<double>     ("dc,d",                       2, "Duty cycle for pulse train [%]");
+    add_option<double>     ("frequency,f",               10, "Pulse repetition rate [kHz]");
+    add_option<double>     ("power,P",                17.65, "Pulse power [W]");
+    add_option<size_t>     ("nrep",                       1, "Number of pulse periods to simulate");
+    add_option<size_t>     ("steps-per-period",        1000, "Number of time steps in each pulse period");
+
+    add_prog_specific_options_and_parse(argc,argv,doc);
+
+    // Check that heatsink temperature is positive
+    const auto Tsink = get_option<double>("Tsink");
+    if (Tsink <= 0.0)
+    {
+        std::ostringstream oss;
+        oss << "Heatsink temperature, " << Tsink << " is not positive.";
+        throw std::domain_error(oss.str());
+    }
+
+    // Check that spatial steps are positive
+    if(get_option<double>("dy") <= 0.0 or get_option<double>("dx") <= 0.0) {
+        throw std::domain_error ("Spatial resolution must be positive");
+    }
+
+    // Check that ridge fits on substrate
+    const auto w_ridge = get_option<double>("ridge-width");
+    const auto w_sub   = get_option<double>("substrate-width");
+
+    if(w_ridge <= 0.0 or w_ridge > w_sub)
+    {
+        std::ostringstream oss;
+        oss << "Ridge width, " << w_ridge << " micron must be positive and no wider than "
+            << "the substrate (" << w_sub << " micron).";
+        throw std::domain_error(oss.str());
+    }
+
+    if(get_option<double>("length") <= 0.0) {
+        throw std::domain_error ("Ridge length must be positive");
+    }
+
+    // Check that duty cycle is positive and
+    // rescale to a decimal value
+    dc = get_option<double>("dc") * 0.01;
+
+    if(dc <= 0.0 or dc >= 1.0)
+    {
+        std::ostringstream oss;
+        oss << "Specified duty cycle, " << dc << " is invalid.";
+        throw std::domain_error(oss.str());
+    }
+
+    // Check that frequency is positive and
+    // rescale to Hz
+    f = get_option<double>("frequency") * 1.0e3;
+
+    if(f <= 0) {
+        throw std::domain_error ("Pulse repetition rate must "
+                                 "be positive.");
+    }
+
+    // Check that power is positive
+    const auto power = get_option<double>("power");
+    if(power <= 0.0)
+    {
+        std::ostringstream oss;
+        oss << "Electrical power dissipation, " << power << " is not positive.";
+        throw std::domain_error(oss.str());
+    }
+
+    // Check that the pulse spans at least one time step
+    const auto nt_per = get_option<size_t>("steps-per-period");
+    if(nt_per == 0 or nt_per*dc < 1.0)
+    {
+        std::ostringstream oss;
+        oss << "Too few time steps per period (" << nt_per << ") to resolve a "
+            << get_duty_cycle()*100 << "% duty cycle.";
+        throw std::domain_error(oss.str());
+    }
+
+    if(get_verbose()) {
+        print();
+    }
+}
+
+void Thermal2DOptions::print() const
+{
+    std::cout << "Heat sink temperature = " << get_option<double>("Tsink")           << " K"           << std::endl
+              << "Power                 = " << get_option<double>("power")           << " W"           << std::endl
+              << "Frequency             = " << f/1.0e3                               << " kHz"         << std::endl
+              << "Duty cycle            = " << get_duty_cycle()*100                  << "%"            << std::endl
+              << "Period length         = " << 1e6/f                                 << " microsecond" << std::endl
+              << "Number of periods     = " << get_option<size_t>("nrep")                              << std::endl
+              << "Steps per period      = " << get_option<size_t>("steps-per-period")                  << std::endl
+              << "Growth resolution     = " << get_option<double>("dy")*1e6          << " micron"      << std::endl
+              << "Lateral resolution    = " << get_option<double>("dx")*1e6          << " micron"      << std::endl
+              << "Ridge width           = " << get_option<double>("ridge-width")     << " micron"      << std::endl
+              << "Substrate width       = " << get_option<double>("substrate-width") << " micron"      << std::endl
+              << "Ridge length          = " << get_option<double>("length")          << " mm"          << std::endl;
+}
+
+/**
+ * Harmonic mean of thermal conductivity across an interface [W/m/K]
+ *
+ * \details This is zero if either side is insulating.
+ */
+static inline auto interface_k(const double k1,
+                               const double k2) -> double
+{
+    return (k1 + k2 > 0.0) ? 2.0*k1*k2/(k1+k2) : 0.0;
+}
+
+/**
+ * Calculate the temperature profile at the next time-step
+ *
+ * \param[in] dt     Time-step [s]
+ * \param[in] Told   Temperature at each point (row = growth, column = lateral) [K]
+ * \param[in] q_old  Power density at previous time-step [W/m^3]
+ * \param[in] q_new  Power density at this time-step [W/m^3]
+ * \param[in] solid  Nonzero for each point that lies inside the device
+ * \param[in] layers Thermal properties of each layer
+ * \param[in] dx     Lateral grid spacing [m]
+ * \param[in] dy     Growth-direction grid spacing [m]
+ *
+ * \details The bottom row of points is held at the heatsink temperature,
+ *          and all other boundaries are insulating.  The first half-step is
+ *          implicit in the growth direction and explicit laterally, and the
+ *          second half-step is the reverse.  Material properties are found
+ *          using the temperature at the start of the step.
+ */
+static auto calctemp(const double                     dt,
+                     const arma::mat                 &Told,
+                     const arma::mat                 &q_old,
+                     const arma::mat                 &q_new,
+                     const arma::umat                &solid,
+                     const std::vector<ThermalLayer> &layers,
+                     const double                     dx,
+                     const double                     dy) -> arma::mat
+{
+    const auto ny = Told.n_rows;
+    const auto nx = Told.n_cols;
+    const auto dx_sq = dx*dx;
+    const auto dy_sq = dy*dy;
+
+    // Thermal conductivity [W/m/K] and ratio of half time-step to heat
+    // capacity per unit volume [m^3.K/W] at each point
+    arma::mat k = arma::zeros(ny, nx);
+    arma::mat r = arma::zeros(ny, nx);
+
+    for(const auto &layer : layers)
+    {
+        if(!layer.points.empty())
+        {
+            const arma::vec T_layer = Told.elem(layer.points);
+            k.elem(layer.points) = layer.k.get_k(T_layer);
+            r.elem(layer.points) = dt/(2.0*layer.rho*layer.dm.get_cp(T_layer));
+        }
+    }
+
+    // Interface conductivities in growth direction (between iy and iy+1)
+    // and lateral direction (between ix and ix+1)
+    arma::mat ky(ny-1, nx);
+    arma::mat kx(ny, nx-1);
+
+    #pragma omp parallel for
+    for(unsigned int ix = 0; ix < nx; ++ix)
+    {
+        for(unsigned int iy = 0; iy+1 < ny; ++iy) {
+            ky(iy, ix) = interface_k(k(iy, ix), k(iy+1, ix));
+        }
+    }
+
+    #pragma omp parallel for
+    for(unsigned int ix = 0; ix+1 < nx; ++ix)
+    {
+        for(unsigned int iy = 0; iy < ny; ++iy) {
+            kx(iy, ix) = interface_k(k(iy, ix), k(iy, ix+1));
+        }
+    }
+
+    // Lateral heat flow into a point, per unit volume [W/m^3]
+    auto lateral_flow = [&](const arma::mat &T, unsigned int iy, unsigned int ix) -> double {
+        double flow = 0.0;
+
+        if(ix > 0) {
+            flow += kx(iy, ix-1)*(T(iy, ix-1) - T(iy, ix));
+        }
+
+        if(ix+1 < nx) {
+            flow += kx(iy, ix)*(T(iy, ix+1) - T(iy, ix));
+        }
+
+        return flow/dx_sq;
+    };
+
+    // Growth-direction heat flow into a point, per unit volume [W/m^3].
+    // At the top surface, dT/dy=0, which gives T[n] = T[n-2] in the
+    // finite-difference approximation
+    auto vertical_flow = [&](const arma::mat &T, unsigned int iy, unsigned int ix) -> double {
+        if(iy == ny-1) {
+            return 2.0*ky(iy-1, ix)*(T(iy-1, ix) - T(iy, ix))/dy_sq;
+        }
+
+        return (ky(iy-1, ix)*(T(iy-1, ix) - T(iy, ix)) + ky(iy, ix)*(T(iy+1, ix) - T(iy, ix)))/dy_sq;
+    };
+
+    // First half-step: implicit in growth direction, solved column by column
+    arma::mat T_half(ny, nx);
+
+    #pragma omp parallel for
+    for(unsigned int ix = 0; ix < nx; ++ix)
+    {
+        arma::vec diag  = arma::ones(ny);
+        arma::vec sub   = arma::zeros(ny-1);
+        arma::vec super = arma::zeros(ny-1);
+        arma::vec rhs(ny);
+
+        // Bottom of the device is held at the heatsink temperature
+        rhs(0) = Told(0, ix);
+
+        for(unsigned int iy = 1; iy < ny; ++iy)
+        {
+            if(solid(iy, ix) == 0)
+            {
+                rhs(iy) = Told(iy, ix);
+                continue;
+            }
+
+            const auto r_here = r(iy, ix);
+            rhs(iy) = Told(iy, ix) + r_here*(lateral_flow(Told, iy, ix) + q_old(iy, ix));
+
+            if(iy == ny-1)
+            {
+                const auto a = 2.0*r_here*ky(iy-1, ix)/dy_sq;
+                sub(iy-1) = -a;
+                diag(iy)  = 1.0 + a;
+            }
+            else
+            {
+                const auto a_s = r_here*ky(iy-1, ix)/dy_sq;
+                const auto a_n = r_here*ky(iy,   ix)/dy_sq;
+                sub(iy-1) = -a_s;
+                super(iy) = -a_n;
+                diag(iy)  = 1.0 + a_s + a_n;
+            }
+        }
+
+        T_half.col(ix) = solve_tridiag(sub, diag, super, rhs);
+    }
+
+    // Second half-step: implicit in lateral direction, solved row by row
+    arma::mat T(ny, nx);
+    T.row(0) = Told.row(0);
+
+    #pragma omp parallel for
+    for(unsigned int iy = 1; iy < ny; ++iy)
+    {
+        arma::vec diag  = arma::ones(nx);
+        arma::vec sub   = arma::zeros(nx-1);
+        arma::vec super = arma::zeros(nx-1);
+        arma::vec rhs(nx);
+
+        for(unsigned int ix = 0; ix < nx; ++ix)
+        {
+            if(solid(iy, ix) == 0)
+            {
+                rhs(ix) = T_half(iy, ix);
+                continue;
+            }
+
+            const auto r_here = r(iy, ix);
+            rhs(ix) = T_half(iy, ix) + r_here*(vertical_flow(T_half, iy, ix) + q_new(iy, ix));
+
+            if(ix > 0)
+            {
+                const auto a_w = r_here*kx(iy, ix-1)/dx_sq;
+                sub(ix-1) = -a_w;
+                diag(ix) += a_w;
+            }
+
+            if(ix+1 < nx)
+            {
+                const auto a_e = r_here*kx(iy, ix)/dx_sq;
+                super(ix) = -a_e;
+                diag(ix) += a_e;
+            }
+        }
+
+        T.row(iy) = solve_tridiag(sub, diag, super, rhs).t();
+    }
+
+    return T;
+}
+
+/**
+ * Write a temperature map to file
+ *
+ * \param[in] filename Name of output file
+ * \param[in] x        Lateral position of each column [m]
+ * \param[in] y        Growth-direction position of each row [m]
+ * \param[in] T        Temperature at each point [K]
+ * \param[in] solid    Nonzero for each point that lies inside the device
+ *
+ * \details Each line contains the lateral position [micron], growth-direction
+ *          position [micron] and temperature [K].  Points outside the device
+ *          are skipped, and each column of the grid is separated by a blank line.
+ */
+static void write_map(const std::string &filename,
+                      const arma::vec   &x,
+                      const arma::vec   &y,
+                      const arma::mat   &T,
+                      const arma::umat  &solid)
+{
+    std::ofstream stream(filename);
+
+    if(!stream.is_open())
+    {
+        std::ostringstream oss;
+        oss << "Could not open " << filename;
+        throw std::runtime_error(oss.str());
+    }
+
+    for(unsigned int ix = 0; ix < x.size(); ++ix)
+    {
+        for(unsigned int iy = 0; iy < y.size(); ++iy)
+        {
+            if(solid(iy, ix) != 0) {
+                stream << x(ix)*1e6 << "\t" << y(iy)*1e6 << "\t" << T(iy, ix) << std::endl;
+            }
+        }
+
+        stream << std::endl;
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+    constexpr double MICRON_TO_M = 1e-6;
+    constexpr double MM_TO_M     = 1e-3;
+
+    // Grab user preferences
+    MaterialLibrary material_library("");
+    Thermal2DOptions opt(argc, argv);
+
+    // Read input data
+    arma::vec d;       // Layer thickness [m]
+    arma::vec x_layer; // Alloy composition in each layer
+    arma::vec doping;  // Unused doping data
+    std::vector<std::string> mat_name;
+    const auto infile = opt.get_option<std::string>("infile");
+    read_table(infile, d, x_layer, doping, mat_name);
+    d *= MICRON_TO_M;
+
+    const size_t nL = d.size();
+
+    if(nL == 0)
+    {
+        std::ostringstream oss;
+        oss << "Could not read any layers from " << infile;
+        throw std::runtime_error(oss.str());
+    }
+
+    std::vector<Material> mat_layer;
+
+    for(auto const &name : mat_name) {
+        mat_layer.push_back(*material_library.get_material(name));
+    }
+
+    const auto iAR     = opt.get_option<size_t>("active");
+    const auto iRidge  = opt.get_option<size_t>("ridge");
+
+    if(iAR >= nL or iRidge >= nL)
+    {
+        std::ostringstream oss;
+        oss << "Active region and ridge layer indices must be less than the number of layers (" << nL << ")";
+        throw std::domain_error(oss.str());
+    }
+
+    // Set up grid. The growth direction starts at the heatsink, and the
+    // lateral direction starts at the centre of the ridge
+    const auto dy       = opt.get_option<double>("dy");
+    const auto dx       = opt.get_option<double>("dx");
+    const auto L        = arma::accu(d);
+    const size_t ny     = ceil(L/dy) + 1;
+    const auto w_ridge  = opt.get_option<double>("ridge-width")*MICRON_TO_M;
+    const auto w_sub    = opt.get_option<double>("substrate-width")*MICRON_TO_M;
+    const size_t nx     = ceil(w_sub/(2.0*dx));
+
+    if(nx < 2) {
+        throw std::domain_error("Lateral resolution is too coarse for the substrate width");
+    }
+
+    const arma::vec y = arma::linspace(0, (ny-1)*dy, ny);
+    const arma::vec x = (arma::regspace(0, nx-1) + 0.5)*dx; // Centre of each column
+
+    // Power density in active region [W/m^3]
+    const auto L_AR          = d(iAR);
+    const auto volume        = L_AR * w_ridge * opt.get_option<double>("length")*MM_TO_M;
+    const auto power_density = opt.get_option<double>("power")/volume;
+    const auto pw            = opt.get_duty_cycle()/opt.get_f_rep();
+
+    if(opt.get_verbose())
+    {
+        printf("Grid = %zu x %zu points.\n", ny, nx);
+        printf("Power density = %5.2e W/m3.\n", power_density);
+        printf("Pulse width = %5.1f ns.\n", pw*1e9);
+    }
+
+    // Find the layer containing each row of the grid
+    arma::uvec iLayer(ny);
+    const arma::vec top_of_layer = arma::cumsum(d);
+
+    for(unsigned int iy = 0, iL = 0; iy < ny; ++iy)
+    {
+        while(iL < nL-1 and y(iy) > top_of_layer(iL)) {
+            ++iL;
+        }
+
+        iLayer(iy) = iL;
+    }
+
+    // Mark which points are inside the device (i.e., not in the etched
+    // region beside the ridge) and which are heated
+    arma::umat solid = arma::ones<arma::umat>(ny, nx);
+    arma::mat  g     = arma::zeros(ny, nx); // Power density profile [W/m^3]
+
+    for(unsigned int ix = 0; ix < nx; ++ix)
+    {
+        const bool in_ridge = (x(ix) < w_ridge/2.0);
+
+        for(unsigned int iy = 0; iy < ny; ++iy)
+        {
+            if(iLayer(iy) >= iRidge and !in_ridge) {
+                solid(iy, ix) = 0;
+            } else if(iLayer(iy) == iAR) {
+                g(iy, ix) = power_density;
+            }
+        }
+    }
+
+    const arma::uvec heated = arma::find(g > 0);
+
+    if(heated.empty()) {
+        throw std::runtime_error("The active region does not contain any grid points");
+    }
+
+    // Set up the thermal properties of each layer
+    std::vector<ThermalLayer> layers;
+
+    for(unsigned int iL = 0; iL < nL; ++iL)
+    {
+        try {
+            const auto T_D    = mat_layer[iL].get_property_value("debye-temperature", x_layer[iL]);
+            const auto M      = mat_layer[iL].get_property_value("molar-mass", x_layer[iL]);
+            const auto natoms = static_cast<unsigned int>(mat_layer[iL].get_property_value("natoms"));
+            const auto rho    = mat_layer[iL].get_property_value("density", x_layer[iL]);
+
+            layers.push_back({DebyeModel(T_D, M, natoms),
+                              ThermalConductivity(mat_layer[iL], x_layer[iL]),
+                              rho,
+                              arma::uvec()});
+        } catch (std::exception &e) {
+            std::cerr << "Could not find material parameters for "
+                      << mat_layer[iL].get_description() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Note which solid grid points lie in each layer
+    arma::umat iLayer_map(ny, nx);
+
+    for(unsigned int ix = 0; ix < nx; ++ix) {
+        iLayer_map.col(ix) = iLayer;
+    }
+
+    for(unsigned int iL = 0; iL < nL; ++iL) {
+        layers[iL].points = arma::find((iLayer_map == iL) % solid);
+    }
+
+    const auto Tsink = opt.get_option<double>("Tsink");
+
+    for(auto &layer : layers) {
+        layer.dm.tabulate_cp(0.5*Tsink, Tsink + 1000.0);
+    }
+
+    // Assume that initially all points are in thermal equilibrium with heat sink.
+    arma::mat T(ny, nx);
+    T.fill(Tsink);
+
+    const double time_period = 1.0/opt.get_f_rep();                         // Length of a period [s]
+    const auto   nt_per      = opt.get_option<size_t>("steps-per-period"); // Number of steps per period
+    const double dt          = time_period/nt_per;                          // Time-increment to use
+
+    const auto n_rep = opt.get_option<size_t>("nrep");
+
+    arma::vec t     = arma::zeros(nt_per * n_rep); // Time at each step [s]
+    arma::vec T_avg = arma::zeros(nt_per * n_rep); // Average AR temperature at each step [K]
+    arma::vec t_max = arma::zeros(n_rep);          // Time of peak AR temperature in each pulse [s]
+    arma::vec T_max = arma::zeros(n_rep);          // Peak AR temperature in each pulse [K]
+    arma::mat T_map_max = T;                       // Temperature map at peak of final pulse
+
+    const arma::mat q_off = arma::zeros(ny, nx);
+
+    for(unsigned int iper = 0; iper < n_rep; ++iper)
+    {
+        const double t_start = time_period*iper;
+
+        for(unsigned int it = 0; it < nt_per; ++it)
+        {
+            const unsigned int it_total = it + nt_per*iper;
+            t(it_total) = t_start + dt*it;
+
+            // Heating at this time-step and at the previous one
+            const auto &q_now = (dt*it <= pw) ? g : q_off;
+            const auto &q_old = (it > 0 and dt*(it-1) <= pw) ? g : q_off;
+
+            T = calctemp(dt, T, q_old, q_now, solid, layers, dx, dy);
+
+            T_avg(it_total) = arma::accu(T.elem(heated))/heated.n_elem;
+
+            if(T_avg(it_total) > T_max(iper))
+            {
+                T_max(iper) = T_avg(it_total);
+                t_max(iper) = t(it_total);
+
+                if(iper == n_rep-1) {
+                    T_map_max = T;
+                }
+            }
+        }
+
+        if(opt.get_verbose())
+        {
+            printf("Period=%u Tmax= %.4f K at t=%.2f microseconds\n",
+                   iper+1,
+                   T_max(iper),
+                   t_max(iper)*1e6);
+        }
+    }
+
+    try {
+        write_table("T_t.dat",    arma::vec(1e6*t),     T_avg);
+        write_table("Tmax_t.dat", arma::vec(1e6*t_max), T_max);
+        write_map("T_xy.dat",     x, y, T,         solid);
+        write_map("T_xy_max.dat", x, y, T_map_max, solid);
+    } catch (std::runtime_error &e) {
+        std::cerr << "Error writing file" << std::endl;
+        std::cerr << e.what() << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -13,7 +13,6 @@
 #include <cstdlib>
 #include <gsl/gsl_math.h>
 #include "qwwad/eigenstate.h"
-#include "qwwad/file-io.h"
 #include "qwwad/wf_options.h"
 #include "qwwad/constants.h"
 #include "qwwad/maths-helpers.h"
@@ -49,11 +48,7 @@ auto main(int argc, char *argv[]) -> int
                                                        1000.0/e,
                                                        true);
 
-    // TODO: read z-coordinates in from the ground state
-    // There should probably be an option in the State class for this
-    arma::vec z;
-    arma::vec _psi;
-    read_table("wf_e1.r", z, _psi);
+    const auto z  = all_states.at(0).get_position_samples();
     const size_t nz = z.size();
     const double dz = z[1] - z[0];
 
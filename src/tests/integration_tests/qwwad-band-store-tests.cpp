@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include "qwwad/band-store.h"
+
+using namespace QWWAD;
+
+namespace {
+const size_t n_G     = 7;  ///< Number of plane waves
+const size_t n_basis = 14; ///< Number of coefficients, with two spin components
+const size_t n_bands = 3;  ///< Number of stored bands
+const size_t n_k     = 9;  ///< Number of wave vectors
+
+/**
+ * Make a distinct set of energies for a wave vector
+ */
+auto make_energies(const size_t ik) -> arma::vec
+{
+    return arma::linspace(0.1*ik, 0.1*ik + 1.0, n_bands);
+}
+
+/**
+ * Make a distinct set of coefficients for a wave vector
+ */
+auto make_coefficients(const size_t ik) -> arma::cx_mat
+{
+    arma::cx_mat ank(n_basis, n_bands);
+
+    for(arma::uword ib = 0; ib < n_bands; ++ib) {
+        for(arma::uword iG = 0; iG < n_basis; ++iG) {
+            ank(iG, ib) = std::complex<double>(ik + 0.01*iG, -static_cast<double>(ib));
+        }
+    }
+
+    return ank;
+}
+
+/**
+ * Make a list of wave vectors
+ */
+auto make_k() -> std::vector<arma::vec>
+{
+    std::vector<arma::vec> k;
+
+    for(size_t ik = 0; ik < n_k; ++ik) {
+        k.push_back(arma::vec{0.0, 0.0, 1e8*ik});
+    }
+
+    return k;
+}
+} // namespace
+
+/**
+ * Check that a store written out of order, from several threads, is read
+ * back exactly
+ */
+TEST(BandStore, threadedRoundTripTest)
+{
+    const std::string filename = "band-store-roundtrip-test.bin";
+    const auto k = make_k();
+
+    {
+        BandStore::Writer writer(filename, n_basis, n_G, n_bands, 4, k);
+
+        // Each thread writes every third wave vector, in reverse order
+        std::vector<std::thread> threads;
+
+        for(size_t it = 0; it < 3; ++it) {
+            threads.emplace_back([&writer, it]() {
+                for(size_t j = it; j < n_k; j += 3) {
+                    const auto ik = n_k - 1 - j;
+                    writer.write(ik, make_energies(ik), make_coefficients(ik));
+                }
+            });
+        }
+
+        for(auto &thread : threads) {
+            thread.join();
+        }
+
+        writer.close();
+    }
+
+    ASSERT_TRUE(BandStore::is_store(filename));
+
+    const BandStore store(filename);
+    ASSERT_EQ(n_basis, store.get_n_basis());
+    ASSERT_EQ(n_G,     store.get_n_G());
+    ASSERT_EQ(n_k,     store.get_n_k());
+    ASSERT_EQ(n_bands, store.get_n_bands());
+    ASSERT_TRUE(store.has_band_index());
+    ASSERT_EQ(4U,      store.get_band_min());
+
+    const auto E = store.get_energies();
+
+    for(size_t ik = 0; ik < n_k; ++ik) {
+        EXPECT_TRUE(arma::all(k[ik] == store.get_k(ik)));
+        EXPECT_TRUE(arma::all(make_energies(ik) == E.col(ik)));
+        EXPECT_TRUE(arma::all(arma::vectorise(make_coefficients(ik) == store.get_coefficients(ik))));
+    }
+
+    EXPECT_THROW(static_cast<void>(store.get_coefficients(n_k)), std::out_of_range);
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check that a store is only created once every wave vector has been written
+ */
+TEST(BandStore, incompleteWriterTest)
+{
+    const std::string filename = "band-store-incomplete-test.bin";
+
+    {
+        BandStore::Writer writer(filename, n_basis, n_G, n_bands, 0, make_k());
+        writer.write(0, make_energies(0), make_coefficients(0));
+
+        EXPECT_THROW(writer.write(n_k, make_energies(0), make_coefficients(0)), std::length_error);
+        EXPECT_THROW(writer.write(1, arma::vec(n_bands+1), make_coefficients(1)), std::length_error);
+        EXPECT_THROW(writer.close(), std::runtime_error);
+    }
+
+    // Neither the store nor the temporary file should be left behind
+    EXPECT_FALSE(std::ifstream(filename).good());
+    EXPECT_FALSE(std::ifstream(filename + ".tmp").good());
+}
+
+/**
+ * Check that a store can be written without absolute band indices
+ */
+TEST(BandStore, unknownBandIndexTest)
+{
+    const std::string filename = "band-store-unknown-band-test.bin";
+
+    {
+        BandStore::Writer writer(filename, n_basis, n_G, n_bands, BandStore::unknown_band, make_k());
+
+        for(size_t ik = 0; ik < n_k; ++ik) {
+            writer.write(ik, make_energies(ik), make_coefficients(ik));
+        }
+
+        writer.close();
+    }
+
+    const BandStore store(filename);
+    EXPECT_FALSE(store.has_band_index());
+    EXPECT_THROW(static_cast<void>(store.get_band_min()), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check that truncated or damaged stores are rejected
+ */
+TEST(BandStore, truncatedStoreTest)
+{
+    const std::string filename = "band-store-truncated-test.bin";
+
+    {
+        BandStore::Writer writer(filename, n_basis, n_G, n_bands, 0, make_k());
+
+        for(size_t ik = 0; ik < n_k; ++ik) {
+            writer.write(ik, make_energies(ik), make_coefficients(ik));
+        }
+
+        writer.close();
+    }
+
+    std::string contents;
+    {
+        std::ifstream stream(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    // Lose the last coefficient
+    {
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        stream.write(contents.data(), contents.size() - sizeof(std::complex<double>));
+    }
+
+    EXPECT_TRUE(BandStore::is_store(filename));
+    EXPECT_THROW(BandStore store(filename), std::runtime_error);
+
+    // Keep only part of the header
+    {
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        stream.write(contents.data(), 12);
+    }
+
+    EXPECT_THROW(BandStore store(filename), std::runtime_error);
+
+    // Change the format version, which follows the eight-byte signature
+    {
+        std::string damaged = contents;
+        damaged[8] = 99;
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        stream.write(damaged.data(), damaged.size());
+    }
+
+    EXPECT_THROW(BandStore store(filename), std::runtime_error);
+
+    // The header fields follow the signature, version and padding
+    const auto write_header_field = [&](const size_t offset, const uint64_t value) {
+        std::string damaged = contents;
+        std::memcpy(&damaged[offset], &value, sizeof(value));
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        stream.write(damaged.data(), damaged.size());
+    };
+
+    // Number of plane waves matches neither n_basis nor n_basis/2
+    write_header_field(24, n_G + 1);
+    EXPECT_THROW(BandStore store(filename), std::runtime_error);
+
+    // Far more wave vectors than the file holds
+    write_header_field(32, 1ULL << 31);
+    EXPECT_THROW(BandStore store(filename), std::runtime_error);
+
+    // The original header is accepted
+    write_header_field(24, n_G);
+    EXPECT_NO_THROW(BandStore store(filename));
+
+    std::remove(filename.c_str());
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
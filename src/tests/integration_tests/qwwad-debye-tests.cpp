@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include "qwwad/debye.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Check that the batch heat capacity (with and without a look-up table)
+ * matches the numerical derivative of the internal energy
+ */
+TEST(Debye, batchHeatCapacityTest)
+{
+    DebyeModel dm(345.0, 144.645e-3, 2); // GaAs
+    const arma::vec T = arma::linspace(10.0, 1000.0, 199);
+
+    const auto cp_exact = dm.get_cp(T);
+
+    for(arma::uword iT = 0; iT < T.size(); ++iT) {
+        EXPECT_NEAR(1.0, cp_exact(iT)/dm.get_cp(T(iT)), 1e-4) << "T = " << T(iT) << " K";
+    }
+
+    dm.tabulate_cp(10.0, 1000.0);
+    const auto cp_table = dm.get_cp(T);
+
+    for(arma::uword iT = 0; iT < T.size(); ++iT) {
+        EXPECT_NEAR(1.0, cp_table(iT)/dm.get_cp(T(iT)), 1e-3) << "T = " << T(iT) << " K";
+    }
+
+    // Dulong-Petit limit at 300 K is about 94% of 3Nk for GaAs
+    const double cp_300 = dm.get_cp(arma::vec{300.0})(0);
+    EXPECT_GT(cp_300, 0.9*dm.get_cp_high_T());
+    EXPECT_LT(cp_300, dm.get_cp_high_T());
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "qwwad/eigenstate.h"
+#include "qwwad/eigenstate-archive.h"
+
+using namespace QWWAD;
+
+namespace {
+/**
+ * Make a set of states on a common grid
+ */
+auto make_states() -> std::vector<Eigenstate>
+{
+    const size_t nz = 101;
+    const arma::vec z = arma::linspace(0, 10e-9, nz);
+
+    std::vector<Eigenstate> states;
+
+    for(unsigned int ist = 1; ist <= 3; ++ist) {
+        const arma::vec psi = sin(ist*arma::datum::pi*z/z(nz-1));
+        states.emplace_back(10.0*ist*ist, z, arma::cx_vec(psi, 0.5*psi));
+    }
+
+    return states;
+}
+
+/**
+ * Write a string to a file
+ */
+void write_file(const std::string &filename,
+                const std::string &contents)
+{
+    std::ofstream stream(filename, std::ios::binary);
+    stream << contents;
+}
+} // namespace
+
+/**
+ * Check that states are read back exactly as they were written, both
+ * directly and through the Eigenstate readers
+ */
+TEST(EigenstateArchive, roundTripTest)
+{
+    const std::string filename = "archive-roundtrip-test.r";
+    const auto states = make_states();
+
+    EigenstateArchive::Metadata metadata;
+    metadata.particle   = 'h';
+    metadata.mass       = 0.067*9.10938e-31;
+    metadata.solver     = "matrix-taylor";
+    metadata.input_hash = 12345;
+    EigenstateArchive::write(filename, states, metadata);
+
+    ASSERT_TRUE(EigenstateArchive::is_archive(filename));
+
+    {
+        const EigenstateArchive archive(filename);
+        ASSERT_EQ(states.size(), archive.get_n_states());
+        ASSERT_EQ(states[0].get_position_samples().size(), archive.get_n_samples());
+
+        EXPECT_EQ('h',                 archive.get_metadata().particle);
+        EXPECT_EQ(metadata.mass,       archive.get_metadata().mass);
+        EXPECT_EQ("matrix-taylor",     archive.get_metadata().solver);
+        EXPECT_EQ(12345U,              archive.get_metadata().input_hash);
+
+        const auto z   = archive.get_position_samples();
+        const auto E   = archive.get_energies();
+        const auto psi = archive.get_wavefunctions();
+
+        for(unsigned int ist = 0; ist < states.size(); ++ist) {
+            EXPECT_EQ(states[ist].get_energy(), E(ist));
+            EXPECT_TRUE(arma::all(states[ist].get_position_samples() == z));
+            EXPECT_TRUE(arma::all(states[ist].get_wavefunction_samples() == psi.col(ist)));
+        }
+    }
+
+    // The file-name arguments are unused for an archive
+    const auto read_states = Eigenstate::read_from_file(filename, "unused", ".r", 1000.0, true);
+    ASSERT_EQ(states.size(), read_states.size());
+
+    for(unsigned int ist = 0; ist < states.size(); ++ist) {
+        EXPECT_DOUBLE_EQ(states[ist].get_energy()/1000.0, read_states[ist].get_energy());
+        EXPECT_NEAR(0.0, arma::norm(states[ist].get_wavefunction_samples() -
+                                    read_states[ist].get_wavefunction_samples()), 1e-6);
+    }
+
+    const auto E = Eigenstate::read_energies_from_file(filename, 1000.0, true);
+    ASSERT_EQ(states.size(), E.size());
+    EXPECT_DOUBLE_EQ(states[2].get_energy()/1000.0, E(2));
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check that archives with the wrong version, or the wrong size, are rejected
+ */
+TEST(EigenstateArchive, rejectionTest)
+{
+    const std::string filename = "archive-reject-test.r";
+    EigenstateArchive::write(filename, make_states(), EigenstateArchive::Metadata());
+
+    // The version number follows the eight-byte signature
+    {
+        std::fstream stream(filename, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = 999;
+        stream.seekp(8);
+        stream.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    }
+
+    EXPECT_TRUE(EigenstateArchive::is_archive(filename));
+    EXPECT_THROW(EigenstateArchive archive(filename), std::runtime_error);
+
+    // Truncate a valid archive
+    EigenstateArchive::write(filename, make_states(), EigenstateArchive::Metadata());
+    std::string contents;
+    {
+        std::ifstream stream(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+    write_file(filename, contents.substr(0, contents.size() - 16));
+
+    EXPECT_THROW(EigenstateArchive archive(filename), std::runtime_error);
+
+    // Dimensions whose product overflows.  The sample and state counts
+    // follow the signature, version and particle ID
+    {
+        std::string damaged = contents;
+        const uint64_t n = 1ULL << 30;
+        std::memcpy(&damaged[16], &n, sizeof(n));
+        std::memcpy(&damaged[24], &n, sizeof(n));
+        write_file(filename, damaged);
+    }
+
+    EXPECT_THROW(EigenstateArchive archive(filename), std::runtime_error);
+
+    // A text energy file is not an archive
+    write_file(filename, "1 10.0\n2 40.0\n");
+    EXPECT_FALSE(EigenstateArchive::is_archive(filename));
+    EXPECT_THROW(EigenstateArchive archive(filename), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check the input hash against published FNV-1a test vectors, and that it
+ * depends on the order of the files
+ */
+TEST(EigenstateArchive, hashTest)
+{
+    const std::string file_a = "archive-hash-test-a.r";
+    const std::string file_b = "archive-hash-test-b.r";
+    write_file(file_a, "a");
+    write_file(file_b, "foobar");
+
+    EXPECT_EQ(0xaf63dc4c8601ec8cULL, EigenstateArchive::hash_files({file_a}));
+    EXPECT_EQ(0x85944171f73967e8ULL, EigenstateArchive::hash_files({file_b}));
+    EXPECT_EQ(14695981039346656037ULL, EigenstateArchive::hash_files({}));
+    EXPECT_NE(EigenstateArchive::hash_files({file_a, file_b}),
+              EigenstateArchive::hash_files({file_b, file_a}));
+
+    EXPECT_THROW(static_cast<void>(EigenstateArchive::hash_files({"archive-hash-test-missing.r"})), std::runtime_error);
+
+    std::remove(file_a.c_str());
+    std::remove(file_b.c_str());
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
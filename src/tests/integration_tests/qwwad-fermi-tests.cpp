@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "qwwad/fermi.h"
+#include "qwwad/constants.h"
+#include "qwwad/subband.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+TEST(Fermi, batchFermiGlobalTest)
+{
+    const double m = 0.067*me;
+    arma::vec Esb = {20.0, 60.0, 130.0};
+    Esb *= 1e-3*e;
+
+    // Grid of sheet densities and temperatures
+    const arma::vec N  = {1e14, 1e15, 1e16, 1e15, 1e16};
+    const arma::vec Te = {4.0,  77.0, 77.0, 300.0, 300.0};
+
+    const auto Ef = find_fermi_global(Esb, m, N, Te);
+    ASSERT_EQ(N.size(), Ef.size());
+
+    // Check against the scalar solver and the resulting populations
+    for(arma::uword i = 0; i < N.size(); ++i)
+    {
+        const auto Ef_scalar = find_fermi_global(Esb, m, N(i), Te(i));
+        EXPECT_NEAR(Ef_scalar, Ef(i), 1e-6*e);
+
+        double N_total = 0.0;
+
+        for(auto E : Esb) {
+            N_total += find_pop(E, Ef(i), m, Te(i));
+        }
+
+        EXPECT_NEAR(1.0, N_total/N(i), 1e-6);
+    }
+}
+
+TEST(Fermi, batchPopulationTest)
+{
+    const double m     = 0.067*me;
+    const double Esb   = 50e-3*e;
+    const double alpha = 0.7/e;
+    const double V     = 0.0;
+
+    const arma::vec Ef = {-0.5*Esb, Esb, 2.0*Esb};
+    const arma::vec Te = {10.0, 100.0, 300.0};
+
+    const auto N = find_pop(Esb, Ef, m, Te, alpha, V);
+
+    for(arma::uword i = 0; i < Ef.size(); ++i) {
+        EXPECT_NEAR(1.0, N(i)/find_pop(Esb, Ef(i), m, Te(i), alpha, V), 1e-10);
+    }
+
+    // Far below the subband, both versions return the same tiny population
+    const arma::vec Ef_low = {Esb - 800*kB*Te(0)};
+    const arma::vec Te_low = {Te(0)};
+    EXPECT_DOUBLE_EQ(find_pop(Esb, Ef_low(0), m, Te_low(0), alpha, V),
+                     find_pop(Esb, Ef_low, m, Te_low, alpha, V)(0));
+
+    const auto f = f_FD(Ef, Esb, Te);
+
+    for(arma::uword i = 0; i < Ef.size(); ++i) {
+        EXPECT_NEAR(f_FD(Ef(i), Esb, Te(i)), f(i), 1e-12);
+    }
+}
+
+/**
+ * Check that the tabulated occupation of a subband matches the Fermi-Dirac
+ * distribution, including the crossover between degenerate and
+ * non-degenerate statistics
+ */
+TEST(Fermi, subbandOccupationTableTest)
+{
+    const double m     = 0.067*me;
+    const double alpha = 0.7/e;
+    const double Esb   = 50e-3*e;
+    const double Te    = 77.0;
+
+    const arma::vec    z   = arma::linspace(0, 10e-9, 101);
+    const arma::cx_vec psi(z.n_elem, arma::fill::ones);
+    const Eigenstate   ground(Esb, z, psi);
+
+    // Non-degenerate, crossover (Fermi energy at subband minimum) and degenerate cases
+    const arma::vec Ef = {Esb - 10*kB*Te, Esb, Esb + 0.1*kB*Te, Esb + 10*kB*Te};
+
+    for(auto Ef_i : Ef)
+    {
+        Subband tabulated(ground, m, alpha, 0.0);
+        Subband direct(ground, m, alpha, 0.0);
+
+        EXPECT_TRUE(tabulated.get_occupation_table());
+        direct.set_occupation_table(false);
+        EXPECT_FALSE(direct.get_occupation_table());
+
+        tabulated.set_distribution_from_Ef_Te(Ef_i, Te);
+        direct.set_distribution_from_Ef_Te(Ef_i, Te);
+
+        // Sample beyond the end of the table too, to check the fallback
+        const auto k_max = tabulated.get_k_at_Ek(std::max(Ef_i - Esb, 0.0) + 60*kB*Te);
+        const arma::vec k = arma::linspace(0, k_max, 997);
+
+        const auto f_tabulated = tabulated.get_occupation_at_k(k);
+        const auto f_direct    = direct.get_occupation_at_k(k);
+
+        for(arma::uword ik = 0; ik < k.n_elem; ++ik)
+        {
+            const auto E = tabulated.get_E_total_at_k(k(ik));
+            EXPECT_DOUBLE_EQ(f_FD(Ef_i, E, Te), f_direct(ik));
+            EXPECT_NEAR(f_direct(ik), f_tabulated(ik), 1e-5);
+            EXPECT_NEAR(direct.get_occupation_at_E_total(E), tabulated.get_occupation_at_E_total(E), 1e-5);
+        }
+    }
+
+    // A zero temperature would give an occupation table with no spacing
+    Subband subband(ground, m, alpha, 0.0);
+    EXPECT_THROW(subband.set_distribution_from_Ef_Te(Esb, 0.0), std::domain_error);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
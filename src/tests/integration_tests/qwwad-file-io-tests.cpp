@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "qwwad/file-io.h"
+
+using namespace QWWAD;
+
+namespace {
+/**
+ * Write a string to a file
+ */
+void write_file(const std::string &filename,
+                const std::string &contents)
+{
+    std::ofstream stream(filename, std::ios::binary);
+    stream << contents;
+}
+} // namespace
+
+/**
+ * Check that numbers in the formats accepted by stream input are read
+ */
+TEST(FileIO, readColumnsTest)
+{
+    const std::string filename = "file-io-read-test.r";
+    write_file(filename, "1 +2.5e-3\n\n\t2  -4E2 extra\r\n3 1e-400\n");
+
+    std::vector<int>    i;
+    std::vector<double> x;
+    read_columns(filename, i, x);
+
+    ASSERT_EQ(3U, i.size());
+    EXPECT_EQ(2, i[1]);
+    EXPECT_DOUBLE_EQ(2.5e-3, x[0]);
+    EXPECT_DOUBLE_EQ(-400.0, x[1]);
+    EXPECT_DOUBLE_EQ(0.0,    x[2]);
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check that items with trailing characters are rejected
+ */
+TEST(FileIO, rejectTrailingCharactersTest)
+{
+    const std::string filename = "file-io-reject-test.r";
+    std::vector<double> x;
+    std::vector<int>    i;
+
+    write_file(filename, "1.0\n1.5x\n");
+    EXPECT_THROW(read_columns(filename, x), std::runtime_error);
+
+    write_file(filename, "1.5\n");
+    EXPECT_THROW(read_columns(filename, i), std::runtime_error);
+
+    write_file(filename, "1e-400x\n");
+    EXPECT_THROW(read_columns(filename, x), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+/**
+ * Check that block sizes are multiplied without overflow
+ */
+TEST(FileIO, multiplySizesTest)
+{
+    uint64_t product = 99;
+
+    EXPECT_TRUE(multiply_sizes({101, 7, 16}, product));
+    EXPECT_EQ(101U*7U*16U, product);
+
+    // 2^30 * 2^30 * 16 = 2^64, which would wrap to zero
+    EXPECT_FALSE(multiply_sizes({1ULL << 30, 1ULL << 30, 16}, product));
+    EXPECT_TRUE(multiply_sizes({1ULL << 30, 1ULL << 29, 16}, product));
+    EXPECT_EQ(1ULL << 63, product);
+
+    // Any zero dimension gives an empty block
+    EXPECT_TRUE(multiply_sizes({1ULL << 40, 1ULL << 40, 0}, product));
+    EXPECT_EQ(0U, product);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "qwwad/heat-equation.h"
+#include "qwwad/linear-algebra.h"
+
+using namespace QWWAD;
+
+namespace {
+const size_t ny     = 101;    ///< Number of points
+const double dy     = 1e-6;   ///< Spatial step [m]
+const size_t m_if   = 60;     ///< Index of first point in the upper layer
+const double k1     = 30.0;   ///< Conductivity of lower layer [W/m/K]
+const double k2     = 3.0;    ///< Conductivity of upper layer [W/m/K]
+const double rho_cp = 1.6e6;  ///< Heat capacity per unit volume [J/(m^3.K)]
+const double q0     = 1e14;   ///< Power density [W/m^3]
+const double Tsink  = 80.0;   ///< Heatsink temperature [K]
+
+/**
+ * Time-step using the stencil from qwwad_thermal_1d before the thermal
+ * conductivity was found for each layer at once.  The conductivities at
+ * neighbouring points were passed along a chain that lagged by one point,
+ * so the interface was shifted by one point in one direction only.
+ */
+auto baseline_step(const double     dt,
+                   const arma::vec &Told,
+                   const arma::vec &k,
+                   const arma::vec &q) -> arma::vec
+{
+    const auto dy_sq = dy*dy;
+    arma::vec LHS_diag      = arma::ones(ny);
+    arma::vec LHS_subdiag   = arma::zeros(ny-1);
+    arma::vec LHS_superdiag = arma::zeros(ny-1);
+    arma::vec B_diag        = arma::ones(ny);
+    arma::vec B_superdiag   = arma::zeros(ny-1);
+    arma::vec B_subdiag     = arma::zeros(ny-1);
+    arma::vec c             = arma::zeros(ny);
+
+    double k_prev = k(0);
+    double k_this = k(1);
+    double k_next = k(2);
+
+    for(unsigned int iy=1; iy<ny-1; iy++)
+    {
+        const auto kn = (2*k_this*k_next)/(k_this+k_next);
+        const auto ks = (2*k_this*k_prev)/(k_this+k_prev);
+        const auto r = dt/(2.0*rho_cp);
+        const auto alpha = r*ks/dy_sq;
+        const auto gamma = r*kn/dy_sq;
+
+        B_subdiag(iy-1) = alpha;
+        B_superdiag(iy) = gamma;
+        B_diag(iy)      = 1.0 - (alpha+gamma);
+
+        LHS_subdiag(iy-1) = -alpha;
+        LHS_superdiag(iy) = -gamma;
+        LHS_diag(iy)      = 1.0 + (alpha+gamma);
+
+        c(iy) = 2.0*r*q(iy);
+
+        k_prev = k_this;
+        k_this = k_next;
+        k_next = k(iy+1);
+    }
+
+    const auto kns = (2*k_next*k_this)/(k_next+k_this);
+    const auto r = dt/(2.0*rho_cp);
+    const auto alpha_gamma = r*kns/dy_sq;
+    B_subdiag(ny-2)   = 2.0*alpha_gamma;
+    B_diag(ny-1)      = 1.0 - 2.0*alpha_gamma;
+    LHS_subdiag(ny-2) = -2.0*alpha_gamma;
+    LHS_diag(ny-1)    = 1.0 + 2.0*alpha_gamma;
+    c(ny-1) = 2.0*r*q(ny-1);
+
+    const auto RHS = multiply_vec_tridiag(B_subdiag, B_diag, B_superdiag, Told, c);
+    return solve_tridiag(LHS_subdiag, LHS_diag, LHS_superdiag, RHS);
+}
+
+/**
+ * Step a profile towards the steady state
+ *
+ * \details Crank-Nicolson damps the fastest modes very slowly for long
+ *          steps, so the step length is cycled over several decades.
+ */
+template<class Step>
+auto find_steady_state(const Step &step) -> arma::vec
+{
+    const double L  = dy*(ny-1);
+    const double dt_max = 10*L*L*rho_cp/k1;
+
+    arma::vec T(ny);
+    T.fill(Tsink);
+
+    for(unsigned int icycle = 0; icycle < 20; ++icycle) {
+        for(unsigned int j = 0; j < 25; ++j) {
+            T = step(dt_max*std::pow(10.0, -0.25*j), T);
+        }
+    }
+
+    return T;
+}
+
+/**
+ * Analytical steady state for uniform heating of a two-layer slab with an
+ * insulated top, with the interface midway between two points
+ */
+auto analytic_steady_state() -> arma::vec
+{
+    const double L    = dy*(ny-1);
+    const double y_if = (m_if - 0.5)*dy;
+    const double T_if = Tsink + q0/k1*(L*y_if - y_if*y_if/2);
+
+    arma::vec T(ny);
+
+    for(unsigned int iy = 0; iy < ny; ++iy)
+    {
+        const double y = iy*dy;
+        T(iy) = (y < y_if) ? Tsink + q0/k1*(L*y - y*y/2)
+                           : T_if + q0/k2*(L*(y - y_if) - (y*y - y_if*y_if)/2);
+    }
+
+    return T;
+}
+} // namespace
+
+/**
+ * Check the steady-state temperature profile through a heated two-layer
+ * slab, and that the lagged stencil used previously gave the wrong profile
+ */
+TEST(HeatEquation, twoLayerSteadyStateTest)
+{
+    arma::vec k(ny);
+    k.fill(k1);
+    k.tail(ny - m_if).fill(k2);
+
+    const arma::vec rho_cp_vec = rho_cp*arma::ones(ny);
+    const arma::vec q          = q0*arma::ones(ny);
+
+    const auto T_exact = analytic_steady_state();
+    const auto dT      = T_exact(ny-1) - Tsink;
+
+    const auto T_new = find_steady_state([&](double dt, const arma::vec &T) {
+        return heat_step_crank_nicolson(dt, dy, T, k, rho_cp_vec, q, q);
+    });
+
+    const auto T_old = find_steady_state([&](double dt, const arma::vec &T) {
+        return baseline_step(dt, T, k, q);
+    });
+
+    EXPECT_DOUBLE_EQ(Tsink, T_new(0));
+    EXPECT_LT(arma::abs(T_new - T_exact).max()/dT, 1e-3);
+
+    // The lagged stencil put the interface one point too high, which
+    // underestimated the peak temperature by about 3%
+    EXPECT_GT(std::abs(T_old(ny-1) - T_exact(ny-1))/dT, 1e-2);
+}
+
+/**
+ * Check that a single step with no heating conserves a uniform profile,
+ * and that mismatched profiles are rejected
+ */
+TEST(HeatEquation, uniformProfileTest)
+{
+    const arma::vec T = Tsink*arma::ones(ny);
+    const arma::vec k = k1*arma::ones(ny);
+    const arma::vec c = rho_cp*arma::ones(ny);
+    const arma::vec q = arma::zeros(ny);
+
+    const auto T_next = heat_step_crank_nicolson(1e-6, dy, T, k, c, q, q);
+
+    for(unsigned int iy = 0; iy < ny; ++iy) {
+        EXPECT_NEAR(Tsink, T_next(iy), 1e-10);
+    }
+
+    EXPECT_THROW(static_cast<void>(heat_step_crank_nicolson(1e-6, dy, T, arma::vec(ny-1), c, q, q)),
+                 std::length_error);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
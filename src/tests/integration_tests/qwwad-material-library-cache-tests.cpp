@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "qwwad/material.h"
+#include "qwwad/material-library.h"
+#include "qwwad/material-library-cache.h"
+#include "qwwad/material-property-handle.h"
+#include "qwwad/material-property-numeric.h"
+#include "qwwad/material-property-string.h"
+
+using namespace QWWAD;
+
+namespace {
+/// Document type for a material library, which the XML parser validates against
+const std::string library_dtd = R"(<?xml version="1.0" ?>
+<!DOCTYPE material-library
+[
+<!ELEMENT material-library (material+)>
+<!ELEMENT material (property*)>
+<!ELEMENT property (#PCDATA|interp|poly|string)*>
+<!ELEMENT interp (y0,y1,bow*)>
+<!ELEMENT y0 (#PCDATA)>
+<!ELEMENT y1 (#PCDATA)>
+<!ELEMENT bow (#PCDATA)>
+<!ELEMENT poly (ai+)>
+<!ELEMENT ai (#PCDATA)>
+<!ELEMENT string (#PCDATA)>
+
+<!ATTLIST material name        ID    #REQUIRED>
+<!ATTLIST material description CDATA #IMPLIED>
+<!ATTLIST property name        CDATA #REQUIRED>
+<!ATTLIST property description CDATA #IMPLIED>
+<!ATTLIST property unit        CDATA "">
+<!ATTLIST property reference   CDATA #IMPLIED>
+<!ATTLIST interp   xmin        CDATA "0">
+<!ATTLIST interp   xmax        CDATA "1">
+<!ATTLIST poly     xmin        CDATA #IMPLIED>
+<!ATTLIST poly     xmax        CDATA #IMPLIED>
+<!ATTLIST ai       i           CDATA #REQUIRED>
+<!ATTLIST ai       j           CDATA "0">
+]>
+)";
+
+/**
+ * Write a small material library, with one property of each type
+ *
+ * \param[in] filename Name of XML file
+ * \param[in] eps      Text of the constant property in the first material
+ */
+void write_library(const std::string &filename,
+                   const std::string &eps)
+{
+    std::ofstream stream(filename, std::ios::trunc);
+    stream << library_dtd << R"(
+<material-library>
+    <material name="AlGaAsP" description="Test alloy">
+        <property name="eps" description="Relative permittivity">)" << eps << R"(</property>
+        <property name="gap" description="Band gap" unit="eV" reference="test">
+            <interp>
+                <y0>1.5</y0>
+                <y1>2.0</y1>
+                <bow>0.3</bow>
+            </interp>
+        </property>
+        <property name="mass" description="Effective mass">
+            <poly>
+                <ai i="0">0.067</ai>
+                <ai i="1">0.083</ai>
+                <ai i="2">-0.01</ai>
+                <ai i="1" j="1">0.02</ai>
+            </poly>
+        </property>
+        <property name="cation" description="Group-III element">
+            <string>Ga</string>
+        </property>
+    </material>
+
+    <material name="air">
+        <property name="eps">1</property>
+    </material>
+</material-library>
+)";
+}
+
+/**
+ * Use a fresh cache directory for each test
+ */
+class MaterialLibraryCacheTest : public ::testing::Test {
+protected:
+    std::filesystem::path cache_dir;
+    std::string           xml_filename;
+
+    void SetUp() override
+    {
+        const auto *name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        cache_dir = std::filesystem::temp_directory_path() /
+                    ("qwwad-cache-test-" + std::to_string(getpid()) + "-" + name);
+        std::filesystem::remove_all(cache_dir);
+        setenv("QWWAD_CACHE_DIR", cache_dir.c_str(), 1);
+
+        xml_filename = std::string("material-library-cache-test-") + name + ".xml";
+        write_library(xml_filename, "12.5");
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(cache_dir);
+        std::filesystem::remove(xml_filename);
+        unsetenv("QWWAD_CACHE_DIR");
+    }
+
+    /// Move the modification time of the XML file forward, so that it can't match the cache
+    void touch_library() const
+    {
+        const auto t = std::filesystem::last_write_time(xml_filename);
+        std::filesystem::last_write_time(xml_filename, t + std::chrono::seconds(10));
+    }
+};
+} // namespace
+
+/**
+ * Check that a library is compiled on first use, and that the compiled
+ * index matches the XML file
+ */
+TEST_F(MaterialLibraryCacheTest, roundTripTest)
+{
+    EXPECT_EQ(nullptr, MaterialLibraryCache::open(xml_filename));
+
+    // Parsing the XML file writes the cache
+    {
+        const MaterialLibrary library(xml_filename);
+    }
+
+    const auto cache = MaterialLibraryCache::open(xml_filename);
+    ASSERT_NE(nullptr, cache);
+
+    const auto imat = cache->find_material("AlGaAsP");
+    ASSERT_GE(imat, 0);
+    EXPECT_EQ(-1, cache->find_material("GaN"));
+    EXPECT_GE(cache->find_material("air"), 0);
+
+    EXPECT_STREQ("AlGaAsP",    cache->get_material_name(imat));
+    EXPECT_STREQ("Test alloy", cache->get_material_description(imat));
+    ASSERT_EQ(4U, cache->get_n_properties(imat));
+
+    // Properties are sorted by name
+    EXPECT_STREQ("cation", cache->get_property_name(imat, 0));
+    EXPECT_STREQ("eps",    cache->get_property_name(imat, 1));
+    EXPECT_STREQ("gap",    cache->get_property_name(imat, 2));
+    EXPECT_STREQ("mass",   cache->get_property_name(imat, 3));
+    EXPECT_EQ(2,  cache->find_property(imat, "gap"));
+    EXPECT_EQ(-1, cache->find_property(imat, "density"));
+}
+
+/**
+ * Check that materials looked up lazily from the cache give exactly the same
+ * properties as those parsed from the XML file
+ */
+TEST_F(MaterialLibraryCacheTest, lazyLookupTest)
+{
+    const MaterialLibrary parsed(xml_filename);
+    ASSERT_NE(nullptr, MaterialLibraryCache::open(xml_filename));
+    const MaterialLibrary cached(xml_filename);
+
+    const auto *mat_parsed = parsed.get_material("AlGaAsP");
+    const auto *mat_cached = cached.get_material("AlGaAsP");
+
+    EXPECT_EQ(mat_parsed->get_name(),        mat_cached->get_name());
+    EXPECT_EQ(mat_parsed->get_description(), mat_cached->get_description());
+
+    for(const auto *name : {"eps", "gap", "mass"})
+    {
+        const auto *prop_parsed = mat_parsed->get_numeric_property(name);
+        const auto *prop_cached = mat_cached->get_numeric_property(name);
+
+        EXPECT_EQ(prop_parsed->get_unit(),        prop_cached->get_unit())        << name;
+        EXPECT_EQ(prop_parsed->get_description(), prop_cached->get_description()) << name;
+        EXPECT_EQ(prop_parsed->get_reference(),   prop_cached->get_reference())   << name;
+
+        for(const double x : {0.0, 0.3, 1.0})
+        {
+            EXPECT_DOUBLE_EQ(prop_parsed->get_val(x),      prop_cached->get_val(x))      << name << " at x = " << x;
+            EXPECT_DOUBLE_EQ(prop_parsed->get_val(x, 0.4), prop_cached->get_val(x, 0.4)) << name << " at x = " << x;
+        }
+    }
+
+    EXPECT_DOUBLE_EQ(12.5, mat_cached->get_property_value("eps"));
+
+    const auto *text = dynamic_cast<const MaterialPropertyString *>(mat_cached->get_property("cation"));
+    ASSERT_NE(nullptr, text);
+    EXPECT_EQ("Ga", text->get_text());
+
+    EXPECT_DOUBLE_EQ(1.0, cached.get_material("air")->get_property_value("eps"));
+    EXPECT_THROW(static_cast<void>(cached.get_material("GaN")), std::runtime_error);
+}
+
+/**
+ * Check that handles find the right kind of property, and evaluate it in the
+ * same way as a lookup by name
+ */
+TEST_F(MaterialLibraryCacheTest, propertyHandleTest)
+{
+    const MaterialLibrary library(xml_filename);
+    const auto *mat = library.get_material("AlGaAsP");
+
+    const MaterialPropertyHandle eps(*mat,  "eps");
+    const MaterialPropertyHandle gap(*mat,  "gap");
+    const MaterialPropertyHandle mass(*mat, "mass");
+
+    EXPECT_EQ(PROPERTY_KIND_CONSTANT, eps.get_kind());
+    EXPECT_EQ(PROPERTY_KIND_INTERP,   gap.get_kind());
+    EXPECT_EQ(PROPERTY_KIND_POLY,     mass.get_kind());
+    EXPECT_EQ("eV", gap.get_unit());
+
+    const arma::vec x = arma::linspace(0, 1, 5);
+    arma::vec y(x.n_elem);
+    y.fill(0.4);
+
+    for(const auto *handle : {&eps, &gap, &mass})
+    {
+        const auto &name   = handle->get_property().get_name();
+        const auto  val_x  = handle->get_val(x);
+        const auto  val_xy = handle->get_val(x, y);
+
+        for(arma::uword i = 0; i < x.n_elem; ++i)
+        {
+            EXPECT_NEAR(mat->get_property_value(name.c_str(), x(i)), val_x(i), 1e-12) << name << " at x = " << x(i);
+            EXPECT_NEAR(handle->get_val(x(i), 0.4), val_xy(i), 1e-12) << name << " at x = " << x(i);
+        }
+    }
+
+    EXPECT_THROW(MaterialPropertyHandle(*mat, "cation"), std::runtime_error);
+}
+
+/**
+ * Check that the cache is rebuilt whenever the XML file changes, but
+ * survives a change of timestamp alone
+ */
+TEST_F(MaterialLibraryCacheTest, invalidationTest)
+{
+    {
+        const MaterialLibrary library(xml_filename);
+    }
+
+    ASSERT_NE(nullptr, MaterialLibraryCache::open(xml_filename));
+
+    // Same contents, new timestamp: the contents are hashed and still match
+    touch_library();
+    EXPECT_NE(nullptr, MaterialLibraryCache::open(xml_filename));
+
+    // Same size, new contents
+    write_library(xml_filename, "13.5");
+    touch_library();
+    EXPECT_EQ(nullptr, MaterialLibraryCache::open(xml_filename));
+
+    {
+        const MaterialLibrary library(xml_filename);
+        EXPECT_DOUBLE_EQ(13.5, library.get_material("AlGaAsP")->get_property_value("eps"));
+    }
+
+    // The cache has been rebuilt from the new file
+    {
+        ASSERT_NE(nullptr, MaterialLibraryCache::open(xml_filename));
+        const MaterialLibrary library(xml_filename);
+        EXPECT_DOUBLE_EQ(13.5, library.get_material("AlGaAsP")->get_property_value("eps"));
+    }
+
+    // New size
+    write_library(xml_filename, "9.25");
+    EXPECT_EQ(nullptr, MaterialLibraryCache::open(xml_filename));
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
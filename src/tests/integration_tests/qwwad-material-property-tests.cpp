@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "qwwad/material-property-constant.h"
+#include "qwwad/material-property-interp.h"
+#include "qwwad/material-property-poly.h"
+
+using namespace QWWAD;
+
+namespace {
+/**
+ * Compare the batch evaluation of a property with the scalar version at each point.
+ * Polynomials are summed in a different order, so allow for rounding error.
+ */
+void expect_batch_matches_scalar(const MaterialPropertyNumeric &prop)
+{
+    const arma::vec x = arma::linspace(0, 1, 11);
+    const arma::vec y = arma::linspace(0.5, 0, 11);
+
+    const auto val_x  = prop.get_val(x);
+    const auto val_xy = prop.get_val(x, y);
+
+    ASSERT_EQ(x.n_elem, val_x.n_elem);
+    ASSERT_EQ(x.n_elem, val_xy.n_elem);
+
+    for(arma::uword i = 0; i < x.n_elem; ++i)
+    {
+        EXPECT_NEAR(prop.get_val(x(i)),       val_x(i),  1e-12) << prop.get_name() << " at x = " << x(i);
+        EXPECT_NEAR(prop.get_val(x(i), y(i)), val_xy(i), 1e-12) << prop.get_name() << " at x = " << x(i);
+    }
+}
+} // namespace
+
+TEST(MaterialProperty, batchConstantTest)
+{
+    const MaterialPropertyConstant prop("eps", "Permittivity", "", "", 12.9);
+    expect_batch_matches_scalar(prop);
+    EXPECT_DOUBLE_EQ(12.9, prop.get_val(0.3));
+}
+
+TEST(MaterialProperty, batchInterpTest)
+{
+    const MaterialPropertyInterp prop("Eg", "Band gap", "", "eV", 1.519, 2.239, -0.37);
+    expect_batch_matches_scalar(prop);
+    EXPECT_NEAR(1.519*0.7 + 2.239*0.3 - 0.37*0.3*0.7, prop.get_val(0.3));
+}
+
+TEST(MaterialProperty, batchPolyTest)
+{
+    // Terms in x only, and terms that depend on y
+    const MaterialPropertyPoly prop("m", "Effective mass", "", "",
+                                    {{0, 0.067}, {1, 0.083}, {2, -0.01}},
+                                    {{{0, 1}, 0.02}, {{1, 1}, -0.05}, {{0, 2}, 0.004}});
+    expect_batch_matches_scalar(prop);
+    EXPECT_NEAR(0.067 + 0.083*0.3 - 0.01*0.09, prop.get_val(0.3), 1e-12);
+    EXPECT_NEAR(0.067 + 0.083*0.3 - 0.01*0.09 + 0.02*0.5 - 0.05*0.15 + 0.004*0.25,
+                prop.get_val(0.3, 0.5), 1e-12);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include "qwwad/poisson-solver-multigrid.h"
+#include "qwwad/constants.h"
+
+using namespace QWWAD;
+using namespace constants;
+
+/**
+ * Eigenvalue of the discrete 1D Laplacian for the lowest mode in a box of n cells
+ */
+static auto discrete_eigenvalue(const double h, const size_t n) -> double
+{
+    const double s = sin(pi/(2.0*n));
+    return 4.0*s*s/(h*h);
+}
+
+TEST(PoissonSolverMultigrid, dirichlet3DTest)
+{
+    const size_t n   = 32;
+    const double h   = 1e-9;
+    const double eps = 12.9*eps0;
+
+    arma::cube eps_cube(n, n, n);
+    eps_cube.fill(eps);
+    const PoissonSolverMultigrid solver(eps_cube, h, h, h);
+
+    // The lowest sine mode is an exact eigenvector of the discrete operator
+    arma::cube phi_expected(n, n, n);
+
+    for(size_t k = 0; k < n; ++k) {
+        for(size_t j = 0; j < n; ++j) {
+            for(size_t i = 0; i < n; ++i) {
+                phi_expected(i,j,k) = sin(pi*(i+0.5)/n)*sin(pi*(j+0.5)/n)*sin(pi*(k+0.5)/n);
+            }
+        }
+    }
+
+    const double lambda = 3.0*discrete_eigenvalue(h, n);
+    const arma::cube rho = eps*lambda*phi_expected;
+
+    const auto phi = solver.solve(rho);
+
+    EXPECT_GT(solver.get_n_levels(), 1U);
+    EXPECT_NEAR(0.0, arma::abs(phi - phi_expected).max(), 1e-5);
+}
+
+TEST(PoissonSolverMultigrid, zeroField2DTest)
+{
+    const size_t nx  = 64;
+    const size_t ny  = 32;
+    const double h   = 1e-9;
+    const double eps = 12.9*eps0;
+
+    arma::mat eps_mat(nx, ny);
+    eps_mat.fill(eps);
+    const PoissonSolverMultigrid solver(eps_mat, h, h, ZERO_FIELD, ZERO_FIELD);
+
+    // The lowest cosine mode has zero mean, so it is the unique solution
+    arma::mat phi_expected(nx, ny);
+
+    for(size_t j = 0; j < ny; ++j) {
+        for(size_t i = 0; i < nx; ++i) {
+            phi_expected(i,j) = cos(pi*(i+0.5)/nx);
+        }
+    }
+
+    const arma::mat rho = eps*discrete_eigenvalue(h, nx)*phi_expected;
+
+    const auto phi = solver.solve(rho);
+
+    EXPECT_NEAR(0.0, arma::abs(phi - phi_expected).max(), 1e-5);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
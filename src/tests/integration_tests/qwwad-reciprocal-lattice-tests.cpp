@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cmath>
+
+#include "qwwad/reciprocal-lattice.h"
+
+using namespace QWWAD;
+
+namespace {
+/**
+ * Count the vectors found by the original search in qwwad_reciprocal_fcc,
+ * which scans integer coefficients of the bcc reciprocal basis
+ *
+ * \param[in] G_max Largest magnitude of vector [2 pi/A0]
+ */
+auto count_fcc_loop(const int G_max) -> size_t
+{
+    size_t n = 0;
+
+    for(int b1 = -G_max; b1 <= G_max; ++b1) {
+        for(int b2 = -G_max; b2 <= G_max; ++b2) {
+            for(int b3 = -G_max; b3 <= G_max; ++b3)
+            {
+                const int g1 =  b1 - b2 + b3;
+                const int g2 =  b1 + b2 - b3;
+                const int g3 = -b1 + b2 + b3;
+
+                if(g1*g1 + g2*g2 + g3*g3 <= G_max*G_max) {
+                    ++n;
+                }
+            }
+        }
+    }
+
+    return n;
+}
+
+/**
+ * Count the vectors found by the original search in qwwad_reciprocal_cube,
+ * which scans steps of 1/n along each axis.  The steps are counted in
+ * integers here, so that no rounding error accumulates.
+ *
+ * \param[in] G_max Largest magnitude of vector [2 pi/A0]
+ * \param[in] n_x   Number of unit cells along x
+ * \param[in] n_y   Number of unit cells along y
+ * \param[in] n_z   Number of unit cells along z
+ */
+auto count_cube_loop(const int G_max,
+                     const int n_x,
+                     const int n_y,
+                     const int n_z) -> size_t
+{
+    size_t n = 0;
+
+    for(int m1 = -G_max*n_x; m1 <= G_max*n_x; ++m1) {
+        for(int m2 = -G_max*n_y; m2 <= G_max*n_y; ++m2) {
+            for(int m3 = -G_max*n_z; m3 <= G_max*n_z; ++m3)
+            {
+                // Compare |G|^2 <= G_max^2 after multiplying by (n_x n_y n_z)^2
+                const long long a = static_cast<long long>(m1)*n_y*n_z;
+                const long long b = static_cast<long long>(m2)*n_x*n_z;
+                const long long c = static_cast<long long>(m3)*n_x*n_y;
+                const long long scale = static_cast<long long>(G_max)*n_x*n_y*n_z;
+
+                if(a*a + b*b + c*c <= scale*scale) {
+                    ++n;
+                }
+            }
+        }
+    }
+
+    return n;
+}
+
+/// Check that vectors are sorted by magnitude
+void expect_sorted(const ReciprocalLattice &lattice)
+{
+    for(unsigned int iG = 1; iG < lattice.get_n_G(); ++iG)
+    {
+        const double G_prev = arma::norm(lattice.get_G_unit(iG-1));
+        const double G_this = arma::norm(lattice.get_G_unit(iG));
+        EXPECT_LE(G_prev, G_this*(1.0 + 1e-12)) << "at vector " << iG;
+    }
+}
+} // namespace
+
+/**
+ * Check that the fcc lattice has the same vectors as the original search
+ */
+TEST(ReciprocalLatticeTest, fccTest)
+{
+    for(int G_max = 0; G_max <= 6; ++G_max)
+    {
+        const auto lattice = ReciprocalLattice::fcc(G_max);
+        EXPECT_EQ(count_fcc_loop(G_max), lattice.get_n_G()) << "with G_max = " << G_max;
+        expect_sorted(lattice);
+    }
+
+    // The first shells of the bcc reciprocal lattice: Gamma, 8 (111) and 6 (200)
+    const auto lattice = ReciprocalLattice::fcc(2.0);
+    ASSERT_EQ(15U, lattice.get_n_G());
+    EXPECT_DOUBLE_EQ(0.0, arma::norm(lattice.get_G_unit(0)));
+    EXPECT_DOUBLE_EQ(std::sqrt(3.0), arma::norm(lattice.get_G_unit(1)));
+    EXPECT_DOUBLE_EQ(2.0, arma::norm(lattice.get_G_unit(14)));
+}
+
+/**
+ * Check that cubic supercells have the same vectors as the original search
+ */
+TEST(ReciprocalLatticeTest, cubicSupercellTest)
+{
+    for(int G_max = 0; G_max <= 3; ++G_max)
+    {
+        for(const auto &n : {std::array<int, 3>{1, 1, 1},
+                             std::array<int, 3>{2, 2, 2},
+                             std::array<int, 3>{1, 2, 3},
+                             std::array<int, 3>{4, 1, 1}})
+        {
+            const auto lattice = ReciprocalLattice::cubic_supercell(G_max, n[0], n[1], n[2]);
+            EXPECT_EQ(count_cube_loop(G_max, n[0], n[1], n[2]), lattice.get_n_G())
+                << "with G_max = " << G_max << " and " << n[0] << "x" << n[1] << "x" << n[2] << " cells";
+            expect_sorted(lattice);
+        }
+    }
+
+    EXPECT_THROW(static_cast<void>(ReciprocalLattice::cubic_supercell(1.0, 0, 1, 1)), std::domain_error);
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
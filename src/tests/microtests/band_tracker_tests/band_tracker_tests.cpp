@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "qwwad/band-tracker.h"
+
+using namespace QWWAD;
+
+namespace {
+/**
+ * Two uncoupled states with energies +k and -k, which cross at k = 0.
+ * The solver returns them in order of energy, so their order swaps.
+ */
+void solve_crossing(const arma::vec &k,
+                    arma::vec       &E,
+                    arma::cx_mat    &X)
+{
+    arma::cx_mat H(2, 2, arma::fill::zeros);
+    H(0,0) =  k(0);
+    H(1,1) = -k(0);
+    arma::eig_sym(E, X, H);
+}
+
+/// A single band with energy k^2
+void solve_parabola(const arma::vec &k,
+                    arma::vec       &E,
+                    arma::cx_mat    &X)
+{
+    E = arma::vec{k(0)*k(0)};
+    X = arma::cx_mat(1, 1, arma::fill::ones);
+}
+
+/// Get the first component of the wave vector at each point on the path
+auto get_kx(const BandTracker &tracker) -> std::vector<double>
+{
+    std::vector<double> kx;
+
+    for(const auto &k : tracker.get_k()) {
+        kx.push_back(k(0));
+    }
+
+    return kx;
+}
+} // namespace
+
+/**
+ * Check that each band keeps its label through a crossing
+ */
+TEST(BandTrackerTest, crossingTest)
+{
+    BandTracker tracker(solve_crossing, 1e-6);
+    tracker.trace({arma::vec{-1.0}, arma::vec{1.0}}, 5);
+
+    const auto  kx = get_kx(tracker);
+    const auto &E  = tracker.get_energies();
+
+    // The bands are straight lines, so no step is refined
+    ASSERT_EQ(6U, kx.size());
+    ASSERT_EQ(2U, E.n_cols);
+    EXPECT_EQ(6U, tracker.get_n_solves());
+
+    // At the start, the lower band is the one with energy +k
+    for(unsigned int ik = 0; ik < kx.size(); ++ik)
+    {
+        EXPECT_NEAR( kx[ik], E(ik, 0), 1e-12) << "at k = " << kx[ik];
+        EXPECT_NEAR(-kx[ik], E(ik, 1), 1e-12) << "at k = " << kx[ik];
+    }
+}
+
+/**
+ * Check that steps are bisected where a band curves away from a
+ * straight-line extrapolation
+ */
+TEST(BandTrackerTest, curvatureRefinementTest)
+{
+    BandTracker tracker(solve_parabola, 0.1);
+    tracker.trace({arma::vec{0.0}, arma::vec{1.0}}, 2);
+
+    // The first step can't be checked, since there's no slope yet.  The
+    // second step misses the extrapolation by 0.5 so it is bisected, and the
+    // first half of that is bisected again.
+    const std::vector<double> kx_expected = {0.0, 0.5, 0.625, 0.75, 1.0};
+    EXPECT_EQ(kx_expected, get_kx(tracker));
+
+    const auto &E = tracker.get_energies();
+
+    for(unsigned int ik = 0; ik < kx_expected.size(); ++ik) {
+        EXPECT_DOUBLE_EQ(kx_expected[ik]*kx_expected[ik], E(ik, 0));
+    }
+}
+
+/**
+ * Check that steps are never bisected more than the maximum number of times
+ */
+TEST(BandTrackerTest, maxDepthTest)
+{
+    // Every step on a parabola misses this tolerance
+    BandTracker tracker(solve_parabola, 1e-12, 3);
+    tracker.trace({arma::vec{0.0}, arma::vec{1.0}}, 2);
+
+    const auto kx = get_kx(tracker);
+
+    // The first step is kept, and the second is split into 2^3 parts
+    ASSERT_EQ(10U, kx.size());
+    EXPECT_DOUBLE_EQ(0.5, kx[1]);
+
+    for(unsigned int ik = 2; ik < kx.size(); ++ik) {
+        EXPECT_DOUBLE_EQ(0.0625, kx[ik] - kx[ik-1]);
+    }
+
+    // The first point, the first step, and one solution at each level of bisection
+    EXPECT_EQ(1U + 1U + 1U + 2U + 4U + 8U, tracker.get_n_solves());
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
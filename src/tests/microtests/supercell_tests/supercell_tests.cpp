@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "qwwad/supercell.h"
+
+using namespace QWWAD;
+
+class SupercellTest : public ::testing::Test
+{
+protected:
+    /// A 4x4x4 cube of GaAs, with 256 cations and 256 anions
+    Supercell cell = Supercell::zinc_blende(5.65e-10, 4, 4, 4, "GA", "AS");
+
+    /// Count the atoms of a species
+    static auto count_species(const Supercell &c, const std::string &name) -> size_t
+    {
+        const auto &names = c.get_species_names();
+        const auto  it    = std::find(names.begin(), names.end(), name);
+
+        if(it == names.end()) {
+            return 0;
+        }
+
+        const auto id = static_cast<Supercell::SpeciesID>(std::distance(names.begin(), it));
+        return std::count(c.get_species().begin(), c.get_species().end(), id);
+    }
+
+    static void expect_cells_equal(const Supercell &expected,
+                                   const Supercell &actual)
+    {
+        ASSERT_EQ(expected.get_n_atoms(), actual.get_n_atoms());
+        EXPECT_EQ(expected.get_species_names(), actual.get_species_names());
+        EXPECT_EQ(expected.get_species(), actual.get_species());
+        EXPECT_EQ(expected.get_x(), actual.get_x());
+        EXPECT_EQ(expected.get_y(), actual.get_y());
+        EXPECT_EQ(expected.get_z(), actual.get_z());
+    }
+};
+
+TEST_F(SupercellTest, makeAlloyExactCountTest)
+{
+    ASSERT_EQ(512U, cell.get_n_atoms());
+
+    // 30% of 256 sites is 76.8, which rounds to 77
+    EXPECT_EQ(77U, cell.make_alloy("GA", "AL", 0.3, 1));
+    EXPECT_EQ(77U, count_species(cell, "AL"));
+    EXPECT_EQ(179U, count_species(cell, "GA"));
+    EXPECT_EQ(256U, count_species(cell, "AS"));
+
+    EXPECT_EQ(0U, cell.make_alloy("AS", "P", 0.0, 1));
+    EXPECT_EQ(256U, cell.make_alloy("AS", "SB", 1.0, 1));
+    EXPECT_EQ(0U, count_species(cell, "AS"));
+}
+
+TEST_F(SupercellTest, makeAlloySeedTest)
+{
+    auto cell_1 = cell;
+    auto cell_2 = cell;
+    auto cell_3 = cell;
+
+    cell_1.make_alloy("GA", "AL", 0.5, 42);
+    cell_2.make_alloy("GA", "AL", 0.5, 42);
+    cell_3.make_alloy("GA", "AL", 0.5, 43);
+
+    EXPECT_EQ(cell_1.get_species(), cell_2.get_species());
+    EXPECT_NE(cell_1.get_species(), cell_3.get_species());
+}
+
+TEST_F(SupercellTest, makeAlloyInvalidTest)
+{
+    EXPECT_THROW(cell.make_alloy("GA", "AL", 1.5, 1), std::domain_error);
+    EXPECT_THROW(cell.make_alloy("IN", "AL", 0.5, 1), std::domain_error);
+}
+
+TEST_F(SupercellTest, binaryRoundTripTest)
+{
+    const std::string filename = "supercell-test.bin";
+    cell.make_alloy("GA", "AL", 0.3, 7);
+    cell.write(filename);
+
+    ASSERT_TRUE(Supercell::is_binary(filename));
+    expect_cells_equal(cell, Supercell::read(filename));
+
+    std::remove(filename.c_str());
+}
+
+TEST_F(SupercellTest, xyzRoundTripTest)
+{
+    const std::string filename = "supercell-test.xyz";
+    cell.make_alloy("GA", "AL", 0.3, 7);
+    cell.write_xyz(filename);
+
+    ASSERT_FALSE(Supercell::is_binary(filename));
+    const auto read_cell = Supercell::read(filename);
+
+    // Species are numbered in order of appearance, and positions are
+    // written to the nearest 0.001 angstrom
+    ASSERT_EQ(cell.get_n_atoms(), read_cell.get_n_atoms());
+
+    for(size_t ia = 0; ia < cell.get_n_atoms(); ++ia) {
+        EXPECT_EQ(cell.get_species_name(cell.get_species()[ia]),
+                  read_cell.get_species_name(read_cell.get_species()[ia]));
+        EXPECT_NEAR(cell.get_x()[ia], read_cell.get_x()[ia], 1e-13);
+        EXPECT_NEAR(cell.get_y()[ia], read_cell.get_y()[ia], 1e-13);
+        EXPECT_NEAR(cell.get_z()[ia], read_cell.get_z()[ia], 1e-13);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_F(SupercellTest, xyzMissingAtomsTest)
+{
+    const std::string filename = "supercell-test-short.xyz";
+
+    {
+        std::ofstream stream(filename);
+        stream << "3\n\nGA 0.0 0.0 0.0\nAS 1.4 1.4 1.4\n";
+    }
+
+    EXPECT_THROW(static_cast<void>(Supercell::read(filename)), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :